@@ -0,0 +1,413 @@
+#include "PolygonTriangulator.h"
+
+#include <set>
+
+//the edges the sweep line is crossing right now, left to right. An edge is
+//known by the point it starts at (it goes to next[point]), and its place is
+//where it crosses the sweep line. Edges of a polygon that doesn't cross itself
+//never swap places, so the set stays sorted as the line moves down
+struct SweepLine {
+    const vector<ofVec2f>* points;
+    const vector<int>* next;
+    double y;
+
+    //the point the edge left of is being looked for (stands in as edge -1)
+    double probeX;
+
+    double getX(int edge) const {
+        if(edge < 0) return probeX;
+        const ofVec2f& p = (*points)[edge];
+        const ofVec2f& q = (*points)[(*next)[edge]];
+
+        //level edges are only in the set while the line is on them,
+        //and only points right of their left end look for them
+        if(p.y == q.y) return min(p.x, q.x);
+        return p.x + (y - p.y) / (q.y - p.y) * (q.x - p.x);
+    }
+};
+
+struct SweepOrder {
+    const SweepLine* line;
+    bool operator()(int a, int b) const {
+        double xa = line->getX(a);
+        double xb = line->getX(b);
+        return xa < xb || (xa == xb && a < b);
+    }
+};
+
+//--------------------------------------------------------------
+static double cross(const ofVec2f& a, const ofVec2f& b, const ofVec2f& c){
+    return (double)(b.x - a.x) * (c.y - a.y) - (double)(b.y - a.y) * (c.x - a.x);
+}
+
+//--------------------------------------------------------------
+PolygonTriangulator::PolygonTriangulator(){
+    lastTimeMs = 0;
+    clear();
+}
+
+//--------------------------------------------------------------
+void PolygonTriangulator::clear(){
+    points.clear();
+    contours.assign(1, vector<int>());
+    order.clear();
+    indices.clear();
+    bDirty = false;
+    bValid = true;
+}
+
+//--------------------------------------------------------------
+size_t PolygonTriangulator::addContour(){
+    contours.push_back(vector<int>());
+    return contours.size() - 1;
+}
+
+//--------------------------------------------------------------
+void PolygonTriangulator::addPoint(size_t contour, const ofVec2f& point){
+
+    if(contour >= contours.size()) return;
+
+    //flip y so "up" is up (the screen's y goes down)
+    int id = points.size();
+    points.push_back(ofVec2f(point.x, -point.y));
+    contours[contour].push_back(id);
+
+    //slot it into the sweep order, the rest is sorted already
+    order.insert(upper_bound(order.begin(), order.end(), id, [&](int p, int q){ return above(p, q); }), id);
+    bDirty = true;
+}
+
+//--------------------------------------------------------------
+bool PolygonTriangulator::above(int p, int q) const{
+    return points[p].y > points[q].y || (points[p].y == points[q].y && points[p].x < points[q].x);
+}
+
+//--------------------------------------------------------------
+const vector<ofIndexType>& PolygonTriangulator::getIndices(){
+    if(bDirty) triangulate();
+    return indices;
+}
+
+//--------------------------------------------------------------
+bool PolygonTriangulator::isValid(){
+    if(bDirty) triangulate();
+    return bValid;
+}
+
+//--------------------------------------------------------------
+void PolygonTriangulator::triangulate(){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    indices.clear();
+    prev.assign(points.size(), -1);
+    next.assign(points.size(), -1);
+    bDirty = false;
+    bValid = true;
+
+    //link up each contour so the inside is on the left: the outline goes
+    //counter clockwise, the holes clockwise. Points on top of the one before
+    //them are left out, and so are holes that aren't a triangle yet
+    double area = 0;
+    for(size_t c = 0; c < contours.size(); c++){
+
+        vector<int> contour;
+        for(int id : contours[c]){
+            if(contour.empty() || points[id] != points[contour.back()]) contour.push_back(id);
+        }
+        while(contour.size() > 1 && points[contour.back()] == points[contour.front()]) contour.pop_back();
+        if(contour.size() < 3){
+            if(c == 0) break;
+            continue;
+        }
+
+        double contourArea = 0;
+        for(size_t i = 0; i < contour.size(); i++){
+            const ofVec2f& p = points[contour[i]];
+            const ofVec2f& q = points[contour[(i + 1) % contour.size()]];
+            contourArea += (double)p.x * q.y - (double)q.x * p.y;
+        }
+        contourArea /= 2;
+
+        bool bHole = c > 0;
+        if((contourArea < 0) != bHole) reverse(contour.begin(), contour.end());
+        area += bHole ? -fabs(contourArea) : fabs(contourArea);
+
+        for(size_t i = 0; i < contour.size(); i++){
+            next[contour[i]] = contour[(i + 1) % contour.size()];
+            prev[contour[i]] = contour[(i + contour.size() - 1) % contour.size()];
+        }
+    }
+
+    //(an outline that's all folded over itself has no area)
+    if(area <= 0){
+        bValid = contours[0].empty() || next[contours[0].front()] < 0;
+        lastTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+        return;
+    }
+
+    //cut it into monotone pieces
+    vector<pair<int, int> > diagonals;
+    findDiagonals(diagonals);
+
+    //then walk around each piece: the polygon's edges and both sides of every
+    //diagonal. At each corner the next edge is the first one clockwise from
+    //the way we came in, which keeps the piece on the left
+    vector<vector<pair<float, int> > > around(points.size());
+    auto connect = [&](int a, int b){
+        around[a].push_back(make_pair(atan2(points[b].y - points[a].y, points[b].x - points[a].x), b));
+    };
+    for(size_t v = 0; v < points.size(); v++){
+        if(next[v] < 0) continue;
+        connect(v, next[v]);
+        connect(v, prev[v]);
+    }
+    for(auto& d : diagonals){
+        connect(d.first, d.second);
+        connect(d.second, d.first);
+    }
+
+    vector<vector<char> > walked(points.size());
+    for(size_t v = 0; v < points.size(); v++){
+        sort(around[v].begin(), around[v].end());
+        walked[v].assign(around[v].size(), 0);
+
+        //the outside of the polygon isn't a piece
+        for(size_t k = 0; k < around[v].size(); k++){
+            if(around[v][k].second == prev[v]) walked[v][k] = 1;
+        }
+    }
+
+    vector<int> piece;
+    for(size_t v = 0; v < points.size(); v++){
+        for(size_t k = 0; k < around[v].size(); k++){
+            if(walked[v][k]) continue;
+
+            piece.clear();
+            int from = v;
+            size_t edge = k;
+            while(!walked[from][edge]){
+                walked[from][edge] = 1;
+                piece.push_back(from);
+
+                //find where we came from among the edges of the next corner
+                int to = around[from][edge].second;
+                float back = atan2(points[from].y - points[to].y, points[from].x - points[to].x);
+                vector<pair<float, int> >& edges = around[to];
+                size_t in = lower_bound(edges.begin(), edges.end(), make_pair(back, from)) - edges.begin();
+                if(in == edges.size() || edges[in].second != from) break;
+
+                edge = (in + edges.size() - 1) % edges.size();
+                from = to;
+            }
+            triangulateMonotone(piece);
+        }
+    }
+
+    //the triangles have to add up to the polygon, or something crossed
+    double triangleArea = 0;
+    for(size_t i = 0; i < indices.size(); i += 3){
+        triangleArea += cross(points[indices[i]], points[indices[i + 1]], points[indices[i + 2]]) / 2;
+    }
+    bValid = fabs(triangleArea - area) <= 1e-4 * area;
+
+    lastTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+void PolygonTriangulator::findDiagonals(vector<pair<int, int> >& diagonals){
+
+    //what kind of corner each point is
+    vector<VertexType> types(points.size(), REGULAR);
+    for(size_t v = 0; v < points.size(); v++){
+        if(next[v] < 0) continue;
+
+        bool bPrevBelow = above(v, prev[v]);
+        bool bNextBelow = above(v, next[v]);
+        bool bConvex = cross(points[prev[v]], points[v], points[next[v]]) > 0;
+
+        if(bPrevBelow && bNextBelow) types[v] = bConvex ? START : SPLIT;
+        else if(!bPrevBelow && !bNextBelow) types[v] = bConvex ? END : MERGE;
+    }
+
+    SweepLine line;
+    line.points = &points;
+    line.next = &next;
+    line.y = 0;
+    line.probeX = 0;
+
+    //the edges with the inside on their right, and for each one the lowest point
+    //so far that can see it ("helper"). A diagonal to a merge point that's a helper
+    //gets added as soon as the sweep reaches a point below it
+    typedef set<int, SweepOrder> Status;
+    Status status(SweepOrder{&line});
+    vector<Status::iterator> inStatus(points.size(), status.end());
+    vector<int> helper(points.size(), -1);
+
+    auto insert = [&](int edge){
+        inStatus[edge] = status.insert(edge).first;
+        helper[edge] = edge;
+    };
+    auto remove = [&](int edge){
+        if(inStatus[edge] != status.end()) status.erase(inStatus[edge]);
+        inStatus[edge] = status.end();
+    };
+    auto edgeLeftOf = [&](int v){
+        line.probeX = points[v].x;
+        Status::iterator it = status.lower_bound(-1);
+        return it == status.begin() ? -1 : *(--it);
+    };
+    auto fixUp = [&](int v, int edge){
+        if(edge >= 0 && helper[edge] >= 0 && types[helper[edge]] == MERGE) diagonals.push_back(make_pair(v, helper[edge]));
+    };
+
+    for(int v : order){
+        if(next[v] < 0) continue;
+        line.y = points[v].y;
+        int left;
+
+        switch(types[v]){
+
+            case START:
+                insert(v);
+                break;
+
+            case END:
+                fixUp(v, prev[v]);
+                remove(prev[v]);
+                break;
+
+            //a dent pointing up: connect it to the point that last saw the edge on its left
+            case SPLIT:
+                left = edgeLeftOf(v);
+                if(left >= 0){
+                    diagonals.push_back(make_pair(v, helper[left]));
+                    helper[left] = v;
+                }
+                insert(v);
+                break;
+
+            //a dent pointing down: it becomes the helper on its left, and
+            //gets connected to the next point below that sees it
+            case MERGE:
+                fixUp(v, prev[v]);
+                remove(prev[v]);
+                left = edgeLeftOf(v);
+                fixUp(v, left);
+                if(left >= 0) helper[left] = v;
+                break;
+
+            case REGULAR:
+
+                //on the left side of the polygon (going down), inside is to the right
+                if(above(prev[v], v)){
+                    fixUp(v, prev[v]);
+                    remove(prev[v]);
+                    insert(v);
+                } else {
+                    left = edgeLeftOf(v);
+                    fixUp(v, left);
+                    if(left >= 0) helper[left] = v;
+                }
+                break;
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void PolygonTriangulator::triangulateMonotone(const vector<int>& piece){
+
+    size_t n = piece.size();
+    if(n < 3) return;
+    if(n == 3){
+        addTriangle(piece[0], piece[1], piece[2]);
+        return;
+    }
+
+    //the top and bottom split the piece into a left and a right side
+    size_t top = 0, bottom = 0;
+    for(size_t i = 1; i < n; i++){
+        if(above(piece[i], piece[top])) top = i;
+        if(above(piece[bottom], piece[i])) bottom = i;
+    }
+
+    //merge the two sides into one list from top to bottom. Counter clockwise
+    //from the top is down the left side, clockwise is down the right
+    vector<int> sorted;
+    vector<char> bLeft;
+    sorted.reserve(n);
+    bLeft.reserve(n);
+    sorted.push_back(piece[top]);
+    bLeft.push_back(1);
+    size_t l = (top + 1) % n;
+    size_t r = (top + n - 1) % n;
+    while(sorted.size() < n){
+        if(l != bottom && (r == bottom || above(piece[l], piece[r]))){
+            sorted.push_back(piece[l]);
+            bLeft.push_back(1);
+            l = (l + 1) % n;
+        } else {
+            sorted.push_back(piece[r]);
+            bLeft.push_back(r != bottom ? 0 : 1);
+            if(r == bottom) break;
+            r = (r + n - 1) % n;
+        }
+    }
+    if(sorted.size() < n) return;
+
+    //go down with a stack of points that still need triangles
+    vector<size_t> stack;
+    stack.push_back(0);
+    stack.push_back(1);
+
+    for(size_t j = 2; j < n - 1; j++){
+
+        //other side: fan out to everything on the stack
+        if(bLeft[j] != bLeft[stack.back()]){
+            size_t last = stack.back();
+            while(stack.size() > 1){
+                size_t s = stack.back();
+                stack.pop_back();
+                addTriangle(sorted[j], sorted[s], sorted[stack.back()]);
+            }
+            stack.clear();
+            stack.push_back(last);
+            stack.push_back(j);
+
+        //same side: cut off triangles as long as they're inside
+        } else {
+            size_t last = stack.back();
+            stack.pop_back();
+            while(!stack.empty()){
+                const ofVec2f& p = points[sorted[j]];
+                const ofVec2f& q = points[sorted[last]];
+                const ofVec2f& s = points[sorted[stack.back()]];
+                bool bInside = bLeft[j] ? cross(s, q, p) > 0 : cross(p, q, s) > 0;
+                if(!bInside) break;
+
+                addTriangle(sorted[j], sorted[last], sorted[stack.back()]);
+                last = stack.back();
+                stack.pop_back();
+            }
+            stack.push_back(last);
+            stack.push_back(j);
+        }
+    }
+
+    //the bottom point sees everything that's left
+    while(stack.size() > 1){
+        size_t s = stack.back();
+        stack.pop_back();
+        addTriangle(sorted[n - 1], sorted[s], sorted[stack.back()]);
+    }
+}
+
+//--------------------------------------------------------------
+void PolygonTriangulator::addTriangle(int a, int b, int c){
+
+    //all the same way around (counter clockwise with y up)
+    if(cross(points[a], points[b], points[c]) < 0) swap(b, c);
+    indices.push_back(a);
+    indices.push_back(b);
+    indices.push_back(c);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Turns clicked points into triangles: the points are the outline of a polygon
+ * (any shape, concave too) with holes cut out of it, and this works out which
+ * triangles fill it. The triangles come out as indices into the points in the
+ * order they were added, so they can go straight into a mesh that has the same
+ * points as its vertices.
+ *
+ * How: a line sweeps down over the points from top to bottom. Wherever the
+ * outline has a dent that points up or down (a "split" or "merge" corner) a
+ * diagonal is added to the nearest point above or below, which cuts the polygon
+ * into pieces that are "monotone": walking down either side of a piece you never
+ * have to go back up. Those are easy to fill, in one pass from top to bottom with
+ * a stack. Everything is O(n log n), the log coming from the sorting and from
+ * looking up the edge left of each point.
+ * (Ear clipping, the usual simple way, is O(n squared), which gets slow with
+ * outlines drawn with the mouse.)
+ *
+ * Points are kept sorted as they're added (so adding one doesn't sort everything
+ * again) and the triangles are only worked out again when something changed.
+ *
+ * The outline can go either way around, the holes have to be inside it, and
+ * nothing should cross. If something does, isValid() says so (the triangles
+ * don't add up to the polygon's area).
+ */
+
+class PolygonTriangulator {
+
+	public:
+
+    PolygonTriangulator();
+
+    //start over with an empty outline (contour 0)
+    void clear();
+
+    //start a new hole, returns its contour number
+    size_t addContour();
+
+    //add a point to the end of a contour. Its index in the triangles
+    //is how many points were added (to all the contours) before it
+    void addPoint(size_t contour, const ofVec2f& point);
+
+    //the triangles, 3 indices each (worked out again if points were added)
+    const vector<ofIndexType>& getIndices();
+
+    //false if the outline crosses itself or a hole isn't inside it
+    bool isValid();
+
+    size_t getNumPoints() const { return points.size(); }
+    size_t getNumContours() const { return contours.size(); }
+    size_t getNumTriangles() const { return indices.size() / 3; }
+    float getLastTimeMs() const { return lastTimeMs; }
+
+    private:
+
+    //what a corner looks like to the sweep line
+    enum VertexType {
+        START,      //both neighbours below, the inside is between them
+        END,        //both neighbours above, the inside is between them
+        SPLIT,      //both below, the inside is around it (a dent pointing up)
+        MERGE,      //both above, the inside is around it (a dent pointing down)
+        REGULAR     //one above, one below
+    };
+
+    //p comes before q in the sweep (higher up, or level and to the left)
+    bool above(int p, int q) const;
+
+    void triangulate();
+    void findDiagonals(vector<pair<int, int> >& diagonals);
+    void triangulateMonotone(const vector<int>& piece);
+    void addTriangle(int a, int b, int c);
+
+    //the points with y pointing up, as in the textbooks
+    vector<ofVec2f> points;
+    vector<vector<int> > contours;
+
+    //every point, sorted top to bottom (kept up to date as points are added)
+    vector<int> order;
+
+    //the neighbours of each point around its contour, with the inside on the left
+    //going from prev to next. -1 for points that aren't used
+    vector<int> prev;
+    vector<int> next;
+
+    vector<ofIndexType> indices;
+    bool bDirty;
+    bool bValid;
+
+    float lastTimeMs;
+};
@@ -7,12 +7,32 @@ void ofApp::setup(){
     
     meshMode = 0;
     bShowWire = true;
+    currentHole = -1;
+    bIndicesChanged = false;
+    
+    //a new seed every launch (it's logged). Put a number here
+    //instead to get the same colors every time
+    uint64_t seed = ofGetUnixTime();
+    ofLogNotice("ofApp") << "random seed " << seed;
+    randomStream.setSeed(seed);
     
 }
 
 //--------------------------------------------------------------
 void ofApp::update(){
 
+    //In the polygon mode the mesh gets indices: which of the points make up
+    //each triangle. They're only worked out again (and copied into the mesh)
+    //when something changed, once a frame however many points came in while dragging
+    if(bIndicesChanged){
+        if(meshMode == 7){
+            mesh.getIndices() = triangulator.getIndices();
+        } else {
+            mesh.clearIndices();
+        }
+        bIndicesChanged = false;
+    }
+
 }
 
 //--------------------------------------------------------------
@@ -55,6 +75,10 @@ void ofApp::draw(){
             mesh.setMode(OF_PRIMITIVE_TRIANGLE_FAN);
             whichMode = "OF_PRIMITIVE_TRIANGLE_FAN";
             break;
+        case 7:
+            mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+            whichMode = "POLYGON (OF_PRIMITIVE_TRIANGLES with indices)";
+            break;
 
     }
     
@@ -86,7 +110,8 @@ void ofApp::draw(){
     
     
     //also draw the point number next to the point
-    for(int i = 0; i < mesh.getNumVertices(); i++){
+    //(not for outlines drawn with the mouse, the numbers would just be a blur)
+    for(size_t i = 0; i < mesh.getNumVertices() && mesh.getNumVertices() < 300; i++){
         
         //get the position of each mesh vertex
         ofVec3f thisVertex = mesh.getVertex(i);
@@ -103,6 +128,13 @@ void ofApp::draw(){
     ofDrawBitmapString("CURRENT MODE:" + whichMode, 15, 20);
     ofDrawBitmapString("Press SPACE to clear points\nPress 'W' to toggle drawing the wireframe on top", 15, ofGetHeight() - 30);
     
+    if(meshMode == 7){
+        string polygonInfo = ofToString(triangulator.getNumTriangles()) + " triangles from " + ofToString(triangulator.getNumPoints()) + " points, " + ofToString(triangulator.getNumContours() - 1) + " holes in " + ofToString(triangulator.getLastTimeMs(), 2) + " ms";
+        if(!triangulator.isValid()) polygonInfo += "  (the outline crosses itself or a hole sticks out)";
+        ofDrawBitmapString(polygonInfo, 15, 35);
+        ofDrawBitmapString("Click or drag to draw the outline, hold SHIFT to draw a hole (let go to start another one)", 15, ofGetHeight() - 45);
+    }
+    
 }
 
 //--------------------------------------------------------------
@@ -112,20 +144,28 @@ void ofApp::keyPressed(int key){
     if(key == OF_KEY_RIGHT){
         meshMode++;
         
-        if(meshMode > 6){
+        if(meshMode > 7){
             meshMode = 0;
         }
     } else if(key == OF_KEY_LEFT){
         meshMode--;
         
         if(meshMode < 0){
-            meshMode = 6;
+            meshMode = 7;
         }
     }
     
+    //the polygon mode has indices, the others don't
+    if(key == OF_KEY_RIGHT || key == OF_KEY_LEFT){
+        bIndicesChanged = true;
+    }
+    
     //clear out all the points
     if(key == ' '){
         mesh.clear();
+        triangulator.clear();
+        currentHole = -1;
+        bIndicesChanged = true;
     }
     
     if(key == 'w' || key == 'W'){
@@ -138,6 +178,10 @@ void ofApp::keyPressed(int key){
 //--------------------------------------------------------------
 void ofApp::keyReleased(int key){
 
+    //the hole is finished, the next SHIFT click starts a new one
+    if(key == OF_KEY_SHIFT || key == OF_KEY_LEFT_SHIFT || key == OF_KEY_RIGHT_SHIFT){
+        currentHole = -1;
+    }
 }
 
 //--------------------------------------------------------------
@@ -148,21 +192,43 @@ void ofApp::mouseMoved(int x, int y ){
 //--------------------------------------------------------------
 void ofApp::mouseDragged(int x, int y, int button){
     
+    //draw outlines in the polygon mode, a point every few pixels
+    if(meshMode == 7 && lastPoint.distance(ofVec2f(x, y)) >= 5){
+        addPoint(x, y);
+    }
 }
 
 //--------------------------------------------------------------
 void ofApp::mousePressed(int x, int y, int button){
 
+    //with SHIFT held the points go into a hole
+    if(!ofGetKeyPressed(OF_KEY_SHIFT)){
+        currentHole = -1;
+    } else if(currentHole < 0){
+        currentHole = triangulator.addContour();
+    }
+    
+    addPoint(x, y);
+}
+
+//--------------------------------------------------------------
+void ofApp::addPoint(int x, int y){
+
     //add a point to our mesh
     mesh.addVertex(ofVec3f(x, y, 0));
 
     //select a new color everytime we add a point and add it to the mesh.
     //The mesh will draw the first vertex with the first color it has in its lists
     //so it's a good idea to add them at the same time
-    ofColor newColor;
-    newColor.setHsb(ofRandom(255), 200, 200); //use HSB mode so colors come out purty
+    //(any hue, saturation and brightness 200: use HSB mode so colors come out purty)
+    ofColor newColor = randomStream.hsb(ofVec3f(0, 200, 200), ofVec3f(255, 200, 200));
     mesh.addColor(newColor);
     
+    //and to the outline (or the hole being drawn). It gets the same
+    //number as the vertex, so the triangles can use it as an index
+    triangulator.addPoint(currentHole < 0 ? 0 : currentHole, ofVec2f(x, y));
+    lastPoint.set(x, y);
+    bIndicesChanged = true;
 }
 
 //--------------------------------------------------------------
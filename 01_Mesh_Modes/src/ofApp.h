@@ -1,6 +1,8 @@
 #pragma once
 
 #include "ofMain.h"
+#include "PolygonTriangulator.h"
+#include "RandomStream.h"
 
 class ofApp : public ofBaseApp{
 
@@ -27,4 +29,21 @@ class ofApp : public ofBaseApp{
     int meshMode;
     bool bShowWire;
     
+    //add a point (with a new color) to the mesh and the polygon
+    void addPoint(int x, int y);
+    
+    //the last mode treats the points as the outline of a polygon (plus holes)
+    //and fills it with triangles, whatever order they were clicked in
+    PolygonTriangulator triangulator;
+    
+    //the hole points go into while SHIFT is held (-1 when it's not)
+    int currentHole;
+    ofVec2f lastPoint;
+    
+    //points were added, cleared or the mode changed, so the mesh needs its indices redone
+    bool bIndicesChanged;
+    
+    //the points' colors, the same every time for the same seed
+    RandomStream randomStream;
+    
 };
@@ -7,52 +7,130 @@ void ofApp::setup(){
     
     ofEnableDepthTest();
     
-    //load image and or video
-    img.load("stars.png");
-    movie.load("trapped.mov");
+    //load image and or video.
+    //These only get things started: the image is decoded on another thread
+    //and the movie opens in the background while we build the mesh below
+    AssetLoader::Image stars = loader.loadImage("stars.png");
+    std::shared_future<ofVec2f> movieSize = loader.loadMovie(movie, "trapped.mov");
     movie.setLoopState(OF_LOOP_NORMAL);
-
     
-    //create a primitive shape
-    ofPlanePrimitive plane;
+    //how long it may take to get the first frame up (logged after the first draw)
+    loader.setStartupBudgetMs(1000);
+
     
     //set the dimensions of the plane
     meshWidth = 640;
     meshHeight = 360;
     
     //Comment these out for using a texture from the movie or image
-//    meshWidth = movie.getWidth();
-//    meshHeight = movie.getHeight();
+    //(the sizes are read from the files' headers, no need to wait for the rest)
+//    meshWidth = movieSize.get().x;
+//    meshHeight = movieSize.get().y;
     
     //for using mesh with image texture
-//    meshWidth = img.getWidth();
-//    meshHeight = img.getHeight();
+//    meshWidth = stars.size.get().x;
+//    meshHeight = stars.size.get().y;
+    
+    
+    //the plane only depends on these numbers, so it's only built the first time.
+    //After that it comes out of data/meshcache (see buildPlane() for how it's made)
+    GeometryCache::Key planeKey("02 plane");
+    planeKey.add(meshWidth).add(meshHeight).add(50).add(50);
+    mesh = *GeometryCache::get().getMesh(planeKey, [&](ofMesh& plane){ buildPlane(plane, 50, 50); });
+    numVerts = mesh.getNumVertices();
+    
+    //Copy the mesh into the "originalMesh" so that we can
+    //manipulate the mesh later and still know where the original data was
+    originalMesh = mesh;
+    
+    
+    //Build a lighter version with a quarter of the triangles. The decimator merges
+    //vertices where it changes the shape the least and blends the colors and
+    //texcoords along the way so the texture still lines up
+    //(that's slow, so it goes through the cache too)
+    GeometryCache::Key previewKey("02 preview");
+    previewKey.add(planeKey).add(0.25f);
+    previewMesh = *GeometryCache::get().getMesh(previewKey, [&](ofMesh& preview){ decimator.decimateRatio(originalMesh, preview, 0.25); });
+    bPreview = false;
+    
+    //the plane can be seen from both sides so only cull what's off screen
+    culler.setConeCulling(false);
+    bCulling = false;
+    
+    //the tree only cares about which vertices make up each triangle,
+    //so it gets built here and just refit as the noise moves things
+    bvh.build(originalMesh);
+    bPicking = false;
+    bHit = false;
+    
+    //the texcoords are the movie's pixels (1 to 1), so each vertex
+    //reads the brightness of the pixel drawn on it
+    displacement.setup(originalMesh);
+    bLuminance = false;
+    
+    bStreams = false;
+    
+    //the flat plane is the rest pose: both the noise and the movie only ever
+    //lift it by up to 100, so every frame the bounds are just these grown by that
+    bounds.compute(originalMesh);
+    
+    rasterizer.allocate(ofGetWidth(), ofGetHeight());
+    ofDirectory::createDirectory("frames", true, true);
+    ofDirectory::createDirectory("recordings", true, true);
+    bPlaying = false;
+    playFrame = 0;
+    
+    //(how long it took is logged by the GeometryCache)
+    ofLogNotice("02_Mesh_From_Primitive") << "preview mesh: " << previewMesh.getNumIndices() / 3 << " triangles";
+    
+    //everything else is ready, now the texture needs the pixels.
+    //They've usually been decoded by now so this hardly ever waits
+    img.setFromPixels(stars.pixels.get());
+    
+    //and the mipmapped version of it. Only filtered on the first run,
+    //after that it comes straight out of data/mipcache
+    pyramid.loadOrBuild("stars.png", img.getPixels(), MipPyramid::KAISER);
+    pyramid.upload(mipTexture);
+    bMipmaps = true;
+    
+    memory.addMesh("mesh", mesh);
+    memory.addMesh("originalMesh", originalMesh);
+    memory.addMesh("previewMesh", previewMesh);
+    bMemory = false;
     
-    plane.set(meshWidth, meshHeight, 50, 50);
-    //the 50-50 set the number of rows/columns in the mesh
+}
+
+//--------------------------------------------------------------
+void ofApp::buildPlane(ofMesh& planeMesh, int columns, int rows){
+
+    //create a primitive shape
+    ofPlanePrimitive plane;
+    
+    plane.set(meshWidth, meshHeight, columns, rows);
+    //columns and rows set how many squares the plane is cut into (50 by 50 here)
     
     
     //copy the mesh from the plane object
-    mesh = plane.getMesh();
+    planeMesh = plane.getMesh();
     
     
     //Now we'll go through all the vertices and add some colors
 
     //first get the number of vertices
-    numVerts = mesh.getNumVertices();
+    int numVerts = planeMesh.getNumVertices();
     
     //since we got all our mesh data from the plane primitive
     //clear out the colors and other stuff (texcoords) so we
     //can replace it with our own data
-    mesh.clearColors();
-    mesh.clearTexCoords();
+    planeMesh.clearColors();
+    planeMesh.clearTexCoords();
     
     //for loop to go through all the vertices
     for(int i = 0; i < numVerts; i++){
 
         //this will set the color at each mesh point to be increasingly more green
         //So it will start at red and end at yellow
-        mesh.addColor(ofColor(255, 255 * (i/(float)numVerts), 0));
+        planeMesh.addColor(ofColor(255, 255 * (i/(float)numVerts), 0));
         
         
         //Texcoords - The way to tell the mesh how to wrap and image/movie texture
@@ -60,16 +138,10 @@ void ofApp::setup(){
         //In this case, the tex coord is the same as vertex: 1 to 1 mapping
         //i.e. no stretching/warping, etc.
         //since we've made the mesh the same dimensions as the texture
-        mesh.addTexCoord(mesh.getVertex(i) + ofVec3f(meshWidth/2, meshHeight/2, 0));
+        planeMesh.addTexCoord(planeMesh.getVertex(i) + ofVec3f(meshWidth/2, meshHeight/2, 0));
         
         
     }
-    
-    //Copy the mesh into the "originalMesh" so that we can
-    //manipulate the mesh later and still know where the original data was
-    originalMesh = mesh;
-    
-    
 }
 
 //--------------------------------------------------------------
@@ -128,43 +200,108 @@ void ofApp::update(){
     
     
     
-    //Perlin Noise
-    //Pseudo randomness - allows random-ish oscillations but with a certain
-    //degree of smoothness. "noiseScale" will change the spatial scale (wide flowing peaks
-    //versus many smaller peaks) while "speed" will alter how fast we go through the randomness.
-    
-    //maximum height of the oscillation
-    float amp = 100;
-    
-    //change the scale of the noise based on the X value of the mouse
-    float noiseScale = ofMap(ofGetMouseX(), 0, ofGetWidth(), 0.001, 0.012);
-    
-    //change how fast we go through the noise based on the Y value of the mouse
-    float speed = ofMap(ofGetMouseY(), 0, ofGetHeight(), 0.0, 3.0);
-
-    
-    //Go through each vertex and set them to the noise value
-    for(int i = 0; i < numVerts; i++){
+    //Playback
+    //Instead of working out the heights, take them from a recording, one frame
+    //per update and around again at the end. (Only while the vertex count still
+    //matches, the preview mesh stops it)
+    if(bPlaying){
         
+        if(player.getFrame(playFrame, mesh)){
+            playFrame = (playFrame + 1) % player.getNumFrames();
+        } else {
+            bPlaying = false;
+        }
         
-        ofVec3f vertex = mesh.getVertex(i);
-
-        ofVec3f noiseyVertex;
-        
-        //get the 3 dimensional noise value (3 Dims = X, Y and time as the 3rd dimension so the noise value changes over time)
-        float noise = amp * ofNoise(vertex.x * noiseScale, vertex.y * noiseScale, speed * ofGetElapsedTimef());
+    //Movie luminance
+    //Each vertex goes up by how bright the movie is under it, so the plane
+    //becomes a moving relief of the video. This reads the movie's pixels
+    //directly (no copy) and only needs to run when there's a new frame
+    } else if(bLuminance){
         
-        //set the point with noise as the Z value
-        noiseyVertex.set(vertex.x, vertex.y, noise);
+        if(movie.isFrameNew()){
+            displacement.update(movie.getPixels(), mesh, 100);
+        }
         
-        //add the noise vertex back into the mesh
-        mesh.setVertex(i, noiseyVertex);
+    } else {
         
+        //Perlin Noise
+        //Pseudo randomness - allows random-ish oscillations but with a certain
+        //degree of smoothness. "noiseScale" will change the spatial scale (wide flowing peaks
+        //versus many smaller peaks) while "speed" will alter how fast we go through the randomness.
+    
+        //maximum height of the oscillation
+        float amp = 100;
+    
+        //change the scale of the noise based on the X value of the mouse
+        float noiseScale = ofMap(ofGetMouseX(), 0, ofGetWidth(), 0.001, 0.012);
+    
+        //change how fast we go through the noise based on the Y value of the mouse
+        float speed = ofMap(ofGetMouseY(), 0, ofGetHeight(), 0.0, 3.0);
+
+    
+        //Go through each vertex and set them to the noise value.
+        //Every vertex is independent of the others so the scheduler splits them up
+        //between all the cores, a thousand or so at a time. We write straight into
+        //the vertex array so the threads only ever touch their own vertices
+        vector<ofVec3f>& verts = mesh.getVertices();
+        float time = ofGetElapsedTimef();
+    
+        TaskScheduler::get().parallelFor(0, numVerts, 1024, [&](size_t begin, size_t end){
+            for(size_t i = begin; i < end; i++){
+            
+                ofVec3f vertex = verts[i];
+            
+                ofVec3f noiseyVertex;
+            
+                //get the 3 dimensional noise value (3 Dims = X, Y and time as the 3rd dimension so the noise value changes over time)
+                float noise = amp * ofNoise(vertex.x * noiseScale, vertex.y * noiseScale, speed * time);
+            
+                //set the point with noise as the Z value
+                noiseyVertex.set(vertex.x, vertex.y, noise);
+            
+                //put the noise vertex back into the mesh
+                verts[i] = noiseyVertex;
+            }
+        });
+
+    }
+    
+    //save the heights we ended up with as the next frame of the recording
+    if(recorder.isRecording()){
+        recorder.addFrame(mesh);
+    }
+    
+    //Picking: fit the boxes of the tree around the moved vertices and
+    //shoot a ray from the camera through the mouse.
+    //(this happens before culling since the tree keeps its own copy of the triangles)
+    if(bPicking){
+        bvh.refit(mesh);
+        bHit = bvh.pick(mesh, cam, ofVec2f(mouseX, mouseY), ofGetCurrentViewport(), hit);
+    }
+    
+    //Meshlet culling: swap the indices for only the triangles inside the view.
+    //The plane primitive is a triangle strip, but the culler hands back
+    //separate triangles so switch the mode over too
+    if(bCulling){
+        culler.updateBounds(mesh);
+        culler.cull(cam, ofGetCurrentViewport(), mesh.getIndices());
+        mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+    }
+    
+    //no need to look at the vertices, we know how far they can have moved:
+    //up to 100 along z and not at all sideways. (luminance lifts by up to 100 as well)
+    bounds.expand(ofVec3f(0, 0, 100));
+    
+    //send this frame's positions (and the culled indices) to the GPU
+    if(bStreams){
+        streams.updateDynamic(mesh);
+        if(bCulling) streams.updateIndices(mesh);
     }
     
     //update the movie (if we're using the movie texture)
     movie.update();
-
+    
+    memory.update();
     
 }
 
@@ -182,6 +319,58 @@ void ofApp::draw(){
     ofSetColor(255);
     ofDrawBitmapString("Framerate: " + ofToString(ofGetFrameRate()), 15, 15);
     ofDrawBitmapString("Num Vertices: " + ofToString(numVerts), 15, 30);
+    
+    ofDrawBitmapString("Press 'w' to toggle wireframe drawing", 15, 60);
+    ofDrawBitmapString("Press 'd' to toggle the decimated preview mesh", 15, 75);
+    ofDrawBitmapString("Press 'c' to toggle meshlet culling", 15, 90);
+    ofDrawBitmapString("Press 'p' to toggle picking with the mouse", 15, 105);
+    ofDrawBitmapString("Press 'f' to render the frame on the CPU and save it (" + ofToString(rasterizer.getLastDrawTimeMs(), 1) + " ms)", 15, 120);
+    ofDrawBitmapString("Press 'l' to toggle lifting the plane by the movie's brightness", 15, 150);
+    ofDrawBitmapString("Press 'i' to toggle drawing from interleaved vertex streams", 15, 180);
+    ofDrawBitmapString("Press 'z' to frame the mesh with the camera", 15, 210);
+    
+    ofVec3f boundsSize = bounds.getSize();
+    ofDrawBitmapString("Bounds: " + ofToString(boundsSize.x, 0) + " x " + ofToString(boundsSize.y, 0) + " x " + ofToString(boundsSize.z, 0) + "  radius " + ofToString(bounds.getRadius(), 0), 15, 225);
+    
+    ofDrawBitmapString("Press 'm' to toggle the mipmapped texture", 15, 240);
+    string mipInfo = "Mipmaps: " + ofToString(pyramid.getNumLevels()) + " levels, " + ofToString(pyramid.getNumBytes() / 1024) + " KB, ";
+    mipInfo += (pyramid.isFromCache() ? "loaded from the cache in " : "filtered in ") + ofToString(pyramid.getLastBuildTimeMs(), 1) + " ms";
+    ofDrawBitmapString(mipInfo, 15, 255);
+    ofDrawBitmapString("Press 'M' to toggle the memory overlay, 'S' to start/stop logging it to a .csv", 15, 270);
+    
+    ofDrawBitmapString("Press 'R' to start/stop recording the plane, 'P' to play the recording back (left/right arrows skip)", 15, 285);
+    if(recorder.isRecording()){
+        ofDrawBitmapString("Recording: " + ofToString(recorder.getNumFrames()) + " frames, " + ofToString(recorder.getNumBytes() / 1024) + " KB (" + ofToString(recorder.getCompressionRatio(), 1) + "x smaller)  encode: " + ofToString(recorder.getLastEncodeTimeMs(), 2) + " ms", 15, 300);
+    }
+    if(bPlaying){
+        ofDrawBitmapString("Playing: frame " + ofToString(playFrame) + " / " + ofToString(player.getNumFrames()) + " (" + ofToString(player.getCompressionRatio(), 1) + "x smaller)  decode: " + ofToString(player.getLastDecodeTimeMs(), 2) + " ms for " + ofToString(player.getLastNumFramesDecoded()) + " frames, " + ofToString(player.getDecodeMBPerSecond(), 0) + " MB/s", 15, 300);
+    }
+    
+    if(bLuminance){
+        ofDrawBitmapString("Luminance displacement: " + ofToString(displacement.getLastUpdateTimeMs(), 2) + " ms", 15, 165);
+    }
+    
+    //what goes to the GPU per frame: only the positions (and indices when culling)
+    //with the streams, every array of the mesh without them
+    size_t separateBytes = VertexStreams::getSeparateBytesPerFrame(mesh, false);
+    size_t separateLines = VertexStreams::getSeparateCacheLinesPerFrame(mesh, false);
+    string streamInfo = "Per frame: separate arrays " + ofToString(separateBytes / 1024) + " KB / " + ofToString(separateLines) + " cache lines";
+    if(bStreams){
+        streamInfo += "  streams " + ofToString(streams.getBytesPerFrame() / 1024) + " KB / " + ofToString(streams.getCacheLinesPerFrame()) + " cache lines  (" + ofToString(streams.getLastUpdateTimeMs(), 2) + " ms)";
+    }
+    ofDrawBitmapString(streamInfo, 15, 195);
+    
+    if(bCulling){
+        ofDrawBitmapString("Meshlets: " + ofToString(culler.getMeshlets().size()) + "  culled: " + ofToString(culler.getCulledPercent(), 1) + "%  time: " + ofToString(culler.getLastCullTimeMs(), 3) + " ms", 15, 45);
+    }
+    
+    if(bPicking){
+        string pickInfo = "Refit: " + ofToString(bvh.getLastRefitTimeMs(), 2) + " ms  query: " + ofToString(bvh.getLastQueryTimeUs(), 1) + " us";
+        if(bHit){
+            pickInfo += "  triangle: " + ofToString(hit.triangle) + "  vertex: " + ofToString(hit.vertex) + "  uv: " + ofToString(hit.u, 2) + ", " + ofToString(hit.v, 2);
+        }
+        ofDrawBitmapString(pickInfo, 15, 135);
+    }
 
     
     //Everythign drawn between cam.begin() and cam.end() will be subject to
@@ -193,16 +382,26 @@ void ofApp::draw(){
 
     //Comment out the one you don't want.
     //(comment out both to use the mesh colors instead of the texture)
+    //The luminance mode always shows the movie it's lifted by
 
+    if(bLuminance){
+        movie.getTexture().bind();
+    } else if(bMipmaps){
+        mipTexture.bind();
+    } else {
     //    movie.getTexture().bind();
-    img.bind();
+        img.bind();
+    }
     
     //mesh colors will tint the texture so disable them if you want to use a texture
     mesh.disableColors();
     
     
     //draw the mesh or the wireframe
-    if(bWireframe){
+    if(bStreams){
+        ofSetLineWidth(1);
+        streams.draw(bWireframe ? OF_MESH_WIREFRAME : OF_MESH_FILL);
+    } else if(bWireframe){
         ofSetLineWidth(1);
         mesh.drawWireframe();
     } else {
@@ -212,12 +411,31 @@ void ofApp::draw(){
     //unbind th texture once we're done drawing the mesh
     movie.getTexture().unbind();
     img.unbind();
+    mipTexture.unbind();
+    
+    //outline the picked triangle and mark its closest corner
+    if(bPicking && bHit){
+        ofSetColor(0, 255, 255);
+        ofSetLineWidth(3);
+        for(int k = 0; k < 3; k++){
+            ofDrawLine(mesh.getVertex(hit.vertices[k]), mesh.getVertex(hit.vertices[(k + 1) % 3]));
+        }
+        ofDrawSphere(mesh.getVertex(hit.vertex), 3);
+        ofSetColor(255);
+    }
     
     
     //finish wrapping the camera so it knows what is going to be manipulated and what isnt
     cam.end();
 
-    
+    if(bMemory){
+        ofDisableDepthTest();
+        memory.draw(ofGetWidth() - 440, 20);
+        ofEnableDepthTest();
+    }
+
+    //the first time this logs how long it took to get here since the app started
+    loader.frameDrawn();
     
 }
 
@@ -228,9 +446,131 @@ void ofApp::keyPressed(int key){
     if(key == 'w'){
         bWireframe = !bWireframe;
     }
+    
+    //swap between the full mesh and the lighter one.
+    //update() only looks at the XY of each vertex so it works on either
+    if(key == 'd'){
+        bPreview = !bPreview;
+        mesh = bPreview ? previewMesh : originalMesh;
+        numVerts = mesh.getNumVertices();
+        
+        if(bCulling) culler.setup(mesh);
+        
+        //different triangles, so a new tree
+        bvh.build(mesh);
+        bHit = false;
+        
+        //and different vertices to lift
+        displacement.setup(mesh);
+        if(bLuminance) displacement.update(movie.getPixels(), mesh, 100);
+        
+        if(bStreams) streams.setup(mesh, VertexStreams::POSITION, false);
+        
+        //new rest pose
+        bounds.compute(mesh);
+    }
+    
+    //culling swaps out the indices (and mode) every frame
+    //so put the originals back when we turn it off
+    if(key == 'c'){
+        bCulling = !bCulling;
+        mesh = bPreview ? previewMesh : originalMesh;
+        
+        if(bCulling) culler.setup(mesh);
+        if(bLuminance) displacement.update(movie.getPixels(), mesh, 100);
+        if(bStreams) streams.setup(mesh, VertexStreams::POSITION, false);
+    }
+    
+    if(key == 'p'){
+        bPicking = !bPicking;
+        bHit = false;
+    }
+    
+    //the positions change every frame, everything else is packed once.
+    //(no colors, the texture is drawn instead)
+    if(key == 'i'){
+        bStreams = !bStreams;
+        if(bStreams) streams.setup(mesh, VertexStreams::POSITION, false);
+    }
+    
+    //switch between the noise and the movie's brightness.
+    //Lift it straight away rather than waiting for the next movie frame
+    if(key == 'l'){
+        bLuminance = !bLuminance;
+        if(bLuminance) displacement.update(movie.getPixels(), mesh, 100);
+    }
+    
+    if(key == 'z'){
+        frameBounds();
+    }
+    
+    if(key == 'm'){
+        bMipmaps = !bMipmaps;
+    }
+    
+    if(key == 'M'){
+        bMemory = !bMemory;
+    }
+    
+    //write the memory table every few seconds, for leaving it running a long time
+    if(key == 'S'){
+        if(memory.isLogging()) memory.stopLog();
+        else memory.startLog("memory/02_memory.csv");
+    }
+    
+    //record the plane from here on, or finish the recording
+    if(key == 'R'){
+        if(recorder.isRecording()){
+            recorder.stop();
+        } else {
+            bPlaying = false;
+            recorder.start("recordings/plane.mrec", mesh);
+        }
+    }
+    
+    //play the recording back from the start (finishing it first if it's still going)
+    if(key == 'P'){
+        bPlaying = !bPlaying;
+        if(bPlaying){
+            recorder.stop();
+            bPlaying = player.load("recordings/plane.mrec");
+            playFrame = 0;
+        }
+    }
+    
+    //skip two seconds back or forward in the recording
+    if(bPlaying && (key == OF_KEY_LEFT || key == OF_KEY_RIGHT)){
+        int numFrames = player.getNumFrames();
+        playFrame = ((int)playFrame + (key == OF_KEY_LEFT ? -120 : 120) % numFrames + numFrames) % numFrames;
+    }
+    
+    //software render of the current frame: same camera and texture
+    //(the gradient background is replaced by its middle color)
+    if(key == 'f'){
+        if(rasterizer.getWidth() != ofGetWidth() || rasterizer.getHeight() != ofGetHeight()){
+            rasterizer.allocate(ofGetWidth(), ofGetHeight());
+        }
+        
+        rasterizer.clear(ofColor(40));
+        rasterizer.setCamera(cam);
+        rasterizer.setTexture(bLuminance ? &movie.getPixels() : &img.getPixels());
+        rasterizer.draw(mesh, bWireframe ? SoftwareRasterizer::WIREFRAME : SoftwareRasterizer::FILL);
+        rasterizer.save("frames/frame_" + ofToString(ofGetFrameNum(), 5, '0') + ".png");
+    }
+
+    
+    
+}
 
+//--------------------------------------------------------------
+void ofApp::frameBounds(){
     
+    //the sphere fits the view when its edge touches the sides of the
+    //camera's field of view: sin(half the fov) = radius / distance
+    float halfFov = ofDegToRad(cam.getFov() * 0.5);
     
+    cam.setTarget(bounds.getCenter());
+    cam.setDistance(bounds.getRadius() / sin(halfFov));
 }
 
 //--------------------------------------------------------------
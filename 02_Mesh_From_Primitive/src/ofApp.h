@@ -1,6 +1,20 @@
 #pragma once
 
 #include "ofMain.h"
+#include "MeshDecimator.h"
+#include "MeshletCuller.h"
+#include "MeshBVH.h"
+#include "SoftwareRasterizer.h"
+#include "LuminanceDisplacement.h"
+#include "VertexStreams.h"
+#include "MeshBounds.h"
+#include "AssetLoader.h"
+#include "MipPyramid.h"
+#include "MeshRecorder.h"
+#include "MeshPlayer.h"
+#include "TaskScheduler.h"
+#include "GeometryCache.h"
+#include "MeshMemory.h"
 
 class ofApp : public ofBaseApp{
 
@@ -28,6 +42,42 @@ class ofApp : public ofBaseApp{
     //another object that will hold the
     //original mesh values when we change them
     ofMesh originalMesh;
+    
+    //a lighter version of the same plane (fewer triangles) for previews
+    MeshDecimator decimator;
+    ofMesh previewMesh;
+    bool bPreview;
+    
+    //only draw the chunks of the plane that are on screen
+    MeshletCuller culler;
+    bool bCulling;
+    
+    //find the triangle under the mouse, even while the noise moves it around
+    MeshBVH bvh;
+    MeshBVH::Hit hit;
+    bool bPicking;
+    bool bHit;
+    
+    //draws the same thing on the CPU so frames can be saved without the GPU
+    SoftwareRasterizer rasterizer;
+    
+    //lifts the plane by how bright the movie is at each vertex (instead of the noise)
+    LuminanceDisplacement displacement;
+    bool bLuminance;
+    
+    //draw from interleaved buffers: normals + texcoords uploaded once,
+    //only the positions go to the GPU again every frame
+    VertexStreams streams;
+    bool bStreams;
+    
+    //box and sphere around the plane wherever it's been lifted to
+    MeshBounds bounds;
+    
+    //point the camera at the bounds and back it up until they fit the view
+    void frameBounds();
+    
+    //the plane with its colors and texcoords (setup() gets it through the GeometryCache)
+    void buildPlane(ofMesh& planeMesh, int columns, int rows);
 
     //convenience variables
     int numVerts;
@@ -43,4 +93,26 @@ class ofApp : public ofBaseApp{
     //to draw on the mesh
     ofVideoPlayer movie;
     ofImage img;
+    
+    //decodes the image and starts the movie in the background
+    //while setup() builds the mesh
+    AssetLoader loader;
+    
+    //the image with all its mipmaps, filtered on the CPU (and cached on disk)
+    //so the far end of the plane doesn't sparkle when it's tilted away
+    MipPyramid pyramid;
+    ofTexture mipTexture;
+    bool bMipmaps;
+    
+    //record the plane as it moves and play it back exactly the same later
+    //(the noise follows the mouse and the clock, so it never comes out the same twice)
+    MeshRecorder recorder;
+    MeshPlayer player;
+    bool bPlaying;
+    size_t playFrame;
+    
+    //what the full copies of the plane (mesh, originalMesh, previewMesh) cost,
+    //attribute by attribute. 'M' shows it, 'S' logs it to a .csv
+    MeshMemory memory;
+    bool bMemory;
 };
@@ -0,0 +1,198 @@
+#include "TriangleBodies.h"
+#include "TaskScheduler.h"
+
+//--------------------------------------------------------------
+TriangleBodies::TriangleBodies(){
+    gravity.set(0, -500, 0);
+    springStiffness = 20;
+    springDamping = 6;
+    reassembleTime = 2;
+    timeSinceExplosion = reassembleTime;
+    lastUpdateTimeMs = 0;
+}
+
+//--------------------------------------------------------------
+void TriangleBodies::setup(const ofMesh& restMesh){
+
+    const vector<ofVec3f>& verts = restMesh.getVertices();
+    size_t numBodies = verts.size() / 3;
+
+    restX.resize(numBodies);
+    restY.resize(numBodies);
+    restZ.resize(numBodies);
+    localX.resize(numBodies * 3);
+    localY.resize(numBodies * 3);
+    localZ.resize(numBodies * 3);
+
+    for(size_t i = 0; i < numBodies; i++){
+
+        //the center of the triangle is the body's position,
+        //the corners are stored relative to it
+        ofVec3f center = (verts[i * 3] + verts[i * 3 + 1] + verts[i * 3 + 2]) / 3.0;
+        restX[i] = center.x;
+        restY[i] = center.y;
+        restZ[i] = center.z;
+
+        for(int k = 0; k < 3; k++){
+            ofVec3f local = verts[i * 3 + k] - center;
+            localX[i * 3 + k] = local.x;
+            localY[i * 3 + k] = local.y;
+            localZ[i * 3 + k] = local.z;
+        }
+    }
+
+    reset();
+}
+
+//--------------------------------------------------------------
+void TriangleBodies::reset(){
+
+    posX = restX;
+    posY = restY;
+    posZ = restZ;
+
+    size_t numBodies = restX.size();
+    velX.assign(numBodies, 0);
+    velY.assign(numBodies, 0);
+    velZ.assign(numBodies, 0);
+    spinX.assign(numBodies, 0);
+    spinY.assign(numBodies, 0);
+    spinZ.assign(numBodies, 0);
+
+    //(0, 0, 0, 1) is "not rotated at all"
+    rotX.assign(numBodies, 0);
+    rotY.assign(numBodies, 0);
+    rotZ.assign(numBodies, 0);
+    rotW.assign(numBodies, 1);
+
+    timeSinceExplosion = reassembleTime;
+}
+
+//--------------------------------------------------------------
+void TriangleBodies::explode(const ofVec3f& center, float speed, float spin, RandomStream& random){
+
+    //8 random numbers (0 to 1) per body, all made at once. Every body
+    //only uses its own, so the bodies can be split up between the cores
+    vector<float> r(posX.size() * 8);
+    if(!r.empty()) random.fillUniform(&r[0], r.size(), 0, 1);
+
+    TaskScheduler::get().parallelFor(0, posX.size(), 1024, [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++){
+            const float* n = &r[i * 8];
+
+            ofVec3f dir = ofVec3f(posX[i], posY[i], posZ[i]) - center;
+            if(dir.lengthSquared() < 1e-6) dir.set(0, 0, 1);
+            dir.normalize();
+
+            //mostly away from the center, with a bit of randomness
+            //(and always some towards the camera so it's not all flat)
+            dir += ofVec3f(n[0] - 0.5, n[1] - 0.5, ofLerp(0.2, 1, n[2]));
+            dir = dir.getNormalized() * ofLerp(0.3, 1, n[3]) * speed;
+
+            velX[i] += dir.x;
+            velY[i] += dir.y;
+            velZ[i] += dir.z;
+
+            ofVec3f axis(n[4] * 2 - 1, n[5] * 2 - 1, n[6] * 2 - 1);
+            axis = axis.getNormalized() * n[7] * spin;
+            spinX[i] += axis.x;
+            spinY[i] += axis.y;
+            spinZ[i] += axis.z;
+        }
+    });
+
+    timeSinceExplosion = 0;
+}
+
+//--------------------------------------------------------------
+void TriangleBodies::update(float dt, ofMesh& mesh){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    vector<ofVec3f>& verts = mesh.getVertices();
+    size_t numBodies = posX.size();
+    if(verts.size() < numBodies * 3) return;
+
+    //a long frame (like a window being dragged) shouldn't launch everything into space
+    dt = min(dt, 1 / 30.0f);
+
+    //fade the springs in after an explosion (smoothly, not linearly)
+    //and gravity out at the same time
+    timeSinceExplosion += dt;
+    float ramp = reassembleTime > 0 ? ofClamp(timeSinceExplosion / reassembleTime, 0, 1) : 1;
+    ramp = ramp * ramp * (3 - 2 * ramp);
+
+    float k = springStiffness * ramp;
+    float c = springDamping * ramp;
+    ofVec3f g = gravity * (1 - ramp);
+
+    TaskScheduler::get().parallelFor(0, numBodies, 1024, [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++){
+
+            //---- position: gravity + spring back to the rest position
+            //(update the velocity first, then move with the new velocity,
+            //which is a lot more stable than the other way around)
+            velX[i] += (g.x - k * (posX[i] - restX[i]) - c * velX[i]) * dt;
+            velY[i] += (g.y - k * (posY[i] - restY[i]) - c * velY[i]) * dt;
+            velZ[i] += (g.z - k * (posZ[i] - restZ[i]) - c * velZ[i]) * dt;
+
+            posX[i] += velX[i] * dt;
+            posY[i] += velY[i] * dt;
+            posZ[i] += velZ[i] * dt;
+
+            //---- rotation: a spring that turns it back to no rotation.
+            //For a quaternion, 2 * (x, y, z) points along the rotation axis and
+            //grows with the angle, good enough to use as the spring's stretch.
+            //(q and -q are the same rotation, so pick the one that's closer)
+            float qx = rotX[i], qy = rotY[i], qz = rotZ[i], qw = rotW[i];
+            float s = qw < 0 ? -2 : 2;
+
+            spinX[i] += (-k * s * qx - c * spinX[i]) * dt;
+            spinY[i] += (-k * s * qy - c * spinY[i]) * dt;
+            spinZ[i] += (-k * s * qz - c * spinZ[i]) * dt;
+
+            //turn the quaternion by the spin: dq = 0.5 * (spin, 0) * q.
+            //All four parts of dq come from the q we started the step with,
+            //so they're worked out before any of them is added
+            float wx = spinX[i], wy = spinY[i], wz = spinZ[i];
+            float h = 0.5 * dt;
+            float dx = h * ( wx * qw + wy * qz - wz * qy);
+            float dy = h * ( wy * qw + wz * qx - wx * qz);
+            float dz = h * ( wz * qw + wx * qy - wy * qx);
+            float dw = h * (-wx * qx - wy * qy - wz * qz);
+            qx += dx;
+            qy += dy;
+            qz += dz;
+            qw += dw;
+
+            float len = sqrt(qx * qx + qy * qy + qz * qz + qw * qw);
+            qx /= len;
+            qy /= len;
+            qz /= len;
+            qw /= len;
+
+            rotX[i] = qx;
+            rotY[i] = qy;
+            rotZ[i] = qz;
+            rotW[i] = qw;
+
+            //---- put the corners back around the body
+            //rotating v by q: t = 2 * (q.xyz x v), v' = v + w * t + q.xyz x t
+            for(int j = 0; j < 3; j++){
+                float vx = localX[i * 3 + j];
+                float vy = localY[i * 3 + j];
+                float vz = localZ[i * 3 + j];
+
+                float tx = 2 * (qy * vz - qz * vy);
+                float ty = 2 * (qz * vx - qx * vz);
+                float tz = 2 * (qx * vy - qy * vx);
+
+                verts[i * 3 + j].set(posX[i] + vx + qw * tx + (qy * tz - qz * ty),
+                                     posY[i] + vy + qw * ty + (qz * tx - qx * tz),
+                                     posZ[i] + vz + qw * tz + (qx * ty - qy * tx));
+            }
+        }
+    });
+
+    lastUpdateTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "ofMain.h"
+#include "RandomStream.h"
+
+/*
+ * Turns every triangle of the mesh into its own little rigid body so they can be
+ * blown apart and fly back together.
+ *
+ * Each body has a position (the center of its triangle), a rotation, a velocity
+ * and a spin. Every frame:
+ *  - gravity pulls it down
+ *  - a spring pulls it back to where it started and another one turns it back
+ *    to its original rotation (both with some damping so they settle down)
+ *  - the three corners are put back around the new position with the new rotation
+ *
+ * Right after an explosion the springs are off and gravity takes over. Over the
+ * next couple of seconds the springs fade in (and gravity fades out) so all the
+ * pieces find their way home smoothly.
+ *
+ * The bodies are stored "structure of arrays" style (all the x positions together,
+ * all the y positions together...), which keeps the loop simple and lets the
+ * update run in chunks across all the cores.
+ *
+ * Just like the rest of 03, the mesh has to be plain OF_PRIMITIVE_TRIANGLES with
+ * every 3 vertices making one triangle (no indices).
+ */
+
+class TriangleBodies {
+
+	public:
+
+    TriangleBodies();
+
+    //one body per triangle of the mesh in its rest pose
+    void setup(const ofMesh& restMesh);
+
+    //kick every triangle away from center with a random speed up to "speed"
+    //(units per second) and a random spin up to "spin" (radians per second)
+    void explode(const ofVec3f& center, float speed, float spin, RandomStream& random);
+
+    //move everything forward by dt seconds and write the triangles into mesh
+    void update(float dt, ofMesh& mesh);
+
+    //put everything back at rest
+    void reset();
+
+    void setGravity(const ofVec3f& g) { gravity = g; }
+
+    //stiffness is how hard the springs pull, damping how quickly they calm down
+    void setSpring(float stiffness, float damping) { springStiffness = stiffness; springDamping = damping; }
+
+    //how long after an explosion the springs take to come back to full strength
+    void setReassembleTime(float seconds) { reassembleTime = seconds; }
+
+    size_t getNumBodies() const { return restX.size(); }
+    float getLastUpdateTimeMs() const { return lastUpdateTimeMs; }
+
+    private:
+
+    //rest pose
+    vector<float> restX, restY, restZ;
+
+    //corners relative to the center, 3 per body, in the rest rotation
+    vector<float> localX, localY, localZ;
+
+    //state
+    vector<float> posX, posY, posZ;
+    vector<float> velX, velY, velZ;
+    vector<float> rotX, rotY, rotZ, rotW;      //rotation as a quaternion
+    vector<float> spinX, spinY, spinZ;         //angular velocity
+
+    ofVec3f gravity;
+    float springStiffness;
+    float springDamping;
+    float reassembleTime;
+    float timeSinceExplosion;
+
+    float lastUpdateTimeMs;
+};
@@ -0,0 +1,279 @@
+#include "TriangleInstances.h"
+#include "TaskScheduler.h"
+
+//where the per instance attributes go. Kept clear of the ones some drivers
+//share with the built in attributes (0 vertex, 2 normal, 3 color, 8+ texcoords)
+static const int translationLocation = 6;
+static const int texOffsetLocation = 7;
+
+//GLSL 1.20 so it runs next to OF's fixed function drawing. The template's corners
+//come in as gl_Vertex / gl_MultiTexCoord0, the instance's offsets are added on
+static const string vertexShader = R"(
+#version 120
+attribute vec3 translation;
+attribute vec2 texOffset;
+void main(){
+    gl_Position = gl_ModelViewProjectionMatrix * vec4(gl_Vertex.xyz + translation, 1.0);
+    gl_TexCoord[0] = vec4(gl_MultiTexCoord0.xy + texOffset, 0.0, 1.0);
+    gl_FrontColor = gl_Color;
+}
+)";
+
+//the texcoords are in pixels, so the texture is a rectangle one (OF's default)
+static const string fragmentShader = R"(
+#version 120
+#extension GL_ARB_texture_rectangle : enable
+uniform sampler2DRect tex;
+uniform float textured;
+void main(){
+    vec4 color = gl_Color;
+    if(textured > 0.5) color *= texture2DRect(tex, gl_TexCoord[0].xy);
+    gl_FragColor = color;
+}
+)";
+
+//--------------------------------------------------------------
+TriangleInstances::TriangleInstances(){
+    bTexCoords = false;
+    progress = 1;
+    duration = 1;
+    instancedSupport = -1;
+    bDrawingSetup = false;
+    bUpload = false;
+    lastUpdateTimeMs = 0;
+}
+
+//--------------------------------------------------------------
+void TriangleInstances::setup(const ofMesh& restMesh, float tolerance){
+
+    const vector<ofVec3f>& verts = restMesh.getVertices();
+    const vector<ofVec2f>& texCoords = restMesh.getTexCoords();
+    size_t numTriangles = verts.size() / 3;
+    bTexCoords = texCoords.size() == verts.size();
+
+    //the shape of every triangle, rounded to the tolerance, is looked up in a map
+    //so meshes with lots of different shapes don't get slow. Shapes right on a
+    //rounding edge can end up as two templates, which just costs a bit of memory
+    templates.clear();
+    map<vector<int64_t>, size_t> shapes;
+    vector<unsigned> templateOf(numTriangles);
+    vector<size_t> counts;
+
+    for(size_t i = 0; i < numTriangles; i++){
+
+        Template t;
+        for(int k = 0; k < 3; k++){
+            t.corners[k] = verts[i * 3 + k] - verts[i * 3];
+            t.texCoords[k] = bTexCoords ? texCoords[i * 3 + k] - texCoords[i * 3] : ofVec2f(0, 0);
+        }
+
+        vector<int64_t> shape;
+        for(int k = 1; k < 3; k++){
+            shape.push_back(llround(t.corners[k].x / tolerance));
+            shape.push_back(llround(t.corners[k].y / tolerance));
+            shape.push_back(llround(t.corners[k].z / tolerance));
+            shape.push_back(llround(t.texCoords[k].x / tolerance));
+            shape.push_back(llround(t.texCoords[k].y / tolerance));
+        }
+
+        auto found = shapes.find(shape);
+        if(found == shapes.end()){
+            found = shapes.insert(make_pair(shape, templates.size())).first;
+            templates.push_back(t);
+            counts.push_back(0);
+        }
+        templateOf[i] = found->second;
+        counts[found->second]++;
+    }
+
+    //lay the instances out template by template, so each template's
+    //instances are one run in the arrays (and one draw call)
+    size_t begin = 0;
+    for(size_t t = 0; t < templates.size(); t++){
+        templates[t].begin = templates[t].end = begin;
+        begin += counts[t];
+    }
+
+    restTranslations.resize(numTriangles);
+    texOffsets.resize(numTriangles);
+    triangles.resize(numTriangles);
+    for(size_t i = 0; i < numTriangles; i++){
+        size_t instance = templates[templateOf[i]].end++;
+        restTranslations[instance] = verts[i * 3];
+        texOffsets[instance] = bTexCoords ? texCoords[i * 3] : ofVec2f(0, 0);
+        triangles[instance] = i;
+    }
+
+    bDrawingSetup = false;
+    reset();
+}
+
+//--------------------------------------------------------------
+void TriangleInstances::reset(){
+    translations = restTranslations;
+    fromTranslations = restTranslations;
+    toTranslations = restTranslations;
+    progress = 1;
+    bUpload = true;
+}
+
+//--------------------------------------------------------------
+void TriangleInstances::startMove(float duration){
+    fromTranslations = translations;
+    this->duration = max(duration, 0.001f);
+    progress = 0;
+}
+
+//--------------------------------------------------------------
+void TriangleInstances::scatter(float distance, float duration, RandomStream& random){
+
+    //one random offset per triangle moves its three corners together,
+    //just like scattering the mesh does. They're made all at once, then added on
+    vector<ofVec3f> offsets(toTranslations.size());
+    if(!offsets.empty()) random.fillBox(&offsets[0], offsets.size(), ofVec3f(-distance), ofVec3f(distance));
+
+    TaskScheduler::get().parallelFor(0, toTranslations.size(), 4096, [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++){
+            toTranslations[i] += offsets[i];
+        }
+    });
+    startMove(duration);
+}
+
+//--------------------------------------------------------------
+void TriangleInstances::restore(float duration){
+    toTranslations = restTranslations;
+    startMove(duration);
+}
+
+//--------------------------------------------------------------
+bool TriangleInstances::update(float dt){
+
+    if(progress >= 1) return false;
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    //eased so it starts and stops gently (the same curve the morph uses)
+    progress = min(1.0f, progress + dt / duration);
+    float w = progress * progress * (3 - 2 * progress);
+
+    TaskScheduler::get().parallelFor(0, translations.size(), 4096, [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++){
+            translations[i] = fromTranslations[i] * (1 - w) + toTranslations[i] * w;
+        }
+    });
+
+    bUpload = true;
+    lastUpdateTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+    return true;
+}
+
+//--------------------------------------------------------------
+void TriangleInstances::expand(ofMesh& mesh) const{
+
+    vector<ofVec3f>& verts = mesh.getVertices();
+    verts.resize(triangles.size() * 3);
+
+    for(size_t t = 0; t < templates.size(); t++){
+        const Template& shape = templates[t];
+        TaskScheduler::get().parallelFor(shape.begin, shape.end, 4096, [&](size_t begin, size_t end){
+            for(size_t i = begin; i < end; i++){
+                ofVec3f* corners = &verts[triangles[i] * 3];
+                corners[0] = translations[i] + shape.corners[0];
+                corners[1] = translations[i] + shape.corners[1];
+                corners[2] = translations[i] + shape.corners[2];
+            }
+        });
+    }
+}
+
+//--------------------------------------------------------------
+bool TriangleInstances::canDrawInstanced(){
+
+    //the shader is written for the fixed function (GL 2.1) renderer
+    if(instancedSupport < 0){
+        instancedSupport = !ofIsGLProgrammableRenderer() &&
+                           ofGLCheckExtension("GL_ARB_instanced_arrays") &&
+                           ofGLCheckExtension("GL_ARB_draw_instanced");
+
+        if(instancedSupport){
+            shader.setupShaderFromSource(GL_VERTEX_SHADER, vertexShader);
+            shader.setupShaderFromSource(GL_FRAGMENT_SHADER, fragmentShader);
+            shader.bindAttribute(translationLocation, "translation");
+            shader.bindAttribute(texOffsetLocation, "texOffset");
+            instancedSupport = shader.linkProgram();
+        }
+
+        if(!instancedSupport){
+            ofLogWarning("TriangleInstances") << "no instanced arrays, the triangles will be expanded into the mesh instead";
+        }
+    }
+
+    return instancedSupport == 1;
+}
+
+//--------------------------------------------------------------
+void TriangleInstances::setupDrawing(){
+
+    //every instance's translation and texcoord offset, in one buffer each.
+    //The translations are uploaded again whenever they've moved
+    if(!translations.empty()){
+        translationBuffer.allocate(translations.size() * sizeof(ofVec3f), &translations[0], GL_STREAM_DRAW);
+        texOffsetBuffer.allocate(texOffsets.size() * sizeof(ofVec2f), &texOffsets[0], GL_STATIC_DRAW);
+    }
+
+    //one vbo per template: its 3 corners, plus the part of the instance
+    //buffers that belongs to it, moved on once per instance (divisor 1)
+    vbos.clear();
+    vbos.resize(templates.size());
+    for(size_t t = 0; t < templates.size(); t++){
+        const Template& shape = templates[t];
+        ofVbo& vbo = vbos[t];
+
+        vbo.setVertexData(shape.corners, 3, GL_STATIC_DRAW);
+        if(bTexCoords) vbo.setTexCoordData(shape.texCoords, 3, GL_STATIC_DRAW);
+
+        vbo.setAttributeBuffer(translationLocation, translationBuffer, 3, sizeof(ofVec3f), shape.begin * sizeof(ofVec3f));
+        vbo.setAttributeDivisor(translationLocation, 1);
+        vbo.setAttributeBuffer(texOffsetLocation, texOffsetBuffer, 2, sizeof(ofVec2f), shape.begin * sizeof(ofVec2f));
+        vbo.setAttributeDivisor(texOffsetLocation, 1);
+    }
+
+    bDrawingSetup = true;
+    bUpload = false;
+}
+
+//--------------------------------------------------------------
+void TriangleInstances::draw(ofTexture* tex){
+
+    if(translations.empty() || !canDrawInstanced()) return;
+
+    if(!bDrawingSetup){
+        setupDrawing();
+    } else if(bUpload){
+        translationBuffer.updateData(0, translations.size() * sizeof(ofVec3f), &translations[0]);
+        bUpload = false;
+    }
+
+    shader.begin();
+    if(tex != nullptr && bTexCoords){
+        shader.setUniformTexture("tex", *tex, 0);
+        shader.setUniform1f("textured", 1);
+    } else {
+        shader.setUniform1f("textured", 0);
+    }
+
+    for(size_t t = 0; t < templates.size(); t++){
+        if(templates[t].end > templates[t].begin){
+            vbos[t].drawInstanced(GL_TRIANGLES, 0, 3, templates[t].end - templates[t].begin);
+        }
+    }
+
+    shader.end();
+}
+
+//--------------------------------------------------------------
+size_t TriangleInstances::getNumBytes() const{
+    return templates.size() * (3 * sizeof(ofVec3f) + (bTexCoords ? 3 * sizeof(ofVec2f) : 0)) +
+           translations.size() * (sizeof(ofVec3f) + (bTexCoords ? sizeof(ofVec2f) : 0));
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "ofMain.h"
+#include "RandomStream.h"
+
+/*
+ * The grid in 03 is the same two triangles over and over, each one just shifted
+ * over by the grid spacing. The mesh still keeps 3 positions and 3 texcoords for
+ * every triangle (60 bytes), and scattering rewrites all 3 corners of each one.
+ *
+ * This keeps each different triangle shape once (a "template": its corners and
+ * texcoords relative to its first corner) and then, per triangle, only:
+ *
+ *  - a translation: where its first corner is right now      12 bytes
+ *  - a texcoord offset: where its first texcoord is           8 bytes (never changes)
+ *
+ * Scattering, restoring and the slide between the two only touch the
+ * translations, 12 bytes a triangle instead of 36.
+ *
+ * Drawing: with instanced arrays (most desktop GL 2.1 drivers) each template is
+ * drawn once with the translations as a per-instance attribute, so only those
+ * get uploaded every frame. Without them (or when something needs the actual
+ * triangles, like picking) expand() writes the triangles into a plain mesh.
+ *
+ * The triangles only ever move, they don't turn, so there's no rotation in the
+ * instance data. Physics (which spins them) stays on the mesh.
+ * The mesh has to be plain OF_PRIMITIVE_TRIANGLES (every 3 vertices are one triangle).
+ */
+
+class TriangleInstances {
+
+	public:
+
+    TriangleInstances();
+
+    //find the different triangle shapes in the mesh and make one instance per triangle.
+    //Corners that are within tolerance of each other count as the same shape
+    void setup(const ofMesh& restMesh, float tolerance = 0.001);
+
+    //everything back at rest, not moving
+    void reset();
+
+    //move every triangle's target by a random amount up to distance on each axis,
+    //or back to where it started, and slide there over the next duration seconds
+    void scatter(float distance, float duration, RandomStream& random);
+    void restore(float duration);
+
+    //carry on sliding. Returns true if anything moved
+    bool update(float dt);
+    bool isMoving() const { return progress < 1; }
+
+    //write every triangle's corners (at its current translation) into the mesh.
+    //The texcoords are the same as in the rest mesh and are left alone
+    void expand(ofMesh& mesh) const;
+
+    //whether the GPU can draw them straight from the instance data
+    bool canDrawInstanced();
+
+    //draw every instance of every template, textured with tex (or not at all)
+    void draw(ofTexture* tex = nullptr);
+
+    size_t getNumInstances() const { return translations.size(); }
+    size_t getNumTemplates() const { return templates.size(); }
+
+    //memory to draw from: templates + instances, and the same triangles as a mesh
+    size_t getNumBytes() const;
+    size_t getMeshBytes() const { return translations.size() * 3 * (sizeof(ofVec3f) + (bTexCoords ? sizeof(ofVec2f) : 0)); }
+
+    //what a frame of sliding writes (and draw() uploads), and what moving
+    //every vertex of the mesh writes
+    size_t getBytesPerFrame() const { return translations.size() * sizeof(ofVec3f); }
+    size_t getMeshBytesPerFrame() const { return translations.size() * 3 * sizeof(ofVec3f); }
+
+    float getLastUpdateTimeMs() const { return lastUpdateTimeMs; }
+
+    private:
+
+    //one triangle shape, corners relative to the first one
+    struct Template {
+        ofVec3f corners[3];
+        ofVec2f texCoords[3];
+
+        //its instances are [begin, end) in the instance arrays
+        size_t begin, end;
+    };
+
+    //start sliding from wherever the triangles are now
+    void startMove(float duration);
+
+    void setupDrawing();
+
+    vector<Template> templates;
+
+    //per instance (sorted by template). triangles[i] is the instance's triangle in the mesh
+    vector<ofVec3f> translations;
+    vector<ofVec3f> restTranslations;
+    vector<ofVec3f> fromTranslations;
+    vector<ofVec3f> toTranslations;
+    vector<ofVec2f> texOffsets;
+    vector<unsigned> triangles;
+    bool bTexCoords;
+
+    float progress;
+    float duration;
+
+    //-1 until the GPU has been asked, then 0 or 1
+    int instancedSupport;
+    bool bDrawingSetup;
+    bool bUpload;
+    vector<ofVbo> vbos;
+    ofShader shader;
+    ofBufferObject translationBuffer;
+    ofBufferObject texOffsetBuffer;
+
+    float lastUpdateTimeMs;
+};
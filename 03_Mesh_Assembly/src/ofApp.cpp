@@ -7,15 +7,104 @@ void ofApp::setup(){
     ofEnableDepthTest();
     ofEnableAlphaBlending();
     
-    movie.load("trapped.mov");
+    //a new seed every launch (it's logged). Put a number here
+    //instead to scatter the triangles the same way every time
+    uint64_t seed = ofGetUnixTime();
+    ofLogNotice("ofApp") << "random seed " << seed;
+    randomStream.setSeed(seed);
+    
+    //start loading the movie and the image without waiting for them.
+    //The movie's size comes from its header right away, that's all
+    //the grid needs. The rest loads while we build it
+    std::shared_future<ofVec2f> movieSize = loader.loadMovie(movie, "trapped.mov");
     movie.setLoopState(OF_LOOP_NORMAL);
     
-    img.load("stars.png");
+    AssetLoader::Image stars = loader.loadImage("stars.png");
+    
+    //how long it may take to get the first frame up (logged after the first draw)
+    loader.setStartupBudgetMs(1000);
     
     
 
     
     
+    //Number of grid points in our mesh in each direction
+    //These can be higher, but bigger triangles make it easier to see the movie texture
+    int numX = 4;
+    int numY = 4;
+    
+    //this will set the overall mesh dimensions to the same as
+    //that of the movie file you give it
+    int meshWidth = movieSize.get().x;
+    int meshHeight = movieSize.get().y;
+    
+    //the grid only depends on these numbers, so it's only built the first time.
+    //After that it comes out of data/meshcache (buildGrid() below is how it's made)
+    GeometryCache::Key gridKey("03 grid");
+    gridKey.add(numX).add(numY).add(meshWidth).add(meshHeight);
+    mesh = *GeometryCache::get().getMesh(gridKey, [&](ofMesh& grid){ buildGrid(grid, numX, numY, meshWidth, meshHeight); });
+    
+    
+    //get a copy of the mesh and store it so we can know the original
+    //data after we've manipulated it
+    originalMesh = mesh;
+    
+    
+    //the grid can be seen from both sides so only cull what's off screen
+    culler.setConeCulling(false);
+    bCulling = false;
+    
+    //scattering and restoring only move vertices around, the triangles stay the
+    //same, so the tree is built once and refit to wherever they are now
+    bvh.build(originalMesh);
+    bPicking = false;
+    bHit = false;
+    
+    //one rigid body per triangle, starting from the original positions
+    bodies.setup(originalMesh);
+    bPhysics = false;
+    
+    //the grid is two shapes repeated, so it's two templates plus a translation
+    //(and a texcoord offset) per triangle
+    instances.setup(originalMesh);
+    bInstanced = false;
+    bExpandPending = false;
+    
+    //both morph targets start out as the original pose (so they're empty)
+    morph.setup(originalMesh);
+    morph.addTarget(originalMesh);
+    morph.addTarget(originalMesh);
+    scatterMesh = originalMesh;
+    morphProgress = 1;
+    morphTime = 0.75;
+    
+    //the texcoords are the movie's pixels, so every corner
+    //reads the brightness of the pixel drawn on it
+    displacement.setup(scatterMesh);
+    bLuminance = false;
+    luminanceHeight = 100;
+    
+    ofDirectory::createDirectory("recordings", true, true);
+    ofDirectory::createDirectory("export", true, true);
+    bPlaying = false;
+    playFrame = 0;
+    
+    //the image has been decoding this whole time, now it goes to the GPU
+    img.setFromPixels(stars.pixels.get());
+    
+    memory.addMesh("mesh", mesh);
+    memory.addMesh("originalMesh", originalMesh);
+    memory.addMesh("scatterMesh", scatterMesh);
+    memory.add("instances", "all", [&](size_t& live, size_t& allocated){
+        live = allocated = instances.getNumBytes();
+    });
+    bMemory = false;
+    
+}
+
+//--------------------------------------------------------------
+void ofApp::buildGrid(ofMesh& grid, int numX, int numY, int meshWidth, int meshHeight){
+
     /*
      * Now we'll construct a mesh from scratch instead of getting it from a primitive
      * Since we'll add vertices in the order that makes sense for a OF_PRIMITIVE_TRIANGLES
@@ -52,17 +141,7 @@ void ofApp::setup(){
     
     //set the mode. "OF_PRIMITIVE_TRIANGLES" expects triplets of
     //vertices, one triplet per triangle
-    mesh.setMode(OF_PRIMITIVE_TRIANGLES);
-    
-    //Number of grid points in our mesh in each direction
-    //These can be higher, but bigger triangles make it easier to see the movie texture
-    int numX = 4;
-    int numY = 4;
-    
-    //this will set the overall mesh dimensions to the same as
-    //that of the movie file you give it
-    int meshWidth = movie.getWidth();
-    int meshHeight = movie.getHeight();
+    grid.setMode(OF_PRIMITIVE_TRIANGLES);
     
 
     //space between X and Y grid points
@@ -89,15 +168,15 @@ void ofApp::setup(){
             v3 *= gridSpacing;
             
             //add the first triangle's vertices to the mesh
-            mesh.addVertex(v1);
-            mesh.addVertex(v2);
-            mesh.addVertex(v3);
+            grid.addVertex(v1);
+            grid.addVertex(v2);
+            grid.addVertex(v3);
             
             //add the same vertices as texture coordinates. this will map the texture
             //linearly (no warping/stretching) but beware of situations where the size of the texture doesn't match the size of the mesh.
-            mesh.addTexCoord(v1);
-            mesh.addTexCoord(v2);
-            mesh.addTexCoord(v3);
+            grid.addTexCoord(v1);
+            grid.addTexCoord(v2);
+            grid.addTexCoord(v3);
             
             
             //Create points for the second triangle
@@ -111,14 +190,14 @@ void ofApp::setup(){
             v6 *= gridSpacing;
         
             //add second triangle
-            mesh.addVertex(v4);
-            mesh.addVertex(v5);
-            mesh.addVertex(v6);
+            grid.addVertex(v4);
+            grid.addVertex(v5);
+            grid.addVertex(v6);
             
             //add next texCoords
-            mesh.addTexCoord(v4);
-            mesh.addTexCoord(v5);
-            mesh.addTexCoord(v6);
+            grid.addTexCoord(v4);
+            grid.addTexCoord(v5);
+            grid.addTexCoord(v6);
             
             
         }
@@ -129,16 +208,9 @@ void ofApp::setup(){
     //Since our mesh starts at (0,0) at the upper left corner, go through
     //all the mesh points and shift them over by half the width and height
     //so it is centered around the origin and draws nicer
-    for(int i = 0; i < mesh.getNumVertices(); i++){
-        mesh.setVertex(i, mesh.getVertex(i) - ofVec2f(meshWidth/2, meshHeight/2));
+    for(size_t i = 0; i < grid.getNumVertices(); i++){
+        grid.setVertex(i, grid.getVertex(i) - ofVec2f(meshWidth/2, meshHeight/2));
     }
-    
-    
-    //get a copy of the mesh and store it so we can know the original
-    //data after we've manipulated it
-    originalMesh = mesh;
-    
-    
 }
 
 //--------------------------------------------------------------
@@ -146,6 +218,73 @@ void ofApp::update(){
     
     //update the movie so our texture has the next frame
     movie.update();
+    
+    //Playback: take the triangles from the recording instead of
+    //moving them, one frame per update and around again at the end
+    if(bPlaying){
+        
+        if(player.getFrame(playFrame, mesh)){
+            playFrame = (playFrame + 1) % player.getNumFrames();
+        } else {
+            bPlaying = false;
+        }
+        
+    } else if(bInstanced){
+        
+        //only the translations slide. The triangles are written into the mesh
+        //when it's drawn from, or picking, culling or the recorder need it
+        if(instances.update(ofGetLastFrameTime())){
+            bExpandPending = true;
+        }
+        if(bExpandPending && (!isDrawingInstances() || bPicking || recorder.isRecording())){
+            instances.expand(mesh);
+            bExpandPending = false;
+        }
+        
+    } else {
+        
+        //move all the triangles along and write them into the mesh
+        if(bPhysics){
+            bodies.update(ofGetLastFrameTime(), mesh);
+        }
+    
+        //slide from the old pose to the new one (eased so it starts and stops gently)
+        if(!bPhysics && morphProgress < 1){
+            morphProgress = min(1.0, morphProgress + ofGetLastFrameTime() / morphTime);
+            float w = morphProgress * morphProgress * (3 - 2 * morphProgress);
+        
+            morph.setWeight(0, 1 - w);
+            morph.setWeight(1, w);
+            morph.apply(mesh);
+        }
+    
+        //Movie luminance: once the mesh has arrived, keep lifting it by the
+        //brightness of each new movie frame (read straight from the movie's pixels)
+        if(bLuminance && !bPhysics && morphProgress >= 1 && movie.isFrameNew()){
+            displacement.update(movie.getPixels(), mesh, luminanceHeight);
+        }
+    }
+    
+    //save wherever they ended up as the next frame of the recording
+    if(recorder.isRecording()){
+        recorder.addFrame(mesh);
+    }
+    
+    //Picking: fit the tree around the current triangles and shoot a ray
+    //from the camera through the mouse
+    if(bPicking){
+        bvh.refit(mesh);
+        bHit = bvh.pick(mesh, cam, ofVec2f(mouseX, mouseY), ofGetCurrentViewport(), hit);
+    }
+    
+    //Meshlet culling: give the mesh indices for only the triangles inside the view.
+    //Scattering moves the triangles around so the bounds are updated every frame
+    if(bCulling){
+        culler.updateBounds(mesh);
+        culler.cull(cam, ofGetCurrentViewport(), mesh.getIndices());
+    }
+    
+    memory.update();
 
 }
 
@@ -168,6 +307,57 @@ void ofApp::draw(){
     ofDrawBitmapString("Press SPACEBAR to randomize the triangles in the mesh", 15, 60);
     ofDrawBitmapString("Press 'r' to restore the vertex positions from the original mesh", 15, 75);
     ofDrawBitmapString("Press 'w' to toggle wireframe drawing", 15, 90);
+    ofDrawBitmapString("Press 'c' to toggle meshlet culling", 15, 105);
+    ofDrawBitmapString("Press 'p' to toggle picking with the mouse", 15, 120);
+    ofDrawBitmapString("Press 'b' to toggle physics (SPACEBAR explodes, the pieces spring back)", 15, 150);
+    ofDrawBitmapString("Press 'l' to toggle lifting the triangles by the movie's brightness", 15, 180);
+    
+    if(bLuminance){
+        ofDrawBitmapString("Luminance displacement: " + ofToString(displacement.getLastUpdateTimeMs(), 3) + " ms", 15, 195);
+    }
+    
+    ofDrawBitmapString("Press 'R' to start/stop recording the triangles, 'P' to play the recording back (left/right arrows skip)", 15, 225);
+    if(recorder.isRecording()){
+        ofDrawBitmapString("Recording: " + ofToString(recorder.getNumFrames()) + " frames, " + ofToString(recorder.getNumBytes() / 1024) + " KB (" + ofToString(recorder.getCompressionRatio(), 1) + "x smaller)  encode: " + ofToString(recorder.getLastEncodeTimeMs(), 2) + " ms", 15, 240);
+    }
+    if(bPlaying){
+        ofDrawBitmapString("Playing: frame " + ofToString(playFrame) + " / " + ofToString(player.getNumFrames()) + " (" + ofToString(player.getCompressionRatio(), 1) + "x smaller)  decode: " + ofToString(player.getLastDecodeTimeMs(), 2) + " ms for " + ofToString(player.getLastNumFramesDecoded()) + " frames, " + ofToString(player.getDecodeMBPerSecond(), 0) + " MB/s", 15, 240);
+    }
+    
+    ofDrawBitmapString("Press 'x' to compress the grid to data/export/grid.mcdc", 15, 255);
+    if(!codecInfo.empty()){
+        ofDrawBitmapString(codecInfo, 15, 270);
+    }
+    
+    ofDrawBitmapString("Press 'n' to toggle instanced triangles (SPACEBAR and 'r' only move one translation per triangle)", 15, 285);
+    if(bInstanced){
+        string instanceInfo = "Instances: " + ofToString(instances.getNumInstances()) + " of " + ofToString(instances.getNumTemplates()) + " shapes, " + ofToString(instances.getNumBytes() / 1024.0, 1) + " KB instead of " + ofToString(instances.getMeshBytes() / 1024.0, 1) + " KB";
+        instanceInfo += "  slide: " + ofToString(instances.getBytesPerFrame() / 1024.0, 1) + " KB a frame instead of " + ofToString(instances.getMeshBytesPerFrame() / 1024.0, 1) + " KB (" + ofToString(instances.getLastUpdateTimeMs(), 3) + " ms)";
+        instanceInfo += isDrawingInstances() ? "  drawn instanced" : "  drawn from the mesh";
+        ofDrawBitmapString(instanceInfo, 15, 300);
+    }
+    ofDrawBitmapString("Press 'M' to toggle the memory overlay, 'S' to start/stop logging it to a .csv", 15, 315);
+    if(bMemory){
+        memory.draw(ofGetWidth() - 440, 20);
+    }
+    
+    if(bPhysics){
+        ofDrawBitmapString("Bodies: " + ofToString(bodies.getNumBodies()) + "  update: " + ofToString(bodies.getLastUpdateTimeMs(), 2) + " ms", 15, 165);
+    } else {
+        ofDrawBitmapString("Morph: " + ofToString(morph.getNumDeltas(0)) + " -> " + ofToString(morph.getNumDeltas(1)) + " moved vertices  blend: " + ofToString(morph.getLastApplyTimeMs(), 3) + " ms", 15, 165);
+    }
+    
+    if(bCulling){
+        ofDrawBitmapString("Meshlets: " + ofToString(culler.getMeshlets().size()) + "  culled: " + ofToString(culler.getCulledPercent(), 1) + "%  time: " + ofToString(culler.getLastCullTimeMs(), 3) + " ms", 15, 45);
+    }
+    
+    if(bPicking){
+        string pickInfo = "Refit: " + ofToString(bvh.getLastRefitTimeMs(), 2) + " ms  query: " + ofToString(bvh.getLastQueryTimeUs(), 1) + " us";
+        if(bHit){
+            pickInfo += "  triangle: " + ofToString(hit.triangle) + "  vertex: " + ofToString(hit.vertex) + "  uv: " + ofToString(hit.u, 2) + ", " + ofToString(hit.v, 2);
+        }
+        ofDrawBitmapString(pickInfo, 15, 135);
+    }
     
     //start the camera so we can move our mesh around
     cam.begin();
@@ -176,7 +366,9 @@ void ofApp::draw(){
     //bind the texture, but only if the movie has actually loaded
     if(movie.isLoaded()) movie.getTexture().bind();
     
-    if(bWire){
+    if(isDrawingInstances()){
+        instances.draw(movie.isLoaded() ? &movie.getTexture() : nullptr);
+    } else if(bWire){
         mesh.drawWireframe();
     } else {
         mesh.draw();
@@ -185,9 +377,22 @@ void ofApp::draw(){
     //unbind (if the movie has loaded)
     if(movie.isLoaded()) movie.getTexture().unbind();
     
+    //outline the picked triangle and mark its closest corner
+    if(bPicking && bHit){
+        ofSetColor(0, 255, 255);
+        ofSetLineWidth(3);
+        for(int k = 0; k < 3; k++){
+            ofDrawLine(mesh.getVertex(hit.vertices[k]), mesh.getVertex(hit.vertices[(k + 1) % 3]));
+        }
+        ofDrawSphere(mesh.getVertex(hit.vertex), 3);
+        ofSetColor(255);
+    }
+    
     //finish camera manipulation
     cam.end();
     
+    //the first time this logs how long it took to get here since the app started
+    loader.frameDrawn();
     
 }
 
@@ -198,42 +403,197 @@ void ofApp::keyPressed(int key){
         bWire = !bWire;
     }
     
+    //in physics mode give every triangle a kick away from the middle instead
+    if(key == ' ' && bPhysics){
+        bodies.explode(ofVec3f(0, 0, 0), 800, 8, randomStream);
+    }
+    
+    //in instanced mode only the translations are scattered
+    if(key == ' ' && bInstanced){
+        instances.scatter(100, morphTime, randomStream);
+    }
+    
     //scatter all the triangles
-    if(key == ' '){
+    if(key == ' ' && !bPhysics && !bInstanced){
         
         
+        //one random direction per triangle, all made at once
+        //(up to dist on each axis, every triangle gets its own)
+        float dist = 100;
+        vector<ofVec3f> scatters(scatterMesh.getNumVertices() / 3);
+        if(!scatters.empty()) randomStream.fillBox(&scatters[0], scatters.size(), ofVec3f(-dist), ofVec3f(dist));
+        
         //go through all the points by 3's (3 verts in each triangle)
-        //and give them a random distance
-        for(int i = 0; i < mesh.getNumVertices(); i += 3){
+        //and give them a random distance. This moves the pose we're heading
+        //to, the mesh slides over to it in update()
+        for(size_t i = 0; i < scatterMesh.getNumVertices(); i += 3){
             
-            //create a random direction then add that same ofVec3f to all three
+            //take the triangle's random direction then add that same ofVec3f to all three
             //vertices. Doing it this way moves the three vertices in each triangle
             //the same amount keeping the triangle together. Try giving each
             //vertex a different random amount and see what happens
             
-            ofVec3f scatter;
-            float dist = 100;
-            scatter.set(ofRandom(-dist, dist), ofRandom(-dist, dist), ofRandom(-dist, dist));
+            ofVec3f scatter = scatters[i / 3];
 
-            mesh.setVertex(i + 0, mesh.getVertex(i + 0) + scatter);
-            mesh.setVertex(i + 1, mesh.getVertex(i + 1) + scatter);
-            mesh.setVertex(i + 2, mesh.getVertex(i + 2) + scatter);
+            scatterMesh.setVertex(i + 0, scatterMesh.getVertex(i + 0) + scatter);
+            scatterMesh.setVertex(i + 1, scatterMesh.getVertex(i + 1) + scatter);
+            scatterMesh.setVertex(i + 2, scatterMesh.getVertex(i + 2) + scatter);
             
         }
-
-        
-        
         
+        startMorph();
     }
     
 
     //Since we kept a copy of the mesh when it was in its original state we can
-    //restore it very easily
+    //restore it very easily: just head back to it
     if(key == 'r'){
+        if(bInstanced){
+            instances.restore(morphTime);
+        } else if(bPhysics){
+            mesh = originalMesh;
+            bodies.reset();
+        } else {
+            scatterMesh = originalMesh;
+            startMorph();
+        }
+    }
+    
+    //physics always starts from the original layout
+    if(key == 'b'){
+        bPhysics = !bPhysics;
+        bInstanced = false;
+        mesh = originalMesh;
+        bodies.reset();
+        
+        scatterMesh = originalMesh;
+        morphProgress = 1;
+        bLuminance = false;
+    }
+    
+    //slide into (or out of) the lifted shape, physics is switched off for it
+    if(key == 'l'){
+        bLuminance = !bLuminance;
+        if(bPhysics || bInstanced){
+            if(bExpandPending) instances.expand(mesh);
+            bExpandPending = false;
+            bPhysics = false;
+            bInstanced = false;
+            scatterMesh = originalMesh;
+        }
+        startMorph();
+    }
+    
+    //instanced mode starts from the original layout too. Physics and the movie
+    //lifting move every corner on its own, so they're switched off
+    if(key == 'n'){
+        bInstanced = !bInstanced;
+        bPhysics = false;
+        bLuminance = false;
         mesh = originalMesh;
+        scatterMesh = originalMesh;
+        morphProgress = 1;
+        instances.reset();
+        bExpandPending = false;
+    }
+    
+    //the mesh doesn't have any indices of its own (every 3 vertices are a triangle)
+    //so when culling is switched off just clear the ones the culler added
+    if(key == 'c'){
+        bCulling = !bCulling;
+        
+        if(bCulling){
+            culler.setup(mesh);
+        } else {
+            mesh.clearIndices();
+        }
+    }
+    
+    if(key == 'p'){
+        bPicking = !bPicking;
+        bHit = false;
+    }
+    
+    //the grid as it was built, compressed the way it would be shipped to another
+    //machine. It's read straight back and checked against the original.
+    //(there are no indices, every triangle has its own 3 vertices)
+    if(key == 'x'){
+        string path = "export/grid.mcdc";
+        ofMesh decoded;
+        if(codec.save(path, originalMesh)){
+            float encodeTimeMs = codec.getLastEncodeTimeMs();
+            if(codec.load(path, decoded)){
+                MeshCodec::Errors errors = MeshCodec::compare(originalMesh, decoded);
+                codecInfo = "Compressed " + ofToString(codec.getLastRawBytes() / 1024) + " KB to " + ofToString(codec.getLastNumBytes() / 1024) + " KB (" + ofToString(codec.getCompressionRatio(), 1) + "x) in " + ofToString(encodeTimeMs, 1) + " ms, decoded in " + ofToString(codec.getLastDecodeTimeMs(), 1) + " ms (" + ofToString(codec.getDecodeGBPerSecond(), 2) + " GB/s)";
+                codecInfo += "\nLargest error: position " + ofToString(errors.position, 4) + "  texcoord " + ofToString(errors.texCoord, 3);
+            }
+        }
+    }
+    
+    //record the triangles from here on, or finish the recording
+    if(key == 'R'){
+        if(recorder.isRecording()){
+            recorder.stop();
+        } else {
+            bPlaying = false;
+            recorder.start("recordings/triangles.mrec", mesh);
+        }
+    }
+    
+    //play the recording back from the start (finishing it first if it's still going)
+    if(key == 'P'){
+        bPlaying = !bPlaying;
+        if(bPlaying){
+            recorder.stop();
+            bPlaying = player.load("recordings/triangles.mrec");
+            playFrame = 0;
+        }
+    }
+    
+    //skip two seconds back or forward in the recording
+    if(bPlaying && (key == OF_KEY_LEFT || key == OF_KEY_RIGHT)){
+        int numFrames = player.getNumFrames();
+        playFrame = ((int)playFrame + (key == OF_KEY_LEFT ? -120 : 120) % numFrames + numFrames) % numFrames;
+    }
+    
+    if(key == 'M'){
+        bMemory = !bMemory;
+    }
+    
+    //write the memory table every few seconds, for leaving it running a long time
+    if(key == 'S'){
+        if(memory.isLogging()) memory.stopLog();
+        else memory.startLog("memory/03_memory.csv");
+    }
+    
+    
+}
+
+//--------------------------------------------------------------
+void ofApp::startMorph(){
+    
+    //the lifting happens on top of the scattered pose, so take a snapshot of it
+    //with the current movie frame and head there. Once we arrive update()
+    //keeps it moving with the movie
+    ofMesh target = scatterMesh;
+    if(bLuminance){
+        displacement.setup(scatterMesh);
+        displacement.update(movie.getPixels(), target, luminanceHeight);
     }
     
+    //start from wherever the triangles are right now (even halfway through
+    //another move) so there's never a jump
+    morph.setTarget(0, mesh);
+    morph.setTarget(1, target);
+    morphProgress = 0;
+}
+
+//--------------------------------------------------------------
+bool ofApp::isDrawingInstances(){
     
+    //the culler hands the mesh its visible triangles, and the wireframe is the mesh's too
+    //(and playback writes straight into the mesh)
+    return bInstanced && !bWire && !bCulling && !bPlaying && instances.canDrawInstanced();
 }
 
 //--------------------------------------------------------------
@@ -1,6 +1,19 @@
 #pragma once
 
 #include "ofMain.h"
+#include "MeshletCuller.h"
+#include "MeshBVH.h"
+#include "TriangleBodies.h"
+#include "TriangleInstances.h"
+#include "MorphTargets.h"
+#include "LuminanceDisplacement.h"
+#include "AssetLoader.h"
+#include "MeshRecorder.h"
+#include "MeshPlayer.h"
+#include "MeshCodec.h"
+#include "GeometryCache.h"
+#include "MeshMemory.h"
+#include "RandomStream.h"
 
 class ofApp : public ofBaseApp{
 
@@ -21,6 +34,13 @@ class ofApp : public ofBaseApp{
 		void dragEvent(ofDragInfo dragInfo);
 		void gotMessage(ofMessage msg);
 		
+    //slide from wherever the mesh is now to scatterMesh
+    //(lifted by the movie if that's switched on)
+    void startMorph();
+    
+    //the numX by numY grid of triangles, centered (setup() gets it through the GeometryCache)
+    void buildGrid(ofMesh& grid, int numX, int numY, int meshWidth, int meshHeight);
+    
     //Our mesh objects
     ofMesh mesh;
     ofMesh originalMesh;
@@ -31,4 +51,65 @@ class ofApp : public ofBaseApp{
     ofEasyCam cam;
     ofVideoPlayer movie;
     ofImage img;
+    
+    //opens the movie and decodes the image in the background
+    //while setup() builds the grid
+    AssetLoader loader;
+    
+    //only draw the chunks of the grid that are on screen
+    MeshletCuller culler;
+    bool bCulling;
+    
+    //find the triangle under the mouse, wherever it has been scattered to
+    MeshBVH bvh;
+    MeshBVH::Hit hit;
+    bool bPicking;
+    bool bHit;
+    
+    //physics mode: every triangle is a rigid body that flies off
+    //when scattered and springs back to its place
+    TriangleBodies bodies;
+    bool bPhysics;
+    
+    //instanced mode: the two triangle shapes of the grid kept once, plus one
+    //translation per triangle. Scattering and restoring only move those
+    TriangleInstances instances;
+    bool bInstanced;
+    
+    //the instances have moved since they were last written into the mesh
+    bool bExpandPending;
+    
+    //drawn straight from the instances (otherwise from the mesh, which is
+    //also what picking, culling and recording need)
+    bool isDrawingInstances();
+    
+    //scattering and restoring slide smoothly between poses instead of jumping:
+    //target 0 is the pose we're leaving, target 1 the one we're heading to
+    MorphTargets morph;
+    ofMesh scatterMesh;
+    float morphProgress;
+    float morphTime;
+    
+    //lift the (scattered) triangles by how bright the movie is at each corner
+    LuminanceDisplacement displacement;
+    bool bLuminance;
+    float luminanceHeight;
+    
+    //record the triangles flying around and play them back exactly the same later
+    MeshRecorder recorder;
+    MeshPlayer player;
+    bool bPlaying;
+    size_t playFrame;
+    
+    //the grid squeezed for sending to other machines ('x')
+    MeshCodec codec;
+    string codecInfo;
+    
+    //what mesh, originalMesh and scatterMesh (three full copies of the grid)
+    //cost next to the instances. 'M' shows it, 'S' logs it to a .csv
+    MeshMemory memory;
+    bool bMemory;
+    
+    //the scattering (in every mode), the same every time for the same seed
+    RandomStream randomStream;
 };
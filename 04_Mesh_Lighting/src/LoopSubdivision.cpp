@@ -0,0 +1,449 @@
+#include "LoopSubdivision.h"
+
+#include "TaskScheduler.h"
+#include "MeshUtils.h"
+
+//the per edge/face/vertex loops are cheap, so hand them out a couple thousand at a time
+static const size_t grainSize = 2048;
+
+//--------------------------------------------------------------
+LoopSubdivision::LoopSubdivision(){
+    numLevelsRun = 0;
+    numEdgesSplit = 0;
+    lastTimeMs = 0;
+}
+
+//--------------------------------------------------------------
+void LoopSubdivision::subdivide(const ofMesh& src, ofMesh& dst, int levels){
+
+    //a metric that always says yes splits every edge
+    refine(src, dst, [](const ofVec3f&, const ofVec3f&){ return 1.0f; }, 0.0f, levels);
+}
+
+//--------------------------------------------------------------
+void LoopSubdivision::refine(const ofMesh& src, ofMesh& dst, const EdgeMetric& metric, float threshold, int maxLevels){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    numLevelsRun = 0;
+    numEdgesSplit = 0;
+
+    if(src.getMode() != OF_PRIMITIVE_TRIANGLES || !src.hasIndices()){
+        ofLogWarning("LoopSubdivision") << "refine(): expects an indexed OF_PRIMITIVE_TRIANGLES mesh";
+        dst = src;
+        return;
+    }
+
+    //ping-pong between two scratch meshes so we don't reallocate every level
+    const ofMesh* current = &src;
+
+    for(int level = 0; level < maxLevels; level++){
+
+        buildTopology(*current, topology);
+
+        //ask the metric about every edge
+        size_t numEdges = topology.edgeVerts.size() / 2;
+        splitFlags.assign(numEdges, 0);
+
+        const vector<ofVec3f>& verts = current->getVertices();
+
+        TaskScheduler::get().parallelFor(0, numEdges, grainSize, [&](size_t begin, size_t end){
+            for(size_t e = begin; e < end; e++){
+                const ofVec3f& a = verts[topology.edgeVerts[e * 2 + 0]];
+                const ofVec3f& b = verts[topology.edgeVerts[e * 2 + 1]];
+                splitFlags[e] = metric(a, b) > threshold;
+            }
+        });
+
+        int splitThisLevel = 0;
+        for(size_t e = 0; e < numEdges; e++){
+            splitThisLevel += splitFlags[e];
+        }
+
+        //nothing left to refine, we're done early
+        if(splitThisLevel == 0) break;
+
+        ofMesh& next = scratch[level % 2];
+        subdivideLevel(*current, topology, splitFlags, next);
+        current = &next;
+
+        numEdgesSplit += splitThisLevel;
+        numLevelsRun++;
+    }
+
+    dst = *current;
+
+    lastTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+LoopSubdivision::EdgeMetric LoopSubdivision::screenSpaceMetric(const ofCamera& cam, const ofRectangle& viewport){
+
+    //grab the matrix once so every edge only pays for two multiplies
+    ofMatrix4x4 mvp = cam.getModelViewProjectionMatrix(viewport);
+    float halfW = viewport.width * 0.5;
+    float halfH = viewport.height * 0.5;
+
+    return [mvp, halfW, halfH](const ofVec3f& a, const ofVec3f& b){
+        ofVec3f sa = a * mvp;
+        ofVec3f sb = b * mvp;
+
+        float dx = (sa.x - sb.x) * halfW;
+        float dy = (sa.y - sb.y) * halfH;
+        return sqrt(dx * dx + dy * dy);
+    };
+}
+
+//--------------------------------------------------------------
+void LoopSubdivision::buildTopology(const ofMesh& mesh, Topology& topo){
+
+    const vector<ofIndexType>& indices = mesh.getIndices();
+    size_t numFaces = indices.size() / 3;
+    size_t numVerts = mesh.getNumVertices();
+
+    //give every half edge a key made of its two (sorted) vertex indices
+    //then sort so that the two halves of the same edge end up next to each other
+    vector<pair<uint64_t, unsigned> > halfEdges(numFaces * 3);
+
+    TaskScheduler::get().parallelFor(0, numFaces, grainSize, [&](size_t begin, size_t end){
+        for(size_t f = begin; f < end; f++){
+            for(int k = 0; k < 3; k++){
+                uint64_t a = indices[f * 3 + k];
+                uint64_t b = indices[f * 3 + (k + 1) % 3];
+                uint64_t key = a < b ? (a << 32) | b : (b << 32) | a;
+                halfEdges[f * 3 + k] = make_pair(key, (unsigned)(f * 3 + k));
+            }
+        }
+    });
+
+    std::sort(halfEdges.begin(), halfEdges.end());
+
+    topo.edgeVerts.clear();
+    topo.edgeFaces.clear();
+    topo.faceEdges.assign(numFaces * 3, -1);
+
+    int edge = -1;
+    uint64_t lastKey = std::numeric_limits<uint64_t>::max();
+
+    for(size_t i = 0; i < halfEdges.size(); i++){
+
+        uint64_t key = halfEdges[i].first;
+        unsigned slot = halfEdges[i].second;
+
+        if(key != lastKey){
+            edge++;
+            lastKey = key;
+            topo.edgeVerts.push_back((ofIndexType)(key >> 32));
+            topo.edgeVerts.push_back((ofIndexType)(key & 0xffffffff));
+            topo.edgeFaces.push_back(slot);
+            topo.edgeFaces.push_back(-1);
+        } else if(topo.edgeFaces[edge * 2 + 1] < 0){
+            topo.edgeFaces[edge * 2 + 1] = slot;
+        }
+        //non-manifold edges (3+ faces) just keep the first two
+
+        topo.faceEdges[slot] = edge;
+    }
+
+    size_t numEdges = topo.edgeVerts.size() / 2;
+
+    //CSR: count the edges touching each vertex, prefix-sum into offsets, then fill.
+    //We store the edge id (not the neighbor) so boundary checks are free later on
+    topo.vertOffsets.assign(numVerts + 1, 0);
+    for(size_t e = 0; e < numEdges; e++){
+        topo.vertOffsets[topo.edgeVerts[e * 2 + 0] + 1]++;
+        topo.vertOffsets[topo.edgeVerts[e * 2 + 1] + 1]++;
+    }
+    for(size_t v = 0; v < numVerts; v++){
+        topo.vertOffsets[v + 1] += topo.vertOffsets[v];
+    }
+
+    topo.vertNeighbors.resize(topo.vertOffsets[numVerts]);
+    vector<unsigned> fill(topo.vertOffsets.begin(), topo.vertOffsets.end() - 1);
+
+    topo.vertBoundary.assign(numVerts, 0);
+
+    for(size_t e = 0; e < numEdges; e++){
+        ofIndexType a = topo.edgeVerts[e * 2 + 0];
+        ofIndexType b = topo.edgeVerts[e * 2 + 1];
+        topo.vertNeighbors[fill[a]++] = e;
+        topo.vertNeighbors[fill[b]++] = e;
+
+        if(topo.edgeFaces[e * 2 + 1] < 0){
+            topo.vertBoundary[a] = 1;
+            topo.vertBoundary[b] = 1;
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void LoopSubdivision::subdivideLevel(const ofMesh& src, const Topology& topo, const vector<unsigned char>& splitEdges, ofMesh& dst){
+
+    const vector<ofVec3f>& srcVerts = src.getVertices();
+    const vector<ofIndexType>& srcIndices = src.getIndices();
+
+    size_t numVerts = srcVerts.size();
+    size_t numEdges = topo.edgeVerts.size() / 2;
+    size_t numFaces = srcIndices.size() / 3;
+
+    //only copy the attributes that are complete (one per vertex)
+    bool bTex = src.getNumTexCoords() == numVerts;
+    bool bCol = src.getNumColors() == numVerts;
+    bool bNorm = src.getNumNormals() == numVerts;
+
+    //the new vertex for each split edge goes after all the old ones
+    vector<ofIndexType> edgeVertex(numEdges, 0);
+    size_t newVerts = numVerts;
+    for(size_t e = 0; e < numEdges; e++){
+        if(splitEdges[e]) edgeVertex[e] = newVerts++;
+    }
+
+    dst.clear();
+    dst.setMode(OF_PRIMITIVE_TRIANGLES);
+
+    vector<ofVec3f>& verts = dst.getVertices();
+    verts.resize(newVerts);
+
+    if(bTex){
+        dst.getTexCoords() = src.getTexCoords();
+        dst.getTexCoords().resize(newVerts);
+    }
+    if(bCol){
+        dst.getColors() = src.getColors();
+        dst.getColors().resize(newVerts);
+    }
+    if(bNorm){
+        dst.getNormals() = src.getNormals();
+        dst.getNormals().resize(newVerts);
+    }
+
+    //---- spots
+    //vertices sitting on the same spot (both sides of the sphere's texture seam,
+    //the copies of a pole) have to move together, otherwise the mesh cracks open
+    //along the seam. Sort them by position so the copies of every spot end up
+    //side by side, then every spot is decided (and smoothed) once for all its copies
+    vector<unsigned> order(numVerts);
+    for(size_t v = 0; v < numVerts; v++){
+        order[v] = v;
+    }
+
+    MeshUtils::parallelSort(order, [&](unsigned a, unsigned b){
+        const ofVec3f& pa = srcVerts[a];
+        const ofVec3f& pb = srcVerts[b];
+        if(pa.x != pb.x) return pa.x < pb.x;
+        if(pa.y != pb.y) return pa.y < pb.y;
+        return pa.z < pb.z;
+    });
+
+    //spotStart[s] is where the copies of spot s start in order
+    vector<unsigned> spot(numVerts);
+    vector<unsigned> spotStart;
+    spotStart.reserve(numVerts + 1);
+    for(size_t i = 0; i < numVerts; i++){
+        if(i == 0 || srcVerts[order[i]] != srcVerts[order[i - 1]]){
+            spotStart.push_back(i);
+        }
+        spot[order[i]] = spotStart.size() - 1;
+    }
+    size_t numSpots = spotStart.size();
+    spotStart.push_back(numVerts);
+
+    //---- even (old) vertices
+    //only smooth the ones touching a split edge so untouched regions stay put
+    TaskScheduler::get().parallelFor(0, numSpots, grainSize, [&](size_t begin, size_t end){
+        for(size_t s = begin; s < end; s++){
+
+            unsigned firstCopy = spotStart[s];
+            unsigned lastCopy = spotStart[s + 1];
+
+            const ofVec3f& p = srcVerts[order[firstCopy]];
+            ofVec3f smoothed = p;
+
+            //a spot with a copy on a boundary (a seam is a boundary as far as the
+            //indices are concerned) only looks at its boundary edges, the ones
+            //all the copies share. Otherwise one side of a seam could decide to
+            //move while the other one didn't
+            bool bBoundary = false;
+            for(unsigned c = firstCopy; c < lastCopy; c++){
+                if(topo.vertBoundary[order[c]]) bBoundary = true;
+            }
+
+            bool touched = false;
+            for(unsigned c = firstCopy; c < lastCopy && !touched; c++){
+                unsigned v = order[c];
+                for(unsigned i = topo.vertOffsets[v]; i < topo.vertOffsets[v + 1]; i++){
+                    int e = topo.vertNeighbors[i];
+                    if(splitEdges[e] && (!bBoundary || topo.edgeFaces[e * 2 + 1] < 0)){
+                        touched = true;
+                        break;
+                    }
+                }
+            }
+
+            if(touched && bBoundary){
+
+                //boundary rule only looks along the boundary. The copies of a seam
+                //vertex each see the same two neighbors (copies of them, anyway),
+                //so they're counted by spot
+                unsigned neighbors[2];
+                ofVec3f sum;
+                int numBoundary = 0;
+                for(unsigned c = firstCopy; c < lastCopy && numBoundary <= 2; c++){
+                    unsigned v = order[c];
+                    for(unsigned i = topo.vertOffsets[v]; i < topo.vertOffsets[v + 1]; i++){
+                        int e = topo.vertNeighbors[i];
+                        if(topo.edgeFaces[e * 2 + 1] >= 0) continue;
+                        ofIndexType other = topo.edgeVerts[e * 2] == v ? topo.edgeVerts[e * 2 + 1] : topo.edgeVerts[e * 2];
+                        unsigned otherSpot = spot[other];
+                        if((numBoundary > 0 && neighbors[0] == otherSpot) || (numBoundary > 1 && neighbors[1] == otherSpot)) continue;
+                        if(numBoundary < 2){
+                            neighbors[numBoundary] = otherSpot;
+                            sum += srcVerts[other];
+                        }
+                        numBoundary++;
+                    }
+                }
+
+                //corners, poles and odd junctions stay sharp
+                if(numBoundary == 2){
+                    smoothed = p * 0.75 + sum * 0.125;
+                }
+
+            } else if(touched && lastCopy - firstCopy == 1){
+
+                //the regular Loop mask. (Copies that aren't on a seam belong to
+                //surfaces that only touch at this point, they stay put like a corner)
+                unsigned v = order[firstCopy];
+                unsigned first = topo.vertOffsets[v];
+                unsigned last = topo.vertOffsets[v + 1];
+
+                ofVec3f sum;
+                int n = last - first;
+                for(unsigned i = first; i < last; i++){
+                    int e = topo.vertNeighbors[i];
+                    ofIndexType other = topo.edgeVerts[e * 2] == v ? topo.edgeVerts[e * 2 + 1] : topo.edgeVerts[e * 2];
+                    sum += srcVerts[other];
+                }
+
+                float beta = n == 3 ? 3.0 / 16.0 : 3.0 / (8.0 * n);
+                smoothed = p * (1.0 - n * beta) + sum * beta;
+            }
+
+            for(unsigned c = firstCopy; c < lastCopy; c++){
+                verts[order[c]] = smoothed;
+            }
+        }
+    });
+
+    //---- odd (new) vertices, one per split edge
+    TaskScheduler::get().parallelFor(0, numEdges, grainSize, [&](size_t begin, size_t end){
+        for(size_t e = begin; e < end; e++){
+
+            if(!splitEdges[e]) continue;
+
+            ofIndexType a = topo.edgeVerts[e * 2 + 0];
+            ofIndexType b = topo.edgeVerts[e * 2 + 1];
+            ofIndexType nv = edgeVertex[e];
+
+            int slot0 = topo.edgeFaces[e * 2 + 0];
+            int slot1 = topo.edgeFaces[e * 2 + 1];
+
+            if(slot1 < 0){
+                verts[nv] = (srcVerts[a] + srcVerts[b]) * 0.5;
+            } else {
+                //the corner opposite an edge slot is the one "before" it
+                ofIndexType c = srcIndices[(slot0 / 3) * 3 + (slot0 % 3 + 2) % 3];
+                ofIndexType d = srcIndices[(slot1 / 3) * 3 + (slot1 % 3 + 2) % 3];
+                verts[nv] = (srcVerts[a] + srcVerts[b]) * 0.375 + (srcVerts[c] + srcVerts[d]) * 0.125;
+            }
+
+            //the rest of the attributes are just interpolated
+            if(bTex){
+                dst.getTexCoords()[nv] = (src.getTexCoords()[a] + src.getTexCoords()[b]) * 0.5;
+            }
+            if(bCol){
+                dst.getColors()[nv] = (src.getColors()[a] + src.getColors()[b]) * 0.5;
+            }
+            if(bNorm){
+                dst.getNormals()[nv] = (src.getNormals()[a] + src.getNormals()[b]).getNormalized();
+            }
+        }
+    });
+
+    //---- faces
+    //count how many triangles every face turns into, then prefix sum
+    //so each face knows where to write its output
+    vector<unsigned> faceOffsets(numFaces + 1, 0);
+    for(size_t f = 0; f < numFaces; f++){
+        int numSplit = splitEdges[topo.faceEdges[f * 3 + 0]] + splitEdges[topo.faceEdges[f * 3 + 1]] + splitEdges[topo.faceEdges[f * 3 + 2]];
+        faceOffsets[f + 1] = faceOffsets[f] + numSplit + 1;
+    }
+
+    vector<ofIndexType>& indices = dst.getIndices();
+    indices.resize(faceOffsets[numFaces] * 3);
+
+    TaskScheduler::get().parallelFor(0, numFaces, grainSize, [&](size_t begin, size_t end){
+        for(size_t f = begin; f < end; f++){
+
+            ofIndexType* out = &indices[faceOffsets[f] * 3];
+
+            ofIndexType v[3];
+            ofIndexType m[3];
+            int mask = 0;
+
+            for(int k = 0; k < 3; k++){
+                v[k] = srcIndices[f * 3 + k];
+                int e = topo.faceEdges[f * 3 + k];
+                m[k] = edgeVertex[e];
+                if(splitEdges[e]) mask |= 1 << k;
+            }
+
+            int numSplit = (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1);
+
+            if(numSplit == 0){
+
+                out[0] = v[0]; out[1] = v[1]; out[2] = v[2];
+
+            } else if(numSplit == 3){
+
+                //regular 1-to-4 split: one triangle per corner
+                //plus the middle one made of the three new vertices
+                ofIndexType tris[12] = {
+                    v[0], m[0], m[2],
+                    m[0], v[1], m[1],
+                    m[2], m[1], v[2],
+                    m[0], m[1], m[2]
+                };
+                std::copy(tris, tris + 12, out);
+
+            } else if(numSplit == 1){
+
+                //rotate so the split edge goes from a to b
+                int k = mask == 1 ? 0 : mask == 2 ? 1 : 2;
+                ofIndexType a = v[k], b = v[(k + 1) % 3], c = v[(k + 2) % 3];
+
+                ofIndexType tris[6] = {
+                    a, m[k], c,
+                    m[k], b, c
+                };
+                std::copy(tris, tris + 6, out);
+
+            } else {
+
+                //rotate so the edge that is NOT split goes from c back to a,
+                //then a-b and b-c are both split
+                int unsplit = (~mask) & 7;
+                int k = unsplit == 4 ? 0 : unsplit == 1 ? 1 : 2;
+                ofIndexType a = v[k], b = v[(k + 1) % 3], c = v[(k + 2) % 3];
+                ofIndexType mab = m[k], mbc = m[(k + 1) % 3];
+
+                ofIndexType tris[9] = {
+                    mab, b, mbc,
+                    a, mab, mbc,
+                    a, mbc, c
+                };
+                std::copy(tris, tris + 9, out);
+            }
+        }
+    });
+}
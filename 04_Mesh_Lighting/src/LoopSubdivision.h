@@ -0,0 +1,79 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Loop subdivision for indexed OF_PRIMITIVE_TRIANGLES meshes.
+ *
+ * Every level splits edges at their midpoint and smooths the positions with
+ * the Loop masks:
+ *
+ *   new edge vertex  : 3/8 * (a + b) + 1/8 * (c + d)    (c, d = opposite corners)
+ *   old vertex       : (1 - n * beta) * v + beta * sum(neighbors)
+ *   boundary edges   : 1/2 * (a + b)
+ *   boundary vertex  : 3/4 * v + 1/8 * (left + right)
+ *
+ * Texcoords, colors and normals are linearly interpolated so textures don't swim.
+ *
+ * Adaptive mode asks an "edge metric" whether each edge needs splitting. Because the
+ * decision is made once per EDGE (not per triangle) both triangles sharing an edge
+ * always agree, and a triangle with 1 or 2 split edges is cut into 2 or 3 pieces
+ * instead of 4. That way there are never any T-junctions (cracks) in the result.
+ *
+ * Vertices that share a position (the two sides of a texture seam, the copies of a
+ * pole) are found every level and moved as one: whether they move and where to
+ * is decided once for all the copies, so seams can't open up either.
+ *
+ * The adjacency is rebuilt every level in CSR form (one flat array of neighbors plus
+ * an offset per vertex) and each pass of a level runs in parallel over its elements.
+ */
+
+class LoopSubdivision {
+
+	public:
+
+    //returns how much an edge between a and b (rest positions) "wants" to be split.
+    //The edge is split when the returned value is above the threshold
+    typedef std::function<float(const ofVec3f& a, const ofVec3f& b)> EdgeMetric;
+
+    LoopSubdivision();
+
+    //split every edge "levels" times (4^levels the triangles)
+    void subdivide(const ofMesh& src, ofMesh& dst, int levels);
+
+    //only split the edges the metric asks for, up to maxLevels deep
+    void refine(const ofMesh& src, ofMesh& dst, const EdgeMetric& metric, float threshold, int maxLevels);
+
+    //metric helper: length of the edge in pixels once projected by the camera
+    static EdgeMetric screenSpaceMetric(const ofCamera& cam, const ofRectangle& viewport);
+
+    //stats from the last call
+    int getNumLevelsRun() const { return numLevelsRun; }
+    int getNumEdgesSplit() const { return numEdgesSplit; }
+    float getLastTimeMs() const { return lastTimeMs; }
+
+    private:
+
+    //CSR adjacency of one level
+    struct Topology {
+        vector<ofIndexType> edgeVerts;      //2 per edge
+        vector<int>         edgeFaces;      //2 per edge, -1 if boundary
+        vector<int>         faceEdges;      //3 per face, edge k goes from corner k to corner k+1
+        vector<unsigned>    vertOffsets;    //numVerts + 1
+        vector<ofIndexType> vertNeighbors;
+        vector<unsigned char> vertBoundary;
+    };
+
+    void buildTopology(const ofMesh& mesh, Topology& topo);
+
+    //run a single level. splitEdges has one flag per edge in topo
+    void subdivideLevel(const ofMesh& src, const Topology& topo, const vector<unsigned char>& splitEdges, ofMesh& dst);
+
+    Topology topology;
+    vector<unsigned char> splitFlags;
+    ofMesh scratch[2];
+
+    int numLevelsRun;
+    int numEdgesSplit;
+    float lastTimeMs;
+};
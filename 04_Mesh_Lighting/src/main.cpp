@@ -3,7 +3,14 @@
 
 //========================================================================
 int main( ){
+#ifdef HEADLESS
+	// no window and no GL context at all, the app notices and
+	// saves its frames with the software rasterizer instead
+	ofAppNoWindow window;
+	ofSetupOpenGL(&window, 1024,768,OF_WINDOW);
+#else
 	ofSetupOpenGL(1024,768,OF_WINDOW);			// <-------- setup the GL context
+#endif
 
 	// this kicks off the running of my app
 	// can be OF_WINDOW or OF_FULLSCREEN
@@ -6,27 +6,39 @@ void ofApp::setup(){
     ofSetVerticalSync(true);
     ofEnableDepthTest();
     
-    //Load an image so we can use it as a texture for our mesh
-    img.load("water.jpg");
+    //without a window there's no GL to upload textures to (see main.cpp)
+    bHeadless = dynamic_cast<ofAppNoWindow*>(ofGetWindowPtr()) != nullptr;
+    numHeadlessFrames = 300;
     
+    //Load an image so we can use it as a texture for our mesh.
+    //It's a big jpeg, so it decodes on another thread while the spheres get built
+    if(bHeadless) img.setUseTexture(false);
+    AssetLoader::Image water = loader.loadImage("water.jpg");
     
-    //Create a primitive shape so we can grab the mesh from it
-    ofIcoSpherePrimitive icoSphere;
+    //how long it may take to get the first frame up (logged after the first draw)
+    loader.setStartupBudgetMs(1000);
     
-    radius = 100;
-    icoSphere.setResolution(4);
-    icoSphere.setRadius(radius);
-    icoSphere.setPosition(0, 0, 0);
+    //the texture coordinates only need the size, which is in the file's header
+    ofVec2f texSize = water.size.get();
+    
+    //with OF's default (ARB) textures, and the software rasterizer, the
+    //texcoords are in pixels, otherwise 0 to 1. That's what
+    //mapTexCoordsFromTexture() would pick once the texture exists
+    bool bPixelTexCoords = bHeadless || ofGetUsingArbTex();
+    texCoordMax = bPixelTexCoords ? texSize : ofVec2f(1, 1);
     
-    //The primitive sphere has a method that will conveniently
-    //give us the right texture coordinates per vertex to map an image to it
-    icoSphere.mapTexCoordsFromTexture(img.getTexture());
     
-    mesh = icoSphere.getMesh();
+    //The sphere is made by getSphere() the first time, after that it
+    //comes out of data/meshcache ('-' and '+' change the resolution)
+    radius = 100;
+    sphereResolution = 4;
+    shared_ptr<const ofMesh> sphere = getSphere(sphereResolution);
+    cacheInfo = "Sphere: " + ofToString(sphere->getNumVertices()) + " vertices " + getCacheSourceInfo();
+    mesh = *sphere;
     
     //set up the different properties of the lighting
     light.setPosition(400, 0, 400);
-    light.setup();
+    if(!bHeadless) light.setup();
 
     light.setDiffuseColor(ofFloatColor::white);
     light.setAmbientColor(ofFloatColor::darkGray);
@@ -39,52 +51,260 @@ void ofApp::setup(){
     cout << "Mode: " << mesh.getMode() << endl;
 
     originalMesh = mesh;
+    
+    
+    //a much lower resolution version of the same sphere for adaptive subdivision
+    //to start from. The subdivision will add the detail back where it's needed
+    coarseMesh = *getSphere(1);
+    
+    bAdaptive = false;
+    
+    
+    //and a lighter version of the full sphere with a quarter of the triangles.
+    //The texture seam is left alone so the water texture still wraps cleanly
+    decimate();
+    cacheInfo += ", decimated " + getCacheSourceInfo();
+    bDecimated = false;
+    
+    //the sphere is closed so the back half can be skipped too (cone culling)
+    culler.setConeCulling(true);
+    bCulling = false;
+    
+    //the pulse only moves the vertices so the tree is built once
+    //here and refit to the new positions every frame
+    bvh.build(originalMesh);
+    bPicking = false;
+    bHit = false;
+    
+    compactRest.encode(originalMesh);
+    bCompact = false;
+    pulseTimeMs = 0;
+    
+    bStreams = false;
+    
+    //the bounds of the sphere at rest. The pulse never moves a vertex
+    //further than amplitude * radius from there
+    bounds.compute(originalMesh);
+    
+    amplitude = 0.05;   //as a percentage of the radius
+    waveSpeed = 3.5;
+    waveCycles = 6;     //number of full waves from pole to pole
+    
+    rasterizer.allocate(ofGetWidth(), ofGetHeight());
+    ofDirectory::createDirectory("frames", true, true);
+    ofDirectory::createDirectory("export", true, true);
+    ofDirectory::createDirectory("recordings", true, true);
+    bPlaying = false;
+    playFrame = 0;
+    
+    //everything that didn't need the pixels is done, now wait for them
+    //(if they aren't there yet) and make the texture
+    img.setFromPixels(water.pixels.get());
+    
+    //the mipmapped version of the texture. The filtering only happens the
+    //first time, after that the levels come straight out of data/mipcache
+    if(!bHeadless){
+        pyramid.loadOrBuild("water.jpg", img.getPixels(), MipPyramid::KAISER);
+        pyramid.upload(mipTexture);
+    }
+    bMipmaps = !bHeadless;
+    
+    //the easy cam normally backs away from the origin the first time it's
+    //drawn, that never happens without a window so do it here
+    if(bHeadless){
+        cam.setDistance(400);
+        ofLogNotice("ofApp") << "running headless, saving " << numHeadlessFrames << " frames to data/frames/";
+    }
 }
 
 //--------------------------------------------------------------
 void ofApp::update(){
 
+    //multiplying time makes the oscillations faster.
+    //Headless frames are saved as fast as possible so time moves on
+    //by exactly 1/60th of a second per frame instead
+    float seconds = bHeadless ? ofGetFrameNum() / 60.0 : ofGetElapsedTimef();
+    float time = seconds * waveSpeed;
     
-    //let's manipulate all the vertices algorithmically
-    for(int i = 0; i < mesh.getNumVertices(); i++){
+    
+    //the mesh we deform every frame. By default it's the full resolution sphere
+    //but in adaptive mode we rebuild it from the coarse sphere every frame
+    ofMesh* restMesh = bDecimated ? &decimatedMesh : &originalMesh;
+    
+    if(bAdaptive){
         
+        //how many radians the wave goes through per unit of Z
+        float k = (TWO_PI * waveCycles) / (2 * radius);
+        float amp = amplitude * radius;
+        ofMatrix4x4 mvp = cam.getModelViewProjectionMatrix(ofGetCurrentViewport());
+        float halfW = ofGetWidth() * 0.5;
+        float halfH = ofGetHeight() * 0.5;
+        float r = radius;
         
-        //push vertices out then back in using sine
-        //Since the sphere is positioned around the origin, if we scale
-        //the vertex up or down, it will have the effect of pushing the
-        //points in and out of the sphere.
+        //metric: how many PIXELS off a straight edge would be from the real pulsing surface.
+        //The gap between a curve and its chord is about length^2 * curvature / 8
+        //and the second derivative of amp * sin(time + k*z) is amp * k^2 * sin(...).
+        //Add the sphere's own curvature (1/radius) so the silhouette stays round,
+        //then scale from world units to pixels using how long the edge looks on screen
+        auto metric = [=](const ofVec3f& a, const ofVec3f& b){
+            
+            ofVec3f mid = (a + b) * 0.5;
+            float len = a.distance(b);
+            float curvature = amp * k * k * fabs(sin(time + k * (mid.z + r))) + 1.0 / r;
+            float worldError = len * len * curvature / 8.0;
+            
+            ofVec3f sa = a * mvp;
+            ofVec3f sb = b * mvp;
+            float dx = (sa.x - sb.x) * halfW;
+            float dy = (sa.y - sb.y) * halfH;
+            float screenLen = sqrt(dx * dx + dy * dy);
+            
+            return worldError * screenLen / max(len, 0.0001f);
+        };
         
-        //start with the original mesh. If we keep scaling the current mesh
-        //it will spiral out of control
-        ofVec3f vert = originalMesh.getVertex(i);
+        //split edges that are off by more than half a pixel, 5 levels at most
+        subdivision.refine(coarseMesh, adaptiveMesh, metric, 0.5, 5);
         
+        //Loop subdivision shrinks things a little, push every point
+        //back out onto the sphere since we know what shape it should be
+        vector<ofVec3f>& verts = adaptiveMesh.getVertices();
+        for(size_t i = 0; i < verts.size(); i++){
+            verts[i] = verts[i].getNormalized() * radius;
+        }
         
-        float amplitude = 0.05;  //this amplitude is as a percentage of the radius
+        restMesh = &adaptiveMesh;
+        mesh = adaptiveMesh;
+    }
+    
+    
+    //let's manipulate all the vertices algorithmically.
+    //Each vertex only depends on its own rest position so the scheduler can
+    //hand them out to all the cores. Writing into the vertex array directly
+    //means every thread only ever touches its own vertices
+    vector<ofVec3f>& verts = mesh.getVertices();
+    const vector<ofVec3f>& restVerts = restMesh->getVertices();
+    
+    //with the compact copy each chunk unpacks its rest positions straight
+    //into the vertex array first and then pulses them in place.
+    //(the adaptive mesh is new every frame so it always uses the floats)
+    bool bUseCompact = bCompact && !bAdaptive && compactRest.getNumVertices() == verts.size();
+    uint64_t pulseStart = ofGetElapsedTimeMicros();
+    
+    //Playback: take the positions from the recording instead, one frame per
+    //update and around again at the end. If the vertex count doesn't match
+    //(a different mesh, adaptive mode) it stops and the pulse takes over again
+    if(bPlaying && player.getFrame(playFrame, mesh)){
+        playFrame = (playFrame + 1) % player.getNumFrames();
+    } else {
+        bPlaying = false;
         
-        //multiplying time makes the oscillations faster
-        float time = ofGetElapsedTimef() * 3.5;
+        TaskScheduler::get().parallelFor(0, verts.size(), 1024, [&](size_t begin, size_t end){
         
-        //changing phase makes the wave offset at different parts.
-        //if phase was zero, the whole sphere would pulse in and out at the same time
-        //making it non-zero and mapped according to the Z axis (from -radius to radius)
-        //makes it look like the wave is travelling in the Z direction
-        float phase = ofMap(vert.z, -radius, radius, 0, PI * 12);
+            if(bUseCompact){
+                compactRest.decodeVertices(begin, end, &verts[begin]);
+            }
         
-        //scale the vertex (start at 1 (original radius) then add a little bit from there
-        vert *= 1 + amplitude * sin(time + phase);
+            for(size_t i = begin; i < end; i++){
+            
+                //push vertices out then back in using sine
+                //Since the sphere is positioned around the origin, if we scale
+                //the vertex up or down, it will have the effect of pushing the
+                //points in and out of the sphere.
+            
+                //start with the original mesh. If we keep scaling the current mesh
+                //it will spiral out of control
+                ofVec3f vert = bUseCompact ? verts[i] : restVerts[i];
+            
+            
+                //changing phase makes the wave offset at different parts.
+                //if phase was zero, the whole sphere would pulse in and out at the same time
+                //making it non-zero and mapped according to the Z axis (from -radius to radius)
+                //makes it look like the wave is travelling in the Z direction
+                float phase = ofMap(vert.z, -radius, radius, 0, TWO_PI * waveCycles);
+            
+                //scale the vertex (start at 1 (original radius) then add a little bit from there
+                vert *= 1 + amplitude * sin(time + phase);
+            
+                verts[i] = vert;
+            }
+        });
+    }
+    
+    pulseTimeMs = (ofGetElapsedTimeMicros() - pulseStart) / 1000.0f;
+    
+    //save the pulsed positions as the next frame of the recording
+    if(recorder.isRecording()){
+        recorder.addFrame(mesh);
+    }
+    
+    //the pulse scales each vertex by at most 1 +- amplitude, so the rest bounds
+    //grown by amplitude * radius always hold it, without looking at a vertex.
+    //The adaptive mesh is new every frame so that one gets a full scan
+    if(bAdaptive){
+        bounds.compute(mesh);
+    } else {
+        bounds.expand(amplitude * radius);
+    }
+    
+    
+    //Picking: ray from the camera through the mouse.
+    //This has to happen before culling replaces the indices
+    if(bPicking){
         
-        mesh.setVertex(i, vert);
+        //the adaptive mesh has different triangles every frame so it gets a
+        //whole new tree, everything else just moves the boxes around
+        if(bAdaptive){
+            bvh.build(mesh);
+        } else {
+            bvh.refit(mesh);
+        }
         
+        bHit = bvh.pick(mesh, cam, ofVec2f(mouseX, mouseY), ofGetCurrentViewport(), hit);
+    }
+    
+    
+    //swap the mesh indices for only the triangles the camera can see.
+    //The bounds have to follow the pulse so they're recomputed every frame
+    if(bCulling){
         
+        //the adaptive mesh is new every frame so it needs new meshlets too
+        if(bAdaptive){
+            culler.setup(mesh);
+        } else {
+            culler.updateBounds(mesh);
+        }
+        
+        culler.cull(cam, ofGetCurrentViewport(), mesh.getIndices());
     }
     
+    //send this frame's positions (and culled indices) to the GPU.
+    //The adaptive mesh has new triangles every frame so it's packed from scratch
+    if(bStreams && !bHeadless){
+        if(bAdaptive){
+            streams.setup(mesh);
+        } else {
+            streams.updateDynamic(mesh);
+            if(bCulling) streams.updateIndices(mesh);
+        }
+    }
     
+    //keep the numbers for just this frame
+    schedulerStats = TaskScheduler::get().getStats();
+    TaskScheduler::get().resetStats();
+    
+    if(bHeadless){
+        saveSoftwareFrame();
+        if((int)ofGetFrameNum() + 1 >= numHeadlessFrames) ofExit();
+    }
     
 }
 
 //--------------------------------------------------------------
 void ofApp::draw(){
     
+    //nothing to draw into without a window
+    if(bHeadless) return;
+    
     ofBackgroundGradient(ofColor(100), ofColor(0));
     
 
@@ -98,31 +318,355 @@ void ofApp::draw(){
     
 
   
-    img.getTexture().bind();
+    //same image either way, but the mipmapped one is sampled from the level
+    //that matches how big it is on screen
+    ofTexture& texture = bMipmaps ? mipTexture : img.getTexture();
+    texture.bind();
     
-    if(bWire){
+    if(bStreams){
+        streams.draw(bWire ? OF_MESH_WIREFRAME : OF_MESH_FILL);
+    } else if(bWire){
         mesh.drawWireframe();
     } else {
         mesh.draw();
     }
     
-    img.getTexture().unbind();
+    texture.unbind();
 
     material.end();
     light.disable();
+    
+    //outline the picked triangle and mark its closest corner
+    if(bPicking && bHit){
+        ofSetColor(0, 255, 255);
+        ofSetLineWidth(3);
+        for(int k = 0; k < 3; k++){
+            ofDrawLine(mesh.getVertex(hit.vertices[k]), mesh.getVertex(hit.vertices[(k + 1) % 3]));
+        }
+        ofDrawSphere(mesh.getVertex(hit.vertex), 2);
+        ofSetColor(255);
+    }
 
     cam.end();
     
     
+    //turn off depth testing so the text always draws on top
+    ofDisableDepthTest();
+    
+    ofSetColor(255);
+    ofDrawBitmapString("Framerate: " + ofToString(ofGetFrameRate()), 15, 15);
+    ofDrawBitmapString("Num Vertices: " + ofToString(mesh.getNumVertices()), 15, 30);
+    
+    if(bAdaptive){
+        ofDrawBitmapString("Subdivision levels: " + ofToString(subdivision.getNumLevelsRun()) + "  edges split: " + ofToString(subdivision.getNumEdgesSplit()) + "  time: " + ofToString(subdivision.getLastTimeMs(), 2) + " ms", 15, 45);
+    }
+    
+    if(bCulling){
+        ofDrawBitmapString("Meshlets: " + ofToString(culler.getMeshlets().size()) + "  culled: " + ofToString(culler.getCulledPercent(), 1) + "% (frustum " + ofToString(culler.getNumFrustumCulled()) + ", back facing " + ofToString(culler.getNumConeCulled()) + ")  time: " + ofToString(culler.getLastCullTimeMs(), 3) + " ms", 15, 60);
+    }
+    
+    if(bPicking){
+        string pickInfo = "Refit: " + ofToString(bvh.getLastRefitTimeMs(), 2) + " ms  query: " + ofToString(bvh.getLastQueryTimeUs(), 1) + " us";
+        if(bHit){
+            pickInfo += "  triangle: " + ofToString(hit.triangle) + "  vertex: " + ofToString(hit.vertex) + "  uv: " + ofToString(hit.u, 2) + ", " + ofToString(hit.v, 2);
+        }
+        ofDrawBitmapString(pickInfo, 15, 75);
+    }
+    
+    ofDrawBitmapString("Press 'w' to toggle wireframe drawing", 15, 90);
+    ofDrawBitmapString("Press 's' to toggle adaptive subdivision", 15, 105);
+    ofDrawBitmapString("Press 'd' to toggle the decimated preview mesh", 15, 120);
+    ofDrawBitmapString("Press 'c' to toggle meshlet culling", 15, 135);
+    ofDrawBitmapString("Press 'p' to toggle picking with the mouse", 15, 150);
+    ofDrawBitmapString("Press 'f' to render the frame on the CPU and save it (" + ofToString(rasterizer.getLastDrawTimeMs(), 1) + " ms)", 15, 165);
+    ofDrawBitmapString("Threads: " + ofToString(TaskScheduler::get().getNumThreads()) + "  tasks: " + ofToString(schedulerStats.tasksRun) + "  steals: " + ofToString(schedulerStats.steals) + "  idle: " + ofToString(schedulerStats.idleMicros / 1000.0, 1) + " ms", 15, 180);
+    
+    ofDrawBitmapString("Press 'q' to toggle reading the rest positions from the compact (quantized) copy", 15, 195);
+    
+    //memory for all the vertex data (positions, normals, texcoords) both ways
+    size_t floatBytes = QuantizedMesh::getNumBytes(bDecimated ? decimatedMesh : originalMesh);
+    size_t compactBytes = compactRest.getNumBytes();
+    string compactInfo = "Pulse: " + ofToString(pulseTimeMs, 2) + " ms (" + (bCompact && !bAdaptive ? "compact" : "float") + ")";
+    compactInfo += "  vertex data: " + ofToString(floatBytes / 1024) + " KB float, " + ofToString(compactBytes / 1024) + " KB compact (" + ofToString(100.0 * (1 - compactBytes / (double)max(floatBytes, (size_t)1)), 0) + "% less)";
+    compactInfo += "  max error: " + ofToString(compactRest.getVertexErrorBound().length(), 4) + " units, " + ofToString(compactRest.getNormalErrorBound(), 3) + " deg";
+    ofDrawBitmapString(compactInfo, 15, 210);
+    
+    //what goes to the GPU per frame with and without the streams
+    ofDrawBitmapString("Press 'i' to toggle drawing from interleaved vertex streams", 15, 225);
+    string streamInfo = "Per frame: separate arrays " + ofToString(VertexStreams::getSeparateBytesPerFrame(mesh) / 1024) + " KB / " + ofToString(VertexStreams::getSeparateCacheLinesPerFrame(mesh)) + " cache lines";
+    if(bStreams){
+        streamInfo += "  streams " + ofToString(streams.getBytesPerFrame() / 1024) + " KB / " + ofToString(streams.getCacheLinesPerFrame()) + " cache lines  (" + ofToString(streams.getLastUpdateTimeMs(), 2) + " ms)";
+    }
+    ofDrawBitmapString(streamInfo, 15, 240);
+    
+    ofDrawBitmapString("Press 'z' to frame the sphere with the camera", 15, 255);
+    ofVec3f boundsSize = bounds.getSize();
+    string boundsInfo = "Bounds: " + ofToString(boundsSize.x, 0) + " x " + ofToString(boundsSize.y, 0) + " x " + ofToString(boundsSize.z, 0) + "  radius " + ofToString(bounds.getRadius(), 0);
+    boundsInfo += bAdaptive ? "  (scan " + ofToString(bounds.getLastUpdateTimeMs(), 3) + " ms)" : "  (grown from rest)";
+    ofDrawBitmapString(boundsInfo, 15, 270);
     
+    ofDrawBitmapString("Press 'm' to toggle the mipmapped texture", 15, 285);
+    string mipInfo = "Mipmaps: " + ofToString(pyramid.getNumLevels()) + " levels, " + ofToString(pyramid.getNumBytes() / 1024) + " KB, ";
+    mipInfo += (pyramid.isFromCache() ? "loaded from the cache in " : "filtered in ") + ofToString(pyramid.getLastBuildTimeMs(), 1) + " ms";
+    ofDrawBitmapString(mipInfo, 15, 300);
     
+    ofDrawBitmapString("Drop a .ply or .obj file on the window to pulse it instead, press 'e' to save this frame as a .ply", 15, 315);
+    if(!ioInfo.empty()){
+        ofDrawBitmapString(ioInfo, 15, 330);
+    }
+    
+    ofDrawBitmapString("Press 'R' to start/stop recording the pulse, 'P' to play the recording back (left/right arrows skip)", 15, 345);
+    if(recorder.isRecording()){
+        ofDrawBitmapString("Recording: " + ofToString(recorder.getNumFrames()) + " frames, " + ofToString(recorder.getNumBytes() / 1024) + " KB (" + ofToString(recorder.getCompressionRatio(), 1) + "x smaller)  encode: " + ofToString(recorder.getLastEncodeTimeMs(), 2) + " ms", 15, 360);
+    }
+    if(bPlaying){
+        ofDrawBitmapString("Playing: frame " + ofToString(playFrame) + " / " + ofToString(player.getNumFrames()) + " (" + ofToString(player.getCompressionRatio(), 1) + "x smaller)  decode: " + ofToString(player.getLastDecodeTimeMs(), 2) + " ms for " + ofToString(player.getLastNumFramesDecoded()) + " frames, " + ofToString(player.getDecodeMBPerSecond(), 0) + " MB/s", 15, 360);
+    }
+    
+    ofDrawBitmapString("Press 'x' to compress the sphere to data/export/sphere.mcdc (drop a .mcdc file to load it back)", 15, 375);
+    if(!codecInfo.empty()){
+        ofDrawBitmapString(codecInfo, 15, 390);
+    }
+    
+    ofDrawBitmapString("Press '-' / '+' to change the sphere's resolution (" + ofToString(sphereResolution) + ")", 15, 405);
+    ofDrawBitmapString(cacheInfo + "  (cache: " + ofToString(GeometryCache::get().getNumMeshes()) + " meshes, " + ofToString(GeometryCache::get().getNumBytes() / 1024) + " KB)", 15, 420);
+    
+    ofEnableDepthTest();
+    
+    //the first time this logs how long it took to get here since the app started
+    loader.frameDrawn();
 }
 
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key){
 
-    bWire = !bWire;
+    if(key == 'w'){
+        bWire = !bWire;
+    }
     
+    //switch between the full resolution sphere and the adaptive one
+    if(key == 's'){
+        bAdaptive = !bAdaptive;
+        
+        //the two versions have different numbers of vertices so start over
+        //from the original one (update() will rebuild the adaptive one)
+        mesh = bDecimated ? decimatedMesh : originalMesh;
+        
+        bvh.build(mesh);
+        bHit = false;
+        
+        if(bStreams) streams.setup(mesh);
+        bounds.compute(mesh);
+    }
+    
+    //switch between the full resolution sphere and the lighter one
+    if(key == 'd'){
+        bDecimated = !bDecimated;
+        mesh = bDecimated ? decimatedMesh : originalMesh;
+        compactRest.encode(mesh);
+        
+        if(bCulling) culler.setup(mesh);
+        
+        //different triangles, so a new tree
+        bvh.build(mesh);
+        bHit = false;
+        
+        if(bStreams) streams.setup(mesh);
+        
+        //new rest pose
+        bounds.compute(mesh);
+    }
+    
+    //culling swaps out the indices every frame so
+    //put all of them back when we turn it off
+    if(key == 'c'){
+        bCulling = !bCulling;
+        mesh = bDecimated ? decimatedMesh : originalMesh;
+        
+        if(bCulling) culler.setup(mesh);
+        if(bStreams) streams.setup(mesh);
+    }
+    
+    if(key == 'p'){
+        bPicking = !bPicking;
+        bHit = false;
+    }
+    
+    if(key == 'f'){
+        saveSoftwareFrame();
+    }
+    
+    //the compact copy is made up front (and whenever the rest mesh changes)
+    if(key == 'q'){
+        bCompact = !bCompact;
+    }
+    
+    //the positions change every frame, the normals and texcoords are packed once
+    if(key == 'i'){
+        bStreams = !bStreams;
+        if(bStreams) streams.setup(mesh);
+    }
+    
+    if(key == 'z'){
+        frameBounds();
+    }
+    
+    if(key == 'm'){
+        bMipmaps = !bMipmaps;
+    }
+    
+    //the sphere at rest, compressed the way it would be shipped to another
+    //machine. It's read straight back and checked against the original
+    if(key == 'x'){
+        string path = "export/sphere.mcdc";
+        ofMesh decoded;
+        if(codec.save(path, originalMesh)){
+            float encodeTimeMs = codec.getLastEncodeTimeMs();
+            if(codec.load(path, decoded)){
+                MeshCodec::Errors errors = MeshCodec::compare(originalMesh, decoded);
+                codecInfo = "Compressed " + ofToString(codec.getLastRawBytes() / 1024) + " KB to " + ofToString(codec.getLastNumBytes() / 1024) + " KB (" + ofToString(codec.getCompressionRatio(), 1) + "x) in " + ofToString(encodeTimeMs, 1) + " ms, decoded in " + ofToString(codec.getLastDecodeTimeMs(), 1) + " ms (" + ofToString(codec.getDecodeGBPerSecond(), 2) + " GB/s)";
+                codecInfo += "\nLargest error: position " + ofToString(errors.position, 4) + "  normal " + ofToString(errors.normal, 3) + " deg  texcoord " + ofToString(errors.texCoord, 3) + "  triangles " + (errors.bIndicesMatch ? "match" : "DON'T match");
+            }
+        }
+    }
+    
+    //the pulsing mesh as it is right now, for other programs to open.
+    //(with culling on that's only the triangles that were on screen)
+    if(key == 'e'){
+        string path = "export/frame_" + ofToString(ofGetFrameNum(), 5, '0') + ".ply";
+        if(meshIO.save(path, mesh)){
+            ioInfo = "Saved " + path + ": " + ofToString(meshIO.getLastNumBytes() / (1024.0 * 1024.0), 1) + " MB in " + ofToString(meshIO.getLastTimeMs(), 1) + " ms";
+        }
+    }
+    
+    //swap the sphere for a coarser ('-') or finer ('+') one at
+    //another resolution. Every one that's been used before comes back instantly
+    if(key == '-' || key == '+' || key == '='){
+        sphereResolution = ofClamp(sphereResolution + (key == '-' ? -1 : 1), 1, 6);
+        shared_ptr<const ofMesh> sphere = getSphere(sphereResolution);
+        cacheInfo = "Sphere: " + ofToString(sphere->getNumVertices()) + " vertices " + getCacheSourceInfo();
+        replaceMesh(*sphere);
+        cacheInfo += ", decimated " + getCacheSourceInfo();
+    }
+    
+    //record the pulse from here on, or finish the recording
+    if(key == 'R'){
+        if(recorder.isRecording()){
+            recorder.stop();
+        } else {
+            bPlaying = false;
+            recorder.start("recordings/pulse.mrec", mesh);
+        }
+    }
+    
+    //play the recording back from the start (finishing it first if it's still going)
+    if(key == 'P'){
+        bPlaying = !bPlaying;
+        if(bPlaying){
+            recorder.stop();
+            bPlaying = player.load("recordings/pulse.mrec");
+            playFrame = 0;
+        }
+    }
+    
+    //skip two seconds back or forward in the recording
+    if(bPlaying && (key == OF_KEY_LEFT || key == OF_KEY_RIGHT)){
+        int numFrames = player.getNumFrames();
+        playFrame = ((int)playFrame + (key == OF_KEY_LEFT ? -120 : 120) % numFrames + numFrames) % numFrames;
+    }
+    
+}
+
+//--------------------------------------------------------------
+void ofApp::replaceMesh(const ofMesh& newMesh){
+    
+    originalMesh = newMesh;
+    mesh = originalMesh;
+    
+    //adaptive subdivision starts from its own coarse sphere, and the decimated
+    //preview is made below, so go back to showing the new mesh itself
+    bAdaptive = false;
+    bDecimated = false;
+    decimate();
+    
+    compactRest.encode(mesh);
+    if(bCulling) culler.setup(mesh);
+    
+    bvh.build(mesh);
+    bHit = false;
+    
+    if(bStreams) streams.setup(mesh);
+    bounds.compute(mesh);
+}
+
+//--------------------------------------------------------------
+shared_ptr<const ofMesh> ofApp::getSphere(int resolution){
+    
+    //everything the sphere depends on. The texcoords are part of it, so
+    //headless runs (texcoords in pixels) get their own copy
+    GeometryCache::Key key("04 icosphere");
+    key.add(resolution).add(radius).add(texCoordMax.x).add(texCoordMax.y);
+    
+    return GeometryCache::get().getMesh(key, [&](ofMesh& sphere){
+        
+        //Create a primitive shape so we can grab the mesh from it
+        ofIcoSpherePrimitive icoSphere;
+        icoSphere.setResolution(resolution);
+        icoSphere.setRadius(radius);
+        icoSphere.setPosition(0, 0, 0);
+        
+        //The primitive sphere has a method that will conveniently
+        //give us the right texture coordinates per vertex to map an image to it
+        icoSphere.mapTexCoords(0, 0, texCoordMax.x, texCoordMax.y);
+        
+        sphere = icoSphere.getMesh();
+    });
+}
+
+//--------------------------------------------------------------
+void ofApp::decimate(){
+    
+    //the key is the mesh itself, so dropped meshes are only decimated once too
+    GeometryCache::Key key("04 decimated");
+    key.add(originalMesh).add(0.25f);
+    decimatedMesh = *GeometryCache::get().getMesh(key, [&](ofMesh& decimated){ decimator.decimateRatio(originalMesh, decimated, 0.25); });
+}
+
+//--------------------------------------------------------------
+string ofApp::getCacheSourceInfo(){
+    
+    GeometryCache& cache = GeometryCache::get();
+    string source = cache.getLastSource() == GeometryCache::MEMORY ? "from memory" : cache.getLastSource() == GeometryCache::DISK ? "from disk" : "generated";
+    return source + " in " + ofToString(cache.getLastTimeMs(), 2) + " ms";
+}
+
+//--------------------------------------------------------------
+void ofApp::frameBounds(){
+    
+    //the bounding sphere fits the view when its edge touches the sides of
+    //the camera's field of view: sin(half the fov) = radius / distance
+    float halfFov = ofDegToRad(cam.getFov() * 0.5);
+    
+    cam.setTarget(bounds.getCenter());
+    cam.setDistance(bounds.getRadius() / sin(halfFov));
+}
+
+//--------------------------------------------------------------
+void ofApp::saveSoftwareFrame(){
+    
+    //same camera, texture and light as draw(), just done on the CPU.
+    //The gradient background is replaced by its middle color
+    if(rasterizer.getWidth() != ofGetWidth() || rasterizer.getHeight() != ofGetHeight()){
+        rasterizer.allocate(ofGetWidth(), ofGetHeight());
+    }
+    
+    rasterizer.clear(ofColor(50));
+    rasterizer.setCamera(cam);
+    rasterizer.setTexture(&img.getPixels());
+    rasterizer.enableLighting(light.getGlobalPosition(), light.getDiffuseColor(), light.getAmbientColor());
+    rasterizer.draw(mesh, bWire ? SoftwareRasterizer::WIREFRAME : SoftwareRasterizer::FILL);
+    
+    rasterizer.save("frames/frame_" + ofToString(ofGetFrameNum(), 5, '0') + ".png");
 }
 
 //--------------------------------------------------------------
@@ -172,5 +716,42 @@ void ofApp::gotMessage(ofMessage msg){
 
 //--------------------------------------------------------------
 void ofApp::dragEvent(ofDragInfo dragInfo){ 
-
+    
+    if(dragInfo.files.empty()) return;
+    
+    //compressed meshes were saved from here with 'x', they're already
+    //centered, sized and textured the way this sketch wants them
+    if(ofToLower(ofFilePath::getFileExt(dragInfo.files[0])) == "mcdc"){
+        ofMesh decoded;
+        if(!codec.load(dragInfo.files[0], decoded) || !decoded.hasVertices()) return;
+        codecInfo = "Loaded " + ofFilePath::getFileName(dragInfo.files[0]) + ": " + ofToString(codec.getLastNumBytes() / 1024) + " KB, decoded in " + ofToString(codec.getLastDecodeTimeMs(), 1) + " ms (" + ofToString(codec.getDecodeGBPerSecond(), 2) + " GB/s)";
+        replaceMesh(decoded);
+        return;
+    }
+    
+    ofMesh loaded;
+    if(!meshIO.load(dragInfo.files[0], loaded) || !loaded.hasVertices()) return;
+    ioInfo = "Loaded " + ofFilePath::getFileName(dragInfo.files[0]) + ": " + ofToString(meshIO.getLastNumBytes() / (1024.0 * 1024.0), 1) + " MB in " + ofToString(meshIO.getLastTimeMs(), 1) + " ms";
+    
+    //the pulse is made for a sphere of "radius" around the origin,
+    //so move the new mesh there and scale it to the same size
+    MeshBounds fit;
+    fit.compute(loaded);
+    ofVec3f center = fit.getCenter();
+    float scale = radius / max(fit.getRadius(), 0.0001f);
+    for(ofVec3f& vert : loaded.getVertices()){
+        vert = (vert - center) * scale;
+    }
+    
+    //scans often come without normals, and the lighting needs them
+    if(loaded.getNumNormals() != loaded.getNumVertices()){
+        MeshUtils::computeNormals(loaded);
+    }
+    
+    //files keep their texcoords from 0 to 1, stretch them to the texture's
+    for(ofVec2f& texCoord : loaded.getTexCoords()){
+        texCoord *= texCoordMax;
+    }
+    
+    replaceMesh(loaded);
 }
@@ -1,6 +1,23 @@
 #pragma once
 
 #include "ofMain.h"
+#include "LoopSubdivision.h"
+#include "MeshDecimator.h"
+#include "MeshletCuller.h"
+#include "MeshBVH.h"
+#include "SoftwareRasterizer.h"
+#include "TaskScheduler.h"
+#include "QuantizedMesh.h"
+#include "GeometryCache.h"
+#include "VertexStreams.h"
+#include "MeshBounds.h"
+#include "AssetLoader.h"
+#include "MipPyramid.h"
+#include "MeshIO.h"
+#include "MeshUtils.h"
+#include "MeshRecorder.h"
+#include "MeshPlayer.h"
+#include "MeshCodec.h"
 
 class ofApp : public ofBaseApp{
 
@@ -21,6 +38,9 @@ class ofApp : public ofBaseApp{
 		void dragEvent(ofDragInfo dragInfo);
 		void gotMessage(ofMessage msg);
 		
+    //draw the current frame on the CPU and save it as a png
+    void saveSoftwareFrame();
+		
     float radius;
     
     ofMesh mesh;
@@ -33,4 +53,101 @@ class ofApp : public ofBaseApp{
     
     ofImage img;
     
+    //decodes the image on another thread while setup() builds the spheres
+    AssetLoader loader;
+    
+    //the same image with all its mipmaps, filtered on the CPU (and cached on disk)
+    //so the poles where the texture gets squeezed together don't shimmer
+    MipPyramid pyramid;
+    ofTexture mipTexture;
+    bool bMipmaps;
+    
+    
+    //adaptive subdivision: start from a coarse sphere and only
+    //add detail where the pulse wave bends the surface a lot
+    //or where the triangles look big on screen
+    LoopSubdivision subdivision;
+    ofMesh coarseMesh;
+    ofMesh adaptiveMesh;
+    bool bAdaptive;
+    
+    //a lighter version of the sphere for previews
+    MeshDecimator decimator;
+    ofMesh decimatedMesh;
+    bool bDecimated;
+    
+    //only draw the chunks of the sphere that face the camera and are on screen
+    MeshletCuller culler;
+    bool bCulling;
+    
+    //find the triangle under the mouse on the pulsing surface
+    MeshBVH bvh;
+    MeshBVH::Hit hit;
+    bool bPicking;
+    bool bHit;
+    
+    //CPU renderer for saving frames. When the app runs without a window
+    //(build with HEADLESS defined, see main.cpp) it's the only way to see anything
+    SoftwareRasterizer rasterizer;
+    bool bHeadless;
+    int numHeadlessFrames;
+    
+    //the rest positions packed into 16 bits per axis, so the pulse streams
+    //6 bytes per vertex out of memory instead of 12
+    QuantizedMesh compactRest;
+    bool bCompact;
+    float pulseTimeMs;
+    
+    //draw from interleaved buffers: normals + texcoords uploaded once,
+    //only the pulsing positions go to the GPU again every frame
+    VertexStreams streams;
+    bool bStreams;
+    
+    //box and sphere around the pulsing sphere
+    MeshBounds bounds;
+    
+    //point the camera at the bounds and back it up until they fit the view
+    void frameBounds();
+    
+    //.ply and .obj files: meshes dropped on the window are pulsed instead
+    //of the sphere, and 'e' saves the pulsing mesh as it is this frame
+    MeshIO meshIO;
+    string ioInfo;
+    
+    //the sphere squeezed for sending to other machines ('x'), and read back
+    //when a .mcdc file is dropped on the window
+    MeshCodec codec;
+    string codecInfo;
+    
+    //swap the sphere for another mesh and redo everything made from it
+    void replaceMesh(const ofMesh& newMesh);
+    
+    //where the texture's coordinates end (its size in pixels, or 1 x 1)
+    ofVec2f texCoordMax;
+    
+    //the icosphere with its texcoords, and the decimated version of originalMesh.
+    //Both go through the GeometryCache so they're only ever made once
+    shared_ptr<const ofMesh> getSphere(int resolution);
+    void decimate();
+    int sphereResolution;
+    
+    //where the cache found the sphere and its decimated version, and how long it took
+    string getCacheSourceInfo();
+    string cacheInfo;
+    
+    //record the pulse and play it back exactly the same later, even where it
+    //couldn't be worked out in real time (full resolution, slower machine)
+    MeshRecorder recorder;
+    MeshPlayer player;
+    bool bPlaying;
+    size_t playFrame;
+    
+    //what the shared worker threads did during the last frame
+    TaskScheduler::Stats schedulerStats;
+    
+    //pulse parameters (shared by the deformation and the refinement metric)
+    float amplitude;
+    float waveSpeed;
+    float waveCycles;
+    
 };
@@ -0,0 +1,75 @@
+#include "DisjointSets.h"
+
+//--------------------------------------------------------------
+DisjointSets::DisjointSets(){
+    numComponents = 0;
+    largestSize = 0;
+}
+
+//--------------------------------------------------------------
+void DisjointSets::setup(size_t numElements){
+    parent.clear();
+    rank.clear();
+    size.clear();
+    componentId.clear();
+    numComponents = 0;
+    largestSize = 0;
+    resize(numElements);
+}
+
+//--------------------------------------------------------------
+void DisjointSets::resize(size_t numElements){
+
+    size_t first = parent.size();
+    if(numElements <= first) return;
+
+    parent.resize(numElements);
+    rank.resize(numElements, 0);
+    size.resize(numElements, 1);
+    componentId.resize(numElements);
+
+    //each new element is its own root, with its own index as the id
+    for(size_t i = first; i < numElements; i++){
+        parent[i] = i;
+        componentId[i] = i;
+    }
+
+    numComponents += numElements - first;
+    largestSize = max(largestSize, 1u);
+}
+
+//--------------------------------------------------------------
+unsigned DisjointSets::find(unsigned a){
+
+    //path halving: every node on the way skips up to its grandparent.
+    //Same effect as full path compression without a second pass or recursion
+    while(parent[a] != a){
+        parent[a] = parent[parent[a]];
+        a = parent[a];
+    }
+    return a;
+}
+
+//--------------------------------------------------------------
+bool DisjointSets::join(unsigned a, unsigned b){
+
+    unsigned rootA = find(a);
+    unsigned rootB = find(b);
+    if(rootA == rootB) return false;
+
+    //the id comes from the bigger group (by number of elements)...
+    unsigned id = size[rootA] >= size[rootB] ? componentId[rootA] : componentId[rootB];
+
+    //...but the shallower tree goes under the deeper one
+    if(rank[rootA] < rank[rootB]) swap(rootA, rootB);
+    parent[rootB] = rootA;
+    if(rank[rootA] == rank[rootB]) rank[rootA]++;
+
+    size[rootA] += size[rootB];
+    componentId[rootA] = id;
+
+    numComponents--;
+    largestSize = max(largestSize, size[rootA]);
+
+    return true;
+}
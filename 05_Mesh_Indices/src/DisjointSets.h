@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Keeps track of which points are connected to each other (directly or through
+ * other points) as edges get added, a.k.a. union-find.
+ *
+ * Every group ("component") is a little tree of points pointing at their parent,
+ * with one "root" point at the top that stands for the whole group:
+ *
+ *  - find(a) walks up to the root, and points the nodes it passes closer to the
+ *    top on the way (path compression) so the next walk is shorter
+ *  - join(a, b) hangs the shorter tree under the taller one (union by rank) so
+ *    the trees never get deep
+ *
+ * Together that makes each edge cost practically constant time, no matter how
+ * many millions have been added.
+ *
+ * Roots move around as groups merge, so every group also carries an id that
+ * does stay put: when two groups merge the bigger one keeps its id. That's the
+ * one to color things by.
+ */
+
+class DisjointSets {
+
+	public:
+
+    DisjointSets();
+
+    //every element on its own
+    void setup(size_t numElements);
+
+    //add more elements (each on its own) at the end
+    void resize(size_t numElements);
+
+    //connect a and b. Returns true if they were in different groups before
+    bool join(unsigned a, unsigned b);
+
+    //the root of a's group
+    unsigned find(unsigned a);
+
+    bool isConnected(unsigned a, unsigned b) { return find(a) == find(b); }
+
+    //how many elements are in a's group
+    unsigned getSize(unsigned a) { return size[find(a)]; }
+
+    //an id for a's group that stays the same as long as it's the bigger side of every merge
+    unsigned getComponentId(unsigned a) { return componentId[find(a)]; }
+
+    size_t getNumElements() const { return parent.size(); }
+    size_t getNumComponents() const { return numComponents; }
+    unsigned getLargestSize() const { return largestSize; }
+
+    private:
+
+    vector<unsigned> parent;
+    vector<unsigned char> rank;
+
+    //only meaningful at the roots
+    vector<unsigned> size;
+    vector<unsigned> componentId;
+
+    size_t numComponents;
+    unsigned largestSize;
+};
@@ -0,0 +1,127 @@
+#include "ThickLines.h"
+#include "TaskScheduler.h"
+
+//--------------------------------------------------------------
+ThickLines::ThickLines(){
+    ribbons.setMode(OF_PRIMITIVE_TRIANGLES);
+    ribbons.setUsage(GL_DYNAMIC_DRAW);
+    numEdges = 0;
+    width = 1.5;
+    feather = 1;
+    lastUpdateTimeMs = 0;
+}
+
+//--------------------------------------------------------------
+void ThickLines::setWidth(float lineWidth, float featherWidth){
+    if(lineWidth == width && featherWidth == feather) return;
+    width = lineWidth;
+    feather = featherWidth;
+    clear();
+}
+
+//--------------------------------------------------------------
+void ThickLines::clear(){
+    ribbons.clear();
+    ribbons.setMode(OF_PRIMITIVE_TRIANGLES);
+    numEdges = 0;
+}
+
+//--------------------------------------------------------------
+void ThickLines::update(const ofMesh& lines){
+
+    size_t total = lines.getNumIndices() / 2;
+
+    //fewer edges than last time means the lines were reset, start over
+    if(total < numEdges) clear();
+    if(total == numEdges) return;
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    const vector<ofVec3f>& verts = lines.getVertices();
+    const vector<ofIndexType>& lineIndices = lines.getIndices();
+
+    //05 adds a color for every index, other meshes have one per vertex
+    const vector<ofFloatColor>& lineColors = lines.getColors();
+    bool bColorPerIndex = lines.getNumColors() == lines.getNumIndices();
+    bool bColorPerVertex = !bColorPerIndex && lines.getNumColors() == lines.getNumVertices();
+
+    //make room for the new edges at the end and fill them in all at once.
+    //Each edge only writes its own 8 vertices and 18 indices
+    size_t first = numEdges;
+    vector<ofVec3f>& outVerts = ribbons.getVertices();
+    vector<ofFloatColor>& outColors = ribbons.getColors();
+    vector<ofIndexType>& outIndices = ribbons.getIndices();
+    outVerts.resize(total * 8);
+    outColors.resize(total * 8);
+    outIndices.resize(total * 18);
+
+    float inner = width * 0.5;
+    float outer = inner + feather;
+    const float offsets[4] = { outer, inner, -inner, -outer };
+
+    TaskScheduler::get().parallelFor(first, total, 4096, [&](size_t begin, size_t end){
+        for(size_t e = begin; e < end; e++){
+
+            ofIndexType ia = lineIndices[e * 2];
+            ofIndexType ib = lineIndices[e * 2 + 1];
+            const ofVec3f& a = verts[ia];
+            const ofVec3f& b = verts[ib];
+
+            //the direction across the edge, on the screen
+            float dx = b.x - a.x;
+            float dy = b.y - a.y;
+            float len = sqrt(dx * dx + dy * dy);
+            float nx = len > 0 ? -dy / len : 0;
+            float ny = len > 0 ? dx / len : 0;
+
+            ofFloatColor colorA = ofFloatColor::white;
+            ofFloatColor colorB = ofFloatColor::white;
+            if(bColorPerIndex){
+                colorA = lineColors[e * 2];
+                colorB = lineColors[e * 2 + 1];
+            } else if(bColorPerVertex){
+                colorA = lineColors[ia];
+                colorB = lineColors[ib];
+            }
+
+            //the outside rows fade out to nothing
+            ofFloatColor clearA = colorA;
+            ofFloatColor clearB = colorB;
+            clearA.a = 0;
+            clearB.a = 0;
+
+            //0-3 across the "a" end, 4-7 across the "b" end
+            size_t v = e * 8;
+            for(int k = 0; k < 4; k++){
+                outVerts[v + k].set(a.x + nx * offsets[k], a.y + ny * offsets[k], a.z);
+                outVerts[v + 4 + k].set(b.x + nx * offsets[k], b.y + ny * offsets[k], b.z);
+
+                bool bEdge = k == 0 || k == 3;
+                outColors[v + k] = bEdge ? clearA : colorA;
+                outColors[v + 4 + k] = bEdge ? clearB : colorB;
+            }
+
+            //3 strips (feather, solid, feather) of 2 triangles each
+            ofIndexType* idx = &outIndices[e * 18];
+            for(int s = 0; s < 3; s++){
+                ofIndexType a0 = v + s, a1 = v + s + 1;
+                ofIndexType b0 = v + 4 + s, b1 = v + 4 + s + 1;
+                idx[s * 6 + 0] = a0;
+                idx[s * 6 + 1] = a1;
+                idx[s * 6 + 2] = b0;
+                idx[s * 6 + 3] = a1;
+                idx[s * 6 + 4] = b1;
+                idx[s * 6 + 5] = b0;
+            }
+        }
+    });
+
+    numEdges = total;
+
+    lastUpdateTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+void ThickLines::draw(){
+    if(numEdges > 0) ribbons.draw();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Turns the edges of an OF_PRIMITIVE_LINES mesh into real triangles so they can
+ * be any width and have soft (antialiased) edges. ofSetLineWidth() is ignored by
+ * modern OpenGL and plain GL lines have hard, jaggy sides.
+ *
+ * Every edge becomes a flat ribbon in the XY (screen) plane, 4 vertices across:
+ *
+ *     a0 ---------------------------- b0     alpha 0   \ feather
+ *     a1 ---------------------------- b1     color     /
+ *     |              edge             |                 width
+ *     a2 ---------------------------- b2     color     \
+ *     a3 ---------------------------- b3     alpha 0   / feather
+ *
+ * so 8 vertices and 6 triangles. The color fades out to nothing over the
+ * feather, which is what makes the edges look smooth.
+ *
+ * The edges only ever get added to, so update() only expands the ones it hasn't
+ * seen yet and appends them to the end. Everything ends up in one mesh that is
+ * drawn with a single draw call no matter how many connections there are.
+ */
+
+class ThickLines {
+
+	public:
+
+    ThickLines();
+
+    //width of the solid part and of the fade on each side, in pixels.
+    //Changing either one expands all the edges again on the next update()
+    void setWidth(float lineWidth, float featherWidth = 1);
+
+    //expand the edges (index pairs) of the lines mesh that are new since the last call
+    void update(const ofMesh& lines);
+
+    void draw();
+
+    //forget all the edges
+    void clear();
+
+    //the triangles the edges were expanded into
+    const ofMesh& getMesh() const { return ribbons; }
+
+    size_t getNumEdges() const { return numEdges; }
+    float getLastUpdateTimeMs() const { return lastUpdateTimeMs; }
+
+    private:
+
+    ofVboMesh ribbons;
+    size_t numEdges;
+
+    float width;
+    float feather;
+
+    float lastUpdateTimeMs;
+};
@@ -1,13 +1,31 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#ifdef BENCHMARK
+#include "MeshBenchmark.h"
+#endif
 
 //========================================================================
-int main( ){
+int main(int argc, char* argv[]){
+#ifdef BENCHMARK
+	// no window, just time the mesh access patterns and compare them with the
+	// baseline in data/benchmarks (the first run, or --save-baseline, saves it).
+	// Exits with 1 if anything got slower than the baseline allows
+	string baseline = "benchmarks/baseline.csv";
+	bool bSave = (argc > 1 && string(argv[1]) == "--save-baseline") || !ofFile::doesFileExist(baseline);
+
+	MeshBenchmark benchmark;
+	benchmark.run();
+	bool bPassed = bSave ? benchmark.saveBaseline(baseline) : benchmark.compare(baseline);
+	cout << benchmark.getReport();
+	cout << (bSave ? "saved the baseline to " + baseline : bPassed ? "no regressions" : "REGRESSED") << endl;
+	return bPassed ? 0 : 1;
+#else
 	ofSetupOpenGL(1024,768,OF_WINDOW);			// <-------- setup the GL context
 
 	// this kicks off the running of my app
 	// can be OF_WINDOW or OF_FULLSCREEN
 	// pass in width and height too:
 	ofRunApp(new ofApp());
+#endif
 
 }
@@ -10,17 +10,47 @@ void ofApp::setup(){
     radius = 50;
     
     
+    //a new seed every launch (it's logged). Put a number here
+    //instead to get the same points and colors every time
+    uint64_t seed = ofGetUnixTime();
+    ofLogNotice("ofApp") << "random seed " << seed;
+    randomStream.setSeed(seed);
+    
     //let's add a bunch of random points to the mesh
-    //we'll connect them later with the mouse
+    //we'll connect them later with the mouse.
+    //They're all filled in at once, spread evenly over the window
     int numPoints = 1000;
     
-    for(int i = 0; i < numPoints; i++){
-        mesh.addVertex(ofVec3f(ofRandom(ofGetWidth()), ofRandom(ofGetHeight()), ofRandom(-50, 50)));
-    }
+    vector<ofVec3f> points(numPoints);
+    randomStream.fillBox(&points[0], numPoints, ofVec3f(0, 0, -50), ofVec3f(ofGetWidth(), ofGetHeight(), 50));
+    setPoints(points);
+    
+    //1.5 pixels wide (like the lines used to be) with a 1 pixel fade on each side
+    thickLines.setWidth(1.5, 1);
+    
+    //the meshes are members so they stay put, even when setPoints() refills them
+    memory.addMesh("mesh", mesh);
+    memory.addMesh("originalMesh", originalMesh);
+    memory.addMesh("ribbons", thickLines.getMesh());
+    memory.addVector("insideMouse", "flags", insideMouse);
+    bMemory = false;
+    
+
+}
+
+//--------------------------------------------------------------
+void ofApp::setPoints(const vector<ofVec3f>& points){
+    
+    mesh.clear();
+    mesh.addVertices(points);
     
     //get a copy of the original mesh
     originalMesh = mesh;
     
+    //every point starts out as its own cluster
+    components.setup(points.size());
+    bComponentsChanged = true;
+    
     //set the original to points since we'll mainly use it to visualize where they are
     originalMesh.setMode(OF_PRIMITIVE_POINTS);
     
@@ -40,12 +70,34 @@ void ofApp::setup(){
     mesh.addColor(ofColor(0, 0));
     mesh.addColor(ofColor(0, 0));
     
-
+    //the old connections' ribbons
+    thickLines.clear();
 }
 
 //--------------------------------------------------------------
 void ofApp::update(){
 
+    //turn any connections made since last frame into ribbons
+    thickLines.update(mesh);
+    
+    //color the points by which cluster they're in: the same hue for all the points
+    //of a cluster, the original red for the ones that aren't connected to anything.
+    //The cluster ids don't change when a small cluster joins a bigger one
+    //so the colors don't jump around as things get connected
+    if(bComponentsChanged){
+        originalMesh.getColors().resize(originalMesh.getNumVertices());
+        for(size_t i = 0; i < originalMesh.getNumVertices(); i++){
+            if(components.getSize(i) > 1){
+                float hue = (components.getComponentId(i) * 37) % 255;
+                originalMesh.setColor(i, ofColor::fromHsb(hue, 200, 255));
+            } else {
+                originalMesh.setColor(i, ofColor(255, 0, 0));
+            }
+        }
+        bComponentsChanged = false;
+    }
+    
+    memory.update();
 }
 
 //--------------------------------------------------------------
@@ -57,17 +109,26 @@ void ofApp::draw(){
     ofDrawBitmapString("Framerate: " + ofToString(ofGetFrameRate()), 15, 15);
     ofDrawBitmapString("Num Vertices: " + ofToString(mesh.getNumVertices()), 15, 30);
     
-    ofDrawBitmapString("Press any key to toggle drawing the underlying points", 15, 60);
+    ofDrawBitmapString("Connections: " + ofToString(mesh.getNumIndices() / 2 - 1) + "  expanding new ones: " + ofToString(thickLines.getLastUpdateTimeMs(), 3) + " ms", 15, 45);
+    ofDrawBitmapString("Press any key to toggle drawing the underlying points ('M' memory overlay, 'S' log memory to a .csv)", 15, 60);
+    ofDrawBitmapString("Clusters: " + ofToString(components.getNumComponents()) + "  largest: " + ofToString(components.getLargestSize()) + " points", 15, 75);
+    ofDrawBitmapString("Drop a .ply or .obj point cloud on the window to connect its points instead", 15, 90);
+    if(!ioInfo.empty()){
+        ofDrawBitmapString(ioInfo, 15, 105);
+    }
     
-    //draw the mesh
+    //draw the connections. GL lines ignore ofSetLineWidth() on most modern drivers
+    //so they're expanded into triangles instead, all in one draw call.
+    //The faded edges overlap each other so they're drawn without the depth test
     ofSetColor(255);
-    ofSetLineWidth(1.5);
-    mesh.draw();
+    ofDisableDepthTest();
+    thickLines.draw();
+    ofEnableDepthTest();
     
     //draw the original mesh with all the points
     if(bDrawPoints){
         glPointSize(5.0);
-        ofSetColor(255, 0, 0);
+        ofSetColor(255);
         originalMesh.drawVertices();
     }
     
@@ -81,6 +142,11 @@ void ofApp::draw(){
     ofSetColor(255, 0, 0);
     ofDrawCircle(mouseX, mouseY, radius);
     
+    if(bMemory){
+        ofDisableDepthTest();
+        memory.draw(ofGetWidth() - 440, 20);
+        ofEnableDepthTest();
+    }
     
     
 }
@@ -88,7 +154,15 @@ void ofApp::draw(){
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key){
 
-    bDrawPoints = !bDrawPoints;
+    //the memory overlay, and logging it to a .csv for soak tests
+    if(key == 'M'){
+        bMemory = !bMemory;
+    } else if(key == 'S'){
+        if(memory.isLogging()) memory.stopLog();
+        else memory.startLog("memory/05_memory.csv");
+    } else {
+        bDrawPoints = !bDrawPoints;
+    }
 }
 
 //--------------------------------------------------------------
@@ -118,61 +192,65 @@ void ofApp::mouseDragged(int x, int y, int button){
     //maximum number of connections in a single drag event
     int maxConnections = 10;
     
-    //go through all the verts
-    for(int i = 0; i < mesh.getNumVertices(); i++){
-        
-        //get this vertex
-        ofVec3f firstVert = mesh.getVertex(i);
-        
-        //see if this point is inside the mouse radius
-        //use the distSquared method and compare it to the mouse radius squared
-        //this avoids using square roots that are used for normal distance calculations
-        //that are very computationally heavy.
-        float firstVertDistSq = ofDistSquared(firstVert.x, firstVert.y, x, y);
-        
-        if(firstVertDistSq < radius * radius){
-        
-            //then look for other points
-            //but only start after the point we've already found
-            for(int j = i + 1; j < mesh.getNumVertices(); j++){
-                
-                //get the second vertex
-                ofVec3f secondVert = mesh.getVertex(j);
-                
-                //See if THIS point is in the mouse too
-                float secondVertDistSq = ofDistSquared(secondVert.x, secondVert.y, x, y);
-                
-                if(secondVertDistSq < radius * radius){
-                    
-                    //if we've gotten this far, we've found two points, both inside the mouse
-                    //add two indices so the mesh will connect them
-                    mesh.addIndex(i);
-                    mesh.addIndex(j);
-                    
-                    //add two colors too while we're here
-                    //this will add two colors in random grayscale with random transparency
-                    mesh.addColor(ofColor(ofRandom(255), ofRandom(255)));
-                    mesh.addColor(ofColor(ofRandom(255), ofRandom(255)));
-                    
-                    //increment the counter since we've made a connection
-                    connectionsMade++;
-                    
-                    //if we've reached the maximum number of connections
-                    //we don't need to look for any more points, so use "break" to
-                    //exit this for loop
-                    if(connectionsMade == maxConnections) break;
-                    
-                }
-                
-                
-            }
+    //First find all the points inside the mouse radius. Checking each point
+    //doesn't depend on any of the others so this part is split up between
+    //all the cores (a few hundred points per task)
+    const vector<ofVec3f>& verts = mesh.getVertices();
+    insideMouse.resize(verts.size());
+    
+    TaskScheduler::get().parallelFor(0, verts.size(), 256, [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++){
+            
+            //use the distSquared method and compare it to the mouse radius squared
+            //this avoids using square roots that are used for normal distance calculations
+            //that are very computationally heavy.
+            insideMouse[i] = ofDistSquared(verts[i].x, verts[i].y, x, y) < radius * radius;
+        }
+    });
+    
+    //gather them up (in order, so we connect the same pairs as going
+    //through every pair of points would)
+    vector<int> found;
+    for(size_t i = 0; i < insideMouse.size(); i++){
+        if(insideMouse[i]) found.push_back(i);
+    }
+    
+    //now connect them two by two. Only the points inside the circle
+    //need to be paired up instead of every point with every other point
+    for(size_t a = 0; a < found.size(); a++){
         
+        //but only start after the point we've already found
+        for(size_t b = a + 1; b < found.size(); b++){
+            
+            //if we've gotten this far, we've found two points, both inside the mouse
+            //add two indices so the mesh will connect them
+            mesh.addIndex(found[a]);
+            mesh.addIndex(found[b]);
+            
+            //and merge the clusters the two points belong to
+            if(components.join(found[a], found[b])) bComponentsChanged = true;
+            
+            //increment the counter since we've made a connection
+            connectionsMade++;
+            
+            //if we've reached the maximum number of connections
+            //we don't need to look for any more points, so use "break" to
+            //exit this for loop
+            if(connectionsMade == maxConnections) break;
         }
         
         //use break again to exit out of the outer for loop
         if(connectionsMade == maxConnections) break;
     }
     
+    //add two colors for every new connection too (to keep the index/color numbers even),
+    //all in one go: random grayscale (no saturation, random brightness) with random transparency
+    size_t firstColor = mesh.getNumColors();
+    mesh.getColors().resize(mesh.getNumIndices());
+    if(mesh.getNumColors() > firstColor){
+        randomStream.fillHsb(&mesh.getColors()[firstColor], mesh.getNumColors() - firstColor, ofVec3f(0, 0, 0), ofVec3f(0, 0, 1), 0, 1);
+    }
+    
     
     
 }
@@ -209,5 +287,55 @@ void ofApp::gotMessage(ofMessage msg){
 
 //--------------------------------------------------------------
 void ofApp::dragEvent(ofDragInfo dragInfo){ 
-
+    
+    if(dragInfo.files.empty()) return;
+    
+    //scans can have many millions of points, more than we could connect with the
+    //mouse (or even fit in memory). So the file streams through a block at a time
+    //and only every step-th point is kept. Whenever that's too many, every other
+    //kept point goes and the step doubles, so they stay spread over the whole file
+    size_t maxPoints = 20000;
+    size_t step = 1;
+    uint64_t numRead = 0;
+    vector<ofVec3f> points;
+    
+    bool bLoaded = meshIO.stream(dragInfo.files[0], [&](const ofMesh& block){
+        for(const ofVec3f& vert : block.getVertices()){
+            if(numRead % step == 0) points.push_back(vert);
+            numRead++;
+            
+            if(points.size() > maxPoints){
+                size_t numKept = (points.size() + 1) / 2;
+                for(size_t i = 0; i < numKept; i++){
+                    points[i] = points[i * 2];
+                }
+                points.resize(numKept);
+                step *= 2;
+            }
+        }
+    });
+    if(!bLoaded || points.empty()) return;
+    
+    //fit the cloud's x and y into the window (the mouse connects points by x and y),
+    //flipped since files have y going up. The depth gets squashed into the
+    //same -50 to 50 as the random points
+    ofVec3f low = points[0];
+    ofVec3f high = points[0];
+    for(const ofVec3f& point : points){
+        low.set(min(low.x, point.x), min(low.y, point.y), min(low.z, point.z));
+        high.set(max(high.x, point.x), max(high.y, point.y), max(high.z, point.z));
+    }
+    ofVec3f center = (low + high) * 0.5;
+    ofVec3f size = high - low;
+    float scale = 0.9 * min(ofGetWidth() / max(size.x, 0.0001f), ofGetHeight() / max(size.y, 0.0001f));
+    float depthScale = 100 / max(size.z, 0.0001f);
+    
+    for(ofVec3f& point : points){
+        point = (point - center) * ofVec3f(scale, -scale, depthScale) + ofVec3f(ofGetWidth() * 0.5, ofGetHeight() * 0.5, 0);
+    }
+    
+    setPoints(points);
+    
+    ioInfo = "Loaded " + ofFilePath::getFileName(dragInfo.files[0]) + ": " + ofToString(points.size()) + " of " + ofToString(numRead) + " points, ";
+    ioInfo += ofToString(meshIO.getLastNumBytes() / (1024.0 * 1024.0), 1) + " MB in " + ofToString(meshIO.getLastTimeMs(), 1) + " ms";
 }
@@ -1,6 +1,12 @@
 #pragma once
 
 #include "ofMain.h"
+#include "TaskScheduler.h"
+#include "ThickLines.h"
+#include "DisjointSets.h"
+#include "MeshIO.h"
+#include "MeshMemory.h"
+#include "RandomStream.h"
 
 class ofApp : public ofBaseApp{
 
@@ -30,6 +36,34 @@ class ofApp : public ofBaseApp{
     int radius;
 
     bool bDrawPoints;
+    
+    //which vertices are inside the mouse circle (filled in on all the cores)
+    vector<unsigned char> insideMouse;
+    
+    //the connections drawn as soft edged ribbons instead of GL lines
+    ThickLines thickLines;
+    
+    //which points have ended up connected to each other (the clusters).
+    //The points are colored by cluster when they're drawn
+    DisjointSets components;
+    bool bComponentsChanged;
+    
+    //start over with these points, nothing connected
+    void setPoints(const vector<ofVec3f>& points);
+    
+    //point clouds (.ply or .obj) dropped on the window replace the random points.
+    //They're streamed in and thinned out, so any size of scan works
+    MeshIO meshIO;
+    string ioInfo;
+    
+    //how much memory the meshes take, attribute by attribute. The indices and
+    //colors grow with every drag, so this is the one to soak test ('M' and 'S')
+    MeshMemory memory;
+    bool bMemory;
+    
+    //the random points and the connections' colors, the same every
+    //time for the same seed
+    RandomStream randomStream;
 
     
     
@@ -0,0 +1,245 @@
+#include "AssetLoader.h"
+
+//image and movie headers store their numbers most significant byte first
+static uint64_t readBigEndian(const unsigned char* bytes, int numBytes){
+    uint64_t value = 0;
+    for(int i = 0; i < numBytes; i++){
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+//--------------------------------------------------------------
+AssetLoader::AssetLoader(){
+    startupBudgetMs = 0;
+    timeToFirstFrameMs = 0;
+    bFirstFrameDrawn = false;
+}
+
+//--------------------------------------------------------------
+AssetLoader::~AssetLoader(){
+    waitForAll();
+}
+
+//--------------------------------------------------------------
+AssetLoader::Image AssetLoader::loadImage(const string& path){
+
+    //promises are what the decoding thread fills in, the futures are what setup() waits on.
+    //(shared so the lambda can be copied)
+    auto sizePromise = make_shared<std::promise<ofVec2f> >();
+    auto pixelsPromise = make_shared<std::promise<ofPixels> >();
+
+    Image image;
+    image.path = path;
+    image.size = sizePromise->get_future().share();
+    image.pixels = pixelsPromise->get_future().share();
+
+    auto decode = [this, path, sizePromise, pixelsPromise](){
+
+        uint64_t start = ofGetElapsedTimeMicros();
+
+        //the header is only a few bytes, so whoever is waiting on the
+        //size can carry on long before the pixels are done
+        int width = 0, height = 0;
+        bool bHeader = readImageSize(path, width, height);
+        if(bHeader){
+            sizePromise->set_value(ofVec2f(width, height));
+        }
+
+        ofPixels pixels;
+        ofLoadImage(pixels, path);
+
+        //a format we can't read the header of, get the size from the pixels
+        if(!bHeader){
+            width = pixels.getWidth();
+            height = pixels.getHeight();
+            sizePromise->set_value(ofVec2f(width, height));
+        }
+
+        uint64_t end = ofGetElapsedTimeMicros();
+        addRecord(Record{path, width, height, (end - start) / 1000.0f, end / 1000.0f});
+
+        pixelsPromise->set_value(std::move(pixels));
+    };
+
+    //with only one core there's nothing to overlap with, so it's decoded right here
+    if(std::thread::hardware_concurrency() > 1){
+        decodes.push_back(std::async(std::launch::async, decode));
+    } else {
+        decode();
+    }
+
+    return image;
+}
+
+//--------------------------------------------------------------
+std::shared_future<ofVec2f> AssetLoader::loadMovie(ofVideoPlayer& movie, const string& path){
+
+    int width = 0, height = 0;
+    if(readMovieSize(path, width, height)){
+        movie.loadAsync(path);
+    } else {
+
+        //not a file we can read the header of, so load it and ask the player
+        movie.load(path);
+        width = movie.getWidth();
+        height = movie.getHeight();
+    }
+
+    std::promise<ofVec2f> sizePromise;
+    sizePromise.set_value(ofVec2f(width, height));
+    return sizePromise.get_future().share();
+}
+
+//--------------------------------------------------------------
+void AssetLoader::waitForAll(){
+    for(std::future<void>& decode : decodes){
+        decode.wait();
+    }
+    decodes.clear();
+}
+
+//--------------------------------------------------------------
+bool AssetLoader::readImageSize(const string& path, int& width, int& height){
+
+    ifstream file(ofToDataPath(path).c_str(), ios::binary);
+    unsigned char header[24];
+    if(!file.read((char*)header, 8)) return false;
+
+    //PNG: the signature, then the IHDR chunk always comes first
+    //with the width and height right at the start
+    if(header[0] == 0x89 && header[1] == 'P' && header[2] == 'N' && header[3] == 'G'){
+        if(!file.read((char*)header + 8, 16)) return false;
+        width = readBigEndian(header + 16, 4);
+        height = readBigEndian(header + 20, 4);
+        return width > 0 && height > 0;
+    }
+
+    //JPEG: a list of segments (0xFF, a marker byte, then a 2 byte length).
+    //The size is in the "start of frame" segment, which comes before the image data
+    if(header[0] == 0xFF && header[1] == 0xD8){
+        file.seekg(2);
+        while(file){
+
+            int marker = file.get();
+            if(marker != 0xFF) return false;
+
+            //any number of 0xFF can pad the space between segments
+            while(marker == 0xFF) marker = file.get();
+
+            //end of image or start of the image data, too late
+            if(marker == 0xD9 || marker == 0xDA || marker == EOF) return false;
+
+            //markers that are just the 2 bytes, no length
+            if(marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) continue;
+
+            unsigned char segment[7];
+            if(!file.read((char*)segment, 2)) return false;
+            int length = readBigEndian(segment, 2);
+
+            //SOF0 to SOF15 (C4, C8 and CC are other things): precision, height, width
+            if(marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC){
+                if(!file.read((char*)segment + 2, 5)) return false;
+                height = readBigEndian(segment + 3, 2);
+                width = readBigEndian(segment + 5, 2);
+                return width > 0 && height > 0;
+            }
+
+            file.seekg(length - 2, ios::cur);
+        }
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------
+//walk the atoms (size, type, contents) in [begin, end) looking for the
+//first track with a picture size. moov and trak are atoms of atoms
+static bool findTrackSize(ifstream& file, uint64_t begin, uint64_t end, int& width, int& height){
+
+    uint64_t pos = begin;
+    while(pos + 8 <= end){
+
+        unsigned char header[16];
+        file.seekg(pos);
+        if(!file.read((char*)header, 8)) return false;
+
+        uint64_t size = readBigEndian(header, 4);
+        string type((char*)header + 4, 4);
+        uint64_t headerSize = 8;
+
+        //a size of 1 means a 64 bit size follows, 0 means "to the end"
+        if(size == 1){
+            if(!file.read((char*)header + 8, 8)) return false;
+            size = readBigEndian(header + 8, 8);
+            headerSize = 16;
+        } else if(size == 0){
+            size = end - pos;
+        }
+        if(size < headerSize || pos + size > end) return false;
+
+        if(type == "moov" || type == "trak"){
+            if(findTrackSize(file, pos + headerSize, pos + size, width, height)) return true;
+        } else if(type == "tkhd"){
+
+            //the track header ends with the width and height as 16.16 fixed point.
+            //Where that is depends on whether the times in it are 32 or 64 bit
+            int version = file.get();
+            uint64_t offset = version == 1 ? 88 : 76;
+            if(offset + 8 <= size - headerSize){
+                unsigned char dimensions[8];
+                file.seekg(pos + headerSize + offset);
+                if(!file.read((char*)dimensions, 8)) return false;
+                width = readBigEndian(dimensions, 4) >> 16;
+                height = readBigEndian(dimensions + 4, 4) >> 16;
+
+                //sound tracks are 0 x 0, keep looking
+                if(width > 0 && height > 0) return true;
+            }
+        }
+
+        pos += size;
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------
+bool AssetLoader::readMovieSize(const string& path, int& width, int& height){
+
+    ifstream file(ofToDataPath(path).c_str(), ios::binary);
+    if(!file) return false;
+
+    file.seekg(0, ios::end);
+    uint64_t fileSize = file.tellg();
+
+    return findTrackSize(file, 0, fileSize, width, height);
+}
+
+//--------------------------------------------------------------
+void AssetLoader::addRecord(const Record& record){
+    std::lock_guard<std::mutex> lock(recordsMutex);
+    records.push_back(record);
+}
+
+//--------------------------------------------------------------
+void AssetLoader::frameDrawn(){
+
+    if(bFirstFrameDrawn) return;
+    bFirstFrameDrawn = true;
+
+    timeToFirstFrameMs = ofGetElapsedTimeMicros() / 1000.0f;
+
+    if(isOverBudget()){
+        ofLogWarning("AssetLoader") << "time to first frame: " << timeToFirstFrameMs << " ms, over the " << startupBudgetMs << " ms budget";
+    } else if(startupBudgetMs > 0){
+        ofLogNotice("AssetLoader") << "time to first frame: " << timeToFirstFrameMs << " ms (budget " << startupBudgetMs << " ms)";
+    } else {
+        ofLogNotice("AssetLoader") << "time to first frame: " << timeToFirstFrameMs << " ms";
+    }
+
+    std::lock_guard<std::mutex> lock(recordsMutex);
+    for(const Record& record : records){
+        ofLogNotice("AssetLoader") << "  " << record.path << ": " << record.width << " x " << record.height << " decoded in " << record.decodeMs << " ms, ready at " << record.readyAtMs << " ms";
+    }
+}
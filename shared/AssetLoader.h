@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ofMain.h"
+
+#include <future>
+#include <thread>
+
+/*
+ * Gets the images and movies off the startup path. Normally setup() sits in
+ * img.load() until the whole file has been decoded before it even starts
+ * building the mesh. With the loader:
+ *
+ *  - loadImage() hands the decoding to a thread of its own and returns
+ *    straight away with two futures: the size (read from the file's header
+ *    first, so it's ready almost immediately) and the decoded pixels
+ *  - loadMovie() starts the video player loading in the background and gets
+ *    the size from the movie file's header, for sketches that size their mesh
+ *    from the movie
+ *
+ * setup() builds the mesh in the meantime and only waits (future.get()) when it
+ * actually needs the pixels, usually just to hand them to the ofImage at the end.
+ * Textures have to be made on the main thread, so that part stays in setup().
+ *
+ * The decoding doesn't go through the TaskScheduler: the main thread helps out
+ * with whatever is queued while it waits for a parallelFor(), so a decode queued
+ * there could end up running on the main thread after all.
+ *
+ * It also keeps track of how long it took to get the first frame on screen
+ * (call frameDrawn() at the end of draw()) and logs it against a budget,
+ * along with when each file was ready.
+ */
+
+class AssetLoader {
+
+	public:
+
+    struct Image {
+        string path;
+        std::shared_future<ofVec2f> size;
+        std::shared_future<ofPixels> pixels;
+    };
+
+    AssetLoader();
+
+    //waits for anything still decoding
+    ~AssetLoader();
+
+    //start decoding an image from the data folder on a worker thread
+    Image loadImage(const string& path);
+
+    //start loading a movie without waiting for it (movie.isLoaded() turns true
+    //once it's ready). The size is ready straight away if the header could be
+    //read, otherwise this falls back to loading the movie the normal way
+    std::shared_future<ofVec2f> loadMovie(ofVideoPlayer& movie, const string& path);
+
+    //wait for all the images
+    void waitForAll();
+
+    //read just the width and height from a file's header without decoding it.
+    //Images can be PNG or JPEG, movies QuickTime (.mov) or MP4
+    static bool readImageSize(const string& path, int& width, int& height);
+    static bool readMovieSize(const string& path, int& width, int& height);
+
+    //time to first frame to stay under, in ms (0 for no budget)
+    void setStartupBudgetMs(float budgetMs) { startupBudgetMs = budgetMs; }
+
+    //call at the end of draw(). The first call measures the time to first frame
+    //(since the app started) and logs it, the rest don't do anything
+    void frameDrawn();
+
+    float getTimeToFirstFrameMs() const { return timeToFirstFrameMs; }
+    bool isOverBudget() const { return startupBudgetMs > 0 && timeToFirstFrameMs > startupBudgetMs; }
+
+    private:
+
+    //how each file went, for the report
+    struct Record {
+        string path;
+        int width, height;
+        float decodeMs;
+        float readyAtMs;    //since the app started
+    };
+
+    void addRecord(const Record& record);
+
+    //the decodes still going (or done but not waited for)
+    vector<std::future<void> > decodes;
+
+    std::mutex recordsMutex;
+    vector<Record> records;
+
+    float startupBudgetMs;
+    float timeToFirstFrameMs;
+    bool bFirstFrameDrawn;
+};
@@ -0,0 +1,225 @@
+#include "EntropyCoder.h"
+
+#include <cstring>
+
+//frequencies are scaled so they add up to 4096 (12 bits)
+static const int probBits = 12;
+static const uint32_t probScale = 1 << probBits;
+
+//the state stays between this and 256 times this, a byte
+//goes in or out whenever it would leave that range
+static const uint32_t stateLow = 1u << 23;
+
+static void writeU32(vector<unsigned char>& out, uint32_t value){
+    for(int i = 0; i < 4; i++){
+        out.push_back((value >> (i * 8)) & 0xff);
+    }
+}
+
+static uint32_t readU32(const unsigned char* p){
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+//--------------------------------------------------------------
+//count the bytes and scale the counts to add up to probScale,
+//without any byte that's there ending up with 0
+static void buildFrequencies(const unsigned char* data, size_t size, uint32_t* freqs){
+
+    uint64_t counts[256] = {0};
+    for(size_t i = 0; i < size; i++){
+        counts[data[i]]++;
+    }
+
+    int64_t total = 0;
+    for(int s = 0; s < 256; s++){
+        if(counts[s] == 0){
+            freqs[s] = 0;
+            continue;
+        }
+        freqs[s] = max<uint64_t>(1, counts[s] * probScale / size);
+        total += freqs[s];
+    }
+
+    //rounding leaves it a little off, take it from (or give it to) the most
+    //common bytes, where a few counts either way make the least difference
+    while(total != probScale){
+        int largest = 0;
+        for(int s = 1; s < 256; s++){
+            if(freqs[s] > freqs[largest]) largest = s;
+        }
+        if(total > probScale){
+            int64_t take = min<int64_t>(total - probScale, freqs[largest] / 2);
+            freqs[largest] -= take;
+            total -= take;
+        } else {
+            freqs[largest] += probScale - total;
+            total = probScale;
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void EntropyCoder::encode(const unsigned char* data, size_t size, vector<unsigned char>& out){
+
+    writeU32(out, size);
+    if(size == 0) return;
+
+    uint32_t freqs[256], starts[256];
+    buildFrequencies(data, size, freqs);
+
+    //the table: how many bytes are used, then each one and its frequency
+    int numSymbols = 0;
+    for(int s = 0; s < 256; s++){
+        if(freqs[s] > 0) numSymbols++;
+    }
+    out.push_back(numSymbols - 1);
+    uint32_t start = 0;
+    for(int s = 0; s < 256; s++){
+        starts[s] = start;
+        start += freqs[s];
+        if(freqs[s] > 0){
+            out.push_back(s);
+            out.push_back(freqs[s] & 0xff);
+            out.push_back(freqs[s] >> 8);
+        }
+    }
+
+    //rANS works backwards: the last byte encoded is the first one decoded.
+    //So the data is encoded from the end and the output filled in from the back.
+    //Even and odd bytes take turns with two states, so the decoder can work on
+    //two bytes at once instead of always waiting for the one before
+    vector<unsigned char> stream(size * 2 + 16);
+    unsigned char* p = stream.data() + stream.size();
+    uint32_t states[2] = {stateLow, stateLow};
+
+    for(size_t i = size; i > 0; i--){
+        unsigned char s = data[i - 1];
+        uint32_t freq = freqs[s];
+        uint32_t& state = states[(i - 1) & 1];
+
+        //push out bytes until the state is small enough to take this symbol
+        uint32_t maxState = ((stateLow >> probBits) << 8) * freq;
+        while(state >= maxState){
+            *--p = state & 0xff;
+            state >>= 8;
+        }
+        state = ((state / freq) << probBits) + (state % freq) + starts[s];
+    }
+
+    //the final states go first, the decoder starts from them
+    p -= 8;
+    for(int i = 0; i < 4; i++){
+        p[i] = (states[0] >> (i * 8)) & 0xff;
+        p[i + 4] = (states[1] >> (i * 8)) & 0xff;
+    }
+
+    size_t streamSize = stream.data() + stream.size() - p;
+    writeU32(out, streamSize);
+    out.insert(out.end(), p, p + streamSize);
+}
+
+//--------------------------------------------------------------
+static inline unsigned char decodeByte(uint32_t& state, const uint32_t* slots, const unsigned char*& stream, const unsigned char* streamEnd){
+
+    uint32_t slot = slots[state & (probScale - 1)];
+    state = ((slot & 0xfff) + 1) * (state >> probBits) + ((slot >> 12) & 0xfff);
+
+    //pull bytes back in until the state is back in range
+    while(state < stateLow && stream < streamEnd){
+        state = (state << 8) | *stream++;
+    }
+    return slot >> 24;
+}
+
+//--------------------------------------------------------------
+size_t EntropyCoder::decode(const unsigned char* in, size_t inSize, vector<unsigned char>& out){
+
+    const unsigned char* p = in;
+    const unsigned char* end = in + inSize;
+
+    if(end - p < 4) return 0;
+    size_t size = readU32(p);
+    p += 4;
+    out.resize(size);
+    if(size == 0) return p - in;
+
+    //the table, and a lookup from every slot of 0-4095 straight to everything
+    //decoding needs: the byte (top 8 bits), how far into the byte's range
+    //the slot is (middle 12) and the byte's frequency - 1 (low 12)
+    if(end - p < 1) return 0;
+    int numSymbols = *p++ + 1;
+    if(end - p < numSymbols * 3) return 0;
+
+    vector<uint32_t> slots(probScale);
+    uint32_t start = 0;
+    for(int k = 0; k < numSymbols; k++){
+        uint32_t s = p[0];
+        uint32_t freq = p[1] | (p[2] << 8);
+        p += 3;
+        if(freq == 0 || start + freq > probScale) return 0;
+        for(uint32_t j = 0; j < freq; j++){
+            slots[start + j] = (s << 24) | (j << 12) | (freq - 1);
+        }
+        start += freq;
+    }
+    if(start != probScale) return 0;
+
+    if(end - p < 4) return 0;
+    size_t streamSize = readU32(p);
+    p += 4;
+    if(streamSize < 8 || (size_t)(end - p) < streamSize) return 0;
+    const unsigned char* stream = p;
+    const unsigned char* streamEnd = p + streamSize;
+
+    unsigned char* o = out.data();
+
+    //only one byte value: the whole block is that byte
+    if(numSymbols == 1){
+        memset(o, slots[0] >> 24, size);
+        return streamEnd - in;
+    }
+
+    uint32_t state0 = readU32(stream);
+    uint32_t state1 = readU32(stream + 4);
+    stream += 8;
+
+    size_t i = 0;
+    for(; i + 1 < size; i += 2){
+        o[i] = decodeByte(state0, slots.data(), stream, streamEnd);
+        o[i + 1] = decodeByte(state1, slots.data(), stream, streamEnd);
+    }
+    if(i < size){
+        o[i] = decodeByte(state0, slots.data(), stream, streamEnd);
+    }
+
+    return streamEnd - in;
+}
+
+//--------------------------------------------------------------
+void EntropyCoder::appendVarint(int32_t value, vector<unsigned char>& out){
+
+    //zigzag: 0, -1, 1, -2, 2 ... become 0, 1, 2, 3, 4 ...
+    uint32_t v = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+
+    while(v >= 0x80){
+        out.push_back((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(v);
+}
+
+//--------------------------------------------------------------
+const unsigned char* EntropyCoder::readVarint(const unsigned char* p, const unsigned char* end, int32_t& value){
+
+    uint32_t v = 0;
+    for(int shift = 0; shift < 35; shift += 7){
+        if(p == end) return nullptr;
+        unsigned char byte = *p++;
+        v |= (uint32_t)(byte & 0x7f) << shift;
+        if(byte < 0x80){
+            value = (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+            return p;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Squeezes bytes down to (nearly) the fewest bits their statistics allow:
+ * bytes that show up a lot get short codes, rare ones long codes. It's rANS
+ * (asymmetric numeral systems) with one table of byte frequencies per call,
+ * stored in front of the data. Fast to decode, and usually a little tighter
+ * than Huffman since a code doesn't have to be a whole number of bits.
+ *
+ * It works best on data that's mostly small numbers, like the differences
+ * between one frame of an animation and the next. appendVarint() turns those
+ * into bytes first: the sign is folded into the lowest bit (zigzag) and the
+ * number is cut into 7 bit pieces, so small numbers take one byte.
+ *
+ * Every call is independent, so blocks of a big buffer can be encoded and
+ * decoded on different cores.
+ */
+
+namespace EntropyCoder {
+
+    //compress size bytes and append them (with the table) to out
+    void encode(const unsigned char* data, size_t size, vector<unsigned char>& out);
+
+    //decompress what encode() made, replacing what's in out.
+    //Returns how many bytes of "in" it used, or 0 if it's damaged
+    size_t decode(const unsigned char* in, size_t inSize, vector<unsigned char>& out);
+
+    //small signed numbers as 1 to 5 bytes
+    void appendVarint(int32_t value, vector<unsigned char>& out);
+
+    //read one back. Returns where it ended, or null if it runs past the end
+    const unsigned char* readVarint(const unsigned char* p, const unsigned char* end, int32_t& value);
+
+}
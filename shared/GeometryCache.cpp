@@ -0,0 +1,284 @@
+#include "GeometryCache.h"
+
+#include <cstring>
+
+//the cache files start with this, then a version number
+static const char cacheMagic[4] = {'G', 'E', 'O', 'C'};
+static const uint32_t cacheVersion = 1;
+
+//64 bit FNV-1a
+static const uint64_t hashStart = 14695981039346656037ULL;
+static const uint64_t hashPrime = 1099511628211ULL;
+
+//--------------------------------------------------------------
+static size_t getMeshBytes(const ofMesh& mesh){
+    return mesh.getNumVertices() * sizeof(ofVec3f) + mesh.getNumNormals() * sizeof(ofVec3f) +
+           mesh.getNumTexCoords() * sizeof(ofVec2f) + mesh.getNumColors() * sizeof(ofFloatColor) +
+           mesh.getNumIndices() * sizeof(ofIndexType);
+}
+
+//--------------------------------------------------------------
+GeometryCache::Key::Key(const string& generator){
+    hash = hashStart;
+    addBytes(generator.data(), generator.size());
+    description = generator + "(";
+    numParameters = 0;
+}
+
+//--------------------------------------------------------------
+void GeometryCache::Key::addBytes(const void* bytes, size_t numBytes){
+
+    //whole 8 byte words at a time (meshes can be big), then what's left one by one
+    const unsigned char* p = (const unsigned char*)bytes;
+    size_t numWords = numBytes / 8;
+    for(size_t i = 0; i < numWords; i++){
+        uint64_t word;
+        memcpy(&word, p + i * 8, 8);
+        hash = (hash ^ word) * hashPrime;
+    }
+    for(size_t i = numWords * 8; i < numBytes; i++){
+        hash = (hash ^ p[i]) * hashPrime;
+    }
+}
+
+//a letter in front of every parameter keeps an int from
+//hashing the same as a float with the same bits
+//--------------------------------------------------------------
+GeometryCache::Key& GeometryCache::Key::add(int value){
+    addBytes("i", 1);
+    addBytes(&value, sizeof(value));
+    description += (numParameters++ > 0 ? ", " : "") + ofToString(value);
+    return *this;
+}
+
+//--------------------------------------------------------------
+GeometryCache::Key& GeometryCache::Key::add(float value){
+    addBytes("f", 1);
+    addBytes(&value, sizeof(value));
+    description += (numParameters++ > 0 ? ", " : "") + ofToString(value);
+    return *this;
+}
+
+//--------------------------------------------------------------
+GeometryCache::Key& GeometryCache::Key::add(const string& value){
+    uint32_t length = value.size();
+    addBytes("s", 1);
+    addBytes(&length, sizeof(length));
+    addBytes(value.data(), value.size());
+    description += (numParameters++ > 0 ? ", " : "") + value;
+    return *this;
+}
+
+//--------------------------------------------------------------
+GeometryCache::Key& GeometryCache::Key::add(const Key& key){
+    addBytes("k", 1);
+    addBytes(&key.hash, sizeof(key.hash));
+    description += (numParameters++ > 0 ? ", " : "") + key.getDescription();
+    return *this;
+}
+
+//--------------------------------------------------------------
+GeometryCache::Key& GeometryCache::Key::add(const ofMesh& mesh){
+
+    uint32_t sizes[6] = {(uint32_t)mesh.getMode(), (uint32_t)mesh.getNumVertices(), (uint32_t)mesh.getNumNormals(),
+                         (uint32_t)mesh.getNumTexCoords(), (uint32_t)mesh.getNumColors(), (uint32_t)mesh.getNumIndices()};
+    addBytes("m", 1);
+    addBytes(sizes, sizeof(sizes));
+    if(sizes[1] > 0) addBytes(&mesh.getVertices()[0], sizes[1] * sizeof(ofVec3f));
+    if(sizes[2] > 0) addBytes(&mesh.getNormals()[0], sizes[2] * sizeof(ofVec3f));
+    if(sizes[3] > 0) addBytes(&mesh.getTexCoords()[0], sizes[3] * sizeof(ofVec2f));
+    if(sizes[4] > 0) addBytes(&mesh.getColors()[0], sizes[4] * sizeof(ofFloatColor));
+    if(sizes[5] > 0) addBytes(&mesh.getIndices()[0], sizes[5] * sizeof(ofIndexType));
+
+    description += (numParameters++ > 0 ? ", " : "") + ofToString(mesh.getNumVertices()) + " vertex mesh " + ofToHex(hash);
+    return *this;
+}
+
+//--------------------------------------------------------------
+GeometryCache& GeometryCache::get(){
+    static GeometryCache cache;
+    return cache;
+}
+
+//--------------------------------------------------------------
+GeometryCache::GeometryCache(){
+    useCount = 0;
+    numBytes = 0;
+    memoryBudget = 512 * 1024 * 1024;
+    folder = "meshcache";
+    lastSource = GENERATED;
+    lastTimeMs = 0;
+}
+
+//--------------------------------------------------------------
+shared_ptr<const ofMesh> GeometryCache::getMesh(const Key& key, const std::function<void(ofMesh&)>& generate){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = entries.find(key.getHash());
+        if(found != entries.end()){
+            found->second.lastUse = ++useCount;
+            lastSource = MEMORY;
+            lastTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+            return found->second.mesh;
+        }
+    }
+
+    //not in memory: the disk, or make it. Nothing's locked while this
+    //happens, so a generator can use the cache for the meshes it needs
+    shared_ptr<ofMesh> mesh = make_shared<ofMesh>();
+    string path = folder + "/" + ofToHex(key.getHash()) + ".mesh";
+    Source source = DISK;
+
+    if(folder.empty() || !load(path, key, *mesh)){
+        *mesh = ofMesh();
+        generate(*mesh);
+        source = GENERATED;
+
+        if(!folder.empty()){
+            ofDirectory::createDirectory(folder, true, true);
+            save(path, key, *mesh);
+        }
+    }
+
+    float timeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+    ofLogNotice("GeometryCache") << key.getDescription() << (source == DISK ? " read from " + path : " generated") << " in " << timeMs << " ms";
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    //another thread may have made the same one in the meantime, everybody gets the same copy
+    Entry& entry = entries[key.getHash()];
+    if(!entry.mesh){
+        entry.mesh = mesh;
+        entry.numBytes = getMeshBytes(*mesh);
+        numBytes += entry.numBytes;
+    }
+    entry.lastUse = ++useCount;
+    shared_ptr<const ofMesh> result = entry.mesh;
+
+    trim();
+
+    lastSource = source;
+    lastTimeMs = timeMs;
+    return result;
+}
+
+//--------------------------------------------------------------
+void GeometryCache::trim(){
+
+    //the one that was just asked for is the most recent, so it always stays
+    while(numBytes > memoryBudget && entries.size() > 1){
+        auto oldest = entries.begin();
+        for(auto it = entries.begin(); it != entries.end(); ++it){
+            if(it->second.lastUse < oldest->second.lastUse) oldest = it;
+        }
+        numBytes -= oldest->second.numBytes;
+        entries.erase(oldest);
+    }
+}
+
+//--------------------------------------------------------------
+void GeometryCache::setFolder(const string& folder){
+    std::lock_guard<std::mutex> lock(mutex);
+    this->folder = folder;
+}
+
+//--------------------------------------------------------------
+void GeometryCache::setMemoryBudget(size_t numBytes){
+    std::lock_guard<std::mutex> lock(mutex);
+    memoryBudget = numBytes;
+    trim();
+}
+
+//--------------------------------------------------------------
+void GeometryCache::clear(){
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    numBytes = 0;
+}
+
+//--------------------------------------------------------------
+size_t GeometryCache::getNumMeshes() const{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+//--------------------------------------------------------------
+size_t GeometryCache::getNumBytes() const{
+    std::lock_guard<std::mutex> lock(mutex);
+    return numBytes;
+}
+
+//the file: magic, version, the key's description (so a hash that happens to
+//match a different key isn't mistaken for it), the mode, how many of each
+//attribute there are, then the arrays exactly as they are in the mesh
+//--------------------------------------------------------------
+bool GeometryCache::load(const string& path, const Key& key, ofMesh& mesh) const{
+
+    ifstream file(ofToDataPath(path).c_str(), ios::binary);
+    if(!file) return false;
+
+    char magic[4];
+    uint32_t header[2];
+    if(!file.read(magic, 4) || !file.read((char*)header, sizeof(header))) return false;
+    if(string(magic, 4) != string(cacheMagic, 4) || header[0] != cacheVersion || header[1] > 65536) return false;
+
+    string description(header[1], ' ');
+    if(!file.read(&description[0], header[1]) || description != key.getDescription()) return false;
+
+    uint32_t sizes[6];
+    if(!file.read((char*)sizes, sizeof(sizes))) return false;
+
+    //the sizes have to add up to exactly what's left of the file. A cut off or
+    //damaged file could otherwise ask for gigabytes, it's just made again instead
+    uint64_t expected = (uint64_t)sizes[1] * sizeof(ofVec3f) + (uint64_t)sizes[2] * sizeof(ofVec3f)
+                      + (uint64_t)sizes[3] * sizeof(ofVec2f) + (uint64_t)sizes[4] * sizeof(ofFloatColor)
+                      + (uint64_t)sizes[5] * sizeof(ofIndexType);
+    streampos dataStart = file.tellg();
+    file.seekg(0, ios::end);
+    streampos fileEnd = file.tellg();
+    file.seekg(dataStart);
+    if(!file || dataStart < 0 || (uint64_t)(fileEnd - dataStart) != expected) return false;
+
+    mesh.setMode((ofPrimitiveMode)sizes[0]);
+    mesh.getVertices().resize(sizes[1]);
+    mesh.getNormals().resize(sizes[2]);
+    mesh.getTexCoords().resize(sizes[3]);
+    mesh.getColors().resize(sizes[4]);
+    mesh.getIndices().resize(sizes[5]);
+
+    if(sizes[1] > 0) file.read((char*)&mesh.getVertices()[0], sizes[1] * sizeof(ofVec3f));
+    if(sizes[2] > 0) file.read((char*)&mesh.getNormals()[0], sizes[2] * sizeof(ofVec3f));
+    if(sizes[3] > 0) file.read((char*)&mesh.getTexCoords()[0], sizes[3] * sizeof(ofVec2f));
+    if(sizes[4] > 0) file.read((char*)&mesh.getColors()[0], sizes[4] * sizeof(ofFloatColor));
+    if(sizes[5] > 0) file.read((char*)&mesh.getIndices()[0], sizes[5] * sizeof(ofIndexType));
+
+    return (bool)file;
+}
+
+//--------------------------------------------------------------
+void GeometryCache::save(const string& path, const Key& key, const ofMesh& mesh) const{
+
+    string description = key.getDescription();
+    uint32_t header[2] = {cacheVersion, (uint32_t)description.size()};
+    uint32_t sizes[6] = {(uint32_t)mesh.getMode(), (uint32_t)mesh.getNumVertices(), (uint32_t)mesh.getNumNormals(),
+                         (uint32_t)mesh.getNumTexCoords(), (uint32_t)mesh.getNumColors(), (uint32_t)mesh.getNumIndices()};
+
+    ofstream file(ofToDataPath(path).c_str(), ios::binary);
+    file.write(cacheMagic, 4);
+    file.write((const char*)header, sizeof(header));
+    file.write(description.data(), description.size());
+    file.write((const char*)sizes, sizeof(sizes));
+
+    if(sizes[1] > 0) file.write((const char*)&mesh.getVertices()[0], sizes[1] * sizeof(ofVec3f));
+    if(sizes[2] > 0) file.write((const char*)&mesh.getNormals()[0], sizes[2] * sizeof(ofVec3f));
+    if(sizes[3] > 0) file.write((const char*)&mesh.getTexCoords()[0], sizes[3] * sizeof(ofVec2f));
+    if(sizes[4] > 0) file.write((const char*)&mesh.getColors()[0], sizes[4] * sizeof(ofFloatColor));
+    if(sizes[5] > 0) file.write((const char*)&mesh.getIndices()[0], sizes[5] * sizeof(ofIndexType));
+
+    if(!file){
+        ofLogWarning("GeometryCache") << "couldn't write " << path;
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "ofMain.h"
+#include <mutex>
+
+/*
+ * Keeps meshes that are generated from a few numbers (a plane's size and rows,
+ * a sphere's resolution...) or made from another mesh (a decimated version), so
+ * they're only ever generated once.
+ *
+ * A mesh is looked up by a Key: the generator's name and everything it depends
+ * on, boiled down to a 64 bit hash. If a mesh with that key was made before it
+ * comes from memory (instantly, and the same copy for everybody that asks), or
+ * from the cache folder in bin/data, where every generated mesh is saved.
+ * Otherwise the generator runs, and its mesh is kept in both places.
+ *
+ * The meshes are handed out as shared_ptr<const ofMesh>: nobody can change them,
+ * so one copy in memory can be shared by every part of the app that uses the same
+ * geometry. Sketches that deform their mesh copy it (mesh = *cached).
+ *
+ * The key is all the cache knows about the generator. When a generator's code
+ * changes, change its name (or add a version number) or the old meshes come back.
+ */
+
+class GeometryCache {
+
+	public:
+
+    //what a mesh is made from. Parameters are hashed in the order they're added
+    class Key {
+
+        public:
+
+        Key(const string& generator);
+
+        Key& add(int value);
+        Key& add(float value);
+        Key& add(const string& value);
+
+        //meshes made from another mesh: its key, or everything that's in it
+        Key& add(const Key& key);
+        Key& add(const ofMesh& mesh);
+
+        uint64_t getHash() const { return hash; }
+
+        //"name(param, param...)" for the log
+        string getDescription() const { return description + ")"; }
+
+        private:
+
+        void addBytes(const void* bytes, size_t numBytes);
+
+        uint64_t hash;
+        string description;
+        int numParameters;
+    };
+
+    //where the last getMesh() found its mesh
+    enum Source {
+        MEMORY,
+        DISK,
+        GENERATED
+    };
+
+    //the cache everybody shares, so the same mesh is only ever in memory once
+    static GeometryCache& get();
+
+    GeometryCache();
+
+    //the mesh for the key, from memory, the cache folder or generate()
+    shared_ptr<const ofMesh> getMesh(const Key& key, const std::function<void(ofMesh&)>& generate);
+
+    //where meshes are saved (in bin/data). Empty keeps them in memory only
+    void setFolder(const string& folder);
+
+    //when the meshes in memory go over this many bytes the ones that haven't
+    //been asked for the longest are let go (they're still on disk)
+    void setMemoryBudget(size_t numBytes);
+
+    //let go of everything in memory
+    void clear();
+
+    size_t getNumMeshes() const;
+    size_t getNumBytes() const;
+
+    Source getLastSource() const { return lastSource; }
+    float getLastTimeMs() const { return lastTimeMs; }
+
+    private:
+
+    struct Entry {
+        shared_ptr<const ofMesh> mesh;
+        size_t numBytes;
+        uint64_t lastUse;
+    };
+
+    bool load(const string& path, const Key& key, ofMesh& mesh) const;
+    void save(const string& path, const Key& key, const ofMesh& mesh) const;
+
+    //drop the least recently used meshes until they fit the budget
+    void trim();
+
+    mutable std::mutex mutex;
+    map<uint64_t, Entry> entries;
+    uint64_t useCount;
+    size_t numBytes;
+    size_t memoryBudget;
+    string folder;
+
+    Source lastSource;
+    float lastTimeMs;
+};
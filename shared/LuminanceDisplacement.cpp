@@ -0,0 +1,120 @@
+#include "LuminanceDisplacement.h"
+#include "TaskScheduler.h"
+
+//--------------------------------------------------------------
+LuminanceDisplacement::LuminanceDisplacement(){
+    bNormalized = false;
+    lookupWidth = 0;
+    lookupHeight = 0;
+    lookupChannels = 0;
+    stepRight = 0;
+    stepDown = 0;
+    lastUpdateTimeMs = 0;
+}
+
+//--------------------------------------------------------------
+void LuminanceDisplacement::setup(const ofMesh& restMesh, bool normalizedTexCoords){
+
+    restPositions = restMesh.getVertices();
+    texCoords = restMesh.getTexCoords();
+    bNormalized = normalizedTexCoords;
+
+    if(texCoords.size() != restPositions.size()){
+        ofLogWarning("LuminanceDisplacement") << "setup(): the mesh needs one texcoord per vertex";
+        texCoords.resize(restPositions.size());
+    }
+
+    //the lookups get made on the first frame, once we know its size
+    lookupWidth = 0;
+    lookupHeight = 0;
+    lookupChannels = 0;
+}
+
+//--------------------------------------------------------------
+void LuminanceDisplacement::computeLookups(int width, int height, int channels){
+
+    lookupWidth = width;
+    lookupHeight = height;
+    lookupChannels = channels;
+
+    //a 1 pixel wide (or tall) image has no neighbor to blend with
+    stepRight = width > 1 ? channels : 0;
+    stepDown = height > 1 ? width * channels : 0;
+
+    size_t numVerts = texCoords.size();
+    texelOffset.resize(numVerts);
+    fracX.resize(numVerts);
+    fracY.resize(numVerts);
+
+    for(size_t i = 0; i < numVerts; i++){
+
+        float u = texCoords[i].x;
+        float v = texCoords[i].y;
+        if(bNormalized){
+            u *= width;
+            v *= height;
+        }
+
+        //pixel centers are at .5, clamp to the edges of the image.
+        //The top left pixel never goes past the second to last one, at the
+        //very edge the blend just goes all the way to the last one instead
+        float fx = ofClamp(u - 0.5, 0, width - 1);
+        float fy = ofClamp(v - 0.5, 0, height - 1);
+        int ix = min((int)fx, max(0, width - 2));
+        int iy = min((int)fy, max(0, height - 2));
+
+        texelOffset[i] = (iy * width + ix) * channels;
+        fracX[i] = fx - ix;
+        fracY[i] = fy - iy;
+    }
+}
+
+//--------------------------------------------------------------
+void LuminanceDisplacement::update(const ofPixels& frame, ofMesh& mesh, float height){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    if(!frame.isAllocated()) return;
+
+    vector<ofVec3f>& verts = mesh.getVertices();
+    if(verts.size() != restPositions.size()){
+        ofLogWarning("LuminanceDisplacement") << "update(): the mesh doesn't match the one from setup()";
+        return;
+    }
+
+    int channels = frame.getNumChannels();
+    if((int)frame.getWidth() != lookupWidth || (int)frame.getHeight() != lookupHeight || channels != lookupChannels){
+        computeLookups(frame.getWidth(), frame.getHeight(), channels);
+    }
+
+    const unsigned char* pixels = frame.getData();
+
+    //brightness of one pixel as 0-255: the usual 0.299 R + 0.587 G + 0.114 B
+    //in whole numbers (out of 256). Grayscale images are already brightness
+    bool bColor = channels >= 3;
+    auto luminance = [=](const unsigned char* p){
+        return bColor ? (77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8 : p[0];
+    };
+
+    float scale = height / 255.0;
+
+    TaskScheduler::get().parallelFor(0, verts.size(), 8192, [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++){
+
+            const unsigned char* p = pixels + texelOffset[i];
+            float topLeft = luminance(p);
+            float topRight = luminance(p + stepRight);
+            float bottomLeft = luminance(p + stepDown);
+            float bottomRight = luminance(p + stepDown + stepRight);
+
+            float top = topLeft + (topRight - topLeft) * fracX[i];
+            float bottom = bottomLeft + (bottomRight - bottomLeft) * fracX[i];
+            float lum = top + (bottom - top) * fracY[i];
+
+            const ofVec3f& rest = restPositions[i];
+            verts[i].set(rest.x, rest.y, rest.z + lum * scale);
+        }
+    });
+
+    lastUpdateTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Pushes every vertex out along z by how bright the image is at its texture
+ * coordinate, so the mesh turns into a relief of whatever is on the texture
+ * (a movie, a camera, an image...).
+ *
+ * The texcoords don't change from frame to frame, so where each vertex reads
+ * from the image (which 4 pixels and how much of each, for bilinear filtering)
+ * is worked out once in advance. Every frame is then just 4 reads, a few
+ * multiplies and one write per vertex, straight from the frame's pixels (no
+ * copies), split across all the cores.
+ */
+
+class LuminanceDisplacement {
+
+	public:
+
+    LuminanceDisplacement();
+
+    //remember the rest positions and texcoords of the mesh. Texcoords are in
+    //pixels (like OF's default textures) unless normalizedTexCoords is true
+    void setup(const ofMesh& restMesh, bool normalizedTexCoords = false);
+
+    //mesh vertices = rest positions + (0, 0, brightness * height),
+    //with brightness going from 0 (black) to 1 (white)
+    void update(const ofPixels& frame, ofMesh& mesh, float height);
+
+    float getLastUpdateTimeMs() const { return lastUpdateTimeMs; }
+
+    private:
+
+    //work out where every vertex reads from a frame of this size
+    void computeLookups(int width, int height, int channels);
+
+    vector<ofVec3f> restPositions;
+    vector<ofVec2f> texCoords;
+    bool bNormalized;
+
+    //the frame size the lookups were made for
+    int lookupWidth, lookupHeight, lookupChannels;
+
+    //per vertex: offset of the top left of its 4 pixels and how far
+    //towards the right/bottom ones the sample point is
+    vector<unsigned> texelOffset;
+    vector<float> fracX, fracY;
+
+    //from the top left pixel to the one to its right / the one below
+    unsigned stepRight, stepDown;
+
+    float lastUpdateTimeMs;
+};
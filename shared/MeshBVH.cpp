@@ -0,0 +1,257 @@
+#include "MeshBVH.h"
+#include "MeshUtils.h"
+
+#include "TaskScheduler.h"
+
+//--------------------------------------------------------------
+MeshBVH::MeshBVH(){
+    maxLeafSize = 4;
+    lastRefitTimeMs = 0;
+    lastQueryTimeUs = 0;
+}
+
+//--------------------------------------------------------------
+void MeshBVH::build(const ofMesh& mesh, unsigned maxLeafTriangles){
+
+    nodes.clear();
+    levels.clear();
+    order.clear();
+
+    if(!MeshUtils::getTriangleIndices(mesh, triangles) || triangles.empty()){
+        triangles.clear();
+        return;
+    }
+
+    maxLeafSize = max(1u, maxLeafTriangles);
+
+    const vector<ofVec3f>& verts = mesh.getVertices();
+    size_t numTris = triangles.size() / 3;
+
+    //the tree is split on triangle centers
+    vector<ofVec3f> centroids(numTris);
+    order.resize(numTris);
+    for(size_t t = 0; t < numTris; t++){
+        centroids[t] = (verts[triangles[t * 3]] + verts[triangles[t * 3 + 1]] + verts[triangles[t * 3 + 2]]) / 3.0;
+        order[t] = t;
+    }
+
+    nodes.reserve(numTris * 2 / maxLeafSize + 1);
+    buildRecursive(0, numTris, 0, centroids);
+
+    refit(mesh);
+}
+
+//--------------------------------------------------------------
+unsigned MeshBVH::buildRecursive(unsigned first, unsigned count, unsigned depth, vector<ofVec3f>& centroids){
+
+    unsigned index = nodes.size();
+    nodes.push_back(Node());
+
+    if(levels.size() <= depth) levels.resize(depth + 1);
+    levels[depth].push_back(index);
+
+    if(count <= maxLeafSize){
+        nodes[index].first = first;
+        nodes[index].count = count;
+        return index;
+    }
+
+    //split along the longest side of the box around the centers, half the triangles on each side
+    ofVec3f cMin = centroids[order[first]];
+    ofVec3f cMax = cMin;
+    for(unsigned i = first + 1; i < first + count; i++){
+        const ofVec3f& c = centroids[order[i]];
+        cMin.set(min(cMin.x, c.x), min(cMin.y, c.y), min(cMin.z, c.z));
+        cMax.set(max(cMax.x, c.x), max(cMax.y, c.y), max(cMax.z, c.z));
+    }
+
+    ofVec3f size = cMax - cMin;
+    int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+
+    unsigned half = count / 2;
+    std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count, [&](unsigned a, unsigned b){
+        return centroids[a][axis] < centroids[b][axis];
+    });
+
+    //the left child is always the very next node so we only store the right one
+    buildRecursive(first, half, depth + 1, centroids);
+    unsigned right = buildRecursive(first + half, count - half, depth + 1, centroids);
+
+    nodes[index].first = right;
+    nodes[index].count = 0;
+    return index;
+}
+
+//--------------------------------------------------------------
+void MeshBVH::refitNode(Node& node, const vector<ofVec3f>& verts){
+
+    if(node.count > 0){
+        node.boundsMin = verts[triangles[order[node.first] * 3]];
+        node.boundsMax = node.boundsMin;
+
+        for(unsigned i = node.first; i < node.first + node.count; i++){
+            for(int k = 0; k < 3; k++){
+                const ofVec3f& p = verts[triangles[order[i] * 3 + k]];
+                node.boundsMin.set(min(node.boundsMin.x, p.x), min(node.boundsMin.y, p.y), min(node.boundsMin.z, p.z));
+                node.boundsMax.set(max(node.boundsMax.x, p.x), max(node.boundsMax.y, p.y), max(node.boundsMax.z, p.z));
+            }
+        }
+    } else {
+        const Node& left = *(&node + 1);
+        const Node& right = nodes[node.first];
+        node.boundsMin.set(min(left.boundsMin.x, right.boundsMin.x), min(left.boundsMin.y, right.boundsMin.y), min(left.boundsMin.z, right.boundsMin.z));
+        node.boundsMax.set(max(left.boundsMax.x, right.boundsMax.x), max(left.boundsMax.y, right.boundsMax.y), max(left.boundsMax.z, right.boundsMax.z));
+    }
+}
+
+//--------------------------------------------------------------
+void MeshBVH::refit(const ofMesh& mesh){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    const vector<ofVec3f>& verts = mesh.getVertices();
+
+    //deepest level first so the children are always done before their parents.
+    //Nodes on the same level don't depend on each other so they can run in parallel
+    for(int depth = (int)levels.size() - 1; depth >= 0; depth--){
+
+        const vector<unsigned>& level = levels[depth];
+
+        TaskScheduler::get().parallelFor(0, level.size(), 512, [&](size_t begin, size_t end){
+            for(size_t i = begin; i < end; i++){
+                refitNode(nodes[level[i]], verts);
+            }
+        });
+    }
+
+    lastRefitTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+//slab test: distance where the ray enters the box, or -1 if it misses
+static float intersectBox(const ofVec3f& origin, const ofVec3f& invDir, const ofVec3f& bMin, const ofVec3f& bMax, float maxDist){
+
+    float tMin = 0;
+    float tMax = maxDist;
+
+    for(int i = 0; i < 3; i++){
+        float t0 = (bMin[i] - origin[i]) * invDir[i];
+        float t1 = (bMax[i] - origin[i]) * invDir[i];
+        if(t0 > t1) std::swap(t0, t1);
+        tMin = max(tMin, t0);
+        tMax = min(tMax, t1);
+        if(tMax < tMin) return -1;
+    }
+
+    return tMin;
+}
+
+//--------------------------------------------------------------
+bool MeshBVH::raycast(const ofMesh& mesh, const ofVec3f& origin, const ofVec3f& direction, Hit& hit) const{
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    if(nodes.empty()) return false;
+
+    const vector<ofVec3f>& verts = mesh.getVertices();
+
+    //a huge number instead of infinity keeps the slab test happy for axis aligned rays
+    ofVec3f invDir(direction.x != 0 ? 1.0 / direction.x : 1e30,
+                   direction.y != 0 ? 1.0 / direction.y : 1e30,
+                   direction.z != 0 ? 1.0 / direction.z : 1e30);
+
+    float closest = std::numeric_limits<float>::max();
+    bool found = false;
+
+    //depth first, always visiting the nearer child first so we can skip
+    //anything further away than the closest hit so far
+    unsigned stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while(stackSize > 0){
+
+        const Node& node = nodes[stack[--stackSize]];
+
+        if(intersectBox(origin, invDir, node.boundsMin, node.boundsMax, closest) < 0) continue;
+
+        if(node.count == 0){
+            unsigned left = &node - &nodes[0] + 1;
+            unsigned right = node.first;
+
+            float dl = intersectBox(origin, invDir, nodes[left].boundsMin, nodes[left].boundsMax, closest);
+            float dr = intersectBox(origin, invDir, nodes[right].boundsMin, nodes[right].boundsMax, closest);
+
+            //push the far one first so the near one comes off the stack next
+            if(dl >= 0 && dr >= 0){
+                if(dl < dr) std::swap(left, right);
+                stack[stackSize++] = left;
+                stack[stackSize++] = right;
+            } else if(dl >= 0){
+                stack[stackSize++] = left;
+            } else if(dr >= 0){
+                stack[stackSize++] = right;
+            }
+            continue;
+        }
+
+        //Moller-Trumbore ray/triangle test for every triangle in the leaf
+        for(unsigned i = node.first; i < node.first + node.count; i++){
+
+            unsigned t = order[i];
+            const ofVec3f& p0 = verts[triangles[t * 3 + 0]];
+            const ofVec3f& p1 = verts[triangles[t * 3 + 1]];
+            const ofVec3f& p2 = verts[triangles[t * 3 + 2]];
+
+            ofVec3f e1 = p1 - p0;
+            ofVec3f e2 = p2 - p0;
+            ofVec3f pv = direction.getCrossed(e2);
+            float det = e1.dot(pv);
+
+            //parallel to the triangle (both sides count since the sketches don't cull)
+            if(fabs(det) < 1e-12) continue;
+
+            float invDet = 1.0 / det;
+            ofVec3f tv = origin - p0;
+            float u = tv.dot(pv) * invDet;
+            if(u < 0 || u > 1) continue;
+
+            ofVec3f qv = tv.getCrossed(e1);
+            float v = direction.dot(qv) * invDet;
+            if(v < 0 || u + v > 1) continue;
+
+            float dist = e2.dot(qv) * invDet;
+            if(dist <= 0 || dist >= closest) continue;
+
+            closest = dist;
+            found = true;
+
+            hit.triangle = t;
+            hit.u = u;
+            hit.v = v;
+            hit.distance = dist;
+            hit.position = origin + direction * dist;
+            for(int k = 0; k < 3; k++){
+                hit.vertices[k] = triangles[t * 3 + k];
+            }
+
+            //the corner with the biggest weight is the closest one
+            float w0 = 1 - u - v;
+            hit.vertex = w0 >= u && w0 >= v ? hit.vertices[0] : (u >= v ? hit.vertices[1] : hit.vertices[2]);
+        }
+    }
+
+    lastQueryTimeUs = ofGetElapsedTimeMicros() - start;
+
+    return found;
+}
+
+//--------------------------------------------------------------
+bool MeshBVH::pick(const ofMesh& mesh, const ofCamera& cam, const ofVec2f& screenPos, const ofRectangle& viewport, Hit& hit) const{
+
+    //unproject the point on the near plane (z = -1) and on the far plane (z = 1)
+    ofVec3f nearPoint = cam.screenToWorld(ofVec3f(screenPos.x, screenPos.y, -1), viewport);
+    ofVec3f farPoint = cam.screenToWorld(ofVec3f(screenPos.x, screenPos.y, 1), viewport);
+
+    return raycast(mesh, nearPoint, farPoint - nearPoint, hit);
+}
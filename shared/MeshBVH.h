@@ -0,0 +1,78 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Bounding volume hierarchy for picking triangles on a mesh with a ray.
+ *
+ * The tree is built once from the triangles (which triangles end up in which box
+ * never changes), and after the vertices move we only "refit" it: every leaf box is
+ * recomputed from its triangles, then every parent box from its two children.
+ * That's a lot cheaper than building a new tree and works great for meshes that
+ * keep their topology but wiggle around (noise, scatter, pulse...).
+ *
+ * The refit runs one depth level at a time from the bottom up, with the
+ * nodes of each level split between threads.
+ */
+
+class MeshBVH {
+
+	public:
+
+    struct Hit {
+        unsigned triangle;      //which triangle (in getTriangles() order)
+        ofIndexType vertices[3];
+        ofIndexType vertex;     //the corner closest to the hit point
+        float u, v;             //barycentrics: point = (1 - u - v) * v0 + u * v1 + v * v2
+        float distance;         //along the ray (in units of the direction's length)
+        ofVec3f position;
+    };
+
+    MeshBVH();
+
+    //build the tree from the triangles of the mesh.
+    //Only needed again if the indices (topology) change
+    void build(const ofMesh& mesh, unsigned maxLeafTriangles = 4);
+
+    //update all the boxes to the current vertex positions.
+    //The mesh has to have the same vertices it was built with
+    void refit(const ofMesh& mesh);
+
+    //closest hit along the ray, false if it misses everything.
+    //Pass the same mesh the tree was last refit to
+    bool raycast(const ofMesh& mesh, const ofVec3f& origin, const ofVec3f& direction, Hit& hit) const;
+
+    //ray from the camera through a point on screen (in pixels)
+    bool pick(const ofMesh& mesh, const ofCamera& cam, const ofVec2f& screenPos, const ofRectangle& viewport, Hit& hit) const;
+
+    const vector<ofIndexType>& getTriangles() const { return triangles; }
+    size_t getNumNodes() const { return nodes.size(); }
+
+    //timing of the last refit and the last query
+    float getLastRefitTimeMs() const { return lastRefitTimeMs; }
+    float getLastQueryTimeUs() const { return lastQueryTimeUs; }
+
+    private:
+
+    struct Node {
+        ofVec3f boundsMin;
+        ofVec3f boundsMax;
+        unsigned first;         //leaf: first entry in order, inner: index of the right child
+        unsigned count;         //leaf: number of triangles, inner: 0 (left child is the next node)
+    };
+
+    unsigned buildRecursive(unsigned first, unsigned count, unsigned depth, vector<ofVec3f>& centroids);
+    void refitNode(Node& node, const vector<ofVec3f>& verts);
+
+    vector<Node> nodes;
+    vector<unsigned> order;             //triangle ids sorted so every leaf owns a contiguous range
+    vector<ofIndexType> triangles;      //3 vertex indices per triangle
+
+    //nodes grouped by their depth in the tree, so a whole level can be refit at once
+    vector<vector<unsigned> > levels;
+
+    unsigned maxLeafSize;
+
+    float lastRefitTimeMs;
+    mutable float lastQueryTimeUs;
+};
@@ -0,0 +1,256 @@
+#include "MeshBenchmark.h"
+
+//goes up whenever a case changes what it measures, so old baselines aren't compared with it
+static const int baselineVersion = 2;
+
+//--------------------------------------------------------------
+MeshBenchmark::MeshBenchmark(){
+    repeats = 7;
+    threshold = 0.25;
+    sink = 0;
+}
+
+//--------------------------------------------------------------
+void MeshBenchmark::time(const string& name, size_t numElements, const std::function<float()>& run){
+
+    //once to warm up the caches (and the allocator), then the real runs
+    sink = sink + run();
+
+    vector<float> times;
+    for(int r = 0; r < repeats; r++){
+        uint64_t start = ofGetElapsedTimeMicros();
+        sink = sink + run();
+        times.push_back((ofGetElapsedTimeMicros() - start) * 1000.0f / max(numElements, (size_t)1));
+    }
+
+    //the median, so one run interrupted by something else doesn't count
+    nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+
+    Result result;
+    result.name = name;
+    result.nsPerElement = times[times.size() / 2];
+    result.baselineNs = 0;
+    result.bRegressed = false;
+    results.push_back(result);
+}
+
+//--------------------------------------------------------------
+const vector<MeshBenchmark::Result>& MeshBenchmark::run(){
+
+    results.clear();
+
+    //a mesh like 02's plane at a million vertices: positions, colors, texcoords
+    int numVerts = 1000000;
+    ofMesh mesh;
+    mesh.getVertices().resize(numVerts);
+    mesh.getColors().resize(numVerts);
+    mesh.getTexCoords().resize(numVerts);
+    for(int i = 0; i < numVerts; i++){
+        mesh.getVertices()[i].set(i % 1000, i / 1000, (i * 7919) % 100);
+        mesh.getColors()[i] = ofFloatColor(1, i / (float)numVerts, 0);
+        mesh.getTexCoords()[i].set(i % 1000, i / 1000);
+    }
+    ofVec3f offset(0.5, 0.25, 0);
+
+
+    //---- reading every vertex
+    time("read getVertex", numVerts, [&](){
+        float sum = 0;
+        for(size_t i = 0; i < mesh.getNumVertices(); i++){
+            ofVec3f v = mesh.getVertex(i);
+            sum += v.x + v.y + v.z;
+        }
+        return sum;
+    });
+
+    time("read pointer", numVerts, [&](){
+        float sum = 0;
+        const ofVec3f* verts = mesh.getVerticesPointer();
+        size_t n = mesh.getNumVertices();
+        for(size_t i = 0; i < n; i++){
+            sum += verts[i].x + verts[i].y + verts[i].z;
+        }
+        return sum;
+    });
+
+
+    //---- moving every vertex
+    time("write setVertex", numVerts, [&](){
+        for(size_t i = 0; i < mesh.getNumVertices(); i++){
+            mesh.setVertex(i, mesh.getVertex(i) + offset);
+        }
+        return mesh.getVertex(0).x;
+    });
+
+    time("write pointer", numVerts, [&](){
+        ofVec3f* verts = mesh.getVerticesPointer();
+        size_t n = mesh.getNumVertices();
+        for(size_t i = 0; i < n; i++){
+            verts[i] += offset;
+        }
+        return verts[0].x;
+    });
+
+
+    //---- 05's loop: for every point near the mouse, every other point near it.
+    //Timed per pair of points. Both use the same squared distance test,
+    //so the only difference is how the vertices are read
+    int numPoints = 2000;
+    ofMesh points;
+    points.getVertices().assign(mesh.getVertices().begin(), mesh.getVertices().begin() + numPoints);
+    float radius = 50;
+    float radiusSquared = radius * radius;
+
+    time("05 pairs getVertex", numPoints * numPoints, [&](){
+        float count = 0;
+        for(size_t i = 0; i < points.getNumVertices(); i++){
+            for(size_t j = 0; j < points.getNumVertices(); j++){
+                if(points.getVertex(i).squareDistance(points.getVertex(j)) < radiusSquared) count++;
+            }
+        }
+        return count;
+    });
+
+    time("05 pairs pointer", numPoints * numPoints, [&](){
+        float count = 0;
+        const ofVec3f* verts = points.getVerticesPointer();
+        size_t n = points.getNumVertices();
+        for(size_t i = 0; i < n; i++){
+            for(size_t j = 0; j < n; j++){
+                if(verts[i].squareDistance(verts[j]) < radiusSquared) count++;
+            }
+        }
+        return count;
+    });
+
+
+    //---- building a mesh like 02 and 03's setup does
+    int numGrown = 250000;
+
+    time("grow add", numGrown, [&](){
+        ofMesh grown;
+        for(int i = 0; i < numGrown; i++){
+            grown.addVertex(ofVec3f(i % 500, i / 500, 0));
+            grown.addColor(ofFloatColor(1, 0, 0));
+            grown.addTexCoord(ofVec2f(i % 500, i / 500));
+        }
+        return (float)grown.getNumVertices();
+    });
+
+    time("grow reserved", numGrown, [&](){
+        ofMesh grown;
+        grown.getVertices().reserve(numGrown);
+        grown.getColors().reserve(numGrown);
+        grown.getTexCoords().reserve(numGrown);
+        for(int i = 0; i < numGrown; i++){
+            grown.addVertex(ofVec3f(i % 500, i / 500, 0));
+            grown.addColor(ofFloatColor(1, 0, 0));
+            grown.addTexCoord(ofVec2f(i % 500, i / 500));
+        }
+        return (float)grown.getNumVertices();
+    });
+
+    time("grow bulk", numGrown, [&](){
+        ofMesh grown;
+        grown.getVertices().resize(numGrown);
+        grown.getColors().assign(numGrown, ofFloatColor(1, 0, 0));
+        grown.getTexCoords().resize(numGrown);
+        ofVec3f* verts = grown.getVerticesPointer();
+        ofVec2f* texCoords = grown.getTexCoordsPointer();
+        for(int i = 0; i < numGrown; i++){
+            verts[i].set(i % 500, i / 500, 0);
+            texCoords[i].set(i % 500, i / 500);
+        }
+        return (float)grown.getNumVertices();
+    });
+
+
+    //---- originalMesh = mesh, per vertex
+    time("copy mesh", numVerts, [&](){
+        ofMesh copy;
+        copy = mesh;
+        return copy.getVertex(numVerts - 1).x;
+    });
+
+    return results;
+}
+
+//--------------------------------------------------------------
+bool MeshBenchmark::compare(const string& path){
+
+    ifstream file(ofToDataPath(path).c_str());
+    if(!file){
+        ofLogWarning("MeshBenchmark") << "no baseline in " << path;
+        return false;
+    }
+
+    //version,N then name,ns per element
+    map<string, float> baseline;
+    int version = 1;
+    string line;
+    while(getline(file, line)){
+        size_t comma = line.rfind(',');
+        if(comma == string::npos || line[0] == '#') continue;
+        if(line.substr(0, comma) == "version") version = ofToInt(line.substr(comma + 1));
+        else baseline[line.substr(0, comma)] = ofToFloat(line.substr(comma + 1));
+    }
+
+    if(version != baselineVersion){
+        ofLogWarning("MeshBenchmark") << path << " was saved by an older version of the benchmark, save it again with --save-baseline";
+        return false;
+    }
+
+    bool bPassed = true;
+    for(Result& result : results){
+        auto found = baseline.find(result.name);
+        if(found == baseline.end()) continue;
+
+        result.baselineNs = found->second;
+        result.bRegressed = result.nsPerElement > result.baselineNs * (1 + threshold);
+        if(result.bRegressed){
+            ofLogWarning("MeshBenchmark") << result.name << " regressed: " << result.nsPerElement << " ns, was " << result.baselineNs << " ns";
+            bPassed = false;
+        }
+    }
+    return bPassed;
+}
+
+//--------------------------------------------------------------
+bool MeshBenchmark::saveBaseline(const string& path) const{
+
+    ofDirectory::createDirectory(ofFilePath::getEnclosingDirectory(path), true, true);
+    ofstream file(ofToDataPath(path).c_str());
+    file << "# ns per element, compared with a threshold of " << threshold * 100 << "%\n";
+    file << "version," << baselineVersion << "\n";
+    for(const Result& result : results){
+        file << result.name << "," << result.nsPerElement << "\n";
+    }
+
+    if(!file){
+        ofLogWarning("MeshBenchmark") << "couldn't write " << path;
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+string MeshBenchmark::getReport() const{
+
+    stringstream report;
+    for(size_t i = 0; i < results.size(); i++){
+        const Result& result = results[i];
+        report << left << setw(20) << result.name << ofToString(result.nsPerElement, 3, 10, ' ') << " ns";
+
+        if(result.baselineNs > 0){
+            report << "   baseline " << ofToString(result.baselineNs, 3, 10, ' ') << " ns  " << ofToString(100 * (result.nsPerElement / result.baselineNs - 1), 1) << "%";
+            if(result.bRegressed) report << "  REGRESSED";
+        }
+
+        //the fast way right after the slow one: how many times faster it is
+        if(i > 0 && results[i - 1].name.substr(0, 4) == result.name.substr(0, 4) && result.nsPerElement > 0){
+            report << "   " << ofToString(results[i - 1].nsPerElement / result.nsPerElement, 1) << "x faster than " << results[i - 1].name;
+        }
+        report << "\n";
+    }
+    return report.str();
+}
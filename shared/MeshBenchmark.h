@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Times the ways the sketches get at a mesh's data, next to the faster way of
+ * doing the same thing, so there are numbers instead of guesses:
+ *
+ *  - reading and writing every vertex with getVertex(i) / setVertex(i, v) and
+ *    getNumVertices() in the loop condition, against a pointer to the array
+ *  - 05's mouse loop: every point against every other point, both ways
+ *  - building a mesh one addVertex() / addColor() / addTexCoord() at a time
+ *    (02 and 03's setup), against reserving the space and filling it in bulk
+ *  - copying a whole mesh (originalMesh = mesh)
+ *
+ * Every case runs a few times and the median counts, in nanoseconds per element
+ * (per vertex, or per pair of points), so the sizes can change without the
+ * numbers changing.
+ *
+ * The results can be saved as a baseline (a .csv in bin/data) and later runs
+ * compared against it: any case that got slower by more than the threshold
+ * counts as a regression. Baselines only make sense on the machine they were
+ * saved on, in the same kind of build (release, same compiler flags).
+ */
+
+class MeshBenchmark {
+
+	public:
+
+    struct Result {
+        string name;
+        float nsPerElement;
+        float baselineNs;       //0 if the baseline doesn't have this case
+        bool bRegressed;
+    };
+
+    MeshBenchmark();
+
+    //how many times each case runs (the median is kept)
+    void setRepeats(int repeats) { this->repeats = max(repeats, 1); }
+
+    //how much slower than the baseline counts as a regression (0.25 = 25%)
+    void setThreshold(float threshold) { this->threshold = threshold; }
+
+    //run every case. Takes a few seconds
+    const vector<Result>& run();
+
+    //compare the last run with a baseline file. Returns false if anything
+    //regressed (or there's no baseline to compare with)
+    bool compare(const string& path);
+
+    //save the last run as the baseline
+    bool saveBaseline(const string& path) const;
+
+    //the last run as a table, with the baseline and the raw/accessor speedups
+    string getReport() const;
+
+    const vector<Result>& getResults() const { return results; }
+
+    private:
+
+    //time a case that handles numElements elements per call
+    void time(const string& name, size_t numElements, const std::function<float()>& run);
+
+    vector<Result> results;
+    int repeats;
+    float threshold;
+
+    //everything the cases compute ends up here so the compiler can't skip them
+    volatile float sink;
+};
@@ -0,0 +1,140 @@
+#include "MeshBounds.h"
+#include "TaskScheduler.h"
+
+//vertices per block: big enough that scanning one is worth a task
+static const size_t blockSize = 4096;
+
+//--------------------------------------------------------------
+MeshBounds::MeshBounds(){
+    restRadius = 0;
+    radius = 0;
+    lastUpdateTimeMs = 0;
+    numBlocksScanned = 0;
+}
+
+//--------------------------------------------------------------
+void MeshBounds::compute(const ofMesh& mesh){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    const vector<ofVec3f>& verts = mesh.getVertices();
+    size_t numVerts = verts.size();
+    blocks.resize((numVerts + blockSize - 1) / blockSize);
+
+    TaskScheduler::get().parallelFor(0, blocks.size(), 1, [&](size_t begin, size_t end){
+        for(size_t b = begin; b < end; b++){
+            scanBlock(verts, blocks[b], b * blockSize, min((b + 1) * blockSize, numVerts));
+        }
+    });
+
+    numBlocksScanned = blocks.size();
+    merge();
+
+    lastUpdateTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+void MeshBounds::scanBlock(const vector<ofVec3f>& verts, Block& block, size_t begin, size_t end) const{
+
+    //ofVec3f is 3 floats back to back, so the block is one long run of
+    //x y z x y z ... 12 floats is exactly 4 vertices, read as 3 rows of 4:
+    //
+    //    x y z x | y z x y | z x y z
+    //
+    //keeping 4 running mins and maxes per row means every lane always sees
+    //the same axis, and each row is one SIMD min and one SIMD max
+    const float* p = verts[begin].getPtr();
+    size_t count = end - begin;
+    size_t numGroups = count / 4;
+
+    float min0[4], min1[4], min2[4];
+    float max0[4], max1[4], max2[4];
+    for(int j = 0; j < 4; j++){
+        min0[j] = min1[j] = min2[j] = numeric_limits<float>::max();
+        max0[j] = max1[j] = max2[j] = -numeric_limits<float>::max();
+    }
+
+    for(size_t g = 0; g < numGroups; g++){
+        const float* group = p + g * 12;
+        for(int j = 0; j < 4; j++){
+            min0[j] = min0[j] < group[j] ? min0[j] : group[j];
+            min1[j] = min1[j] < group[j + 4] ? min1[j] : group[j + 4];
+            min2[j] = min2[j] < group[j + 8] ? min2[j] : group[j + 8];
+            max0[j] = max0[j] > group[j] ? max0[j] : group[j];
+            max1[j] = max1[j] > group[j + 4] ? max1[j] : group[j + 4];
+            max2[j] = max2[j] > group[j + 8] ? max2[j] : group[j + 8];
+        }
+    }
+
+    //back to 12 slots in memory order, slot k is axis k % 3
+    float mins[12], maxs[12];
+    for(int j = 0; j < 4; j++){
+        mins[j] = min0[j]; mins[j + 4] = min1[j]; mins[j + 8] = min2[j];
+        maxs[j] = max0[j]; maxs[j + 4] = max1[j]; maxs[j + 8] = max2[j];
+    }
+
+    //the 1 to 3 vertices that didn't fill a whole group
+    for(size_t i = numGroups * 4; i < count; i++){
+        for(int k = 0; k < 3; k++){
+            mins[k] = min(mins[k], p[i * 3 + k]);
+            maxs[k] = max(maxs[k], p[i * 3 + k]);
+        }
+    }
+
+    //fold the 4 vertices' worth of slots down to x, y, z
+    for(int k = 0; k < 3; k++){
+        block.boxMin[k] = min(min(mins[k], mins[k + 3]), min(mins[k + 6], mins[k + 9]));
+        block.boxMax[k] = max(max(maxs[k], maxs[k + 3]), max(maxs[k + 6], maxs[k + 9]));
+    }
+}
+
+//--------------------------------------------------------------
+void MeshBounds::merge(){
+
+    if(blocks.empty()){
+        restMin.set(0, 0, 0);
+        restMax.set(0, 0, 0);
+        restRadius = 0;
+    } else {
+
+        restMin = blocks[0].boxMin;
+        restMax = blocks[0].boxMax;
+        for(const Block& block : blocks){
+            restMin.set(min(restMin.x, block.boxMin.x), min(restMin.y, block.boxMin.y), min(restMin.z, block.boxMin.z));
+            restMax.set(max(restMax.x, block.boxMax.x), max(restMax.y, block.boxMax.y), max(restMax.z, block.boxMax.z));
+        }
+
+        //the sphere through the corners of the box. A second pass measuring
+        //the furthest vertex only gets it a fraction of a percent tighter
+        //and costs more than the box scan itself
+        restRadius = (restMax - restMin).length() * 0.5;
+    }
+
+    boxMin = restMin;
+    boxMax = restMax;
+    radius = restRadius;
+}
+
+//--------------------------------------------------------------
+void MeshBounds::expand(float maxDisplacement){
+    expand(ofVec3f(maxDisplacement, maxDisplacement, maxDisplacement));
+
+    //nothing moves further than maxDisplacement (in any direction), which
+    //is tighter than the corners of the grown box
+    radius = restRadius + maxDisplacement;
+}
+
+//--------------------------------------------------------------
+void MeshBounds::expand(const ofVec3f& maxDisplacement){
+    boxMin = restMin - maxDisplacement;
+    boxMax = restMax + maxDisplacement;
+    radius = (boxMax - boxMin).length() * 0.5;
+    numBlocksScanned = 0;
+    lastUpdateTimeMs = 0;
+}
+
+//--------------------------------------------------------------
+bool MeshBounds::inside(const ofVec3f& p) const{
+    return p.x >= boxMin.x && p.y >= boxMin.y && p.z >= boxMin.z &&
+           p.x <= boxMax.x && p.y <= boxMax.y && p.z <= boxMax.z;
+}
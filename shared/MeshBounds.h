@@ -0,0 +1,74 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * The axis aligned bounding box and a bounding sphere of a mesh, kept up to date
+ * while the mesh moves, for framing the camera, culling, quantizing etc.
+ *
+ * There are two ways to keep them current:
+ *
+ *  - compute():    scan every vertex. The vertices are split into blocks of a
+ *                  few thousand that are scanned on all the cores, and the
+ *                  mesh's bounds are put together from the blocks' boxes
+ *  - expand():     the vertices never move further than some known distance
+ *                  from the rest pose (like the noise amplitude), so the rest
+ *                  bounds are just grown by that much. No scanning at all
+ *
+ * The box scan works on the vertex array as plain floats, 12 at a time (4 whole
+ * vertices) laid out so the compiler can use SIMD min/max instructions for it.
+ */
+
+class MeshBounds {
+
+	public:
+
+    MeshBounds();
+
+    //scan all the vertices. This is also the rest pose expand() grows from
+    void compute(const ofMesh& mesh);
+
+    //bounds of the last compute() grown by maxDisplacement on every side
+    //(for vertices that can move that far in any direction)
+    void expand(float maxDisplacement);
+
+    //the same, with a different distance along each axis. Vertices that only
+    //move along z (a lifted plane) grow the box in z only
+    void expand(const ofVec3f& maxDisplacement);
+
+    const ofVec3f& getMin() const { return boxMin; }
+    const ofVec3f& getMax() const { return boxMax; }
+    ofVec3f getCenter() const { return (boxMin + boxMax) * 0.5; }
+    ofVec3f getSize() const { return boxMax - boxMin; }
+
+    //the sphere is centered on the box and goes through its corners
+    float getRadius() const { return radius; }
+
+    //does the (grown) box contain this point?
+    bool inside(const ofVec3f& p) const;
+
+    float getLastUpdateTimeMs() const { return lastUpdateTimeMs; }
+    size_t getNumBlocksScanned() const { return numBlocksScanned; }
+
+    private:
+
+    struct Block {
+        ofVec3f boxMin, boxMax;
+    };
+
+    void scanBlock(const vector<ofVec3f>& verts, Block& block, size_t begin, size_t end) const;
+
+    //put the mesh's bounds together from the blocks
+    void merge();
+
+    vector<Block> blocks;
+
+    //the bounds from the blocks, and what's reported (maybe grown by expand())
+    ofVec3f restMin, restMax;
+    float restRadius;
+    ofVec3f boxMin, boxMax;
+    float radius;
+
+    float lastUpdateTimeMs;
+    size_t numBlocksScanned;
+};
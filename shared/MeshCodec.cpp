@@ -0,0 +1,687 @@
+#include "MeshCodec.h"
+#include "EntropyCoder.h"
+#include "TaskScheduler.h"
+
+#include <cstring>
+
+//which attributes there are
+static const uint8_t hasNormals = 1;
+static const uint8_t hasTexCoords = 2;
+static const uint8_t hasColors = 4;
+
+//how the indices are stored
+static const uint8_t noIndices = 0;
+static const uint8_t triangleIndices = 1;
+static const uint8_t deltaIndices = 2;
+
+//how many recent edges and vertices a triangle can point back to.
+//Both fit in half a byte, with one value left over for "not there"
+static const int numEdges = 15;
+static const int numVertices = 14;
+static const int notThere = 15;
+
+//zigzag: 0, -1, 1, -2 ... as 0, 1, 2, 3 ... so small differences either way stay small
+//--------------------------------------------------------------
+static inline uint16_t zigzag16(uint16_t d){
+    return (uint16_t)((d << 1) ^ (uint16_t)((int16_t)d >> 15));
+}
+
+static inline uint16_t unzigzag16(uint16_t z){
+    return (uint16_t)((z >> 1) ^ -(int)(z & 1));
+}
+
+static inline uint8_t zigzag8(uint8_t d){
+    return (uint8_t)((d << 1) ^ (uint8_t)((int8_t)d >> 7));
+}
+
+static inline uint8_t unzigzag8(uint8_t z){
+    return (uint8_t)((z >> 1) ^ -(int)(z & 1));
+}
+
+//--------------------------------------------------------------
+static void writeU32(vector<unsigned char>& out, uint32_t value){
+    for(int i = 0; i < 4; i++){
+        out.push_back((value >> (i * 8)) & 0xff);
+    }
+}
+
+static uint32_t readU32(const unsigned char* p){
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+//--------------------------------------------------------------
+//16 bit values with "stride" components per vertex: each one minus the same
+//component of the vertex before, as a stream of low bytes and one of high bytes
+static void encodeDeltas16(const uint16_t* values, size_t count, vector<unsigned char>& low, vector<unsigned char>& high, vector<unsigned char>& out, int stride){
+
+    low.resize(count);
+    high.resize(count);
+    for(size_t j = 0; j < count; j++){
+        uint16_t predicted = j >= (size_t)stride ? values[j - stride] : 0;
+        uint16_t z = zigzag16(values[j] - predicted);
+        low[j] = z & 0xff;
+        high[j] = z >> 8;
+    }
+
+    EntropyCoder::encode(low.data(), count, out);
+    EntropyCoder::encode(high.data(), count, out);
+}
+
+//--------------------------------------------------------------
+static bool decodeDeltas16(const unsigned char*& p, const unsigned char* end, uint16_t* values, size_t count, vector<unsigned char>& low, vector<unsigned char>& high, int stride){
+
+    size_t used = EntropyCoder::decode(p, end - p, low);
+    if(used == 0 || low.size() != count) return false;
+    p += used;
+    used = EntropyCoder::decode(p, end - p, high);
+    if(used == 0 || high.size() != count) return false;
+    p += used;
+
+    //the first vertex of the block was predicted from 0
+    for(size_t j = 0; j < count && j < (size_t)stride; j++){
+        values[j] = unzigzag16(low[j] | (high[j] << 8));
+    }
+    for(size_t j = stride; j < count; j++){
+        values[j] = values[j - stride] + unzigzag16(low[j] | (high[j] << 8));
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+static void encodeDeltas8(const uint8_t* values, size_t count, vector<unsigned char>& low, vector<unsigned char>& out, int stride){
+
+    low.resize(count);
+    for(size_t j = 0; j < count; j++){
+        uint8_t predicted = j >= (size_t)stride ? values[j - stride] : 0;
+        low[j] = zigzag8(values[j] - predicted);
+    }
+
+    EntropyCoder::encode(low.data(), count, out);
+}
+
+//--------------------------------------------------------------
+static bool decodeDeltas8(const unsigned char*& p, const unsigned char* end, uint8_t* values, size_t count, vector<unsigned char>& low, int stride){
+
+    size_t used = EntropyCoder::decode(p, end - p, low);
+    if(used == 0 || low.size() != count) return false;
+    p += used;
+
+    for(size_t j = 0; j < count && j < (size_t)stride; j++){
+        values[j] = unzigzag8(low[j]);
+    }
+    for(size_t j = stride; j < count; j++){
+        values[j] = values[j - stride] + unzigzag8(low[j]);
+    }
+    return true;
+}
+
+//the recent edges and vertices the triangles point back to. Both are rings
+//where 0 is the newest. They start out full of a vertex that can't exist
+//--------------------------------------------------------------
+struct RecentGeometry {
+
+    struct Edge {
+        uint32_t a, b;
+    };
+
+    Edge edges[16];
+    uint32_t vertices[16];
+    size_t edgeCount;
+    size_t vertexCount;
+
+    RecentGeometry(){
+        for(int i = 0; i < 16; i++){
+            edges[i].a = edges[i].b = vertices[i] = 0xffffffff;
+        }
+        edgeCount = 0;
+        vertexCount = 0;
+    }
+
+    const Edge& getEdge(int i) const { return edges[(edgeCount - 1 - i) & 15]; }
+    uint32_t getVertex(int i) const { return vertices[(vertexCount - 1 - i) & 15]; }
+
+    void addEdge(uint32_t a, uint32_t b){
+        Edge& e = edges[edgeCount++ & 15];
+        e.a = a;
+        e.b = b;
+    }
+
+    void addVertex(uint32_t v){
+        vertices[vertexCount++ & 15] = v;
+    }
+};
+
+//--------------------------------------------------------------
+//triangles [first, last): one code byte each (and a second one for the ones
+//that don't share a recent edge), plus the corners that had to be written out.
+//"next" is the next vertex no triangle before this block has used
+static void encodeTriangles(const ofIndexType* indices, size_t first, size_t last, uint32_t next, vector<unsigned char>& out){
+
+    RecentGeometry recent;
+    vector<unsigned char> codes;
+    vector<unsigned char> written;
+    codes.reserve((last - first) * 5 / 4);
+
+    writeU32(out, next);
+    uint32_t lastWritten = next;
+
+    //where a corner comes from: the next new vertex (0), a recent one (1-14)
+    //or written out as the difference to the last written one (15)
+    auto encodeVertex = [&](uint32_t v){
+        if(v == next){
+            next++;
+            recent.addVertex(v);
+            return 0;
+        }
+        for(int i = 0; i < numVertices; i++){
+            if(recent.getVertex(i) == v) return i + 1;
+        }
+        EntropyCoder::appendVarint((int32_t)(v - lastWritten), written);
+        lastWritten = v;
+        next = max(next, v + 1);
+        recent.addVertex(v);
+        return notThere;
+    };
+
+    for(size_t t = first; t < last; t++){
+
+        uint32_t tri[3] = {indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2]};
+
+        //a neighbour goes along the shared edge the other way: our a -> b
+        //is its b -> a. Try each corner as a, the newest edges first
+        int edge = -1;
+        int corner = 0;
+        for(int i = 0; i < numEdges && edge < 0; i++){
+            const RecentGeometry::Edge& e = recent.getEdge(i);
+            for(int k = 0; k < 3; k++){
+                if(e.a == tri[(k + 1) % 3] && e.b == tri[k]){
+                    edge = i;
+                    corner = k;
+                    break;
+                }
+            }
+        }
+
+        if(edge >= 0){
+            uint32_t a = tri[corner], b = tri[(corner + 1) % 3], c = tri[(corner + 2) % 3];
+            codes.push_back((edge << 4) | encodeVertex(c));
+
+            //the shared edge has both its triangles now, it won't come up again
+            recent.addEdge(b, c);
+            recent.addEdge(c, a);
+        } else {
+            uint32_t a = tri[0], b = tri[1], c = tri[2];
+            int codeA = encodeVertex(a);
+            int codeB = encodeVertex(b);
+            int codeC = encodeVertex(c);
+            codes.push_back((notThere << 4) | codeA);
+            codes.push_back((codeB << 4) | codeC);
+
+            recent.addEdge(a, b);
+            recent.addEdge(b, c);
+            recent.addEdge(c, a);
+        }
+    }
+
+    EntropyCoder::encode(codes.data(), codes.size(), out);
+    EntropyCoder::encode(written.data(), written.size(), out);
+}
+
+//--------------------------------------------------------------
+static bool decodeTriangles(const unsigned char* p, const unsigned char* end, ofIndexType* indices, size_t numTriangles, uint32_t numVerts){
+
+    vector<unsigned char> codes, written;
+
+    if(end - p < 4) return false;
+    uint32_t next = readU32(p);
+    p += 4;
+
+    size_t used = EntropyCoder::decode(p, end - p, codes);
+    if(used == 0) return false;
+    p += used;
+    if(EntropyCoder::decode(p, end - p, written) == 0) return false;
+
+    RecentGeometry recent;
+    const unsigned char* c = codes.data();
+    const unsigned char* cEnd = c + codes.size();
+    const unsigned char* w = written.data();
+    const unsigned char* wEnd = w + written.size();
+    uint32_t lastWritten = next;
+
+    //everything the encoder did, the other way around
+    auto decodeVertex = [&](int code){
+        uint32_t v;
+        if(code == 0){
+            v = next++;
+            recent.addVertex(v);
+        } else if(code != notThere){
+            v = recent.getVertex(code - 1);
+        } else {
+            int32_t delta = 0;
+            if(w) w = EntropyCoder::readVarint(w, wEnd, delta);
+            v = lastWritten + delta;
+            lastWritten = v;
+            next = max(next, v + 1);
+            recent.addVertex(v);
+        }
+        return v;
+    };
+
+    for(size_t t = 0; t < numTriangles; t++){
+
+        if(c == cEnd) return false;
+        int code = *c++;
+        uint32_t a, b, v;
+
+        if((code >> 4) != notThere){
+            const RecentGeometry::Edge& e = recent.getEdge(code >> 4);
+            a = e.b;
+            b = e.a;
+            v = decodeVertex(code & 15);
+
+            recent.addEdge(b, v);
+            recent.addEdge(v, a);
+        } else {
+            if(c == cEnd) return false;
+            int more = *c++;
+            a = decodeVertex(code & 15);
+            b = decodeVertex(more >> 4);
+            v = decodeVertex(more & 15);
+
+            recent.addEdge(a, b);
+            recent.addEdge(b, v);
+            recent.addEdge(v, a);
+        }
+
+        //damaged data points at vertices that aren't there
+        if(a >= numVerts || b >= numVerts || v >= numVerts) return false;
+
+        indices[t * 3] = a;
+        indices[t * 3 + 1] = b;
+        indices[t * 3 + 2] = v;
+    }
+
+    return w != nullptr;
+}
+
+//--------------------------------------------------------------
+MeshCodec::MeshCodec(){
+    lastNumBytes = 0;
+    lastRawBytes = 0;
+    lastEncodeTimeMs = 0;
+    lastDecodeTimeMs = 0;
+}
+
+//--------------------------------------------------------------
+size_t MeshCodec::getNumVertexBlocks(const Header& header) const{
+    return (header.numVertices + vertexBlockSize - 1) / vertexBlockSize;
+}
+
+//--------------------------------------------------------------
+size_t MeshCodec::getNumIndexBlocks(const Header& header) const{
+    if(header.indexCoding == triangleIndices){
+        return (header.numIndices / 3 + triangleBlockSize - 1) / triangleBlockSize;
+    }
+    if(header.indexCoding == deltaIndices){
+        return (header.numIndices + indexBlockSize - 1) / indexBlockSize;
+    }
+    return 0;
+}
+
+//--------------------------------------------------------------
+void MeshCodec::encode(const ofMesh& mesh, vector<unsigned char>& out){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+    size_t outStart = out.size();
+
+    TaskScheduler& scheduler = TaskScheduler::get();
+
+    //quantize everything first, the rest works on whole numbers
+    quantized.encode(mesh);
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "MCDC", 4);
+    header.version = 1;
+    header.numVertices = quantized.numVerts;
+    header.numIndices = mesh.getNumIndices();
+    header.mode = mesh.getMode();
+    header.attributes = (quantized.hasNormals() ? hasNormals : 0) | (quantized.hasTexCoords() ? hasTexCoords : 0) | (quantized.hasColors() ? hasColors : 0);
+    for(int k = 0; k < 3; k++){
+        header.positionMin[k] = quantized.positionMin[k];
+        header.positionStep[k] = quantized.positionStep[k];
+    }
+    for(int k = 0; k < 2; k++){
+        header.texCoordMin[k] = quantized.texCoordMin[k];
+        header.texCoordStep[k] = quantized.texCoordStep[k];
+    }
+
+    //the edge trick only works on separate triangles
+    if(header.numIndices == 0){
+        header.indexCoding = noIndices;
+    } else if(mesh.getMode() == OF_PRIMITIVE_TRIANGLES && header.numIndices % 3 == 0){
+        header.indexCoding = triangleIndices;
+    } else {
+        header.indexCoding = deltaIndices;
+    }
+
+    size_t numVertexBlocks = getNumVertexBlocks(header);
+    size_t numIndexBlocks = getNumIndexBlocks(header);
+    vector<vector<unsigned char> > blocks(numVertexBlocks + numIndexBlocks);
+    const ofIndexType* indices = mesh.getNumIndices() > 0 ? &mesh.getIndices()[0] : nullptr;
+
+    //each triangle block starts from the first vertex the blocks before it haven't used
+    vector<uint32_t> blockNext;
+    if(header.indexCoding == triangleIndices){
+        blockNext.resize(numIndexBlocks + 1, 0);
+        scheduler.parallelFor(0, numIndexBlocks, 1, [&](size_t first, size_t last){
+            for(size_t b = first; b < last; b++){
+                size_t end = min((b + 1) * triangleBlockSize * 3, (size_t)header.numIndices);
+                uint32_t next = 0;
+                for(size_t i = b * triangleBlockSize * 3; i < end; i++){
+                    next = max(next, (uint32_t)indices[i] + 1);
+                }
+                blockNext[b + 1] = next;
+            }
+        });
+        for(size_t b = 1; b <= numIndexBlocks; b++){
+            blockNext[b] = max(blockNext[b], blockNext[b - 1]);
+        }
+    }
+
+    scheduler.parallelFor(0, blocks.size(), 1, [&](size_t first, size_t last){
+
+        vector<unsigned char> low, high;
+
+        for(size_t b = first; b < last; b++){
+
+            vector<unsigned char>& block = blocks[b];
+
+            if(b < numVertexBlocks){
+                size_t begin = b * vertexBlockSize;
+                size_t count = min(begin + vertexBlockSize, (size_t)header.numVertices) - begin;
+
+                encodeDeltas16(&quantized.positions[begin * 3], count * 3, low, high, block, 3);
+                if(header.attributes & hasNormals){
+                    encodeDeltas16((const uint16_t*)&quantized.normals[begin * 2], count * 2, low, high, block, 2);
+                }
+                if(header.attributes & hasTexCoords){
+                    encodeDeltas16(&quantized.texCoords[begin * 2], count * 2, low, high, block, 2);
+                }
+                if(header.attributes & hasColors){
+                    encodeDeltas8(&quantized.colors[begin * 4], count * 4, low, block, 4);
+                }
+
+            } else if(header.indexCoding == triangleIndices){
+                size_t i = b - numVertexBlocks;
+                size_t end = min((i + 1) * triangleBlockSize, (size_t)header.numIndices / 3);
+                encodeTriangles(indices, i * triangleBlockSize, end, blockNext[i], block);
+
+            } else {
+                //strips, fans, lines...: each index minus the one before
+                size_t i = b - numVertexBlocks;
+                size_t begin = i * indexBlockSize;
+                size_t end = min(begin + indexBlockSize, (size_t)header.numIndices);
+                low.clear();
+                for(size_t j = begin; j < end; j++){
+                    EntropyCoder::appendVarint((int32_t)(indices[j] - (j > begin ? indices[j - 1] : 0)), low);
+                }
+                EntropyCoder::encode(low.data(), low.size(), block);
+            }
+        }
+    });
+
+    //the header, the size of every block, then the blocks
+    const unsigned char* headerBytes = (const unsigned char*)&header;
+    out.insert(out.end(), headerBytes, headerBytes + sizeof(header));
+    for(const vector<unsigned char>& block : blocks){
+        writeU32(out, block.size());
+    }
+    for(const vector<unsigned char>& block : blocks){
+        out.insert(out.end(), block.begin(), block.end());
+    }
+
+    lastNumBytes = out.size() - outStart;
+    lastRawBytes = QuantizedMesh::getNumBytes(mesh) + mesh.getNumIndices() * sizeof(ofIndexType);
+    lastEncodeTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+bool MeshCodec::decode(const unsigned char* data, size_t size, ofMesh& mesh){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    Header header;
+    if(size < sizeof(header)){
+        ofLogWarning("MeshCodec") << "decode(): too short to be a compressed mesh";
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if(memcmp(header.magic, "MCDC", 4) != 0 || header.version != 1){
+        ofLogWarning("MeshCodec") << "decode(): not a compressed mesh";
+        return false;
+    }
+
+    //find where every block starts
+    size_t numVertexBlocks = getNumVertexBlocks(header);
+    size_t numIndexBlocks = getNumIndexBlocks(header);
+    size_t numBlocks = numVertexBlocks + numIndexBlocks;
+
+    const unsigned char* p = data + sizeof(header);
+    const unsigned char* end = data + size;
+    if((size_t)(end - p) < numBlocks * 4){
+        ofLogWarning("MeshCodec") << "decode(): the data is cut off";
+        return false;
+    }
+
+    vector<const unsigned char*> blockData(numBlocks + 1);
+    blockData[0] = p + numBlocks * 4;
+    for(size_t b = 0; b < numBlocks; b++){
+        blockData[b + 1] = blockData[b] + readU32(p + b * 4);
+        if(blockData[b + 1] > end){
+            ofLogWarning("MeshCodec") << "decode(): the data is cut off";
+            return false;
+        }
+    }
+
+    //the blocks go straight into the packed arrays and the mesh's indices
+    size_t numVerts = header.numVertices;
+    quantized.numVerts = numVerts;
+    for(int k = 0; k < 3; k++){
+        quantized.positionMin[k] = header.positionMin[k];
+        quantized.positionStep[k] = header.positionStep[k];
+    }
+    for(int k = 0; k < 2; k++){
+        quantized.texCoordMin[k] = header.texCoordMin[k];
+        quantized.texCoordStep[k] = header.texCoordStep[k];
+    }
+    //the same error bounds QuantizedMesh::encode() works out (except the
+    //normals', which can only be measured with the original normals)
+    float epsilon = numeric_limits<float>::epsilon();
+    float positionMagnitude = max(quantized.positionMin.length(), (quantized.positionMin + quantized.positionStep * 65535).length());
+    float texCoordMagnitude = max(quantized.texCoordMin.length(), (quantized.texCoordMin + quantized.texCoordStep * 65535).length());
+    quantized.positionError = quantized.positionStep * 0.5 + ofVec3f(1, 1, 1) * positionMagnitude * 4 * epsilon;
+    quantized.texCoordError = quantized.texCoordStep * 0.5 + ofVec2f(1, 1) * texCoordMagnitude * 4 * epsilon;
+    quantized.normalError = 0;
+
+    quantized.positions.resize(numVerts * 3);
+    quantized.normals.resize(header.attributes & hasNormals ? numVerts * 2 : 0);
+    quantized.texCoords.resize(header.attributes & hasTexCoords ? numVerts * 2 : 0);
+    quantized.colors.resize(header.attributes & hasColors ? numVerts * 4 : 0);
+
+    mesh.clear();
+    mesh.setMode((ofPrimitiveMode)header.mode);
+    mesh.getIndices().resize(header.numIndices);
+    ofIndexType* indices = header.numIndices > 0 ? &mesh.getIndices()[0] : nullptr;
+
+    std::atomic<bool> bOk(true);
+
+    TaskScheduler::get().parallelFor(0, numBlocks, 1, [&](size_t first, size_t last){
+
+        vector<unsigned char> low, high;
+
+        for(size_t b = first; b < last && bOk; b++){
+
+            const unsigned char* p = blockData[b];
+            const unsigned char* end = blockData[b + 1];
+            bool bBlockOk = true;
+
+            if(b < numVertexBlocks){
+                size_t begin = b * vertexBlockSize;
+                size_t count = min(begin + vertexBlockSize, numVerts) - begin;
+
+                bBlockOk = decodeDeltas16(p, end, &quantized.positions[begin * 3], count * 3, low, high, 3);
+                if(bBlockOk && (header.attributes & hasNormals)){
+                    bBlockOk = decodeDeltas16(p, end, (uint16_t*)&quantized.normals[begin * 2], count * 2, low, high, 2);
+                }
+                if(bBlockOk && (header.attributes & hasTexCoords)){
+                    bBlockOk = decodeDeltas16(p, end, &quantized.texCoords[begin * 2], count * 2, low, high, 2);
+                }
+                if(bBlockOk && (header.attributes & hasColors)){
+                    bBlockOk = decodeDeltas8(p, end, &quantized.colors[begin * 4], count * 4, low, 4);
+                }
+
+            } else if(header.indexCoding == triangleIndices){
+                size_t i = b - numVertexBlocks;
+                size_t numTriangles = min((i + 1) * triangleBlockSize, (size_t)header.numIndices / 3) - i * triangleBlockSize;
+                bBlockOk = decodeTriangles(p, end, indices + i * triangleBlockSize * 3, numTriangles, numVerts);
+
+            } else {
+                size_t i = b - numVertexBlocks;
+                size_t begin = i * indexBlockSize;
+                size_t count = min(begin + indexBlockSize, (size_t)header.numIndices) - begin;
+                bBlockOk = EntropyCoder::decode(p, end - p, low) > 0;
+
+                const unsigned char* v = low.data();
+                const unsigned char* vEnd = v + low.size();
+                uint32_t index = 0;
+                for(size_t j = 0; j < count && v; j++){
+                    int32_t delta;
+                    v = EntropyCoder::readVarint(v, vEnd, delta);
+                    index += delta;
+                    indices[begin + j] = index;
+                    if(index >= numVerts) v = nullptr;
+                }
+                bBlockOk = bBlockOk && v;
+            }
+
+            if(!bBlockOk) bOk = false;
+        }
+    });
+
+    if(!bOk){
+        ofLogWarning("MeshCodec") << "decode(): the data is damaged";
+        mesh.clear();
+        return false;
+    }
+
+    //and the packed numbers back to floats, on all the cores as well
+    quantized.decode(mesh);
+
+    lastNumBytes = size;
+    lastRawBytes = QuantizedMesh::getNumBytes(mesh) + mesh.getNumIndices() * sizeof(ofIndexType);
+    lastDecodeTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+    return true;
+}
+
+//--------------------------------------------------------------
+bool MeshCodec::save(const string& path, const ofMesh& mesh){
+
+    vector<unsigned char> data;
+    encode(mesh, data);
+
+    ofstream file(ofToDataPath(path).c_str(), ios::binary);
+    file.write((const char*)data.data(), data.size());
+    if(!file){
+        ofLogWarning("MeshCodec") << "couldn't write " << path;
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+bool MeshCodec::load(const string& path, ofMesh& mesh){
+
+    ifstream file(ofToDataPath(path).c_str(), ios::binary);
+    file.seekg(0, ios::end);
+    vector<unsigned char> data(max<streamoff>(file.tellg(), 0));
+    file.seekg(0);
+    file.read((char*)data.data(), data.size());
+    if(!file){
+        ofLogWarning("MeshCodec") << "couldn't read " << path;
+        return false;
+    }
+
+    return decode(data.data(), data.size(), mesh);
+}
+
+//--------------------------------------------------------------
+MeshCodec::Errors MeshCodec::compare(const ofMesh& original, const ofMesh& decoded){
+
+    Errors errors;
+    errors.position = 0;
+    errors.normal = 0;
+    errors.texCoord = 0;
+    errors.color = 0;
+    errors.bIndicesMatch = original.getNumIndices() == decoded.getNumIndices() && original.getMode() == decoded.getMode();
+
+    //nothing to compare if an attribute went missing (or appeared)
+    size_t numVerts = original.getNumVertices();
+    float missing = numeric_limits<float>::max();
+    if(decoded.getNumVertices() != numVerts) errors.position = missing;
+    if(decoded.getNumNormals() != original.getNumNormals()) errors.normal = 180;
+    if(decoded.getNumTexCoords() != original.getNumTexCoords()) errors.texCoord = missing;
+    if(decoded.getNumColors() != original.getNumColors()) errors.color = missing;
+
+    if(errors.position == 0){
+        for(size_t i = 0; i < numVerts; i++){
+            ofVec3f d = original.getVertices()[i] - decoded.getVertices()[i];
+            errors.position = max(errors.position, max(fabs(d.x), max(fabs(d.y), fabs(d.z))));
+        }
+    }
+    if(errors.normal == 0){
+        float smallestDot = 1;
+        for(size_t i = 0; i < original.getNumNormals(); i++){
+            smallestDot = min(smallestDot, original.getNormals()[i].getNormalized().dot(decoded.getNormals()[i]));
+        }
+        errors.normal = ofRadToDeg(acos(ofClamp(smallestDot, -1, 1)));
+    }
+    if(errors.texCoord == 0){
+        for(size_t i = 0; i < original.getNumTexCoords(); i++){
+            ofVec2f d = original.getTexCoords()[i] - decoded.getTexCoords()[i];
+            errors.texCoord = max(errors.texCoord, max(fabs(d.x), fabs(d.y)));
+        }
+    }
+    if(errors.color == 0){
+        for(size_t i = 0; i < original.getNumColors(); i++){
+            const ofFloatColor& a = original.getColors()[i];
+            const ofFloatColor& b = decoded.getColors()[i];
+            errors.color = max(errors.color, max(max(fabs(a.r - b.r), fabs(a.g - b.g)), max(fabs(a.b - b.b), fabs(a.a - b.a))));
+        }
+    }
+
+    //triangles can start at any of their corners, everything else has to be exact
+    if(errors.bIndicesMatch){
+        const vector<ofIndexType>& a = original.getIndices();
+        const vector<ofIndexType>& b = decoded.getIndices();
+        if(original.getMode() == OF_PRIMITIVE_TRIANGLES && a.size() % 3 == 0){
+            for(size_t t = 0; t < a.size() && errors.bIndicesMatch; t += 3){
+                bool bSame = false;
+                for(int k = 0; k < 3 && !bSame; k++){
+                    bSame = a[t] == b[t + k] && a[t + 1] == b[t + (k + 1) % 3] && a[t + 2] == b[t + (k + 2) % 3];
+                }
+                errors.bIndicesMatch = bSame;
+            }
+        } else {
+            errors.bIndicesMatch = a == b;
+        }
+    }
+
+    return errors;
+}
+
+//--------------------------------------------------------------
+float MeshCodec::getDecodeGBPerSecond() const{
+    if(lastDecodeTimeMs <= 0) return 0;
+    return lastRawBytes / (1024.0 * 1024.0 * 1024.0) / (lastDecodeTimeMs / 1000.0);
+}
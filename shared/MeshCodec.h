@@ -0,0 +1,112 @@
+#pragma once
+
+#include "ofMain.h"
+#include "QuantizedMesh.h"
+
+/*
+ * Compresses a whole indexed mesh (vertices, normals, texcoords, colors and
+ * indices) into a small file to send around, and unpacks it again quickly.
+ *
+ * Vertex data: first packed by QuantizedMesh (16 bits per position/texcoord
+ * component, octahedral normals, 8 bit colors), then every value is predicted
+ * from the same value of the vertex before it and only the difference is kept.
+ * Neighbouring vertices are usually close, so the differences are small numbers.
+ * Those are split into a stream of low bytes and one of high bytes (the high ones
+ * are almost all 0) and each stream is squeezed by EntropyCoder.
+ *
+ * Indices of a triangle list: most triangles share an edge with one that came
+ * shortly before them, and most corners are either a vertex that was used
+ * shortly before too or the next vertex that hasn't been used yet. So each
+ * triangle is stored as one byte: which recent edge it's built on (one of the
+ * last 15) and where its third corner comes from (the next new vertex, one of
+ * the last 14 vertices, or a number stored on the side). Triangles that don't
+ * share a recent edge take a second byte for their other corners.
+ * Other modes (strips, fans...) store each index as the difference to the last.
+ *
+ * Everything is cut into blocks that don't depend on each other, so encoding and
+ * decoding run on all the cores, and the decoder writes straight into the mesh.
+ *
+ * What comes back: every value within half a quantization step, and the same
+ * triangles in the same order with the same winding, but a triangle may start
+ * at a different corner (b, c, a instead of a, b, c). compare() checks that.
+ */
+
+class MeshCodec {
+
+	public:
+
+    //how far a decoded mesh is from the original (the largest error of each attribute)
+    struct Errors {
+        float position;         //per axis, in the mesh's units
+        float normal;           //angle, in degrees
+        float texCoord;         //per axis
+        float color;            //per channel, 0-1
+        bool bIndicesMatch;     //same triangles in the same order (any starting corner)
+    };
+
+    MeshCodec();
+
+    //compress the mesh and append it to out
+    void encode(const ofMesh& mesh, vector<unsigned char>& out);
+
+    //unpack a compressed mesh into the mesh (replacing everything in it)
+    bool decode(const unsigned char* data, size_t size, ofMesh& mesh);
+
+    //the same to and from a file
+    bool save(const string& path, const ofMesh& mesh);
+    bool load(const string& path, ofMesh& mesh);
+
+    //the round trip check: what changed from original to decoded
+    static Errors compare(const ofMesh& original, const ofMesh& decoded);
+
+    //the last encode() or decode(): compressed size, the mesh's size as
+    //floats and indices, and how long it took
+    size_t getLastNumBytes() const { return lastNumBytes; }
+    size_t getLastRawBytes() const { return lastRawBytes; }
+    float getCompressionRatio() const { return lastNumBytes > 0 ? lastRawBytes / (float)lastNumBytes : 0; }
+    float getLastEncodeTimeMs() const { return lastEncodeTimeMs; }
+    float getLastDecodeTimeMs() const { return lastDecodeTimeMs; }
+
+    //how fast the last decode() produced the mesh
+    float getDecodeGBPerSecond() const;
+
+    //the most the positions and texcoords can be off by after the last encode()
+    //or decode() (half a step per axis), and the largest normal error measured by encode()
+    ofVec3f getVertexErrorBound() const { return quantized.getVertexErrorBound(); }
+    ofVec2f getTexCoordErrorBound() const { return quantized.getTexCoordErrorBound(); }
+    float getNormalErrorBound() const { return quantized.getNormalErrorBound(); }
+
+    //vertices and triangles per block (a block is encoded and decoded on its own)
+    static const size_t vertexBlockSize = 16384;
+    static const size_t triangleBlockSize = 16384;
+    static const size_t indexBlockSize = 65536;
+
+    private:
+
+    //at the start of the data
+    struct Header {
+        char magic[4];              //"MCDC"
+        uint32_t version;
+        uint32_t numVertices;
+        uint32_t numIndices;
+        uint8_t mode;               //ofPrimitiveMode
+        uint8_t attributes;         //which of normals, texcoords, colors there are
+        uint8_t indexCoding;        //none, triangles or deltas
+        uint8_t reserved;
+        float positionMin[3];
+        float positionStep[3];
+        float texCoordMin[2];
+        float texCoordStep[2];
+    };
+
+    size_t getNumVertexBlocks(const Header& header) const;
+    size_t getNumIndexBlocks(const Header& header) const;
+
+    //the packed vertex data, kept from the last encode()/decode()
+    QuantizedMesh quantized;
+
+    size_t lastNumBytes;
+    size_t lastRawBytes;
+    float lastEncodeTimeMs;
+    float lastDecodeTimeMs;
+};
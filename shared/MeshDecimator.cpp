@@ -0,0 +1,653 @@
+#include "MeshDecimator.h"
+#include "MeshUtils.h"
+#include "TaskScheduler.h"
+
+//--------------------------------------------------------------
+MeshDecimator::Quadric::Quadric(){
+    a2 = ab = ac = ad = b2 = bc = bd = c2 = cd = d2 = 0;
+}
+
+//--------------------------------------------------------------
+//quadric of the plane ax + by + cz + d = 0
+MeshDecimator::Quadric::Quadric(double a, double b, double c, double d, double weight){
+    a2 = a * a * weight; ab = a * b * weight; ac = a * c * weight; ad = a * d * weight;
+    b2 = b * b * weight; bc = b * c * weight; bd = b * d * weight;
+    c2 = c * c * weight; cd = c * d * weight;
+    d2 = d * d * weight;
+}
+
+//--------------------------------------------------------------
+MeshDecimator::Quadric& MeshDecimator::Quadric::operator+=(const Quadric& q){
+    a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+    b2 += q.b2; bc += q.bc; bd += q.bd;
+    c2 += q.c2; cd += q.cd;
+    d2 += q.d2;
+    return *this;
+}
+
+//--------------------------------------------------------------
+double MeshDecimator::Quadric::evaluate(const ofVec3f& p) const{
+    double x = p.x, y = p.y, z = p.z;
+    return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+         + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+         + c2 * z * z + 2 * cd * z
+         + d2;
+}
+
+//--------------------------------------------------------------
+bool MeshDecimator::Quadric::optimize(ofVec3f& p) const{
+
+    //solve the 3x3 system A * p = -b with Cramer's rule
+    double det = a2 * (b2 * c2 - bc * bc) - ab * (ab * c2 - bc * ac) + ac * (ab * bc - b2 * ac);
+
+    //flat or straight areas don't have a single best point
+    if(fabs(det) < 1e-12) return false;
+
+    double inv = 1.0 / det;
+    p.x = -inv * (ad * (b2 * c2 - bc * bc) - ab * (bd * c2 - bc * cd) + ac * (bd * bc - b2 * cd));
+    p.y = -inv * (a2 * (bd * c2 - cd * bc) - ad * (ab * c2 - bc * ac) + ac * (ab * cd - bd * ac));
+    p.z = -inv * (a2 * (b2 * cd - bc * bd) - ab * (ab * cd - bd * ac) + ad * (ab * bc - b2 * ac));
+    return true;
+}
+
+//--------------------------------------------------------------
+MeshDecimator::MeshDecimator(){
+    borderWeight = 100;
+    numCollapses = 0;
+    lastError = 0;
+    lastTimeMs = 0;
+}
+
+//--------------------------------------------------------------
+bool MeshDecimator::decimateRatio(const ofMesh& src, ofMesh& dst, float ratio, float maxError){
+
+    vector<ofIndexType> tris;
+    if(!MeshUtils::getTriangleIndices(src, tris)) return false;
+
+    return decimate(src, dst, (size_t)(ofClamp(ratio, 0, 1) * tris.size() / 3), maxError);
+}
+
+//--------------------------------------------------------------
+bool MeshDecimator::decimate(const ofMesh& src, ofMesh& dst, size_t targetTriangles, float maxError){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    numCollapses = 0;
+    lastError = 0;
+
+    if(!MeshUtils::getTriangleIndices(src, triangles)){
+        ofLogWarning("MeshDecimator") << "decimate(): mesh isn't made of triangles";
+        return false;
+    }
+
+    size_t numVerts = src.getNumVertices();
+    size_t numTris = triangles.size() / 3;
+
+    positions = src.getVertices();
+
+    //only carry the attributes that have one value per vertex
+    texCoords.clear();
+    colors.clear();
+    normals.clear();
+    if(src.getNumTexCoords() == numVerts) texCoords = src.getTexCoords();
+    if(src.getNumColors() == numVerts) colors = src.getColors();
+    if(src.getNumNormals() == numVerts) normals = src.getNormals();
+
+    quadrics.assign(numVerts, Quadric());
+    locked.assign(numVerts, 0);
+    triangleDead.assign(numTris, 0);
+
+    TaskScheduler& scheduler = TaskScheduler::get();
+
+    //---- which triangles each vertex belongs to
+    //(counted first so every list is allocated once)
+    vector<unsigned> valence(numVerts, 0);
+    for(size_t i = 0; i < numTris * 3; i++){
+        valence[triangles[i]]++;
+    }
+
+    vertexTriangles.assign(numVerts, vector<unsigned>());
+    scheduler.parallelFor(0, numVerts, 0, [&](size_t begin, size_t end){
+        for(size_t v = begin; v < end; v++){
+            vertexTriangles[v].reserve(valence[v]);
+        }
+    });
+
+    for(size_t t = 0; t < numTris; t++){
+        for(int k = 0; k < 3; k++){
+            vertexTriangles[triangles[t * 3 + k]].push_back(t);
+        }
+    }
+
+    //---- plane quadrics, weighted by triangle area
+    //every vertex adds up the planes of its own triangles, so the vertices can
+    //be split up between the threads without two of them adding to the same quadric
+    //(each plane is worked out three times, which is cheaper than storing it)
+    scheduler.parallelFor(0, numVerts, 0, [&](size_t begin, size_t end){
+        for(size_t v = begin; v < end; v++){
+            for(unsigned t : vertexTriangles[v]){
+
+                const ofVec3f& p0 = positions[triangles[t * 3 + 0]];
+                const ofVec3f& p1 = positions[triangles[t * 3 + 1]];
+                const ofVec3f& p2 = positions[triangles[t * 3 + 2]];
+
+                ofVec3f n = (p1 - p0).getCrossed(p2 - p0);
+                float area = n.length() * 0.5;
+
+                if(area > 0){
+                    n /= area * 2;
+                    quadrics[v] += Quadric(n.x, n.y, n.z, -n.dot(p0), area);
+                }
+            }
+        }
+    });
+
+    //---- border planes
+    //an edge used by only one triangle is on a border. Add a plane through the edge
+    //that's perpendicular to the triangle so sliding away from the border costs a lot
+    vector<pair<uint64_t, unsigned> > edges(numTris * 3);
+    scheduler.parallelFor(0, numTris, 0, [&](size_t begin, size_t end){
+        for(size_t t = begin; t < end; t++){
+            for(int k = 0; k < 3; k++){
+                uint64_t a = triangles[t * 3 + k];
+                uint64_t b = triangles[t * 3 + (k + 1) % 3];
+                edges[t * 3 + k] = make_pair(a < b ? (a << 32) | b : (b << 32) | a, (unsigned)(t * 3 + k));
+            }
+        }
+    });
+    MeshUtils::parallelSort(edges);
+
+    //(there are few of them, so they're simply added one after the other)
+    for(size_t i = 0; i < edges.size(); i++){
+
+        bool shared = (i > 0 && edges[i - 1].first == edges[i].first) || (i + 1 < edges.size() && edges[i + 1].first == edges[i].first);
+        if(shared) continue;
+
+        unsigned slot = edges[i].second;
+        unsigned t = slot / 3;
+        ofIndexType a = triangles[slot];
+        ofIndexType b = triangles[t * 3 + (slot % 3 + 1) % 3];
+        ofIndexType c = triangles[t * 3 + (slot % 3 + 2) % 3];
+
+        ofVec3f edge = positions[b] - positions[a];
+        ofVec3f faceNormal = edge.getCrossed(positions[c] - positions[a]);
+        ofVec3f n = edge.getCrossed(faceNormal).getNormalized();
+
+        Quadric q(n.x, n.y, n.z, -n.dot(positions[a]), borderWeight * edge.lengthSquared());
+        quadrics[a] += q;
+        quadrics[b] += q;
+    }
+
+    //---- seams
+    //sort the vertices by position, any that end up next to an identical one are
+    //duplicates (same spot, different texcoords) and must not move
+    vector<unsigned> order(numVerts);
+    for(size_t i = 0; i < numVerts; i++){
+        order[i] = i;
+    }
+
+    MeshUtils::parallelSort(order, [&](unsigned a, unsigned b){
+        const ofVec3f& pa = positions[a];
+        const ofVec3f& pb = positions[b];
+        if(pa.x != pb.x) return pa.x < pb.x;
+        if(pa.y != pb.y) return pa.y < pb.y;
+        return pa.z < pb.z;
+    });
+
+    for(size_t i = 1; i < numVerts; i++){
+        if(positions[order[i]] == positions[order[i - 1]]){
+            locked[order[i]] = 1;
+            locked[order[i - 1]] = 1;
+        }
+    }
+
+    //---- every edge once, with what it costs to collapse
+    //worked out on all the cores. Edges with both ends locked can't be collapsed
+    //and get left out
+    vector<uint64_t> uniqueEdges;
+    uniqueEdges.reserve(edges.size() / 2 + 1);
+    for(size_t i = 0; i < edges.size(); i++){
+        if(i > 0 && edges[i - 1].first == edges[i].first) continue;
+        uniqueEdges.push_back(edges[i].first);
+    }
+    vector<pair<uint64_t, unsigned> >().swap(edges);
+
+    candidates.resize(uniqueEdges.size());
+    scheduler.parallelFor(0, uniqueEdges.size(), 0, [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++){
+            makeEdge(uniqueEdges[i] >> 32, uniqueEdges[i] & 0xffffffff, candidates[i]);
+        }
+    });
+
+    //ties are broken by the vertices so the order (and the result) doesn't
+    //depend on the number of threads
+    auto cheaper = [](const Edge& x, const Edge& y){
+        if(x.cost != y.cost) return x.cost < y.cost;
+        if(x.a != y.a) return x.a < y.a;
+        return x.b < y.b;
+    };
+
+    auto cantCollapse = [](const Edge& edge){ return edge.a == edge.b; };
+
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), cantCollapse), candidates.end());
+    MeshUtils::parallelSort(candidates, cheaper);
+
+    //---- collapse in passes
+    //every pass goes through the cheapest edges in order and picks the ones that
+    //don't share a triangle with an edge that's already been picked. Collapses like
+    //that can't get in each other's way (each one only reads and writes the triangles
+    //around its two ends), so the whole batch is collapsed on all the cores at once.
+    //Then only the edges around the vertices that moved get new costs, and those are
+    //merged back in so the list stays in order
+    size_t liveTriangles = numTris;
+
+    //the pass in which a vertex was last claimed by a picked edge / moved or went away
+    vector<unsigned> claimed(numVerts, 0);
+    vector<unsigned> changed(numVerts, 0);
+    unsigned pass = 0;
+
+    //two edges share a triangle exactly when an end of one is a neighbor of (or the
+    //same as) an end of the other. So picking an edge claims all the neighbors of
+    //both its ends, and after that an edge only needs to look at its own two ends
+    auto claim = [&](unsigned v){
+        for(unsigned t : vertexTriangles[v]){
+            if(triangleDead[t]) continue;
+            for(int k = 0; k < 3; k++) claimed[triangles[t * 3 + k]] = pass;
+        }
+    };
+
+    //did anything around v move since the given pass
+    auto hasChangedSince = [&](unsigned v, unsigned since){
+        for(unsigned t : vertexTriangles[v]){
+            if(triangleDead[t]) continue;
+            for(int k = 0; k < 3; k++){
+                if(changed[triangles[t * 3 + k]] > since) return true;
+            }
+        }
+        return false;
+    };
+
+    vector<size_t> batch;
+    vector<Collapse> collapses;
+    vector<unsigned> dying;
+    vector<unsigned char> bApplied;
+    vector<size_t> newEdgeStart;
+    vector<Edge> newEdges;
+    vector<Edge> merged;
+    vector<size_t> pieceStart;
+    vector<size_t> newPieceStart;
+
+    while(liveTriangles > targetTriangles){
+
+        pass++;
+
+        //a collapse takes out two triangles (one on a border), so this many lands
+        //close to the target without going past it
+        size_t wanted = max<size_t>(1, (liveTriangles - targetTriangles) / 2);
+
+        //---- pick the batch
+        //only look at as many as we'd like to collapse. Most of them are next to one
+        //that's already been picked, but the ones further up are better off waiting
+        //until the cheaper ones around them have been collapsed
+        batch.clear();
+        for(size_t i = 0; i < candidates.size() && (i < wanted || batch.empty()); i++){
+            Edge& edge = candidates[i];
+
+            //everything after this one is too expensive
+            if(edge.cost > maxError) break;
+
+            if(claimed[edge.a] == pass || claimed[edge.b] == pass) continue;
+
+            //it would have folded the mesh last time, only try again if something has moved
+            if(edge.rejected){
+                if(!hasChangedSince(edge.a, edge.rejected) && !hasChangedSince(edge.b, edge.rejected)) continue;
+                edge.rejected = 0;
+            }
+
+            claim(edge.a);
+            claim(edge.b);
+            batch.push_back(i);
+        }
+
+        //nothing left that we're allowed to collapse
+        if(batch.empty()) break;
+
+        //---- collapse the batch
+        collapses.resize(batch.size());
+        dying.assign(batch.size(), 0);
+        bApplied.assign(batch.size(), 0);
+        newEdgeStart.assign(batch.size() + 1, 0);
+
+        scheduler.parallelFor(0, batch.size(), 0, [&](size_t begin, size_t end){
+            vector<unsigned> scratch;
+            for(size_t i = begin; i < end; i++){
+                Edge& edge = candidates[batch[i]];
+                Collapse& collapse = collapses[i];
+                computeCollapse(edge.a, edge.b, collapse);
+
+                if(!isCollapseValid(collapse, scratch)){
+                    edge.rejected = pass;
+                    continue;
+                }
+
+                dying[i] = applyCollapse(collapse);
+                bApplied[i] = 1;
+                changed[collapse.keep] = pass;
+                changed[collapse.remove] = pass;
+
+                //every triangle has at most two new edges
+                newEdgeStart[i + 1] = vertexTriangles[collapse.keep].size() * 2;
+            }
+        });
+
+        for(size_t i = 0; i < batch.size(); i++){
+            newEdgeStart[i + 1] += newEdgeStart[i];
+            if(!bApplied[i]) continue;
+
+            liveTriangles -= min(liveTriangles, (size_t)dying[i]);
+            lastError = max(lastError, collapses[i].cost);
+            numCollapses++;
+        }
+
+        //---- new costs for the edges around the vertices that moved
+        //no two collapses in a batch are neighbors, so none of these come up twice
+        newEdges.resize(newEdgeStart.back());
+        scheduler.parallelFor(0, batch.size(), 0, [&](size_t begin, size_t end){
+            vector<unsigned> neighbors;
+            for(size_t i = begin; i < end; i++){
+                if(!bApplied[i]) continue;
+
+                unsigned keep = collapses[i].keep;
+
+                neighbors.clear();
+                for(unsigned t : vertexTriangles[keep]){
+                    for(int k = 0; k < 3; k++){
+                        if(triangles[t * 3 + k] != keep) neighbors.push_back(triangles[t * 3 + k]);
+                    }
+                }
+                std::sort(neighbors.begin(), neighbors.end());
+                neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+
+                //the slots that aren't needed are left with a == b
+                for(size_t j = newEdgeStart[i]; j < newEdgeStart[i + 1]; j++){
+                    size_t n = j - newEdgeStart[i];
+                    if(n < neighbors.size()){
+                        makeEdge(min(keep, neighbors[n]), max(keep, neighbors[n]), newEdges[j]);
+                    } else {
+                        newEdges[j].a = newEdges[j].b = keep;
+                    }
+                }
+            }
+        });
+        newEdges.erase(std::remove_if(newEdges.begin(), newEdges.end(), cantCollapse), newEdges.end());
+        MeshUtils::parallelSort(newEdges, cheaper);
+
+        //---- swap them in for the old edges of those vertices
+        //the list is cut into one piece per thread and every piece gets the new
+        //edges that sort into its range, so the pieces can be merged side by side.
+        //First the old edges are flagged (a == b) and the rest of each piece is
+        //counted, then the pieces are merged into place
+        size_t numPieces = min<size_t>(scheduler.getNumThreads(), candidates.size() / 4096 + 1);
+        size_t pieceSize = (candidates.size() + numPieces - 1) / numPieces;
+
+        pieceStart.assign(numPieces + 1, 0);
+        newPieceStart.assign(numPieces + 1, newEdges.size());
+        newPieceStart[0] = 0;
+
+        scheduler.parallelFor(0, numPieces, 1, [&](size_t begin, size_t end){
+            for(size_t p = begin; p < end; p++){
+                size_t first = p * pieceSize;
+                size_t last = min(first + pieceSize, candidates.size());
+
+                if(p > 0){
+                    newPieceStart[p] = std::lower_bound(newEdges.begin(), newEdges.end(), candidates[first], cheaper) - newEdges.begin();
+                }
+
+                size_t numLeft = 0;
+                for(size_t i = first; i < last; i++){
+                    Edge& edge = candidates[i];
+                    if(changed[edge.a] == pass || changed[edge.b] == pass){
+                        edge.b = edge.a;
+                    } else {
+                        numLeft++;
+                    }
+                }
+                pieceStart[p + 1] = numLeft;
+            }
+        });
+
+        for(size_t p = 0; p < numPieces; p++){
+            pieceStart[p + 1] += pieceStart[p];
+        }
+
+        merged.resize(pieceStart.back() + newEdges.size());
+        scheduler.parallelFor(0, numPieces, 1, [&](size_t begin, size_t end){
+            for(size_t p = begin; p < end; p++){
+                size_t i = p * pieceSize;
+                size_t last = min(i + pieceSize, candidates.size());
+                size_t j = newPieceStart[p];
+                size_t newLast = newPieceStart[p + 1];
+                size_t out = pieceStart[p] + newPieceStart[p];
+
+                while(i < last || j < newLast){
+                    if(i < last && cantCollapse(candidates[i])){
+                        i++;
+                    } else if(j < newLast && (i == last || cheaper(newEdges[j], candidates[i]))){
+                        merged[out++] = newEdges[j++];
+                    } else {
+                        merged[out++] = candidates[i++];
+                    }
+                }
+            }
+        });
+        candidates.swap(merged);
+    }
+
+    //---- copy out only the vertices that are still in use
+    vector<ofIndexType> remap(numVerts, std::numeric_limits<ofIndexType>::max());
+
+    dst.clear();
+    dst.setMode(OF_PRIMITIVE_TRIANGLES);
+
+    vector<ofIndexType>& outIndices = dst.getIndices();
+    outIndices.reserve(liveTriangles * 3);
+
+    for(size_t t = 0; t < numTris; t++){
+        if(triangleDead[t]) continue;
+
+        for(int k = 0; k < 3; k++){
+            ofIndexType v = triangles[t * 3 + k];
+
+            if(remap[v] == std::numeric_limits<ofIndexType>::max()){
+                remap[v] = dst.getNumVertices();
+                dst.addVertex(positions[v]);
+                if(!texCoords.empty()) dst.addTexCoord(texCoords[v]);
+                if(!colors.empty()) dst.addColor(colors[v]);
+                if(!normals.empty()) dst.addNormal(normals[v].getNormalized());
+            }
+            outIndices.push_back(remap[v]);
+        }
+    }
+
+    lastTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+
+    return true;
+}
+
+//--------------------------------------------------------------
+bool MeshDecimator::computeCollapse(unsigned a, unsigned b, Collapse& collapse) const{
+
+    //locked vertices can only be collapsed onto, never moved
+    if(locked[b] && !locked[a]) std::swap(a, b);
+
+    collapse.keep = a;
+    collapse.remove = b;
+
+    if(locked[a] && locked[b]) return false;
+
+    Quadric q = quadrics[a];
+    q += quadrics[b];
+
+    if(locked[a]){
+        collapse.position = positions[a];
+        collapse.cost = max(0.0, q.evaluate(positions[a]));
+        return true;
+    }
+
+    //try the ideal point plus both ends and the middle, keep the cheapest.
+    //the ideal point is ignored if it lands far away from the edge (nearly flat areas)
+    ofVec3f candidates[4] = { positions[a], positions[b], (positions[a] + positions[b]) * 0.5, ofVec3f() };
+    int numCandidates = 3;
+
+    ofVec3f best;
+    if(q.optimize(best) && best.squareDistance(candidates[2]) < positions[a].squareDistance(positions[b])){
+        candidates[numCandidates++] = best;
+    }
+
+    collapse.cost = std::numeric_limits<float>::max();
+    for(int i = 0; i < numCandidates; i++){
+        float cost = max(0.0, q.evaluate(candidates[i]));
+        if(cost < collapse.cost){
+            collapse.cost = cost;
+            collapse.position = candidates[i];
+        }
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------
+bool MeshDecimator::isCollapseValid(const Collapse& collapse, vector<unsigned>& scratch) const{
+
+    unsigned keep = collapse.keep;
+    unsigned remove = collapse.remove;
+
+    //link condition: the vertices both edge ends have in common must be exactly the
+    //ones on the triangles that share the edge, otherwise we'd pinch the surface.
+    //Collect everything around "keep", then count the ones around "remove" that are
+    //in there. (The lists are short, and this way several threads can check at once)
+    int sharedTriangles = 0;
+    int common = 0;
+
+    scratch.clear();
+    for(unsigned t : vertexTriangles[keep]){
+        if(triangleDead[t]) continue;
+        for(int k = 0; k < 3; k++){
+            ofIndexType v = triangles[t * 3 + k];
+            if(v != keep && v != remove) scratch.push_back(v);
+        }
+    }
+    std::sort(scratch.begin(), scratch.end());
+    scratch.erase(std::unique(scratch.begin(), scratch.end()), scratch.end());
+
+    for(unsigned t : vertexTriangles[remove]){
+        if(triangleDead[t]) continue;
+        for(int k = 0; k < 3; k++){
+            ofIndexType v = triangles[t * 3 + k];
+            if(v == keep) sharedTriangles++;
+
+            //count each common neighbor once
+            vector<unsigned>::iterator found = std::lower_bound(scratch.begin(), scratch.end(), (unsigned)v);
+            if(found != scratch.end() && *found == v){
+                scratch.erase(found);
+                common++;
+            }
+        }
+    }
+    if(common != sharedTriangles) return false;
+
+    //no triangle that survives may flip over or collapse to a sliver
+    for(int side = 0; side < 2; side++){
+
+        unsigned moving = side == 0 ? keep : remove;
+
+        for(unsigned t : vertexTriangles[moving]){
+            if(triangleDead[t]) continue;
+
+            const ofIndexType* tri = &triangles[t * 3];
+            bool hasKeep = tri[0] == keep || tri[1] == keep || tri[2] == keep;
+            bool hasRemove = tri[0] == remove || tri[1] == remove || tri[2] == remove;
+
+            //these ones disappear anyway
+            if(hasKeep && hasRemove) continue;
+
+            ofVec3f before[3], after[3];
+            for(int k = 0; k < 3; k++){
+                before[k] = positions[tri[k]];
+                after[k] = tri[k] == moving ? collapse.position : before[k];
+            }
+
+            ofVec3f n0 = (before[1] - before[0]).getCrossed(before[2] - before[0]);
+            ofVec3f n1 = (after[1] - after[0]).getCrossed(after[2] - after[0]);
+
+            if(n1.lengthSquared() < 1e-12 * n0.lengthSquared()) return false;
+            if(n0.dot(n1) < 0.2 * n0.length() * n1.length()) return false;
+        }
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------
+unsigned MeshDecimator::applyCollapse(const Collapse& collapse){
+
+    unsigned keep = collapse.keep;
+    unsigned remove = collapse.remove;
+
+    //where the new point sits along the edge, to blend the other attributes
+    ofVec3f edge = positions[remove] - positions[keep];
+    float lenSq = edge.lengthSquared();
+    float t = lenSq > 0 ? ofClamp((collapse.position - positions[keep]).dot(edge) / lenSq, 0, 1) : 0;
+
+    if(!texCoords.empty()) texCoords[keep] = texCoords[keep] * (1 - t) + texCoords[remove] * t;
+    if(!colors.empty()) colors[keep] = colors[keep] * (1 - t) + colors[remove] * t;
+    if(!normals.empty()) normals[keep] = normals[keep] * (1 - t) + normals[remove] * t;
+
+    positions[keep] = collapse.position;
+    quadrics[keep] += quadrics[remove];
+
+    //move the triangles over to the vertex we're keeping
+    vector<unsigned>& keepTris = vertexTriangles[keep];
+    unsigned numDead = 0;
+
+    for(unsigned tri : vertexTriangles[remove]){
+        if(triangleDead[tri]) continue;
+
+        bool hasKeep = false;
+        for(int k = 0; k < 3; k++){
+            if(triangles[tri * 3 + k] == keep) hasKeep = true;
+        }
+
+        if(hasKeep){
+            triangleDead[tri] = 1;
+            numDead++;
+        } else {
+            for(int k = 0; k < 3; k++){
+                if(triangles[tri * 3 + k] == remove) triangles[tri * 3 + k] = keep;
+            }
+            keepTris.push_back(tri);
+        }
+    }
+
+    //drop the dead ones while we're here so the lists stay short
+    keepTris.erase(std::remove_if(keepTris.begin(), keepTris.end(), [&](unsigned tri){ return triangleDead[tri] != 0; }), keepTris.end());
+
+    vector<unsigned>().swap(vertexTriangles[remove]);
+
+    return numDead;
+}
+
+//--------------------------------------------------------------
+void MeshDecimator::makeEdge(unsigned a, unsigned b, Edge& edge) const{
+
+    Collapse collapse;
+    if(computeCollapse(a, b, collapse)){
+        edge.cost = collapse.cost;
+        edge.a = a;
+        edge.b = b;
+    } else {
+        edge.cost = 0;
+        edge.a = edge.b = a;
+    }
+    edge.rejected = 0;
+}
@@ -0,0 +1,1520 @@
+#include "MeshIO.h"
+#include "MeshUtils.h"
+#include "TaskScheduler.h"
+
+#include <atomic>
+#include <cstring>
+
+static inline bool isDigit(char c){
+    return c >= '0' && c <= '9';
+}
+
+//not '\n', that one ends the line
+static inline bool isSpace(char c){
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* skipSpaces(const char* p, const char* end){
+    while(p < end && isSpace(*p)) p++;
+    return p;
+}
+
+//every power of ten up to here is exact as a double, so multiplying
+//or dividing by one rounds only once
+static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+//read a number like -1.25e-3 at p (skipping any spaces in front).
+//Returns where it ended, or p if there wasn't a number there
+static const char* parseFloat(const char* p, const char* end, float& value){
+
+    p = skipSpaces(p, end);
+    const char* start = p;
+
+    bool bNegative = false;
+    if(p < end && (*p == '-' || *p == '+')){
+        bNegative = *p == '-';
+        p++;
+    }
+
+    //the digits go into an integer, 19 of them fit, which is far
+    //more than a float can tell apart. The rest only move the point
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int numDigits = 0;
+    bool bDigits = false;
+
+    for(; p < end && isDigit(*p); p++){
+        bDigits = true;
+        if(numDigits < 19){
+            mantissa = mantissa * 10 + (*p - '0');
+            if(mantissa > 0) numDigits++;
+        } else {
+            exponent++;
+        }
+    }
+    if(p < end && *p == '.'){
+        p++;
+        for(; p < end && isDigit(*p); p++){
+            bDigits = true;
+            if(numDigits < 19){
+                mantissa = mantissa * 10 + (*p - '0');
+                if(mantissa > 0) numDigits++;
+                exponent--;
+            }
+        }
+    }
+
+    //nan, inf and the like, leave those to the C library
+    if(!bDigits){
+        char text[32];
+        size_t length = min<size_t>(end - start, sizeof(text) - 1);
+        memcpy(text, start, length);
+        text[length] = 0;
+        char* textEnd;
+        value = strtod(text, &textEnd);
+        return start + (textEnd - text);
+    }
+
+    if(p < end && (*p == 'e' || *p == 'E')){
+        const char* q = p + 1;
+        bool bNegativeExponent = false;
+        if(q < end && (*q == '-' || *q == '+')){
+            bNegativeExponent = *q == '-';
+            q++;
+        }
+        if(q < end && isDigit(*q)){
+            int e = 0;
+            for(; q < end && isDigit(*q); q++){
+                if(e < 10000) e = e * 10 + (*q - '0');
+            }
+            exponent += bNegativeExponent ? -e : e;
+            p = q;
+        }
+    }
+
+    double number = (double)mantissa;
+    if(mantissa != 0 && exponent != 0){
+        if(exponent > 0 && exponent <= 22){
+            number *= powersOfTen[exponent];
+        } else if(exponent < 0 && exponent >= -22){
+            number /= powersOfTen[-exponent];
+        } else {
+            number *= pow(10.0, exponent);
+        }
+    }
+
+    value = bNegative ? -number : number;
+    return p;
+}
+
+//the same for whole numbers
+static const char* parseInt(const char* p, const char* end, int64_t& value){
+
+    p = skipSpaces(p, end);
+    const char* start = p;
+
+    bool bNegative = false;
+    if(p < end && (*p == '-' || *p == '+')){
+        bNegative = *p == '-';
+        p++;
+    }
+    if(p == end || !isDigit(*p)) return start;
+
+    int64_t number = 0;
+    for(; p < end && isDigit(*p); p++){
+        number = number * 10 + (*p - '0');
+    }
+
+    value = bNegative ? -number : number;
+    return p;
+}
+
+//the '\n' at the end of the line starting at p (or the end of the text)
+static inline const char* findLineEnd(const char* p, const char* end){
+    const char* newline = (const char*)memchr(p, '\n', end - p);
+    return newline ? newline : end;
+}
+
+//call f(lineBegin, lineEnd) for every line in [p, end) that isn't blank
+template<typename F>
+static void forEachLine(const char* p, const char* end, F f){
+    while(p < end){
+        const char* lineEnd = findLineEnd(p, end);
+        if(skipSpaces(p, lineEnd) != lineEnd){
+            f(p, lineEnd);
+        }
+        p = lineEnd + 1;
+    }
+}
+
+//cut the text into pieces for the cores, every piece starting at the start of a line.
+//Returns the cuts, piece i is [cuts[i], cuts[i + 1])
+static vector<const char*> splitAtLines(const char* begin, const char* end){
+
+    //a few pieces per core so a slow one doesn't hold up the rest,
+    //but not so small that starting the tasks costs more than parsing
+    size_t size = end - begin;
+    size_t numPieces = min<size_t>(TaskScheduler::get().getNumThreads() * 8, size / (256 << 10) + 1);
+
+    vector<const char*> cuts;
+    cuts.push_back(begin);
+    for(size_t k = 1; k < numPieces; k++){
+        const char* p = findLineEnd(max(begin + size * k / numPieces, cuts.back()), end);
+        if(p < end && p + 1 > cuts.back()) cuts.push_back(p + 1);
+    }
+    cuts.push_back(end);
+
+    return cuts;
+}
+
+//reads a text file a block at a time, each block cut after its last line break.
+//Whatever comes after that is carried over to the start of the next block
+struct LineReader {
+
+    LineReader(ifstream& file) : file(file), numWhole(0), numCarried(0) {}
+
+    bool next(size_t blockBytes){
+
+        if(numCarried > 0) memmove(buffer.data(), buffer.data() + numWhole, numCarried);
+        numWhole = 0;
+
+        while(file){
+            buffer.resize(numCarried + blockBytes);
+            file.read(buffer.data() + numCarried, blockBytes);
+            size_t size = numCarried + file.gcount();
+
+            //the end of the file ends the last line too
+            if(!file){
+                numWhole = size;
+                numCarried = 0;
+                return numWhole > 0;
+            }
+
+            for(size_t i = size; i > numCarried; i--){
+                if(buffer[i - 1] == '\n'){
+                    numWhole = i;
+                    numCarried = size - i;
+                    return true;
+                }
+            }
+
+            //a line longer than the whole block, read more of it
+            numCarried = size;
+        }
+
+        return false;
+    }
+
+    const char* begin() const { return buffer.data(); }
+    const char* end() const { return buffer.data() + numWhole; }
+
+    ifstream& file;
+    vector<char> buffer;
+    size_t numWhole, numCarried;
+};
+
+//splits a polygon into triangles that all share its first corner.
+//Only counts them if there's nowhere to put them
+struct Fan {
+
+    Fan(ofIndexType* out) : out(out), numCorners(0), numTriangles(0), first(0), previous(0) {}
+
+    void add(ofIndexType index){
+        if(numCorners == 0){
+            first = index;
+        } else if(numCorners >= 2){
+            if(out){
+                out[0] = first;
+                out[1] = previous;
+                out[2] = index;
+                out += 3;
+            }
+            numTriangles++;
+        }
+        previous = index;
+        numCorners++;
+    }
+
+    ofIndexType* out;
+    size_t numCorners, numTriangles;
+    ofIndexType first, previous;
+};
+
+static bool isBigEndianHost(){
+    uint16_t one = 1;
+    unsigned char firstByte;
+    memcpy(&firstByte, &one, 1);
+    return firstByte == 0;
+}
+
+enum PlyType {
+    PLY_INVALID, PLY_CHAR, PLY_UCHAR, PLY_SHORT, PLY_USHORT, PLY_INT, PLY_UINT, PLY_FLOAT, PLY_DOUBLE
+};
+
+static PlyType getPlyType(const string& name){
+    if(name == "char" || name == "int8") return PLY_CHAR;
+    if(name == "uchar" || name == "uint8") return PLY_UCHAR;
+    if(name == "short" || name == "int16") return PLY_SHORT;
+    if(name == "ushort" || name == "uint16") return PLY_USHORT;
+    if(name == "int" || name == "int32") return PLY_INT;
+    if(name == "uint" || name == "uint32") return PLY_UINT;
+    if(name == "float" || name == "float32") return PLY_FLOAT;
+    if(name == "double" || name == "float64") return PLY_DOUBLE;
+    return PLY_INVALID;
+}
+
+static int getPlyTypeSize(PlyType type){
+    static const int sizes[] = {0, 1, 1, 2, 2, 4, 4, 4, 8};
+    return sizes[type];
+}
+
+//a binary value of type T, in the file's byte order
+template<typename T>
+static inline T readValue(const char* p, bool bSwap){
+    T value;
+    if(bSwap){
+        char bytes[sizeof(T)];
+        for(size_t i = 0; i < sizeof(T); i++) bytes[i] = p[sizeof(T) - 1 - i];
+        memcpy(&value, bytes, sizeof(T));
+    } else {
+        memcpy(&value, p, sizeof(T));
+    }
+    return value;
+}
+
+static inline double readBinary(const char* p, PlyType type, bool bSwap){
+    switch(type){
+        case PLY_CHAR: return readValue<int8_t>(p, bSwap);
+        case PLY_UCHAR: return readValue<uint8_t>(p, bSwap);
+        case PLY_SHORT: return readValue<int16_t>(p, bSwap);
+        case PLY_USHORT: return readValue<uint16_t>(p, bSwap);
+        case PLY_INT: return readValue<int32_t>(p, bSwap);
+        case PLY_UINT: return readValue<uint32_t>(p, bSwap);
+        case PLY_FLOAT: return readValue<float>(p, bSwap);
+        case PLY_DOUBLE: return readValue<double>(p, bSwap);
+        default: return 0;
+    }
+}
+
+//what a property goes into. Every vertex is read into an array of
+//these first (so the properties can come in any order)
+enum Attribute {
+    ATTR_X, ATTR_Y, ATTR_Z,
+    ATTR_NX, ATTR_NY, ATTR_NZ,
+    ATTR_R, ATTR_G, ATTR_B, ATTR_A,
+    ATTR_U, ATTR_V,
+    NUM_ATTRS,
+    ATTR_INDICES,   //the face's corners
+    ATTR_NONE
+};
+
+static Attribute getAttribute(const string& element, const string& property){
+    if(element == "vertex"){
+        if(property == "x") return ATTR_X;
+        if(property == "y") return ATTR_Y;
+        if(property == "z") return ATTR_Z;
+        if(property == "nx") return ATTR_NX;
+        if(property == "ny") return ATTR_NY;
+        if(property == "nz") return ATTR_NZ;
+        if(property == "red" || property == "diffuse_red") return ATTR_R;
+        if(property == "green" || property == "diffuse_green") return ATTR_G;
+        if(property == "blue" || property == "diffuse_blue") return ATTR_B;
+        if(property == "alpha") return ATTR_A;
+        if(property == "s" || property == "u" || property == "texture_u" || property == "texture_s") return ATTR_U;
+        if(property == "t" || property == "v" || property == "texture_v" || property == "texture_t") return ATTR_V;
+    } else if(element == "face"){
+        if(property == "vertex_indices" || property == "vertex_index") return ATTR_INDICES;
+    }
+    return ATTR_NONE;
+}
+
+struct PlyProperty {
+    string name;
+    PlyType type;
+    PlyType countType;      //PLY_INVALID unless it's a list
+    Attribute attribute;
+    float scale;            //colors stored as integers go to 0-1
+};
+
+struct PlyElement {
+    string name;
+    uint64_t count;
+    vector<PlyProperty> properties;
+
+    uint64_t firstLine;     //in an ascii file, counting from the line after the header
+    int stride;             //bytes per record in a binary file, 0 if they have lists
+
+    bool has(Attribute attribute) const {
+        for(const PlyProperty& property : properties){
+            if(property.attribute == attribute) return true;
+        }
+        return false;
+    }
+};
+
+struct PlyHeader {
+    enum Format {
+        ASCII,
+        BINARY_LITTLE_ENDIAN,
+        BINARY_BIG_ENDIAN
+    };
+
+    Format format;
+    vector<PlyElement> elements;
+    size_t size;            //bytes up to the end of the end_header line
+
+    const PlyElement* find(const string& name) const {
+        for(const PlyElement& element : elements){
+            if(element.name == name) return &element;
+        }
+        return nullptr;
+    }
+
+    bool needsSwap() const {
+        return format != ASCII && (format == BINARY_BIG_ENDIAN) != isBigEndianHost();
+    }
+};
+
+//--------------------------------------------------------------
+static bool readPlyHeader(const char* data, size_t size, PlyHeader& header){
+
+    header.elements.clear();
+    header.size = 0;
+
+    if(size < 4 || string(data, 3) != "ply") return false;
+
+    bool bFormat = false;
+    const char* p = data;
+    const char* end = data + size;
+
+    while(p < end){
+
+        const char* lineEnd = findLineEnd(p, end);
+        istringstream line(string(p, lineEnd));
+        p = lineEnd + 1;
+
+        string keyword;
+        line >> keyword;
+
+        if(keyword == "format"){
+            string format;
+            line >> format;
+            if(format == "ascii") header.format = PlyHeader::ASCII;
+            else if(format == "binary_little_endian") header.format = PlyHeader::BINARY_LITTLE_ENDIAN;
+            else if(format == "binary_big_endian") header.format = PlyHeader::BINARY_BIG_ENDIAN;
+            else return false;
+            bFormat = true;
+
+        } else if(keyword == "element"){
+            PlyElement element;
+            line >> element.name >> element.count;
+            if(!line) return false;
+            header.elements.push_back(element);
+
+        } else if(keyword == "property"){
+            if(header.elements.empty()) return false;
+
+            PlyProperty property;
+            string type;
+            line >> type;
+            if(type == "list"){
+                string countType;
+                line >> countType >> type;
+                property.countType = getPlyType(countType);
+                if(property.countType == PLY_INVALID || property.countType == PLY_FLOAT || property.countType == PLY_DOUBLE) return false;
+            } else {
+                property.countType = PLY_INVALID;
+            }
+            property.type = getPlyType(type);
+            line >> property.name;
+            if(!line || property.type == PLY_INVALID) return false;
+
+            PlyElement& element = header.elements.back();
+            property.attribute = getAttribute(element.name, property.name);
+
+            //a list in a vertex or a single number as a face's corners, we don't know what to do with those
+            if((property.attribute == ATTR_INDICES) != (property.countType != PLY_INVALID)){
+                property.attribute = ATTR_NONE;
+            }
+
+            property.scale = 1;
+            if(property.attribute >= ATTR_R && property.attribute <= ATTR_A){
+                if(property.type == PLY_UCHAR || property.type == PLY_CHAR) property.scale = 1 / 255.0f;
+                if(property.type == PLY_USHORT || property.type == PLY_SHORT) property.scale = 1 / 65535.0f;
+            }
+            element.properties.push_back(property);
+
+        } else if(keyword == "end_header"){
+            header.size = min<size_t>(p - data, size);
+            break;
+        }
+    }
+
+    if(!bFormat || header.size == 0) return false;
+
+    uint64_t line = 0;
+    for(PlyElement& element : header.elements){
+        element.firstLine = line;
+        line += element.count;
+
+        element.stride = 0;
+        for(const PlyProperty& property : element.properties){
+            if(property.countType != PLY_INVALID){
+                element.stride = 0;
+                break;
+            }
+            element.stride += getPlyTypeSize(property.type);
+        }
+    }
+
+    return true;
+}
+
+//where the vertices being read go. The attributes the file doesn't have are null
+struct VertexTarget {
+    ofVec3f* vertices;
+    ofVec3f* normals;
+    ofFloatColor* colors;
+    ofVec2f* texCoords;
+};
+
+//size the mesh's vectors for count vertices from this element (or none if it's null)
+static VertexTarget prepareVertices(ofMesh& mesh, size_t count, const PlyElement* element){
+
+    bool bNormals = element && element->has(ATTR_NX);
+    bool bColors = element && element->has(ATTR_R);
+    bool bTexCoords = element && element->has(ATTR_U);
+
+    mesh.getVertices().resize(count);
+    mesh.getNormals().resize(bNormals ? count : 0);
+    mesh.getColors().resize(bColors ? count : 0);
+    mesh.getTexCoords().resize(bTexCoords ? count : 0);
+
+    VertexTarget target;
+    target.vertices = mesh.getVertices().data();
+    target.normals = bNormals ? mesh.getNormals().data() : nullptr;
+    target.colors = bColors ? mesh.getColors().data() : nullptr;
+    target.texCoords = bTexCoords ? mesh.getTexCoords().data() : nullptr;
+    return target;
+}
+
+static inline void resetValues(float* values){
+    for(int i = 0; i < NUM_ATTRS; i++){
+        values[i] = 0;
+    }
+    values[ATTR_A] = 1;
+}
+
+static inline void storeVertex(const float* values, const VertexTarget& target, size_t i){
+    target.vertices[i].set(values[ATTR_X], values[ATTR_Y], values[ATTR_Z]);
+    if(target.normals) target.normals[i].set(values[ATTR_NX], values[ATTR_NY], values[ATTR_NZ]);
+    if(target.colors) target.colors[i] = ofFloatColor(values[ATTR_R], values[ATTR_G], values[ATTR_B], values[ATTR_A]);
+    if(target.texCoords) target.texCoords[i].set(values[ATTR_U], values[ATTR_V]);
+}
+
+//one record (vertex, face, or anything else) from a line of an ascii file. The
+//vertex attributes go into values and the face's triangles into triangles, if
+//they aren't null. Returns false if the line is missing numbers
+static bool parseTextRecord(const char* p, const char* end, const PlyElement& element, float* values, ofIndexType* triangles, size_t& numTriangles){
+
+    numTriangles = 0;
+
+    for(const PlyProperty& property : element.properties){
+
+        if(property.countType == PLY_INVALID){
+            float value;
+            const char* next = parseFloat(p, end, value);
+            if(next == p) return false;
+            p = next;
+            if(values && property.attribute < NUM_ATTRS) values[property.attribute] = value * property.scale;
+
+        } else {
+            int64_t count;
+            const char* next = parseInt(p, end, count);
+            if(next == p || count < 0) return false;
+            p = next;
+
+            //whole numbers are read as whole numbers: a float only holds them
+            //exactly up to 2^24, past that an index would quietly point at a
+            //vertex next door. Negative ones would wrap around to huge indices
+            bool bInteger = property.type != PLY_FLOAT && property.type != PLY_DOUBLE;
+
+            Fan fan(triangles);
+            for(int64_t k = 0; k < count; k++){
+                int64_t index;
+                if(bInteger){
+                    next = parseInt(p, end, index);
+                } else {
+                    float value;
+                    next = parseFloat(p, end, value);
+                    index = (int64_t)value;
+                }
+                if(next == p) return false;
+                p = next;
+                if(property.attribute == ATTR_INDICES){
+                    if(index < 0) return false;
+                    fan.add((ofIndexType)index);
+                }
+            }
+            if(property.attribute == ATTR_INDICES) numTriangles = fan.numTriangles;
+        }
+    }
+
+    return true;
+}
+
+//the same for a record in a binary file. Returns where the
+//record ends, or null if it runs past the end of the data
+static const char* parseBinaryRecord(const char* p, const char* end, const PlyElement& element, bool bSwap, float* values, ofIndexType* triangles, size_t& numTriangles){
+
+    numTriangles = 0;
+
+    for(const PlyProperty& property : element.properties){
+
+        int size = getPlyTypeSize(property.type);
+
+        if(property.countType == PLY_INVALID){
+            if(end - p < size) return nullptr;
+            if(values && property.attribute < NUM_ATTRS) values[property.attribute] = readBinary(p, property.type, bSwap) * property.scale;
+            p += size;
+
+        } else {
+            int countSize = getPlyTypeSize(property.countType);
+            if(end - p < countSize) return nullptr;
+            int64_t count = readBinary(p, property.countType, bSwap);
+            p += countSize;
+            if(count < 0 || (uint64_t)(end - p) < (uint64_t)count * size) return nullptr;
+
+            if(property.attribute == ATTR_INDICES){
+                Fan fan(triangles);
+                for(int64_t k = 0; k < count; k++){
+                    fan.add((ofIndexType)(int64_t)readBinary(p + k * size, property.type, bSwap));
+                }
+                numTriangles = fan.numTriangles;
+            }
+            p += (size_t)count * size;
+        }
+    }
+
+    return p;
+}
+
+//--------------------------------------------------------------
+//the lines [begin, end) of an ascii file, the first of them being line number
+//"line" (counting from the one after the header). The vertex lines go into the
+//mesh's vertices, the face lines into its indices. line moves past the text
+static bool parsePlyText(const char* begin, const char* end, uint64_t& line, const PlyHeader& header, ofMesh& mesh){
+
+    const PlyElement* vertex = header.find("vertex");
+    const PlyElement* face = header.find("face");
+
+    auto isVertex = [&](uint64_t l){ return vertex && l >= vertex->firstLine && l < vertex->firstLine + vertex->count; };
+    auto isFace = [&](uint64_t l){ return face && l >= face->firstLine && l < face->firstLine + face->count; };
+
+    vector<const char*> cuts = splitAtLines(begin, end);
+    size_t numPieces = cuts.size() - 1;
+
+    //first line and first triangle of each piece
+    vector<uint64_t> pieceLines(numPieces + 1, 0);
+    vector<size_t> pieceTriangles(numPieces + 1, 0);
+    vector<char> pieceOk(numPieces, 1);
+
+    //count the lines in each piece, then add them up to get where each piece starts
+    TaskScheduler::get().parallelFor(0, numPieces, 1, [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++){
+            uint64_t count = 0;
+            forEachLine(cuts[i], cuts[i + 1], [&](const char*, const char*){ count++; });
+            pieceLines[i + 1] = count;
+        }
+    });
+    pieceLines[0] = line;
+    for(size_t i = 0; i < numPieces; i++){
+        pieceLines[i + 1] += pieceLines[i];
+    }
+
+    //now each piece knows its line numbers and can tell its faces apart, count their triangles
+    if(face){
+        TaskScheduler::get().parallelFor(0, numPieces, 1, [&](size_t first, size_t last){
+            for(size_t i = first; i < last; i++){
+                if(pieceLines[i + 1] <= face->firstLine || pieceLines[i] >= face->firstLine + face->count) continue;
+
+                uint64_t l = pieceLines[i];
+                size_t count = 0;
+                forEachLine(cuts[i], cuts[i + 1], [&](const char* lineBegin, const char* lineEnd){
+                    size_t numTriangles;
+                    if(isFace(l)){
+                        if(parseTextRecord(lineBegin, lineEnd, *face, nullptr, nullptr, numTriangles)) count += numTriangles;
+                        else pieceOk[i] = 0;
+                    }
+                    l++;
+                });
+                pieceTriangles[i + 1] = count;
+            }
+        });
+        for(size_t i = 0; i < numPieces; i++){
+            pieceTriangles[i + 1] += pieceTriangles[i];
+        }
+    }
+
+    //the vertices in this text, and the first of them
+    uint64_t firstVertex = 0, numVertices = 0;
+    if(vertex){
+        uint64_t vertexEnd = vertex->firstLine + vertex->count;
+        firstVertex = min(max(line, vertex->firstLine), vertexEnd);
+        numVertices = min(max(pieceLines[numPieces], vertex->firstLine), vertexEnd) - firstVertex;
+    }
+
+    VertexTarget target = prepareVertices(mesh, numVertices, vertex);
+    mesh.getIndices().resize(pieceTriangles[numPieces] * 3);
+    ofIndexType* indices = mesh.getIndices().data();
+
+    //and parse everything straight into place
+    TaskScheduler::get().parallelFor(0, numPieces, 1, [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++){
+            uint64_t l = pieceLines[i];
+            size_t triangle = pieceTriangles[i];
+            forEachLine(cuts[i], cuts[i + 1], [&](const char* lineBegin, const char* lineEnd){
+                size_t numTriangles;
+                if(isVertex(l)){
+                    float values[NUM_ATTRS];
+                    resetValues(values);
+                    if(parseTextRecord(lineBegin, lineEnd, *vertex, values, nullptr, numTriangles)){
+                        storeVertex(values, target, l - firstVertex);
+                    } else {
+                        pieceOk[i] = 0;
+                    }
+                } else if(isFace(l)){
+                    if(parseTextRecord(lineBegin, lineEnd, *face, nullptr, indices + triangle * 3, numTriangles)){
+                        triangle += numTriangles;
+                    }
+                }
+                l++;
+            });
+        }
+    });
+
+    line = pieceLines[numPieces];
+
+    for(char ok : pieceOk){
+        if(!ok) return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+//the body of a binary file, element by element
+static bool parsePlyBinary(const char* p, const char* end, const PlyHeader& header, ofMesh& mesh){
+
+    bool bSwap = header.needsSwap();
+
+    for(const PlyElement& element : header.elements){
+
+        bool bVertex = element.name == "vertex";
+        bool bFace = element.name == "face" && element.has(ATTR_INDICES);
+
+        //fixed size records: vertices are converted on all the cores, anything else is skipped
+        if(element.stride > 0){
+            if((uint64_t)(end - p) < element.count * element.stride) return false;
+
+            if(bVertex){
+                VertexTarget target = prepareVertices(mesh, element.count, &element);
+                TaskScheduler::get().parallelFor(0, element.count, 4096, [&](size_t first, size_t last){
+                    float values[NUM_ATTRS];
+                    size_t numTriangles;
+                    for(size_t i = first; i < last; i++){
+                        resetValues(values);
+                        parseBinaryRecord(p + i * element.stride, end, element, bSwap, values, nullptr, numTriangles);
+                        storeVertex(values, target, i);
+                    }
+                });
+            }
+
+            p += element.count * element.stride;
+            continue;
+        }
+
+        //faces that are all triangles are all the same size too. Check every one of them
+        //has 3 corners, and if so they can be converted on all the cores as well
+        if(bFace){
+            size_t listOffset = 0, stride = 0;
+            PlyType countType = PLY_INVALID;
+            int numLists = 0;
+            for(const PlyProperty& property : element.properties){
+                if(property.countType == PLY_INVALID){
+                    stride += getPlyTypeSize(property.type);
+                    if(numLists == 0) listOffset = stride;
+                } else {
+                    numLists++;
+                    countType = property.countType;
+                    stride += getPlyTypeSize(property.countType) + 3 * getPlyTypeSize(property.type);
+                }
+            }
+
+            bool bTriangles = numLists == 1 && (uint64_t)(end - p) >= element.count * stride;
+            if(bTriangles){
+                std::atomic<bool> bAllTriangles(true);
+                TaskScheduler::get().parallelFor(0, element.count, 16384, [&](size_t first, size_t last){
+                    for(size_t i = first; i < last; i++){
+                        if(readBinary(p + i * stride + listOffset, countType, bSwap) != 3){
+                            bAllTriangles = false;
+                            return;
+                        }
+                    }
+                });
+                bTriangles = bAllTriangles;
+            }
+
+            if(bTriangles){
+                mesh.getIndices().resize(element.count * 3);
+                ofIndexType* indices = mesh.getIndices().data();
+                TaskScheduler::get().parallelFor(0, element.count, 4096, [&](size_t first, size_t last){
+                    size_t numTriangles;
+                    for(size_t i = first; i < last; i++){
+                        parseBinaryRecord(p + i * stride, end, element, bSwap, nullptr, indices + i * 3, numTriangles);
+                    }
+                });
+                p += element.count * stride;
+                continue;
+            }
+        }
+
+        //everything else one record at a time: once to find the
+        //records and count the triangles, once to fill them in
+        const char* records = p;
+        size_t numTriangles = 0;
+        for(uint64_t i = 0; i < element.count; i++){
+            size_t count;
+            p = parseBinaryRecord(p, end, element, bSwap, nullptr, nullptr, count);
+            if(!p) return false;
+            numTriangles += count;
+        }
+
+        if(bVertex || bFace){
+            VertexTarget target = VertexTarget();
+            if(bVertex) target = prepareVertices(mesh, element.count, &element);
+            if(bFace) mesh.getIndices().resize(numTriangles * 3);
+
+            const char* q = records;
+            size_t triangle = 0;
+            for(uint64_t i = 0; i < element.count; i++){
+                float values[NUM_ATTRS];
+                resetValues(values);
+                size_t count;
+                q = parseBinaryRecord(q, end, element, bSwap, values, bFace ? mesh.getIndices().data() + triangle * 3 : nullptr, count);
+                if(bVertex) storeVertex(values, target, i);
+                triangle += count;
+            }
+        }
+    }
+
+    return true;
+}
+
+enum ObjLine {
+    OBJ_OTHER, OBJ_V, OBJ_VT, OBJ_VN, OBJ_F
+};
+
+//what kind of line it is. Moves p past the keyword
+static ObjLine getObjLine(const char*& p, const char* end){
+    p = skipSpaces(p, end);
+    if(end - p >= 2 && p[0] == 'v' && isSpace(p[1])){ p += 1; return OBJ_V; }
+    if(end - p >= 3 && p[0] == 'v' && p[1] == 't' && isSpace(p[2])){ p += 2; return OBJ_VT; }
+    if(end - p >= 3 && p[0] == 'v' && p[1] == 'n' && isSpace(p[2])){ p += 2; return OBJ_VN; }
+    if(end - p >= 2 && p[0] == 'f' && isSpace(p[1])){ p += 1; return OBJ_F; }
+    return OBJ_OTHER;
+}
+
+//one corner of a face: v, v/vt, v//vn or v/vt/vn (0 for the ones that
+//aren't there). Returns where it ended, or p if there wasn't one
+static const char* parseObjCorner(const char* p, const char* end, int64_t& v, int64_t& vt, int64_t& vn){
+    vt = vn = 0;
+    const char* next = parseInt(p, end, v);
+    if(next == p) return p;
+    p = next;
+    if(p < end && *p == '/'){
+        p++;
+        if(p < end && *p != '/') p = parseInt(p, end, vt);
+        if(p < end && *p == '/') p = parseInt(p + 1, end, vn);
+    }
+    return p;
+}
+
+//OBJ indices start at 1, negative ones count back from the latest. -1 if it's missing
+static inline int64_t getObjIndex(int64_t index, uint64_t numSoFar){
+    if(index > 0) return index - 1;
+    if(index < 0) return (int64_t)numSoFar + index;
+    return -1;
+}
+
+//how many of everything came before, OBJ's indices count from the start of the file
+struct ObjCounts {
+    ObjCounts() : v(0), vt(0), vn(0), triangles(0), colors(-1) {}
+    uint64_t v, vt, vn, triangles;
+    int colors;     //whether the first "v" has a color after it, -1 if there wasn't one yet
+};
+
+//--------------------------------------------------------------
+//the lines [begin, end) of an OBJ file, with counts of what came before them. One
+//vertex per "v", faces into the indices. With bAttributes the texcoords and normals
+//the faces point at go onto the vertices (which only works for the whole file)
+static bool parseObjText(const char* begin, const char* end, ObjCounts& before, ofMesh& mesh, bool bAttributes){
+
+    vector<const char*> cuts = splitAtLines(begin, end);
+    size_t numPieces = cuts.size() - 1;
+
+    //count everything in each piece, then add them up so each piece knows where its things go
+    vector<ObjCounts> pieces(numPieces + 1);
+    TaskScheduler::get().parallelFor(0, numPieces, 1, [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++){
+            ObjCounts& counts = pieces[i + 1];
+            forEachLine(cuts[i], cuts[i + 1], [&](const char* p, const char* lineEnd){
+                switch(getObjLine(p, lineEnd)){
+                    case OBJ_V:
+                        if(counts.colors < 0){
+                            int numValues = 0;
+                            float value;
+                            for(const char* next; (next = parseFloat(p, lineEnd, value)) != p; p = next) numValues++;
+                            counts.colors = numValues >= 6;
+                        }
+                        counts.v++;
+                        break;
+                    case OBJ_VT: counts.vt++; break;
+                    case OBJ_VN: counts.vn++; break;
+                    case OBJ_F: {
+                        int64_t v, vt, vn;
+                        int numCorners = 0;
+                        for(const char* next; (next = parseObjCorner(p, lineEnd, v, vt, vn)) != p; p = next) numCorners++;
+                        counts.triangles += max(numCorners - 2, 0);
+                        break;
+                    }
+                    default: break;
+                }
+            });
+        }
+    });
+
+    pieces[0] = before;
+    for(size_t i = 0; i < numPieces; i++){
+        pieces[i + 1].v += pieces[i].v;
+        pieces[i + 1].vt += pieces[i].vt;
+        pieces[i + 1].vn += pieces[i].vn;
+        pieces[i + 1].triangles += pieces[i].triangles;
+        if(pieces[i].colors >= 0) pieces[i + 1].colors = pieces[i].colors;
+    }
+    const ObjCounts& after = pieces[numPieces];
+
+    size_t numVertices = after.v - before.v;
+    size_t numTriangles = after.triangles - before.triangles;
+    size_t numTexCoords = bAttributes ? after.vt - before.vt : 0;
+    size_t numNormals = bAttributes ? after.vn - before.vn : 0;
+    bool bColors = after.colors > 0;
+
+    mesh.getVertices().resize(numVertices);
+    mesh.getColors().resize(bColors ? numVertices : 0);
+    mesh.getNormals().clear();
+    mesh.getTexCoords().clear();
+    mesh.getIndices().resize(numTriangles * 3);
+
+    ofVec3f* vertices = mesh.getVertices().data();
+    ofFloatColor* colors = mesh.getColors().data();
+    ofIndexType* indices = mesh.getIndices().data();
+
+    //texcoords and normals have their own numbering. They're read into their own lists
+    //along with which one each corner of each triangle uses, and sorted out after
+    vector<ofVec2f> texCoords(numTexCoords);
+    vector<ofVec3f> normals(numNormals);
+    vector<int64_t> cornerTexCoords(numTexCoords > 0 ? numTriangles * 3 : 0);
+    vector<int64_t> cornerNormals(numNormals > 0 ? numTriangles * 3 : 0);
+
+    vector<char> pieceOk(numPieces, 1);
+
+    TaskScheduler::get().parallelFor(0, numPieces, 1, [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++){
+            ObjCounts counts = pieces[i];
+            forEachLine(cuts[i], cuts[i + 1], [&](const char* p, const char* lineEnd){
+                float values[6];
+                switch(getObjLine(p, lineEnd)){
+
+                    case OBJ_V: {
+                        int numValues = 0;
+                        for(const char* next; numValues < 6 && (next = parseFloat(p, lineEnd, values[numValues])) != p; p = next) numValues++;
+                        if(numValues < 3){
+                            pieceOk[i] = 0;
+                            break;
+                        }
+                        size_t v = counts.v - before.v;
+                        vertices[v].set(values[0], values[1], values[2]);
+                        if(bColors) colors[v] = numValues == 6 ? ofFloatColor(values[3], values[4], values[5]) : ofFloatColor(1, 1, 1);
+                        counts.v++;
+                        break;
+                    }
+
+                    case OBJ_VT:
+                        if(numTexCoords > 0){
+                            values[0] = values[1] = 0;
+                            p = parseFloat(p, lineEnd, values[0]);
+                            parseFloat(p, lineEnd, values[1]);
+                            texCoords[counts.vt - before.vt].set(values[0], values[1]);
+                        }
+                        counts.vt++;
+                        break;
+
+                    case OBJ_VN:
+                        if(numNormals > 0){
+                            values[0] = values[1] = values[2] = 0;
+                            p = parseFloat(p, lineEnd, values[0]);
+                            p = parseFloat(p, lineEnd, values[1]);
+                            parseFloat(p, lineEnd, values[2]);
+                            normals[counts.vn - before.vn].set(values[0], values[1], values[2]);
+                        }
+                        counts.vn++;
+                        break;
+
+                    case OBJ_F: {
+                        //fanned out like a PLY face, but the texcoords and normals come along
+                        int64_t corner[3], firstCorner[3] = {0, 0, 0}, previousCorner[3] = {0, 0, 0};
+                        int numCorners = 0;
+                        for(const char* next; (next = parseObjCorner(p, lineEnd, corner[0], corner[1], corner[2])) != p; p = next){
+
+                            corner[0] = getObjIndex(corner[0], counts.v);
+                            corner[1] = getObjIndex(corner[1], counts.vt);
+                            corner[2] = getObjIndex(corner[2], counts.vn);
+                            if(corner[0] < 0) pieceOk[i] = 0;
+
+                            if(numCorners == 0){
+                                memcpy(firstCorner, corner, sizeof(corner));
+                            } else if(numCorners >= 2){
+                                const int64_t* triangle[3] = {firstCorner, previousCorner, corner};
+                                size_t t = (counts.triangles - before.triangles) * 3;
+                                for(int k = 0; k < 3; k++){
+                                    indices[t + k] = (ofIndexType)triangle[k][0];
+                                    if(!cornerTexCoords.empty()) cornerTexCoords[t + k] = triangle[k][1];
+                                    if(!cornerNormals.empty()) cornerNormals[t + k] = triangle[k][2];
+                                }
+                                counts.triangles++;
+                            }
+                            memcpy(previousCorner, corner, sizeof(corner));
+                            numCorners++;
+                        }
+                        break;
+                    }
+
+                    default:
+                        break;
+                }
+            });
+        }
+    });
+
+    //a vertex used with different texcoords or normals by different faces keeps
+    //the last ones. It's the price of keeping the vertices in the file's order
+    if(numTexCoords > 0){
+        mesh.getTexCoords().resize(numVertices);
+        for(size_t c = 0; c < cornerTexCoords.size(); c++){
+            int64_t t = cornerTexCoords[c] - before.vt;
+            if(indices[c] < numVertices && t >= 0 && t < (int64_t)numTexCoords) mesh.getTexCoords()[indices[c]] = texCoords[t];
+        }
+    }
+    if(numNormals > 0){
+        mesh.getNormals().resize(numVertices);
+        for(size_t c = 0; c < cornerNormals.size(); c++){
+            int64_t n = cornerNormals[c] - before.vn;
+            if(indices[c] < numVertices && n >= 0 && n < (int64_t)numNormals) mesh.getNormals()[indices[c]] = normals[n];
+        }
+    }
+
+    before = after;
+
+    for(char ok : pieceOk){
+        if(!ok) return false;
+    }
+    return true;
+}
+
+//format count items as text on all the cores, a piece each,
+//then write the pieces to the file in order
+static void writeText(ofstream& file, size_t count, const std::function<void(size_t, string&)>& format){
+
+    size_t numPieces = min<size_t>(TaskScheduler::get().getNumThreads() * 8, count / 4096 + 1);
+    vector<string> pieces(numPieces);
+
+    TaskScheduler::get().parallelFor(0, numPieces, 1, [&](size_t first, size_t last){
+        for(size_t k = first; k < last; k++){
+            size_t begin = count * k / numPieces;
+            size_t end = count * (k + 1) / numPieces;
+            pieces[k].reserve((end - begin) * 48);
+            for(size_t i = begin; i < end; i++){
+                format(i, pieces[k]);
+            }
+        }
+    });
+
+    for(const string& piece : pieces){
+        file.write(piece.data(), piece.size());
+    }
+}
+
+//"%.9g" is the shortest that always reads back as exactly the same float
+static inline void appendFloat(string& out, float value){
+    char text[32];
+    int length = snprintf(text, sizeof(text), "%.9g", value);
+    out.append(text, length);
+}
+
+static inline void appendInt(string& out, int64_t value){
+    char text[32];
+    int length = snprintf(text, sizeof(text), "%lld", (long long)value);
+    out.append(text, length);
+}
+
+static inline unsigned char toByte(float value){
+    return (unsigned char)(ofClamp(value, 0, 1) * 255 + 0.5f);
+}
+
+//--------------------------------------------------------------
+static bool savePly(ofstream& file, const ofMesh& mesh, const vector<ofIndexType>& triangles, bool bBinary){
+
+    size_t numVertices = mesh.getNumVertices();
+    size_t numTriangles = triangles.size() / 3;
+    bool bNormals = mesh.getNumNormals() == numVertices && numVertices > 0;
+    bool bColors = mesh.getNumColors() == numVertices && numVertices > 0;
+    bool bTexCoords = mesh.getNumTexCoords() == numVertices && numVertices > 0;
+
+    const ofVec3f* vertices = mesh.getVertices().data();
+    const ofVec3f* normals = mesh.getNormals().data();
+    const ofFloatColor* colors = mesh.getColors().data();
+    const ofVec2f* texCoords = mesh.getTexCoords().data();
+
+    file << "ply\n";
+    if(!bBinary) file << "format ascii 1.0\n";
+    else if(isBigEndianHost()) file << "format binary_big_endian 1.0\n";
+    else file << "format binary_little_endian 1.0\n";
+    file << "element vertex " << numVertices << "\n";
+    file << "property float x\nproperty float y\nproperty float z\n";
+    if(bNormals) file << "property float nx\nproperty float ny\nproperty float nz\n";
+    if(bColors) file << "property uchar red\nproperty uchar green\nproperty uchar blue\nproperty uchar alpha\n";
+    if(bTexCoords) file << "property float s\nproperty float t\n";
+    if(numTriangles > 0){
+        file << "element face " << numTriangles << "\n";
+        file << "property list uchar int vertex_indices\n";
+    }
+    file << "end_header\n";
+
+    if(!bBinary){
+        writeText(file, numVertices, [&](size_t i, string& out){
+            appendFloat(out, vertices[i].x); out += ' ';
+            appendFloat(out, vertices[i].y); out += ' ';
+            appendFloat(out, vertices[i].z);
+            if(bNormals){
+                out += ' '; appendFloat(out, normals[i].x);
+                out += ' '; appendFloat(out, normals[i].y);
+                out += ' '; appendFloat(out, normals[i].z);
+            }
+            if(bColors){
+                out += ' '; appendInt(out, toByte(colors[i].r));
+                out += ' '; appendInt(out, toByte(colors[i].g));
+                out += ' '; appendInt(out, toByte(colors[i].b));
+                out += ' '; appendInt(out, toByte(colors[i].a));
+            }
+            if(bTexCoords){
+                out += ' '; appendFloat(out, texCoords[i].x);
+                out += ' '; appendFloat(out, texCoords[i].y);
+            }
+            out += '\n';
+        });
+        writeText(file, numTriangles, [&](size_t i, string& out){
+            out += "3 ";
+            appendInt(out, triangles[i * 3]); out += ' ';
+            appendInt(out, triangles[i * 3 + 1]); out += ' ';
+            appendInt(out, triangles[i * 3 + 2]); out += '\n';
+        });
+        return (bool)file;
+    }
+
+    //binary: the records are all the same size, so every vertex
+    //knows where it goes and they're converted on all the cores
+    size_t stride = 12 + (bNormals ? 12 : 0) + (bColors ? 4 : 0) + (bTexCoords ? 8 : 0);
+    vector<char> data(numVertices * stride);
+    TaskScheduler::get().parallelFor(0, numVertices, 4096, [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++){
+            char* p = data.data() + i * stride;
+            memcpy(p, vertices[i].getPtr(), 12);
+            p += 12;
+            if(bNormals){
+                memcpy(p, normals[i].getPtr(), 12);
+                p += 12;
+            }
+            if(bColors){
+                unsigned char rgba[4] = {toByte(colors[i].r), toByte(colors[i].g), toByte(colors[i].b), toByte(colors[i].a)};
+                memcpy(p, rgba, 4);
+                p += 4;
+            }
+            if(bTexCoords){
+                memcpy(p, texCoords[i].getPtr(), 8);
+            }
+        }
+    });
+    file.write(data.data(), data.size());
+
+    data.resize(numTriangles * 13);
+    TaskScheduler::get().parallelFor(0, numTriangles, 4096, [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++){
+            char* p = data.data() + i * 13;
+            int32_t corners[3] = {(int32_t)triangles[i * 3], (int32_t)triangles[i * 3 + 1], (int32_t)triangles[i * 3 + 2]};
+            p[0] = 3;
+            memcpy(p + 1, corners, 12);
+        }
+    });
+    file.write(data.data(), data.size());
+
+    return (bool)file;
+}
+
+//--------------------------------------------------------------
+static bool saveObj(ofstream& file, const ofMesh& mesh, const vector<ofIndexType>& triangles){
+
+    size_t numVertices = mesh.getNumVertices();
+    bool bNormals = mesh.getNumNormals() == numVertices && numVertices > 0;
+    bool bColors = mesh.getNumColors() == numVertices && numVertices > 0;
+    bool bTexCoords = mesh.getNumTexCoords() == numVertices && numVertices > 0;
+
+    const vector<ofVec3f>& vertices = mesh.getVertices();
+    const vector<ofVec3f>& normals = mesh.getNormals();
+    const vector<ofFloatColor>& colors = mesh.getColors();
+    const vector<ofVec2f>& texCoords = mesh.getTexCoords();
+
+    //colors aren't part of OBJ, but lots of programs read them after the position
+    writeText(file, numVertices, [&](size_t i, string& out){
+        out += "v ";
+        appendFloat(out, vertices[i].x); out += ' ';
+        appendFloat(out, vertices[i].y); out += ' ';
+        appendFloat(out, vertices[i].z);
+        if(bColors){
+            out += ' '; appendFloat(out, colors[i].r);
+            out += ' '; appendFloat(out, colors[i].g);
+            out += ' '; appendFloat(out, colors[i].b);
+        }
+        out += '\n';
+    });
+    if(bTexCoords){
+        writeText(file, numVertices, [&](size_t i, string& out){
+            out += "vt ";
+            appendFloat(out, texCoords[i].x); out += ' ';
+            appendFloat(out, texCoords[i].y); out += '\n';
+        });
+    }
+    if(bNormals){
+        writeText(file, numVertices, [&](size_t i, string& out){
+            out += "vn ";
+            appendFloat(out, normals[i].x); out += ' ';
+            appendFloat(out, normals[i].y); out += ' ';
+            appendFloat(out, normals[i].z); out += '\n';
+        });
+    }
+
+    //every vertex has its own texcoord and normal, so all three indices are the same
+    writeText(file, triangles.size() / 3, [&](size_t i, string& out){
+        out += 'f';
+        for(int k = 0; k < 3; k++){
+            int64_t index = triangles[i * 3 + k] + 1;
+            out += ' ';
+            appendInt(out, index);
+            if(bTexCoords || bNormals){
+                out += '/';
+                if(bTexCoords) appendInt(out, index);
+                if(bNormals){
+                    out += '/';
+                    appendInt(out, index);
+                }
+            }
+        }
+        out += '\n';
+    });
+
+    return (bool)file;
+}
+
+//--------------------------------------------------------------
+MeshIO::MeshIO(){
+    lastTimeMs = 0;
+    lastNumBytes = 0;
+}
+
+//--------------------------------------------------------------
+bool MeshIO::load(const string& path, ofMesh& mesh){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    string extension = ofToLower(ofFilePath::getFileExt(path));
+    if(extension != "ply" && extension != "obj"){
+        ofLogWarning("MeshIO") << "can't read " << path << ", only .ply and .obj files";
+        return false;
+    }
+
+    //the whole file in memory, the parsers work straight on its bytes
+    ifstream file(ofToDataPath(path).c_str(), ios::binary);
+    if(!file){
+        ofLogWarning("MeshIO") << "couldn't open " << path;
+        return false;
+    }
+    file.seekg(0, ios::end);
+    size_t size = file.tellg();
+    file.seekg(0);
+
+    vector<char> data(size);
+    file.read(data.data(), size);
+    if(!file){
+        ofLogWarning("MeshIO") << "couldn't read " << path;
+        return false;
+    }
+    const char* begin = data.data();
+    const char* end = begin + size;
+
+    mesh.clear();
+
+    bool bOk = false;
+    if(extension == "obj"){
+        ObjCounts counts;
+        bOk = parseObjText(begin, end, counts, mesh, true);
+    } else {
+        PlyHeader header;
+        if(readPlyHeader(begin, size, header)){
+            if(header.format == PlyHeader::ASCII){
+                uint64_t line = 0;
+                bOk = parsePlyText(begin + header.size, end, line, header, mesh);
+            } else {
+                bOk = parsePlyBinary(begin + header.size, end, header, mesh);
+            }
+        }
+    }
+
+    //faces pointing at vertices that aren't there would crash the drawing later
+    if(bOk){
+        std::atomic<bool> bIndicesOk(true);
+        size_t numVertices = mesh.getNumVertices();
+        const ofIndexType* indices = mesh.getIndices().data();
+        TaskScheduler::get().parallelFor(0, mesh.getNumIndices(), 65536, [&](size_t first, size_t last){
+            for(size_t i = first; i < last; i++){
+                if(indices[i] >= numVertices) bIndicesOk = false;
+            }
+        });
+        bOk = bIndicesOk;
+    }
+
+    if(!bOk){
+        ofLogWarning("MeshIO") << "couldn't read " << path << ", it's not a mesh or it's damaged";
+        mesh.clear();
+        return false;
+    }
+
+    //a file without faces is a point cloud
+    mesh.setMode(mesh.hasIndices() ? OF_PRIMITIVE_TRIANGLES : OF_PRIMITIVE_POINTS);
+
+    lastNumBytes = size;
+    lastTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+    return true;
+}
+
+//--------------------------------------------------------------
+bool MeshIO::save(const string& path, const ofMesh& mesh, bool bBinary){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    string extension = ofToLower(ofFilePath::getFileExt(path));
+    if(extension != "ply" && extension != "obj"){
+        ofLogWarning("MeshIO") << "can't write " << path << ", only .ply and .obj files";
+        return false;
+    }
+
+    ofstream file(ofToDataPath(path).c_str(), ios::binary);
+    if(!file){
+        ofLogWarning("MeshIO") << "couldn't open " << path << " for writing";
+        return false;
+    }
+
+    //strips and fans are written as plain triangles, points and lines without faces
+    vector<ofIndexType> triangles;
+    MeshUtils::getTriangleIndices(mesh, triangles);
+
+    bool bOk = extension == "obj" ? saveObj(file, mesh, triangles) : savePly(file, mesh, triangles, bBinary);
+    if(!bOk){
+        ofLogWarning("MeshIO") << "couldn't write " << path;
+        return false;
+    }
+
+    lastNumBytes = file.tellp();
+    lastTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+    return true;
+}
+
+//--------------------------------------------------------------
+bool MeshIO::stream(const string& path, const std::function<void(const ofMesh& block)>& onBlock, size_t blockBytes){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    string extension = ofToLower(ofFilePath::getFileExt(path));
+    if(extension != "ply" && extension != "obj"){
+        ofLogWarning("MeshIO") << "can't read " << path << ", only .ply and .obj files";
+        return false;
+    }
+
+    ifstream file(ofToDataPath(path).c_str(), ios::binary);
+    if(!file){
+        ofLogWarning("MeshIO") << "couldn't open " << path;
+        return false;
+    }
+    file.seekg(0, ios::end);
+    uint64_t size = file.tellg();
+    file.seekg(0);
+
+    blockBytes = max<size_t>(blockBytes, 4096);
+
+    ofMesh block;
+    bool bOk = true;
+
+    if(extension == "obj"){
+        LineReader reader(file);
+        ObjCounts counts;
+        while(bOk && reader.next(blockBytes)){
+            bOk = parseObjText(reader.begin(), reader.end(), counts, block, false);
+            block.setMode(block.hasIndices() ? OF_PRIMITIVE_TRIANGLES : OF_PRIMITIVE_POINTS);
+            if(bOk) onBlock(block);
+        }
+
+    } else {
+
+        //the header is only a few lines, a MB is plenty
+        vector<char> data(min<uint64_t>(size, 1 << 20));
+        file.read(data.data(), data.size());
+        PlyHeader header;
+        bOk = readPlyHeader(data.data(), data.size(), header);
+        file.clear();
+        file.seekg(header.size);
+
+        if(bOk && header.format == PlyHeader::ASCII){
+            LineReader reader(file);
+            uint64_t line = 0;
+            while(bOk && reader.next(blockBytes)){
+                bOk = parsePlyText(reader.begin(), reader.end(), line, header, block);
+                block.setMode(block.hasIndices() ? OF_PRIMITIVE_TRIANGLES : OF_PRIMITIVE_POINTS);
+                if(bOk) onBlock(block);
+            }
+
+        } else if(bOk){
+
+            bool bSwap = header.needsSwap();
+
+            for(const PlyElement& element : header.elements){
+                if(!bOk) break;
+
+                bool bVertex = element.name == "vertex";
+                bool bFace = element.name == "face" && element.has(ATTR_INDICES);
+
+                if(element.stride > 0 && !bVertex){
+                    file.seekg(element.count * element.stride, ios::cur);
+                    continue;
+                }
+
+                //vertices of a fixed size: read as many as fit in a block, convert them on all the cores
+                if(element.stride > 0){
+                    size_t perBlock = max<size_t>(blockBytes / element.stride, 1);
+                    for(uint64_t done = 0; done < element.count; ){
+                        size_t count = min<uint64_t>(perBlock, element.count - done);
+                        data.resize(count * element.stride);
+                        if(!file.read(data.data(), data.size())){
+                            bOk = false;
+                            break;
+                        }
+
+                        VertexTarget target = prepareVertices(block, count, &element);
+                        block.getIndices().clear();
+                        block.setMode(OF_PRIMITIVE_POINTS);
+                        const char* p = data.data();
+                        TaskScheduler::get().parallelFor(0, count, 4096, [&](size_t first, size_t last){
+                            float values[NUM_ATTRS];
+                            size_t numTriangles;
+                            for(size_t i = first; i < last; i++){
+                                resetValues(values);
+                                parseBinaryRecord(p + i * element.stride, p + data.size(), element, bSwap, values, nullptr, numTriangles);
+                                storeVertex(values, target, i);
+                            }
+                        });
+                        onBlock(block);
+                        done += count;
+                    }
+                    continue;
+                }
+
+                //records with lists in them: read a block, take the whole records out of it
+                //(once to count, once to fill in) and carry the rest over to the next block
+                size_t numCarried = 0;
+                for(uint64_t done = 0; done < element.count; ){
+
+                    data.resize(numCarried + blockBytes);
+                    file.read(data.data() + numCarried, blockBytes);
+                    const char* p = data.data();
+                    const char* end = p + numCarried + file.gcount();
+
+                    size_t numRecords = 0, numTriangles = 0;
+                    const char* q = p;
+                    while(done + numRecords < element.count){
+                        size_t count;
+                        const char* next = parseBinaryRecord(q, end, element, bSwap, nullptr, nullptr, count);
+                        if(!next) break;
+                        q = next;
+                        numRecords++;
+                        numTriangles += count;
+                    }
+
+                    if(numRecords == 0){
+                        //a record bigger than a whole block, read more of it. Unless the file's run out
+                        if(!file){
+                            bOk = false;
+                            break;
+                        }
+                        numCarried = end - p;
+                        continue;
+                    }
+
+                    if(bVertex || bFace){
+                        VertexTarget target = prepareVertices(block, bVertex ? numRecords : 0, &element);
+                        block.getIndices().resize(numTriangles * 3);
+                        block.setMode(bFace ? OF_PRIMITIVE_TRIANGLES : OF_PRIMITIVE_POINTS);
+
+                        const char* r = p;
+                        size_t triangle = 0;
+                        for(size_t i = 0; i < numRecords; i++){
+                            float values[NUM_ATTRS];
+                            resetValues(values);
+                            size_t count;
+                            r = parseBinaryRecord(r, end, element, bSwap, values, bFace ? block.getIndices().data() + triangle * 3 : nullptr, count);
+                            if(bVertex) storeVertex(values, target, i);
+                            triangle += count;
+                        }
+                        onBlock(block);
+                    }
+
+                    done += numRecords;
+                    numCarried = end - q;
+                    memmove(data.data(), q, numCarried);
+                }
+
+                //whatever was read past the element belongs to the next one
+                file.clear();
+                file.seekg(-(streamoff)numCarried, ios::cur);
+            }
+        }
+    }
+
+    if(!bOk){
+        ofLogWarning("MeshIO") << "couldn't read " << path << ", it's not a mesh or it's damaged";
+        return false;
+    }
+
+    lastNumBytes = size;
+    lastTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+    return true;
+}
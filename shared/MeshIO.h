@@ -0,0 +1,61 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Reads and writes meshes as PLY (ascii or binary) and OBJ files, so scanned
+ * meshes and point clouds can be brought into the sketches and deformed frames
+ * can be saved for other programs.
+ *
+ * Reading:
+ *
+ *  - the mesh's vertex, normal, color, texcoord and index vectors are sized
+ *    first and then filled in place, there's no temporary mesh in between
+ *  - text is cut into chunks at line breaks and the chunks are parsed on all
+ *    the cores. That takes a couple of passes: count what's in each chunk, add
+ *    the counts up so every chunk knows where its vertices and triangles go,
+ *    then parse. Numbers go through a small float parser of our own, strtof and
+ *    stringstreams are slow (and read "1,5" or "1.5" depending on the locale)
+ *  - binary PLY vertices are all the same size, so they're converted on all
+ *    the cores straight from the file's bytes. Faces are too when they're all
+ *    triangles (which is checked first)
+ *  - polygons with more than 3 corners are split into triangle fans
+ *
+ * stream() is for files too big to fit in memory: it reads a block at a time
+ * and hands each block to a function, so only one block is ever loaded.
+ *
+ * Writing makes PLY or OBJ depending on the extension. Text is formatted on all
+ * the cores and then written in order, binary is converted on all the cores.
+ *
+ * OBJ keeps one vertex per "v" line, so indices in the mesh match the file. The
+ * texcoords and normals the faces point at are copied onto those vertices.
+ */
+
+class MeshIO {
+
+	public:
+
+    MeshIO();
+
+    //read a .ply or .obj file into the mesh (replacing whatever was in it)
+    bool load(const string& path, ofMesh& mesh);
+
+    //write a .ply (binary unless bBinary is false) or .obj file, by the extension
+    bool save(const string& path, const ofMesh& mesh, bool bBinary = true);
+
+    //read the file about blockBytes at a time and call onBlock for each block with
+    //its vertices (and colors, normals, texcoords if the file has them) and faces.
+    //The block mesh is reused, and its face indices count from the start of the
+    //file so they can point at vertices from earlier blocks. OBJ texcoords and
+    //normals are indexed separately from the vertices, those are skipped here
+    bool stream(const string& path, const std::function<void(const ofMesh& block)>& onBlock, size_t blockBytes = 64 << 20);
+
+    //how long the last load, save or stream took, and how big the file was
+    float getLastTimeMs() const { return lastTimeMs; }
+    uint64_t getLastNumBytes() const { return lastNumBytes; }
+
+    private:
+
+    float lastTimeMs;
+    uint64_t lastNumBytes;
+};
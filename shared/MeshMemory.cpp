@@ -0,0 +1,162 @@
+#include "MeshMemory.h"
+
+//--------------------------------------------------------------
+static string toKB(size_t bytes){
+    return ofToString(bytes / 1024.0, 1, 10, ' ') + " KB";
+}
+
+//--------------------------------------------------------------
+static string padRight(const string& text, size_t width){
+    return text + string(width > text.size() ? width - text.size() : 0, ' ');
+}
+
+//--------------------------------------------------------------
+MeshMemory::MeshMemory(){
+    highWaterBytes = 0;
+    logInterval = 5;
+    lastLogTime = 0;
+}
+
+//--------------------------------------------------------------
+MeshMemory::~MeshMemory(){
+    stopLog();
+}
+
+//--------------------------------------------------------------
+void MeshMemory::addMesh(const string& owner, const ofMesh& mesh){
+    addVector(owner, "vertices", mesh.getVertices());
+    addVector(owner, "normals", mesh.getNormals());
+    addVector(owner, "colors", mesh.getColors());
+    addVector(owner, "texcoords", mesh.getTexCoords());
+    addVector(owner, "indices", mesh.getIndices());
+}
+
+//--------------------------------------------------------------
+void MeshMemory::add(const string& owner, const string& name, const std::function<void(size_t&, size_t&)>& measure){
+    Attribute attribute;
+    attribute.owner = owner;
+    attribute.name = name;
+    attribute.liveBytes = 0;
+    attribute.slackBytes = 0;
+    attribute.highWaterBytes = 0;
+    attribute.measure = measure;
+    attributes.push_back(attribute);
+}
+
+//--------------------------------------------------------------
+void MeshMemory::clear(){
+    attributes.clear();
+    highWaterBytes = 0;
+}
+
+//--------------------------------------------------------------
+void MeshMemory::update(){
+
+    size_t allocatedBytes = 0;
+    for(Attribute& attribute : attributes){
+        size_t live = 0;
+        size_t allocated = 0;
+        attribute.measure(live, allocated);
+
+        attribute.liveBytes = live;
+        attribute.slackBytes = max(allocated, live) - live;
+        attribute.highWaterBytes = max(attribute.highWaterBytes, allocated);
+        allocatedBytes += max(allocated, live);
+    }
+    highWaterBytes = max(highWaterBytes, allocatedBytes);
+
+    if(log.is_open() && ofGetElapsedTimef() - lastLogTime >= logInterval){
+        writeLog();
+    }
+}
+
+//--------------------------------------------------------------
+void MeshMemory::draw(float x, float y) const{
+
+    //one line per attribute that has ever had anything in it,
+    //and a total line for each owner (they're added owner by owner)
+    string table = padRight("", 12) + ofToString(string("live"), 13, ' ') + ofToString(string("slack"), 13, ' ') + ofToString(string("high water"), 13, ' ') + "\n";
+    size_t ownerLive = 0;
+    size_t ownerSlack = 0;
+    size_t ownerHighWater = 0;
+
+    for(size_t i = 0; i < attributes.size(); i++){
+        const Attribute& attribute = attributes[i];
+        if(attribute.highWaterBytes > 0){
+            table += "  " + padRight(attribute.name, 10) + toKB(attribute.liveBytes) + toKB(attribute.slackBytes) + toKB(attribute.highWaterBytes) + "\n";
+        }
+        ownerLive += attribute.liveBytes;
+        ownerSlack += attribute.slackBytes;
+        ownerHighWater += attribute.highWaterBytes;
+
+        if(i + 1 == attributes.size() || attributes[i + 1].owner != attribute.owner){
+            table += padRight(attribute.owner, 12) + toKB(ownerLive) + toKB(ownerSlack) + toKB(ownerHighWater) + "\n";
+            ownerLive = ownerSlack = ownerHighWater = 0;
+        }
+    }
+
+    table += padRight("total", 12) + toKB(getLiveBytes()) + toKB(getSlackBytes()) + toKB(highWaterBytes);
+    if(log.is_open()){
+        table += "\nlogging to " + logPath;
+    }
+
+    ofDrawBitmapStringHighlight(table, x, y, ofColor(0, 180), ofColor(255));
+}
+
+//--------------------------------------------------------------
+bool MeshMemory::startLog(const string& path, float interval){
+
+    stopLog();
+
+    ofDirectory::createDirectory(ofFilePath::getEnclosingDirectory(path), true, true);
+    log.open(ofToDataPath(path).c_str());
+    if(!log.is_open()){
+        ofLogWarning("MeshMemory") << "couldn't write " << path;
+        return false;
+    }
+
+    logPath = path;
+    logInterval = interval;
+    log << "seconds,owner,attribute,live bytes,slack bytes,high water bytes\n";
+    writeLog();
+    return true;
+}
+
+//--------------------------------------------------------------
+void MeshMemory::stopLog(){
+    if(log.is_open()){
+        log.close();
+    }
+}
+
+//--------------------------------------------------------------
+void MeshMemory::writeLog(){
+
+    lastLogTime = ofGetElapsedTimef();
+    string seconds = ofToString(lastLogTime, 1);
+    for(const Attribute& attribute : attributes){
+        log << seconds << "," << attribute.owner << "," << attribute.name << "," << attribute.liveBytes << "," << attribute.slackBytes << "," << attribute.highWaterBytes << "\n";
+    }
+    log << seconds << ",total,," << getLiveBytes() << "," << getSlackBytes() << "," << highWaterBytes << "\n";
+
+    //so a soak test that crashes still leaves everything up to here
+    log.flush();
+}
+
+//--------------------------------------------------------------
+size_t MeshMemory::getLiveBytes() const{
+    size_t bytes = 0;
+    for(const Attribute& attribute : attributes){
+        bytes += attribute.liveBytes;
+    }
+    return bytes;
+}
+
+//--------------------------------------------------------------
+size_t MeshMemory::getSlackBytes() const{
+    size_t bytes = 0;
+    for(const Attribute& attribute : attributes){
+        bytes += attribute.slackBytes;
+    }
+    return bytes;
+}
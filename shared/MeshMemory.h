@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Keeps track of how much memory each mesh of a sketch takes, attribute by
+ * attribute (vertices, normals, colors, texcoords, indices), so it's easy to see
+ * that originalMesh costs as much as mesh, or that 05's indices and colors keep
+ * growing with every drag.
+ *
+ * For every attribute there are three numbers:
+ *
+ *  - live:        what's in use (size() * the size of one element)
+ *  - slack:       what's allocated on top of that and not used yet
+ *                 (capacity() - size(): vectors grow in steps, usually doubling)
+ *  - high water:  the most that was ever allocated (live + slack) at once
+ *
+ * The meshes keep their usual std::vectors, nothing is swapped out for a counting
+ * allocator (ofMesh doesn't let us choose one), so the meshes are just looked at
+ * once per update(). Anything that isn't a mesh (a vector of flags, a class that
+ * knows its own size) can be added as well.
+ *
+ * draw() shows it all as an overlay. For soak tests startLog() writes a row per
+ * attribute every few seconds to a .csv, which can be watched for anything that
+ * keeps growing.
+ */
+
+class MeshMemory {
+
+	public:
+
+    struct Attribute {
+        string owner;           //the mesh (or whatever) it belongs to
+        string name;            //vertices, colors, ...
+        size_t liveBytes;
+        size_t slackBytes;
+        size_t highWaterBytes;
+
+        //fills in the live and allocated bytes
+        std::function<void(size_t&, size_t&)> measure;
+    };
+
+    MeshMemory();
+    ~MeshMemory();
+
+    //follow all the attributes of a mesh. The mesh has to stay where it is
+    //(a member of the app) for as long as it's tracked
+    void addMesh(const string& owner, const ofMesh& mesh);
+
+    //follow any vector
+    template<typename T>
+    void addVector(const string& owner, const string& name, const vector<T>& values){
+        add(owner, name, [&values](size_t& live, size_t& allocated){
+            live = values.size() * sizeof(T);
+            allocated = values.capacity() * sizeof(T);
+        });
+    }
+
+    //follow anything else that can say how big it is
+    void add(const string& owner, const string& name, const std::function<void(size_t&, size_t&)>& measure);
+
+    //stop following everything
+    void clear();
+
+    //measure everything again (and write it to the log if it's time)
+    void update();
+
+    //the table, with its top left corner at x, y
+    void draw(float x, float y) const;
+
+    //write everything to a .csv (in bin/data) every interval seconds until stopLog()
+    bool startLog(const string& path, float interval = 5);
+    void stopLog();
+    bool isLogging() const { return log.is_open(); }
+
+    const vector<Attribute>& getAttributes() const { return attributes; }
+    size_t getLiveBytes() const;
+    size_t getSlackBytes() const;
+    size_t getHighWaterBytes() const { return highWaterBytes; }
+
+    private:
+
+    void writeLog();
+
+    vector<Attribute> attributes;
+
+    //the most allocated at once over everything (not the sum of the
+    //attributes' own high water marks, which can happen at different times)
+    size_t highWaterBytes;
+
+    ofstream log;
+    string logPath;
+    float logInterval;
+    float lastLogTime;
+};
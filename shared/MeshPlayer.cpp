@@ -0,0 +1,260 @@
+#include "MeshPlayer.h"
+#include "EntropyCoder.h"
+
+#include <cstring>
+
+static const size_t blockSize = MeshRecorder::blockSize;
+
+//--------------------------------------------------------------
+MeshPlayer::MeshPlayer(){
+    bLoaded = false;
+    currentFrame = -1;
+    lastNumFramesDecoded = 0;
+    lastDecodeTimeMs = 0;
+    lastWaitTimeMs = 0;
+    memset(&header, 0, sizeof(header));
+}
+
+//--------------------------------------------------------------
+MeshPlayer::~MeshPlayer(){
+
+    //nothing can be thrown out of a destructor
+    try {
+        TaskScheduler::get().wait(group);
+    } catch(std::exception& e) {
+        ofLogWarning("MeshPlayer") << "reading ahead failed: " << e.what();
+    } catch(...) {
+        ofLogWarning("MeshPlayer") << "reading ahead failed";
+    }
+}
+
+//--------------------------------------------------------------
+bool MeshPlayer::load(const string& path){
+
+    //the file is about to change under the prefetch
+    TaskScheduler::get().wait(group);
+    prefetched.index = -1;
+
+    bLoaded = false;
+    offsets.clear();
+    currentFrame = -1;
+
+    file.close();
+    file.clear();
+    file.open(ofToDataPath(path).c_str(), ios::binary);
+    if(!file.read((char*)&header, sizeof(header)) || string(header.magic, 4) != "MREC"){
+        ofLogWarning("MeshPlayer") << "couldn't read " << path << ", it's not a recording";
+        return false;
+    }
+    if(header.version != MeshRecorder::version){
+        ofLogWarning("MeshPlayer") << path << " is a version " << header.version << " recording, this plays version " << MeshRecorder::version << ". Record it again";
+        return false;
+    }
+
+    //the end of the file says where the index is. It's only there
+    //once the recording was stopped properly
+    uint64_t indexOffset = 0;
+    char magic[4];
+    file.seekg(-12, ios::end);
+    file.read((char*)&indexOffset, 8);
+    file.read(magic, 4);
+    uint32_t numFrames = 0;
+    if(file && string(magic, 4) == "MEND"){
+        file.seekg(indexOffset);
+        file.read((char*)&numFrames, 4);
+        offsets.resize(numFrames + 1);
+        file.read((char*)offsets.data(), offsets.size() * sizeof(uint64_t));
+    }
+    if(!file || numFrames == 0){
+        ofLogWarning("MeshPlayer") << "couldn't read " << path << ", the recording wasn't finished";
+        offsets.clear();
+        return false;
+    }
+
+    current.assign(header.numVertices * 3, 0);
+    bLoaded = true;
+    return true;
+}
+
+//--------------------------------------------------------------
+bool MeshPlayer::readFrame(size_t index, Frame& frame){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    frame.index = -1;
+    frame.data.resize(offsets[index + 1] - offsets[index]);
+    file.clear();
+    file.seekg(offsets[index]);
+    if(!file.read(frame.data.data(), frame.data.size())) return false;
+
+    //whether it's a keyframe, the size of each block, then the blocks
+    const unsigned char* p = (const unsigned char*)frame.data.data();
+    const unsigned char* end = p + frame.data.size();
+    size_t numVerts = header.numVertices;
+    size_t numBlocks = (numVerts + blockSize - 1) / blockSize;
+
+    uint32_t count;
+    if(end - p < 5) return false;
+    frame.bKeyframe = p[0] != 0;
+    memcpy(&count, p + 1, 4);
+    p += 5;
+    if(count != numBlocks || (size_t)(end - p) < numBlocks * 4) return false;
+
+    vector<const unsigned char*> blockData(numBlocks + 1);
+    blockData[0] = p + numBlocks * 4;
+    for(size_t b = 0; b < numBlocks; b++){
+        uint32_t size;
+        memcpy(&size, p + b * 4, 4);
+        blockData[b + 1] = blockData[b] + size;
+    }
+    if(blockData[numBlocks] > end) return false;
+
+    frame.values.resize(numVerts * 3);
+    std::atomic<bool> bOk(true);
+
+    TaskScheduler::get().parallelFor(0, numBlocks, 1, [&](size_t first, size_t last){
+
+        vector<unsigned char> varints;
+
+        for(size_t b = first; b < last; b++){
+            size_t size = blockData[b + 1] - blockData[b];
+            if(EntropyCoder::decode(blockData[b], size, varints) != size){
+                bOk = false;
+                continue;
+            }
+
+            const unsigned char* v = varints.data();
+            const unsigned char* vEnd = v + varints.size();
+            size_t begin = b * blockSize * 3;
+            size_t end = min((b + 1) * blockSize, numVerts) * 3;
+            for(size_t i = begin; i < end && v; i++){
+                v = EntropyCoder::readVarint(v, vEnd, frame.values[i]);
+            }
+            if(!v) bOk = false;
+        }
+    });
+
+    if(!bOk) return false;
+
+    frame.index = index;
+    frame.decodeTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+    return true;
+}
+
+//--------------------------------------------------------------
+void MeshPlayer::applyFrame(const Frame& frame){
+
+    size_t numVerts = header.numVertices;
+    size_t numBlocks = (numVerts + blockSize - 1) / blockSize;
+    const int32_t* values = frame.values.data();
+    int32_t* q = current.data();
+
+    TaskScheduler::get().parallelFor(0, numBlocks, 1, [&](size_t first, size_t last){
+        for(size_t b = first; b < last; b++){
+            size_t begin = b * blockSize * 3;
+            size_t end = min((b + 1) * blockSize, numVerts) * 3;
+
+            //a keyframe is the steps from one vertex to the next, starting
+            //from 0 in every block, so it's a running sum per axis
+            if(frame.bKeyframe){
+                for(size_t i = begin; i < end; i++){
+                    q[i] = (i >= begin + 3 ? q[i - 3] : 0) + values[i];
+                }
+            } else {
+                for(size_t i = begin; i < end; i++){
+                    q[i] += values[i];
+                }
+            }
+        }
+    });
+
+    currentFrame = frame.index;
+}
+
+//--------------------------------------------------------------
+void MeshPlayer::prefetch(size_t index){
+
+    //with one core there's nothing to overlap with
+    if(TaskScheduler::get().getNumThreads() <= 1) return;
+
+    TaskScheduler::get().run(group, [this, index](){
+        readFrame(index, prefetched);
+    });
+}
+
+//--------------------------------------------------------------
+bool MeshPlayer::getFrame(size_t index, ofMesh& mesh){
+
+    if(!bLoaded || index >= getNumFrames()) return false;
+
+    if(mesh.getNumVertices() != header.numVertices){
+        ofLogWarning("MeshPlayer") << "the recording has " << header.numVertices << " vertices, the mesh " << mesh.getNumVertices();
+        return false;
+    }
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    //the prefetch uses the file (and might be the very frame we want)
+    TaskScheduler::get().wait(group);
+
+    //carry on from the current frame if it's on the way, otherwise
+    //start over from the keyframe the wanted frame depends on
+    size_t keyframe = index - index % header.keyframeInterval;
+    size_t from = currentFrame >= (int64_t)keyframe && currentFrame <= (int64_t)index ? currentFrame + 1 : keyframe;
+
+    lastNumFramesDecoded = 0;
+    lastDecodeTimeMs = 0;
+
+    for(size_t f = from; f <= index; f++){
+
+        uint64_t applyStart = ofGetElapsedTimeMicros();
+
+        const Frame* next = &prefetched;
+        if(prefetched.index != (int64_t)f){
+            if(!readFrame(f, frame)){
+                ofLogWarning("MeshPlayer") << "frame " << f << " is damaged";
+                currentFrame = -1;
+                return false;
+            }
+            next = &frame;
+        }
+
+        applyFrame(*next);
+
+        lastNumFramesDecoded++;
+        lastDecodeTimeMs += next->decodeTimeMs + (ofGetElapsedTimeMicros() - applyStart) / 1000.0f;
+    }
+
+    //grid steps back to positions
+    size_t numVerts = header.numVertices;
+    ofVec3f* verts = mesh.getVertices().data();
+    const int32_t* q = current.data();
+    ofVec3f origin(header.origin[0], header.origin[1], header.origin[2]);
+    float step = header.step;
+
+    TaskScheduler::get().parallelFor(0, numVerts, 4096, [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++){
+            verts[i].set(origin.x + q[i * 3] * step, origin.y + q[i * 3 + 1] * step, origin.z + q[i * 3 + 2] * step);
+        }
+    });
+
+    //and get the one after this ready while the sketch draws
+    prefetch((index + 1) % getNumFrames());
+
+    lastWaitTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+    return true;
+}
+
+//--------------------------------------------------------------
+float MeshPlayer::getCompressionRatio() const{
+    if(offsets.size() < 2) return 0;
+    double rawBytes = getNumFrames() * (double)header.numVertices * sizeof(ofVec3f);
+    return rawBytes / (offsets.back() - offsets.front());
+}
+
+//--------------------------------------------------------------
+float MeshPlayer::getDecodeMBPerSecond() const{
+    if(lastDecodeTimeMs <= 0) return 0;
+    double rawBytes = lastNumFramesDecoded * (double)header.numVertices * sizeof(ofVec3f);
+    return rawBytes / (1024.0 * 1024.0) / (lastDecodeTimeMs / 1000.0);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "ofMain.h"
+#include "MeshRecorder.h"
+#include "TaskScheduler.h"
+
+/*
+ * Plays back what MeshRecorder recorded, into the vertices of a mesh with the
+ * same number of vertices (usually the very mesh that was recorded).
+ *
+ * Any frame can be asked for in any order. Going forward one frame at a time
+ * only decodes the new frame's changes. Jumping somewhere else starts from the
+ * nearest keyframe before it and adds the changes up from there, so it costs
+ * at most keyframeInterval frames.
+ *
+ * Decoding happens in two steps: unpacking the entropy coded blocks (the slow
+ * part, on all the cores) and adding the changes to the last frame. While the
+ * sketch is drawing one frame, the next one is read and unpacked on a worker
+ * thread (prefetching), so the next getFrame() usually only has the adding left.
+ */
+
+class MeshPlayer {
+
+	public:
+
+    MeshPlayer();
+
+    //waits for the prefetch
+    ~MeshPlayer();
+
+    //open a recording. Only the header and the index are read, frames are read when they're needed
+    bool load(const string& path);
+    bool isLoaded() const { return bLoaded; }
+
+    //put frame "index" into the mesh's vertices
+    bool getFrame(size_t index, ofMesh& mesh);
+
+    size_t getNumFrames() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    size_t getNumVertices() const { return header.numVertices; }
+    size_t getKeyframeInterval() const { return header.keyframeInterval; }
+
+    //how many times smaller the frames are than the raw floats
+    float getCompressionRatio() const;
+
+    //the last getFrame(): how many frames it decoded to get there, how long the
+    //decoding took in all (including what the prefetch did earlier), that as
+    //MB of floats per second, and how long getFrame() itself actually took
+    size_t getLastNumFramesDecoded() const { return lastNumFramesDecoded; }
+    float getLastDecodeTimeMs() const { return lastDecodeTimeMs; }
+    float getDecodeMBPerSecond() const;
+    float getLastWaitTimeMs() const { return lastWaitTimeMs; }
+
+    private:
+
+    //a frame read from the file and unpacked, but not yet added to the last one
+    struct Frame {
+        Frame() : index(-1), bKeyframe(false), decodeTimeMs(0) {}
+        int64_t index;
+        bool bKeyframe;
+        vector<int32_t> values;
+        vector<char> data;
+        float decodeTimeMs;
+    };
+
+    bool readFrame(size_t index, Frame& frame);
+
+    //add the frame's changes to the current one
+    void applyFrame(const Frame& frame);
+
+    //start reading the frame on a worker thread
+    void prefetch(size_t index);
+
+    ifstream file;
+    MeshRecorder::Header header;
+    vector<uint64_t> offsets;
+    bool bLoaded;
+
+    //the frame the current positions are from (-1 for none yet)
+    int64_t currentFrame;
+    vector<int32_t> current;
+
+    Frame frame;
+    Frame prefetched;
+    TaskScheduler::TaskGroup group;
+
+    size_t lastNumFramesDecoded;
+    float lastDecodeTimeMs;
+    float lastWaitTimeMs;
+};
@@ -0,0 +1,163 @@
+#include "MeshRecorder.h"
+#include "MeshBounds.h"
+#include "EntropyCoder.h"
+#include "TaskScheduler.h"
+
+//--------------------------------------------------------------
+MeshRecorder::MeshRecorder(){
+    bRecording = false;
+    numFrames = 0;
+    numBytes = 0;
+    numRawBytes = 0;
+    lastEncodeTimeMs = 0;
+}
+
+//--------------------------------------------------------------
+MeshRecorder::~MeshRecorder(){
+    stop();
+}
+
+//--------------------------------------------------------------
+bool MeshRecorder::start(const string& path, const ofMesh& mesh, float precision, int keyframeInterval){
+
+    stop();
+
+    file.open(ofToDataPath(path).c_str(), ios::binary);
+    if(!file){
+        ofLogWarning("MeshRecorder") << "couldn't open " << path << " for writing";
+        return false;
+    }
+
+    //the grid starts at the corner of the mesh. A step of twice the precision
+    //means nothing is ever more than half a step (the precision) away from it
+    MeshBounds bounds;
+    bounds.compute(mesh);
+
+    header.magic[0] = 'M';
+    header.magic[1] = 'R';
+    header.magic[2] = 'E';
+    header.magic[3] = 'C';
+    header.version = version;
+    header.numVertices = mesh.getNumVertices();
+    header.keyframeInterval = max(keyframeInterval, 1);
+    header.step = precision > 0 ? precision * 2 : max(bounds.getSize().length() / 65536.0f, 1e-6f);
+    header.origin[0] = bounds.getMin().x;
+    header.origin[1] = bounds.getMin().y;
+    header.origin[2] = bounds.getMin().z;
+    file.write((const char*)&header, sizeof(header));
+
+    offsets.clear();
+    offsets.push_back(file.tellp());
+    previous.assign(header.numVertices * 3, 0);
+
+    numFrames = 0;
+    numBytes = offsets.back();
+    numRawBytes = 0;
+    bRecording = true;
+    return true;
+}
+
+//--------------------------------------------------------------
+void MeshRecorder::addFrame(const ofMesh& mesh){
+
+    if(!bRecording) return;
+
+    if(mesh.getNumVertices() != header.numVertices){
+        ofLogWarning("MeshRecorder") << "the mesh went from " << header.numVertices << " to " << mesh.getNumVertices() << " vertices, stopping the recording";
+        stop();
+        return;
+    }
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    bool bKeyframe = numFrames % header.keyframeInterval == 0;
+    size_t numVerts = header.numVertices;
+    size_t numBlocks = (numVerts + blockSize - 1) / blockSize;
+
+    quantized.resize(numVerts * 3);
+    blocks.resize(numBlocks);
+
+    const ofVec3f* verts = mesh.getVertices().data();
+    float scale = 1 / header.step;
+
+    TaskScheduler::get().parallelFor(0, numBlocks, 1, [&](size_t first, size_t last){
+
+        vector<unsigned char> varints;
+
+        for(size_t b = first; b < last; b++){
+            size_t begin = b * blockSize;
+            size_t end = min(begin + blockSize, numVerts);
+
+            varints.clear();
+            for(size_t i = begin; i < end; i++){
+                for(int k = 0; k < 3; k++){
+                    int32_t q = (int32_t)floor((verts[i][k] - header.origin[k]) * scale + 0.5f);
+
+                    //a keyframe stores the step from the vertex before (starting over
+                    //in every block), everything else how far it moved since last frame
+                    int32_t predicted;
+                    if(bKeyframe){
+                        predicted = i > begin ? quantized[(i - 1) * 3 + k] : 0;
+                    } else {
+                        predicted = previous[i * 3 + k];
+                    }
+
+                    quantized[i * 3 + k] = q;
+                    EntropyCoder::appendVarint(q - predicted, varints);
+                }
+            }
+
+            blocks[b].clear();
+            EntropyCoder::encode(varints.data(), varints.size(), blocks[b]);
+        }
+    });
+
+    previous.swap(quantized);
+
+    //the frame: whether it's a keyframe, the size of each block, then the blocks
+    unsigned char type = bKeyframe ? 1 : 0;
+    uint32_t count = numBlocks;
+    file.write((const char*)&type, 1);
+    file.write((const char*)&count, 4);
+    for(const vector<unsigned char>& block : blocks){
+        uint32_t size = block.size();
+        file.write((const char*)&size, 4);
+    }
+    for(const vector<unsigned char>& block : blocks){
+        file.write((const char*)block.data(), block.size());
+    }
+
+    offsets.push_back(file.tellp());
+    numFrames++;
+    numBytes = offsets.back();
+    numRawBytes += numVerts * sizeof(ofVec3f);
+
+    lastEncodeTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+void MeshRecorder::stop(){
+
+    if(!bRecording) return;
+    bRecording = false;
+
+    //the index: how many frames, where each one starts (and the last one ends).
+    //Then where the index is, so the player can find it from the end of the file
+    uint64_t indexOffset = file.tellp();
+    uint32_t count = numFrames;
+    file.write((const char*)&count, 4);
+    file.write((const char*)offsets.data(), offsets.size() * sizeof(uint64_t));
+    file.write((const char*)&indexOffset, 8);
+    file.write("MEND", 4);
+
+    numBytes = file.tellp();
+    file.close();
+
+    ofLogNotice("MeshRecorder") << numFrames << " frames of " << header.numVertices << " vertices, " << numBytes / 1024 << " KB (" << getCompressionRatio() << " times smaller than the floats)";
+}
+
+//--------------------------------------------------------------
+float MeshRecorder::getCompressionRatio() const{
+    uint64_t frameBytes = offsets.empty() ? 0 : offsets.back() - offsets.front();
+    return frameBytes > 0 ? numRawBytes / (double)frameBytes : 0;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Records the vertices of a mesh that's animated live (noise, physics, a
+ * pulse...) to a file, so the performance can be played back exactly the same
+ * later with MeshPlayer, on a machine that couldn't generate it in real time.
+ *
+ * Raw, every frame would be 12 bytes per vertex. Instead each frame is:
+ *
+ *  - quantized: positions snapped to a grid (by default 1/65536 of the first
+ *    frame's size) and stored as whole numbers. That's the only loss
+ *  - delta encoded: most vertices only move a little from one frame to the
+ *    next, so each one is stored as how far it moved since the last frame.
+ *    Every keyframeInterval frames there's a keyframe that doesn't depend on
+ *    the frames before it (each vertex is stored as the step from the one
+ *    before it instead), so playback can jump anywhere without decoding the
+ *    whole file from the start
+ *  - entropy coded: the small numbers are packed with EntropyCoder
+ *
+ * The deltas are taken from the quantized previous frame (what the player will
+ * have), not the real one, so rounding errors don't build up over time.
+ *
+ * The vertices are cut into blocks that are encoded (and decoded) on all the cores.
+ * The file ends with an index of where each frame starts, written by stop().
+ *
+ * Only positions are recorded: the mesh's indices, normals, texcoords and colors
+ * are whatever the sketch set up, and they have to stay the same size.
+ */
+
+class MeshRecorder {
+
+	public:
+
+    //at the start of the file
+    struct Header {
+        char magic[4];              //"MREC"
+        uint32_t version;
+        uint32_t numVertices;
+        uint32_t keyframeInterval;
+        float step;                 //size of a grid step
+        float origin[3];            //where the grid's 0, 0, 0 is
+    };
+
+    //vertices in a block that's encoded on its own
+    static const size_t blockSize = 16384;
+
+    //what goes in Header::version. 1 was before the frames were entropy coded,
+    //those recordings can't be played back any more
+    static const uint32_t version = 2;
+
+    MeshRecorder();
+
+    //finishes the file if it's still recording
+    ~MeshRecorder();
+
+    //start a new recording of this mesh. precision is the most a position may be
+    //off by when it's played back (0 picks one from the mesh's size)
+    bool start(const string& path, const ofMesh& mesh, float precision = 0, int keyframeInterval = 30);
+
+    //add the mesh's current vertices as the next frame
+    void addFrame(const ofMesh& mesh);
+
+    //write the index and close the file
+    void stop();
+
+    bool isRecording() const { return bRecording; }
+    size_t getNumFrames() const { return numFrames; }
+
+    //the file so far, and how many times smaller it is than the raw floats
+    uint64_t getNumBytes() const { return numBytes; }
+    float getCompressionRatio() const;
+
+    float getLastEncodeTimeMs() const { return lastEncodeTimeMs; }
+
+    private:
+
+    ofstream file;
+    Header header;
+    bool bRecording;
+
+    //the last frame, quantized. Also where the new one is quantized into
+    vector<int32_t> previous;
+    vector<int32_t> quantized;
+    vector<vector<unsigned char> > blocks;
+
+    //where each frame starts in the file (and where the last one ends)
+    vector<uint64_t> offsets;
+
+    size_t numFrames;
+    uint64_t numBytes;
+    uint64_t numRawBytes;
+    float lastEncodeTimeMs;
+};
@@ -0,0 +1,92 @@
+#include "MeshUtils.h"
+
+//--------------------------------------------------------------
+bool MeshUtils::getTriangleIndices(const ofMesh& mesh, vector<ofIndexType>& triangles){
+
+    triangles.clear();
+
+    //without indices the vertices are used in order, 0, 1, 2, 3...
+    size_t count = mesh.hasIndices() ? mesh.getNumIndices() : mesh.getNumVertices();
+    const vector<ofIndexType>& indices = mesh.getIndices();
+    bool bIndexed = mesh.hasIndices();
+
+    auto index = [&](size_t i){
+        return bIndexed ? indices[i] : (ofIndexType)i;
+    };
+
+    switch(mesh.getMode()){
+
+        case OF_PRIMITIVE_TRIANGLES:
+            triangles.reserve(count);
+            for(size_t i = 0; i + 2 < count; i += 3){
+                triangles.push_back(index(i));
+                triangles.push_back(index(i + 1));
+                triangles.push_back(index(i + 2));
+            }
+            break;
+
+        case OF_PRIMITIVE_TRIANGLE_STRIP:
+            //every new index makes a triangle with the previous two,
+            //flipping every other one to keep the winding the same.
+            //Strips joined with repeated indices make degenerate triangles, skip those
+            triangles.reserve(count * 3);
+            for(size_t i = 2; i < count; i++){
+                ofIndexType a = index(i - 2);
+                ofIndexType b = index(i - 1);
+                ofIndexType c = index(i);
+                if(a == b || b == c || a == c) continue;
+
+                if(i % 2 == 0){
+                    triangles.push_back(a);
+                    triangles.push_back(b);
+                } else {
+                    triangles.push_back(b);
+                    triangles.push_back(a);
+                }
+                triangles.push_back(c);
+            }
+            break;
+
+        case OF_PRIMITIVE_TRIANGLE_FAN:
+            //every triangle shares the very first vertex
+            triangles.reserve(count * 3);
+            for(size_t i = 2; i < count; i++){
+                triangles.push_back(index(0));
+                triangles.push_back(index(i - 1));
+                triangles.push_back(index(i));
+            }
+            break;
+
+        default:
+            return false;
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------
+void MeshUtils::computeNormals(ofMesh& mesh){
+
+    vector<ofIndexType> triangles;
+    if(!getTriangleIndices(mesh, triangles)) return;
+
+    const vector<ofVec3f>& verts = mesh.getVertices();
+    vector<ofVec3f>& normals = mesh.getNormals();
+    normals.assign(verts.size(), ofVec3f(0, 0, 0));
+
+    //the cross product is as long as twice the triangle's area,
+    //so adding them up as they are is what weights them by size
+    for(size_t i = 0; i + 2 < triangles.size(); i += 3){
+        ofIndexType a = triangles[i], b = triangles[i + 1], c = triangles[i + 2];
+        if(a >= verts.size() || b >= verts.size() || c >= verts.size()) continue;
+
+        ofVec3f normal = (verts[b] - verts[a]).getCrossed(verts[c] - verts[a]);
+        normals[a] += normal;
+        normals[b] += normal;
+        normals[c] += normal;
+    }
+
+    for(ofVec3f& normal : normals){
+        normal.normalize();
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ofMain.h"
+#include "TaskScheduler.h"
+
+/*
+ * Small helpers shared by the mesh processing classes in this folder.
+ */
+
+namespace MeshUtils {
+
+    //fill "triangles" with 3 indices per triangle no matter how the mesh is
+    //assembled (TRIANGLES, TRIANGLE_STRIP or TRIANGLE_FAN, with or without indices).
+    //Returns false if the mesh isn't made of triangles at all
+    bool getTriangleIndices(const ofMesh& mesh, vector<ofIndexType>& triangles);
+
+    //smooth normals for a mesh that came without any: every vertex gets the
+    //average of the triangles around it, bigger triangles counting for more
+    void computeNormals(ofMesh& mesh);
+
+    //std::sort on all the cores: every thread sorts a piece, then the pieces
+    //are merged two at a time (the pairs side by side) until there's one left.
+    //Only the first "count" values are sorted, the rest is left alone
+    template<typename T, typename Compare>
+    void parallelSort(vector<T>& values, size_t count, Compare less){
+
+        TaskScheduler& scheduler = TaskScheduler::get();
+        size_t numPieces = scheduler.getNumThreads();
+        if(numPieces == 1 || count < 4096){
+            std::sort(values.begin(), values.begin() + count, less);
+            return;
+        }
+
+        size_t pieceSize = (count + numPieces - 1) / numPieces;
+        scheduler.parallelFor(0, numPieces, 1, [&](size_t begin, size_t end){
+            for(size_t p = begin; p < end; p++){
+                size_t first = min(p * pieceSize, count);
+                size_t last = min(first + pieceSize, count);
+                std::sort(values.begin() + first, values.begin() + last, less);
+            }
+        });
+
+        for(size_t width = pieceSize; width < count; width *= 2){
+            size_t numPairs = (count + width * 2 - 1) / (width * 2);
+            scheduler.parallelFor(0, numPairs, 1, [&](size_t begin, size_t end){
+                for(size_t p = begin; p < end; p++){
+                    size_t first = p * width * 2;
+                    size_t mid = min(first + width, count);
+                    size_t last = min(first + width * 2, count);
+                    std::inplace_merge(values.begin() + first, values.begin() + mid, values.begin() + last, less);
+                }
+            });
+        }
+    }
+
+    template<typename T, typename Compare>
+    void parallelSort(vector<T>& values, Compare less){
+        parallelSort(values, values.size(), less);
+    }
+
+    template<typename T>
+    void parallelSort(vector<T>& values){
+        parallelSort(values, std::less<T>());
+    }
+
+}
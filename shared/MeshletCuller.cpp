@@ -0,0 +1,227 @@
+#include "MeshletCuller.h"
+#include "MeshUtils.h"
+
+//--------------------------------------------------------------
+MeshletCuller::MeshletCuller(){
+    bConeCulling = false;
+    culledPercent = 0;
+    lastCullTimeMs = 0;
+    numFrustumCulled = 0;
+    numConeCulled = 0;
+}
+
+//--------------------------------------------------------------
+void MeshletCuller::setup(const ofMesh& mesh, unsigned maxTriangles, unsigned maxVertices){
+
+    meshlets.clear();
+    indices.clear();
+
+    vector<ofIndexType> triangles;
+    if(!MeshUtils::getTriangleIndices(mesh, triangles)){
+        ofLogWarning("MeshletCuller") << "setup(): mesh isn't made of triangles";
+        return;
+    }
+
+    size_t numTris = triangles.size() / 3;
+    size_t numVerts = mesh.getNumVertices();
+
+    //---- triangle neighbors across each edge
+    //sort the edges so the two triangles sharing one end up side by side
+    vector<pair<uint64_t, unsigned> > edges(numTris * 3);
+    for(size_t t = 0; t < numTris; t++){
+        for(int k = 0; k < 3; k++){
+            uint64_t a = triangles[t * 3 + k];
+            uint64_t b = triangles[t * 3 + (k + 1) % 3];
+            edges[t * 3 + k] = make_pair(a < b ? (a << 32) | b : (b << 32) | a, (unsigned)t);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    vector<int> neighbors(numTris * 3, -1);
+    vector<unsigned char> numNeighbors(numTris, 0);
+    for(size_t i = 1; i < edges.size(); i++){
+        if(edges[i].first != edges[i - 1].first) continue;
+
+        unsigned a = edges[i - 1].second;
+        unsigned b = edges[i].second;
+        if(numNeighbors[a] < 3) neighbors[a * 3 + numNeighbors[a]++] = b;
+        if(numNeighbors[b] < 3) neighbors[b * 3 + numNeighbors[b]++] = a;
+    }
+
+    //---- grow meshlets
+    //start from the first unused triangle and keep adding neighbors (breadth first)
+    //until we run out of room for triangles or vertices
+    vector<unsigned char> used(numTris, 0);
+    vector<unsigned> vertexMark(numVerts, 0);
+    unsigned meshletStamp = 0;
+    vector<unsigned> queue;
+
+    indices.reserve(triangles.size());
+
+    for(size_t seed = 0; seed < numTris; seed++){
+
+        if(used[seed]) continue;
+
+        Meshlet meshlet;
+        meshlet.firstIndex = indices.size();
+        meshlet.numTriangles = 0;
+        meshlet.numVertices = 0;
+
+        meshletStamp++;
+        queue.clear();
+        queue.push_back(seed);
+
+        for(size_t q = 0; q < queue.size() && meshlet.numTriangles < maxTriangles; q++){
+
+            unsigned t = queue[q];
+            if(used[t]) continue;
+
+            //how many new vertices would this triangle bring in?
+            unsigned newVerts = 0;
+            for(int k = 0; k < 3; k++){
+                if(vertexMark[triangles[t * 3 + k]] != meshletStamp) newVerts++;
+            }
+            if(meshlet.numVertices + newVerts > maxVertices) continue;
+
+            used[t] = 1;
+            for(int k = 0; k < 3; k++){
+                ofIndexType v = triangles[t * 3 + k];
+                vertexMark[v] = meshletStamp;
+                indices.push_back(v);
+            }
+            meshlet.numVertices += newVerts;
+            meshlet.numTriangles++;
+
+            for(int k = 0; k < numNeighbors[t]; k++){
+                if(!used[neighbors[t * 3 + k]]) queue.push_back(neighbors[t * 3 + k]);
+            }
+        }
+
+        meshlets.push_back(meshlet);
+    }
+
+    updateBounds(mesh);
+}
+
+//--------------------------------------------------------------
+void MeshletCuller::updateBounds(const ofMesh& mesh){
+
+    const vector<ofVec3f>& verts = mesh.getVertices();
+    bool bNormals = mesh.getNumNormals() == verts.size();
+
+    for(Meshlet& meshlet : meshlets){
+
+        const ofIndexType* tri = &indices[meshlet.firstIndex];
+        size_t count = meshlet.numTriangles * 3;
+
+        //sphere around the center of the bounding box
+        ofVec3f minP = verts[tri[0]];
+        ofVec3f maxP = minP;
+        for(size_t i = 1; i < count; i++){
+            const ofVec3f& p = verts[tri[i]];
+            minP.set(min(minP.x, p.x), min(minP.y, p.y), min(minP.z, p.z));
+            maxP.set(max(maxP.x, p.x), max(maxP.y, p.y), max(maxP.z, p.z));
+        }
+        meshlet.center = (minP + maxP) * 0.5;
+
+        float radiusSq = 0;
+        for(size_t i = 0; i < count; i++){
+            radiusSq = max(radiusSq, verts[tri[i]].squareDistance(meshlet.center));
+        }
+        meshlet.radius = sqrt(radiusSq);
+
+        //cone: average facing direction of the triangles
+        //and the widest angle any of them makes with it
+        faceNormals.resize(meshlet.numTriangles);
+        ofVec3f axis;
+
+        for(unsigned t = 0; t < meshlet.numTriangles; t++){
+            const ofVec3f& a = verts[tri[t * 3 + 0]];
+            const ofVec3f& b = verts[tri[t * 3 + 1]];
+            const ofVec3f& c = verts[tri[t * 3 + 2]];
+            ofVec3f n = (b - a).getCrossed(c - a).getNormalized();
+
+            //let the vertex normals decide which side is the outside
+            //so the result doesn't depend on the winding order
+            if(bNormals){
+                ofVec3f vn = mesh.getNormals()[tri[t * 3]] + mesh.getNormals()[tri[t * 3 + 1]] + mesh.getNormals()[tri[t * 3 + 2]];
+                if(n.dot(vn) < 0) n = -n;
+            }
+
+            faceNormals[t] = n;
+            axis += n;
+        }
+
+        meshlet.coneAxis = axis.getNormalized();
+
+        float minDot = 1;
+        for(unsigned t = 0; t < meshlet.numTriangles; t++){
+            minDot = min(minDot, faceNormals[t].dot(meshlet.coneAxis));
+        }
+
+        //if the triangles point more than 90 degrees apart there's
+        //no direction they all face away from
+        meshlet.coneCutoff = minDot <= 0 ? 1 : sqrt(1 - minDot * minDot);
+    }
+}
+
+//--------------------------------------------------------------
+size_t MeshletCuller::cull(const ofCamera& cam, const ofRectangle& viewport, vector<ofIndexType>& visibleIndices){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    //pull the 6 frustum planes straight out of the view-projection matrix.
+    //OF multiplies points as rows (p * M), so clip coordinate j is column j
+    ofMatrix4x4 m = cam.getModelViewProjectionMatrix(viewport);
+    ofVec4f planes[6];
+    for(int i = 0; i < 3; i++){
+        planes[i * 2 + 0] = ofVec4f(m(0, 3) + m(0, i), m(1, 3) + m(1, i), m(2, 3) + m(2, i), m(3, 3) + m(3, i));
+        planes[i * 2 + 1] = ofVec4f(m(0, 3) - m(0, i), m(1, 3) - m(1, i), m(2, 3) - m(2, i), m(3, 3) - m(3, i));
+    }
+    for(int i = 0; i < 6; i++){
+        float len = ofVec3f(planes[i].x, planes[i].y, planes[i].z).length();
+        planes[i].x /= len;
+        planes[i].y /= len;
+        planes[i].z /= len;
+        planes[i].w /= len;
+    }
+
+    ofVec3f camPos = cam.getGlobalPosition();
+
+    visibleIndices.clear();
+    numFrustumCulled = 0;
+    numConeCulled = 0;
+    size_t numVisible = 0;
+
+    for(const Meshlet& meshlet : meshlets){
+
+        //outside if the whole sphere is behind any one plane
+        bool outside = false;
+        for(int i = 0; i < 6 && !outside; i++){
+            float dist = planes[i].x * meshlet.center.x + planes[i].y * meshlet.center.y + planes[i].z * meshlet.center.z + planes[i].w;
+            outside = dist < -meshlet.radius;
+        }
+        if(outside){
+            numFrustumCulled++;
+            continue;
+        }
+
+        //facing away if the camera is inside the "back" cone of the meshlet,
+        //padded by the sphere radius since the cone starts from the whole cluster
+        if(bConeCulling){
+            ofVec3f toMeshlet = meshlet.center - camPos;
+            if(toMeshlet.dot(meshlet.coneAxis) >= meshlet.coneCutoff * toMeshlet.length() + meshlet.radius){
+                numConeCulled++;
+                continue;
+            }
+        }
+
+        visibleIndices.insert(visibleIndices.end(), indices.begin() + meshlet.firstIndex, indices.begin() + meshlet.firstIndex + meshlet.numTriangles * 3);
+        numVisible++;
+    }
+
+    culledPercent = meshlets.empty() ? 0 : 100.0 * (meshlets.size() - numVisible) / meshlets.size();
+    lastCullTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+
+    return numVisible;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Splits a triangle mesh into "meshlets": small clusters of neighboring triangles
+ * (up to 124 triangles / 64 vertices by default). Each meshlet gets a bounding
+ * sphere and a normal cone (the average direction its triangles face plus how much
+ * they spread out from it).
+ *
+ * Every frame the culler checks each meshlet against the camera:
+ *  - frustum: is the bounding sphere outside any of the 6 planes of the view?
+ *  - cone: are ALL the triangles facing away from the camera? (closed shapes only,
+ *    a flat plane is seen from both sides since OF doesn't cull back faces)
+ *
+ * The triangles of the meshlets that survive are written into one compact index
+ * list that can be handed straight to the mesh to draw.
+ *
+ * The meshes are assumed to be drawn without any extra transform inside the camera
+ * (like all the sketches here), so mesh space is world space.
+ */
+
+class MeshletCuller {
+
+	public:
+
+    struct Meshlet {
+        unsigned firstIndex;    //into getIndices()
+        unsigned numTriangles;
+        unsigned numVertices;
+
+        ofVec3f center;
+        float radius;
+
+        ofVec3f coneAxis;
+        float coneCutoff;       //1 means the triangles spread too much to ever cull
+    };
+
+    MeshletCuller();
+
+    //cluster the triangles of the mesh. Call again if the topology changes
+    void setup(const ofMesh& mesh, unsigned maxTriangles = 124, unsigned maxVertices = 64);
+
+    //recompute the spheres and cones from the current vertex positions.
+    //Call this every frame for meshes that are deformed
+    void updateBounds(const ofMesh& mesh);
+
+    //test every meshlet against the camera and fill visibleIndices with
+    //the triangles of the visible ones. Returns the number of visible meshlets
+    size_t cull(const ofCamera& cam, const ofRectangle& viewport, vector<ofIndexType>& visibleIndices);
+
+    void setConeCulling(bool enable) { bConeCulling = enable; }
+
+    const vector<Meshlet>& getMeshlets() const { return meshlets; }
+
+    //all the triangles, reordered meshlet by meshlet
+    const vector<ofIndexType>& getIndices() const { return indices; }
+
+    //stats from the last cull()
+    float getCulledPercent() const { return culledPercent; }
+    float getLastCullTimeMs() const { return lastCullTimeMs; }
+    size_t getNumFrustumCulled() const { return numFrustumCulled; }
+    size_t getNumConeCulled() const { return numConeCulled; }
+
+    private:
+
+    vector<Meshlet> meshlets;
+    vector<ofIndexType> indices;
+    vector<ofVec3f> faceNormals;
+
+    bool bConeCulling;
+
+    float culledPercent;
+    float lastCullTimeMs;
+    size_t numFrustumCulled;
+    size_t numConeCulled;
+};
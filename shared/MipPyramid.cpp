@@ -0,0 +1,400 @@
+#include "MipPyramid.h"
+#include "TaskScheduler.h"
+
+//the cache file starts with this, then a version number
+static const char cacheMagic[4] = {'M', 'I', 'P', 'S'};
+static const uint32_t cacheVersion = 1;
+
+//lookup tables between gamma encoded (sRGB) bytes and linear light, and
+//the same for alpha which is just scaled. Going through a table for every
+//channel means the loops never have to check which one they're on
+struct GammaTables {
+
+    float toLinear[256];
+    float alphaToFloat[256];
+
+    //indexed by linear * (size - 1). Fine enough that every sRGB value
+    //except the very darkest gets its own entries
+    static const int gammaSize = 4096;
+    unsigned char toGamma[gammaSize];
+    unsigned char alphaToByte[gammaSize];
+
+    GammaTables(){
+        for(int i = 0; i < 256; i++){
+            float c = i / 255.0f;
+            toLinear[i] = c <= 0.04045f ? c / 12.92f : pow((c + 0.055f) / 1.055f, 2.4f);
+            alphaToFloat[i] = c;
+        }
+        for(int i = 0; i < gammaSize; i++){
+            float c = i / float(gammaSize - 1);
+            float encoded = c <= 0.0031308f ? c * 12.92f : 1.055f * pow(c, 1 / 2.4f) - 0.055f;
+            toGamma[i] = ofClamp(encoded * 255 + 0.5f, 0, 255);
+            alphaToByte[i] = c * 255 + 0.5f;
+        }
+    }
+};
+
+static const GammaTables& getGammaTables(){
+    static GammaTables tables;
+    return tables;
+}
+
+//is this channel alpha (linear already) rather than a color?
+static bool isAlphaChannel(int channel, int numChannels){
+    return (numChannels == 4 && channel == 3) || (numChannels == 2 && channel == 1);
+}
+
+//taps for halving an image, centered between the two pixels that become one.
+//Box is just those two. Kaiser is sinc (the ideal low pass filter for half
+//the resolution) faded out over 4 pixels each way by a Kaiser window
+static vector<float> getTaps(MipPyramid::Filter filter){
+
+    vector<float> taps;
+    if(filter == MipPyramid::BOX){
+        taps.assign(2, 0.5f);
+        return taps;
+    }
+
+    //zeroth order modified Bessel function, the series converges quickly
+    auto bessel0 = [](float x){
+        float sum = 1, term = 1;
+        for(int k = 1; k < 20; k++){
+            term *= (x / (2 * k)) * (x / (2 * k));
+            sum += term;
+        }
+        return sum;
+    };
+
+    const int numTaps = 8;
+    const float alpha = 4;
+    float total = 0;
+    for(int t = 0; t < numTaps; t++){
+
+        //distance from the center in source pixels: -3.5 ... 3.5
+        float d = t - (numTaps - 1) * 0.5f;
+
+        float x = d * 0.5f * PI;
+        float sinc = x == 0 ? 1 : sin(x) / x;
+
+        float r = d / (numTaps * 0.5f);
+        float window = bessel0(alpha * sqrt(max(0.0f, 1 - r * r))) / bessel0(alpha);
+
+        taps.push_back(sinc * window);
+        total += taps.back();
+    }
+
+    //add up to 1 so flat areas stay exactly the same brightness
+    for(float& tap : taps){
+        tap /= total;
+    }
+    return taps;
+}
+
+//a quick hash of the file's bytes (64 bit FNV-1a) for naming the cache
+static uint64_t hashBytes(const char* bytes, size_t numBytes){
+    uint64_t hash = 14695981039346656037ULL;
+    for(size_t i = 0; i < numBytes; i++){
+        hash ^= (unsigned char)bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+//horizontal pass over rows [begin, end): every row gets half as wide.
+//Each row is copied with the border pixels repeated past both ends first,
+//so the taps never have to check if they've run off the edge. Rows come
+//either from the image's bytes (through the gamma tables) or from floats.
+//The number of channels is a template parameter so the inner loops unroll
+template<int nc>
+static void filterRows(const unsigned char* srcBytes, const float* srcData, int srcWidth, float* dstData, int dstWidth,
+                       const vector<float>& taps, int firstTap, const float* const* toFloat, size_t begin, size_t end){
+
+    int numTaps = taps.size();
+    int paddedWidth = firstTap + 2 * dstWidth + numTaps;
+    vector<float> padded(paddedWidth * nc);
+
+    for(size_t y = begin; y < end; y++){
+
+        for(int x = 0; x < paddedWidth; x++){
+            int sx = min(max(x - firstTap, 0), srcWidth - 1);
+            size_t i = (y * srcWidth + sx) * nc;
+            for(int c = 0; c < nc; c++){
+                padded[x * nc + c] = srcBytes ? toFloat[c][srcBytes[i + c]] : srcData[i + c];
+            }
+        }
+
+        float* out = dstData + y * dstWidth * nc;
+        for(int x = 0; x < dstWidth; x++){
+            const float* p = &padded[2 * x * nc];
+            float sum[nc];
+            for(int c = 0; c < nc; c++){
+                sum[c] = 0;
+            }
+            for(int t = 0; t < numTaps; t++){
+                for(int c = 0; c < nc; c++){
+                    sum[c] += taps[t] * p[t * nc + c];
+                }
+            }
+            for(int c = 0; c < nc; c++){
+                out[x * nc + c] = sum[c];
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------
+MipPyramid::MipPyramid(){
+    numChannels = 0;
+    lastBuildTimeMs = 0;
+    bFromCache = false;
+}
+
+//--------------------------------------------------------------
+void MipPyramid::build(const ofPixels& image, Filter filter){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    levels.clear();
+    bFromCache = false;
+
+    numChannels = image.getNumChannels();
+    if(!image.isAllocated() || numChannels < 1 || numChannels > 4){
+        ofLogWarning("MipPyramid") << "build(): needs an 8 bit image with 1 to 4 channels";
+        return;
+    }
+
+    //the image itself is the first level. Filtering starts from its bytes,
+    //converted to linear light a row at a time as they're read, instead of
+    //making a float copy of the whole (big) image first
+    levels.push_back(image);
+
+    Level current;
+    current.width = image.getWidth();
+    current.height = image.getHeight();
+    current.bytes = image.getData();
+
+    vector<float> taps = getTaps(filter);
+
+    //halve it until there's 1 pixel left. The float levels and the scratch
+    //space for the horizontal pass only get smaller so they're allocated once
+    Level next;
+    vector<float> scratch;
+    while(current.width > 1 || current.height > 1){
+        downsample(current, next, taps, scratch);
+        levels.push_back(ofPixels());
+        encode(next, levels.back());
+        swap(current, next);
+    }
+
+    lastBuildTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+void MipPyramid::downsample(const Level& src, Level& dst, const vector<float>& taps, vector<float>& scratch) const{
+
+    dst.width = max(1, src.width / 2);
+    dst.height = max(1, src.height / 2);
+    dst.bytes = nullptr;
+
+    int numTaps = taps.size();
+
+    //destination pixel x sits between source pixels 2x and 2x + 1,
+    //so its taps start this far to the left of 2x
+    int firstTap = numTaps / 2 - 1;
+
+    TaskScheduler& scheduler = TaskScheduler::get();
+
+    //horizontal pass into the scratch space: same number of rows, half as wide
+    scratch.resize(dst.width * src.height * numChannels);
+    float* halfWidth = scratch.data();
+    int nc = numChannels;
+
+    //the image's bytes go through the gamma tables on the way in
+    const GammaTables& gamma = getGammaTables();
+    const float* toFloat[4];
+    for(int c = 0; c < nc; c++){
+        toFloat[c] = isAlphaChannel(c, nc) ? gamma.alphaToFloat : gamma.toLinear;
+    }
+
+    const float* srcData = src.bytes ? nullptr : src.data.data();
+    scheduler.parallelFor(0, src.height, 16, [&](size_t begin, size_t end){
+        switch(nc){
+            case 1: filterRows<1>(src.bytes, srcData, src.width, halfWidth, dst.width, taps, firstTap, toFloat, begin, end); break;
+            case 2: filterRows<2>(src.bytes, srcData, src.width, halfWidth, dst.width, taps, firstTap, toFloat, begin, end); break;
+            case 3: filterRows<3>(src.bytes, srcData, src.width, halfWidth, dst.width, taps, firstTap, toFloat, begin, end); break;
+            case 4: filterRows<4>(src.bytes, srcData, src.width, halfWidth, dst.width, taps, firstTap, toFloat, begin, end); break;
+        }
+    });
+
+    //vertical pass: each destination row is a weighted sum of whole source rows,
+    //one long multiply add over contiguous floats per tap
+    dst.data.assign(dst.width * dst.height * nc, 0);
+    size_t rowSize = dst.width * nc;
+
+    scheduler.parallelFor(0, dst.height, 8, [&](size_t begin, size_t end){
+        for(size_t y = begin; y < end; y++){
+            float* out = &dst.data[y * rowSize];
+
+            for(int t = 0; t < numTaps; t++){
+                int sy = min(max(2 * (int)y - firstTap + t, 0), src.height - 1);
+                const float* in = &halfWidth[sy * rowSize];
+                float weight = taps[t];
+                for(size_t i = 0; i < rowSize; i++){
+                    out[i] += weight * in[i];
+                }
+            }
+        }
+    });
+}
+
+//--------------------------------------------------------------
+void MipPyramid::encode(const Level& level, ofPixels& pixels) const{
+
+    pixels.allocate(level.width, level.height, numChannels);
+    unsigned char* out = pixels.getData();
+
+    const GammaTables& gamma = getGammaTables();
+    const unsigned char* toByte[4];
+    for(int c = 0; c < numChannels; c++){
+        toByte[c] = isAlphaChannel(c, numChannels) ? gamma.alphaToByte : gamma.toGamma;
+    }
+
+    const float maxIndex = GammaTables::gammaSize - 1;
+    int nc = numChannels;
+
+    //the sinc's negative lobes can overshoot a little past 0 and 1, hence the clamps
+    TaskScheduler::get().parallelFor(0, level.height, 16, [&](size_t begin, size_t end){
+        for(size_t y = begin; y < end; y++){
+            const float* in = &level.data[y * level.width * nc];
+            unsigned char* row = out + y * level.width * nc;
+            for(int x = 0; x < level.width; x++){
+                for(int c = 0; c < nc; c++){
+                    float v = in[x * nc + c];
+                    v = v < 0 ? 0 : (v > 1 ? 1 : v);
+                    row[x * nc + c] = toByte[c][int(v * maxIndex + 0.5f)];
+                }
+            }
+        }
+    });
+}
+
+//--------------------------------------------------------------
+bool MipPyramid::loadOrBuild(const string& imagePath, const ofPixels& image, Filter filter, const string& cacheFolder){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    //the cache is named after what's in the file, not when it was changed,
+    //so copying the project around doesn't make it stale
+    ofBuffer file = ofBufferFromFile(imagePath, true);
+    uint64_t hash = hashBytes(file.getData(), file.size());
+
+    string cachePath = cacheFolder + "/" + ofFilePath::getBaseName(imagePath) + "-" + ofToHex(hash) + (filter == BOX ? "-box" : "-kaiser") + ".mip";
+
+    if(loadCache(cachePath) && (int)levels[0].getWidth() == (int)image.getWidth() && (int)levels[0].getHeight() == (int)image.getHeight()){
+        bFromCache = true;
+        lastBuildTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+        return true;
+    }
+
+    build(image, filter);
+
+    if(!levels.empty()){
+        ofDirectory::createDirectory(cacheFolder, true, true);
+        saveCache(cachePath);
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+bool MipPyramid::loadCache(const string& path){
+
+    ifstream file(ofToDataPath(path).c_str(), ios::binary);
+    if(!file) return false;
+
+    char magic[4];
+    uint32_t header[3];
+    if(!file.read(magic, 4) || !file.read((char*)header, sizeof(header))) return false;
+    if(string(magic, 4) != string(cacheMagic, 4) || header[0] != cacheVersion) return false;
+
+    int channels = header[1];
+    int numLevels = header[2];
+    if(channels < 1 || channels > 4 || numLevels < 1 || numLevels > 32) return false;
+
+    vector<ofPixels> loaded(numLevels);
+    for(ofPixels& level : loaded){
+        uint32_t size[2];
+        if(!file.read((char*)size, sizeof(size)) || size[0] == 0 || size[1] == 0) return false;
+        level.allocate(size[0], size[1], channels);
+        if(!file.read((char*)level.getData(), size[0] * size[1] * channels)) return false;
+    }
+
+    levels.swap(loaded);
+    numChannels = channels;
+    return true;
+}
+
+//--------------------------------------------------------------
+void MipPyramid::saveCache(const string& path) const{
+
+    ofstream file(ofToDataPath(path).c_str(), ios::binary);
+    uint32_t header[3] = {cacheVersion, (uint32_t)numChannels, (uint32_t)levels.size()};
+    file.write(cacheMagic, 4);
+    file.write((const char*)header, sizeof(header));
+
+    for(const ofPixels& level : levels){
+        uint32_t size[2] = {(uint32_t)level.getWidth(), (uint32_t)level.getHeight()};
+        file.write((const char*)size, sizeof(size));
+        file.write((const char*)level.getData(), size[0] * size[1] * numChannels);
+    }
+
+    if(!file){
+        ofLogWarning("MipPyramid") << "couldn't write the cache to " << path;
+    }
+}
+
+//--------------------------------------------------------------
+void MipPyramid::upload(ofTexture& texture) const{
+
+    if(levels.empty()) return;
+
+    const ofPixels& base = levels[0];
+    int glInternalFormat = ofGetGLInternalFormat(base);
+    int glFormat = ofGetGLFormat(base);
+
+    //rectangle (ARB) textures can't have mipmaps
+    texture.allocate(base.getWidth(), base.getHeight(), glInternalFormat, false);
+
+    const ofTextureData& data = texture.getTextureData();
+    glBindTexture(data.textureTarget, data.textureID);
+
+    //rows of odd sized levels aren't padded to 4 bytes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for(size_t i = 0; i < levels.size(); i++){
+        glTexImage2D(data.textureTarget, i, glInternalFormat, levels[i].getWidth(), levels[i].getHeight(), 0, glFormat, GL_UNSIGNED_BYTE, levels[i].getData());
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+#ifndef TARGET_OPENGLES
+    glTexParameteri(data.textureTarget, GL_TEXTURE_MAX_LEVEL, levels.size() - 1);
+#endif
+    glBindTexture(data.textureTarget, 0);
+
+    //blend between the two closest levels
+    texture.setTextureMinMagFilter(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR);
+
+    //meshes made for OF's default textures have their texcoords in pixels
+    if(ofGetUsingArbTex()){
+        ofMatrix4x4 toNormalized;
+        toNormalized.makeScaleMatrix(1.0 / base.getWidth(), 1.0 / base.getHeight(), 1);
+        texture.setTextureMatrix(toNormalized);
+    }
+}
+
+//--------------------------------------------------------------
+size_t MipPyramid::getNumBytes() const{
+    size_t numBytes = 0;
+    for(const ofPixels& level : levels){
+        numBytes += level.size();
+    }
+    return numBytes;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * A full chain of mipmaps for an image, made on the CPU: every level is half the
+ * size of the one before, down to 1 x 1. When a texture is drawn smaller than it
+ * is (the far side of a plane, the poles of a sphere) the GPU reads from the level
+ * that matches, instead of skipping over most of the pixels and sparkling.
+ *
+ * Each level is filtered down from the one before it, with either
+ *
+ *  - BOX:     the average of each 2 x 2 block. Fast, a little blurry
+ *  - KAISER:  a windowed sinc, 8 pixels wide in each direction. Sharper, and
+ *             keeps patterns that are too fine for the level from turning into
+ *             moire
+ *
+ * The averaging happens in linear light: the pixels are stored gamma encoded
+ * (sRGB), and averaging those directly makes every level darker than it should
+ * be. Alpha is already linear and is left alone.
+ *
+ * The rows of a level are filtered on all the cores. The loops run over plain
+ * float arrays so the compiler can use SIMD for them.
+ *
+ * Filtering a big photo takes a while, so loadOrBuild() keeps the finished
+ * pyramid in a cache folder in bin/data. It's named after a hash of the image
+ * file's contents, so it's found again on the next launch and ignored as soon
+ * as the image changes.
+ */
+
+class MipPyramid {
+
+	public:
+
+    enum Filter {
+        BOX,
+        KAISER
+    };
+
+    MipPyramid();
+
+    //make all the levels from the image. Works on 8 bit pixels with 1 to 4 channels
+    void build(const ofPixels& image, Filter filter = KAISER);
+
+    //the same, but read the pyramid from the cache if it was made from exactly this
+    //file (and filter) before, and save it there if it wasn't. Returns true if it came from the cache
+    bool loadOrBuild(const string& imagePath, const ofPixels& image, Filter filter = KAISER, const string& cacheFolder = "mipcache");
+
+    //allocate a (non ARB) texture with all the levels and trilinear filtering.
+    //The texture gets a texture matrix that scales pixel texcoords down to 0-1,
+    //so meshes made for OF's default (ARB) textures draw with it unchanged
+    void upload(ofTexture& texture) const;
+
+    size_t getNumLevels() const { return levels.size(); }
+    const ofPixels& getLevel(size_t level) const { return levels[level]; }
+
+    //bytes in all the levels together (about 4/3 of the image)
+    size_t getNumBytes() const;
+
+    float getLastBuildTimeMs() const { return lastBuildTimeMs; }
+    bool isFromCache() const { return bFromCache; }
+
+    private:
+
+    //linear light, floats, channels interleaved. Or the image's own
+    //(gamma encoded) bytes for the first level
+    struct Level {
+        vector<float> data;
+        const unsigned char* bytes;
+        int width, height;
+    };
+
+    //half the width and height, through the filter's taps (one pass per direction)
+    void downsample(const Level& src, Level& dst, const vector<float>& taps, vector<float>& scratch) const;
+
+    //linear floats -> gamma encoded bytes
+    void encode(const Level& level, ofPixels& pixels) const;
+
+    bool loadCache(const string& path);
+    void saveCache(const string& path) const;
+
+    vector<ofPixels> levels;
+    int numChannels;
+
+    float lastBuildTimeMs;
+    bool bFromCache;
+};
@@ -0,0 +1,215 @@
+#include "MorphTargets.h"
+#include "TaskScheduler.h"
+
+//--------------------------------------------------------------
+MorphTargets::MorphTargets(){
+    numVerts = 0;
+    lastApplyTimeMs = 0;
+}
+
+//--------------------------------------------------------------
+void MorphTargets::setup(const ofMesh& base){
+
+    numVerts = base.getNumVertices();
+    targets.clear();
+
+    //plain float arrays so blending is just adding long runs of numbers
+    basePositions.resize(numVerts * 3);
+    for(size_t i = 0; i < numVerts; i++){
+        const ofVec3f& p = base.getVertices()[i];
+        basePositions[i * 3 + 0] = p.x;
+        basePositions[i * 3 + 1] = p.y;
+        basePositions[i * 3 + 2] = p.z;
+    }
+
+    baseColors.clear();
+    if(base.getNumColors() == numVerts){
+        baseColors.resize(numVerts * 4);
+        for(size_t i = 0; i < numVerts; i++){
+            const ofFloatColor& c = base.getColors()[i];
+            baseColors[i * 4 + 0] = c.r;
+            baseColors[i * 4 + 1] = c.g;
+            baseColors[i * 4 + 2] = c.b;
+            baseColors[i * 4 + 3] = c.a;
+        }
+    }
+}
+
+//--------------------------------------------------------------
+int MorphTargets::addTarget(const ofMesh& target, float threshold){
+    targets.push_back(Target());
+    targets.back().weight = 0;
+    buildTarget(targets.back(), target, threshold);
+    return targets.size() - 1;
+}
+
+//--------------------------------------------------------------
+void MorphTargets::setTarget(int index, const ofMesh& target, float threshold){
+    if(index < 0 || index >= (int)targets.size()) return;
+    buildTarget(targets[index], target, threshold);
+}
+
+//--------------------------------------------------------------
+void MorphTargets::buildTarget(Target& t, const ofMesh& target, float threshold){
+
+    t.indices.clear();
+    t.positions.clear();
+    t.colors.clear();
+
+    if(target.getNumVertices() != numVerts){
+        ofLogWarning("MorphTargets") << "target has " << target.getNumVertices() << " vertices, the base has " << numVerts;
+        return;
+    }
+
+    bool bColors = !baseColors.empty() && target.getNumColors() == numVerts;
+
+    //find the vertices that actually changed
+    vector<unsigned> changed;
+    bool bAnyColor = false;
+
+    for(size_t i = 0; i < numVerts; i++){
+        const ofVec3f& p = target.getVertices()[i];
+        bool moved = fabs(p.x - basePositions[i * 3 + 0]) > threshold ||
+                     fabs(p.y - basePositions[i * 3 + 1]) > threshold ||
+                     fabs(p.z - basePositions[i * 3 + 2]) > threshold;
+
+        bool recolored = false;
+        if(bColors){
+            const ofFloatColor& c = target.getColors()[i];
+            for(int k = 0; k < 4; k++){
+                recolored |= fabs(c[k] - baseColors[i * 4 + k]) > threshold;
+            }
+            bAnyColor |= recolored;
+        }
+
+        if(moved || recolored) changed.push_back(i);
+    }
+
+    //if most of the mesh moves, skipping the few that don't isn't worth the indirection
+    bool bDense = changed.size() > numVerts / 2;
+    if(bDense){
+        changed.resize(numVerts);
+        for(size_t i = 0; i < numVerts; i++) changed[i] = i;
+    } else {
+        t.indices = changed;
+    }
+
+    t.positions.resize(changed.size() * 3);
+    for(size_t k = 0; k < changed.size(); k++){
+        const ofVec3f& p = target.getVertices()[changed[k]];
+        t.positions[k * 3 + 0] = p.x - basePositions[changed[k] * 3 + 0];
+        t.positions[k * 3 + 1] = p.y - basePositions[changed[k] * 3 + 1];
+        t.positions[k * 3 + 2] = p.z - basePositions[changed[k] * 3 + 2];
+    }
+
+    if(bAnyColor){
+        t.colors.resize(changed.size() * 4);
+        for(size_t k = 0; k < changed.size(); k++){
+            const ofFloatColor& c = target.getColors()[changed[k]];
+            for(int j = 0; j < 4; j++){
+                t.colors[k * 4 + j] = c[j] - baseColors[changed[k] * 4 + j];
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void MorphTargets::setWeight(int index, float weight){
+    if(index < 0 || index >= (int)targets.size()) return;
+    targets[index].weight = weight;
+}
+
+//--------------------------------------------------------------
+float MorphTargets::getWeight(int index) const{
+    if(index < 0 || index >= (int)targets.size()) return 0;
+    return targets[index].weight;
+}
+
+//--------------------------------------------------------------
+size_t MorphTargets::getNumDeltas(int index) const{
+    if(index < 0 || index >= (int)targets.size()) return 0;
+    return targets[index].positions.size() / 3;
+}
+
+//--------------------------------------------------------------
+void MorphTargets::apply(ofMesh& mesh){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    if(mesh.getNumVertices() != numVerts || numVerts == 0){
+        ofLogWarning("MorphTargets") << "apply(): the mesh doesn't have the same vertices as the base";
+        return;
+    }
+
+    //ofVec3f is 3 floats and ofFloatColor is 4 floats back to back,
+    //so the mesh's arrays can be treated as plain float arrays
+    float* outPositions = mesh.getVertices()[0].getPtr();
+    float* outColors = nullptr;
+    if(!baseColors.empty() && mesh.getNumColors() == numVerts){
+        outColors = &mesh.getColors()[0].r;
+    }
+
+    //each chunk of vertices starts from the base and adds every target that's
+    //switched on. The chunks don't overlap so they can all run at once
+    TaskScheduler::get().parallelFor(0, numVerts, 4096, [&](size_t begin, size_t end){
+
+        std::copy(basePositions.begin() + begin * 3, basePositions.begin() + end * 3, outPositions + begin * 3);
+        if(outColors){
+            std::copy(baseColors.begin() + begin * 4, baseColors.begin() + end * 4, outColors + begin * 4);
+        }
+
+        for(const Target& t : targets){
+            if(t.weight != 0) applyRange(t, outPositions, outColors, begin, end);
+        }
+    });
+
+    lastApplyTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+void MorphTargets::applyRange(const Target& t, float* outPositions, float* outColors, size_t begin, size_t end) const{
+
+    float w = t.weight;
+
+    if(t.indices.empty() && !t.positions.empty()){
+
+        //dense: one straight run of floats, no branches.
+        //This is the loop the compiler vectorizes
+        const float* delta = &t.positions[begin * 3];
+        float* out = outPositions + begin * 3;
+        size_t count = (end - begin) * 3;
+        for(size_t j = 0; j < count; j++){
+            out[j] += w * delta[j];
+        }
+
+        if(outColors && !t.colors.empty()){
+            const float* cDelta = &t.colors[begin * 4];
+            float* cOut = outColors + begin * 4;
+            size_t cCount = (end - begin) * 4;
+            for(size_t j = 0; j < cCount; j++){
+                cOut[j] += w * cDelta[j];
+            }
+        }
+        return;
+    }
+
+    //sparse: only the stored vertices that fall inside this chunk
+    size_t first = std::lower_bound(t.indices.begin(), t.indices.end(), begin) - t.indices.begin();
+    size_t last = std::lower_bound(t.indices.begin(), t.indices.end(), end) - t.indices.begin();
+
+    for(size_t k = first; k < last; k++){
+        size_t v = t.indices[k];
+        outPositions[v * 3 + 0] += w * t.positions[k * 3 + 0];
+        outPositions[v * 3 + 1] += w * t.positions[k * 3 + 1];
+        outPositions[v * 3 + 2] += w * t.positions[k * 3 + 2];
+    }
+
+    if(outColors && !t.colors.empty()){
+        for(size_t k = first; k < last; k++){
+            size_t v = t.indices[k];
+            for(int j = 0; j < 4; j++){
+                outColors[v * 4 + j] += w * t.colors[k * 4 + j];
+            }
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Morph targets (a.k.a. blend shapes): a base mesh plus any number of "targets",
+ * other poses of the same vertices. Each target is stored as the difference
+ * (delta) from the base, and every frame the mesh is rebuilt as
+ *
+ *     base + weight0 * delta0 + weight1 * delta1 + ...
+ *
+ * so sliding a weight from 0 to 1 smoothly moves the mesh from the base pose to
+ * the target, and several targets can be mixed together.
+ *
+ * Only the vertices a target actually moves are stored. A target that touches a
+ * handful of vertices costs a handful of additions per frame; one that moves most
+ * of the mesh is stored densely so its loop is a straight run over the array,
+ * which the compiler turns into SIMD code. Vertex colors can be morphed too.
+ *
+ * All the poses must have the same vertices (same count, same order).
+ */
+
+class MorphTargets {
+
+	public:
+
+    MorphTargets();
+
+    //the pose the deltas are measured from
+    void setup(const ofMesh& base);
+
+    //store the difference between this pose and the base. Vertices (and colors)
+    //that differ by less than threshold are left out. Returns the new target's index
+    int addTarget(const ofMesh& target, float threshold = 0.0001);
+
+    //replace a target with a new pose (keeps its weight)
+    void setTarget(int index, const ofMesh& target, float threshold = 0.0001);
+
+    void setWeight(int index, float weight);
+    float getWeight(int index) const;
+
+    //write the blended pose into the mesh's vertices (and colors)
+    void apply(ofMesh& mesh);
+
+    size_t getNumTargets() const { return targets.size(); }
+
+    //how many vertices a target moves
+    size_t getNumDeltas(int index) const;
+
+    float getLastApplyTimeMs() const { return lastApplyTimeMs; }
+
+    private:
+
+    struct Target {
+        //which vertices are stored, in increasing order. Empty means all of them
+        vector<unsigned> indices;
+
+        //x, y, z per stored vertex, r, g, b, a per stored color (empty if none changed)
+        vector<float> positions;
+        vector<float> colors;
+
+        float weight;
+    };
+
+    void buildTarget(Target& t, const ofMesh& target, float threshold);
+
+    //add the deltas for the vertices in [begin, end) to the output arrays
+    void applyRange(const Target& t, float* outPositions, float* outColors, size_t begin, size_t end) const;
+
+    vector<float> basePositions;
+    vector<float> baseColors;
+    size_t numVerts;
+
+    vector<Target> targets;
+
+    float lastApplyTimeMs;
+};
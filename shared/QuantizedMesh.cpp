@@ -0,0 +1,273 @@
+#include "QuantizedMesh.h"
+#include "TaskScheduler.h"
+
+//octahedral encoding: squash the unit sphere into an octahedron (|x| + |y| + |z| = 1),
+//then fold the bottom half over the top one. Looking down z that's a square
+//from -1 to 1, so x and y are all we need to keep
+//--------------------------------------------------------------
+static inline void encodeOctahedral(const ofVec3f& n, int16_t* out){
+
+    float l1 = fabs(n.x) + fabs(n.y) + fabs(n.z);
+    float x = l1 > 0 ? n.x / l1 : 0;
+    float y = l1 > 0 ? n.y / l1 : 0;
+
+    if(n.z < 0){
+        float fx = (1 - fabs(y)) * (x >= 0 ? 1 : -1);
+        float fy = (1 - fabs(x)) * (y >= 0 ? 1 : -1);
+        x = fx;
+        y = fy;
+    }
+
+    out[0] = (int16_t)roundf(ofClamp(x, -1, 1) * 32767);
+    out[1] = (int16_t)roundf(ofClamp(y, -1, 1) * 32767);
+}
+
+//--------------------------------------------------------------
+static inline ofVec3f decodeOctahedral(const int16_t* in){
+
+    float x = in[0] / 32767.0f;
+    float y = in[1] / 32767.0f;
+    float z = 1 - fabs(x) - fabs(y);
+
+    //unfold the bottom half
+    float t = max(-z, 0.0f);
+    x += x >= 0 ? -t : t;
+    y += y >= 0 ? -t : t;
+
+    return ofVec3f(x, y, z).getNormalized();
+}
+
+//--------------------------------------------------------------
+QuantizedMesh::QuantizedMesh(){
+    numVerts = 0;
+    normalError = 0;
+    lastEncodeTimeMs = 0;
+    lastDecodeTimeMs = 0;
+}
+
+//--------------------------------------------------------------
+void QuantizedMesh::encode(const ofMesh& mesh){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    numVerts = mesh.getNumVertices();
+    positions.clear();
+    normals.clear();
+    texCoords.clear();
+    colors.clear();
+    positionError.set(0, 0, 0);
+    texCoordError.set(0, 0);
+    normalError = 0;
+
+    if(numVerts == 0) return;
+
+    TaskScheduler& scheduler = TaskScheduler::get();
+
+    //---- positions: 0 is the min corner of the box, 65535 the max corner
+    const vector<ofVec3f>& verts = mesh.getVertices();
+    ofVec3f boxMax = verts[0];
+    positionMin = verts[0];
+    for(size_t i = 1; i < numVerts; i++){
+        positionMin.set(min(positionMin.x, verts[i].x), min(positionMin.y, verts[i].y), min(positionMin.z, verts[i].z));
+        boxMax.set(max(boxMax.x, verts[i].x), max(boxMax.y, verts[i].y), max(boxMax.z, verts[i].z));
+    }
+
+    positionStep = (boxMax - positionMin) / 65535.0;
+
+    //rounding to the nearest step is off by half a step at most. Working it back
+    //out in floats can add a few of the float's own rounding errors on top
+    float positionMagnitude = max(positionMin.length(), boxMax.length());
+    positionError = positionStep * 0.5 + ofVec3f(1, 1, 1) * positionMagnitude * 4 * numeric_limits<float>::epsilon();
+
+    //a flat mesh has no size along one of the axes, everything there is step 0
+    ofVec3f inv;
+    for(int k = 0; k < 3; k++){
+        inv[k] = positionStep[k] > 0 ? 1.0 / positionStep[k] : 0;
+    }
+
+    positions.resize(numVerts * 3);
+    scheduler.parallelFor(0, numVerts, 8192, [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++){
+            positions[i * 3 + 0] = (uint16_t)min((verts[i].x - positionMin.x) * inv.x + 0.5f, 65535.0f);
+            positions[i * 3 + 1] = (uint16_t)min((verts[i].y - positionMin.y) * inv.y + 0.5f, 65535.0f);
+            positions[i * 3 + 2] = (uint16_t)min((verts[i].z - positionMin.z) * inv.z + 0.5f, 65535.0f);
+        }
+    });
+
+    //---- normals: encode, then decode again to see how far off they came out
+    if(mesh.getNumNormals() == numVerts){
+
+        const vector<ofVec3f>& srcNormals = mesh.getNormals();
+        normals.resize(numVerts * 2);
+
+        float smallestDot = 1;
+        std::mutex errorMutex;
+
+        scheduler.parallelFor(0, numVerts, 8192, [&](size_t begin, size_t end){
+            float chunkDot = 1;
+            for(size_t i = begin; i < end; i++){
+                encodeOctahedral(srcNormals[i], &normals[i * 2]);
+                chunkDot = min(chunkDot, decodeOctahedral(&normals[i * 2]).dot(srcNormals[i].getNormalized()));
+            }
+
+            std::lock_guard<std::mutex> lock(errorMutex);
+            smallestDot = min(smallestDot, chunkDot);
+        });
+
+        normalError = ofRadToDeg(acos(ofClamp(smallestDot, -1, 1)));
+    }
+
+    //---- texcoords: same as positions, across the range they cover
+    if(mesh.getNumTexCoords() == numVerts){
+
+        const vector<ofVec2f>& srcTexCoords = mesh.getTexCoords();
+        ofVec2f texMax = srcTexCoords[0];
+        texCoordMin = srcTexCoords[0];
+        for(size_t i = 1; i < numVerts; i++){
+            texCoordMin.set(min(texCoordMin.x, srcTexCoords[i].x), min(texCoordMin.y, srcTexCoords[i].y));
+            texMax.set(max(texMax.x, srcTexCoords[i].x), max(texMax.y, srcTexCoords[i].y));
+        }
+
+        texCoordStep = (texMax - texCoordMin) / 65535.0;
+
+        float texCoordMagnitude = max(texCoordMin.length(), texMax.length());
+        texCoordError = texCoordStep * 0.5 + ofVec2f(1, 1) * texCoordMagnitude * 4 * numeric_limits<float>::epsilon();
+        ofVec2f texInv(texCoordStep.x > 0 ? 1.0 / texCoordStep.x : 0, texCoordStep.y > 0 ? 1.0 / texCoordStep.y : 0);
+
+        texCoords.resize(numVerts * 2);
+        scheduler.parallelFor(0, numVerts, 8192, [&](size_t begin, size_t end){
+            for(size_t i = begin; i < end; i++){
+                texCoords[i * 2 + 0] = (uint16_t)min((srcTexCoords[i].x - texCoordMin.x) * texInv.x + 0.5f, 65535.0f);
+                texCoords[i * 2 + 1] = (uint16_t)min((srcTexCoords[i].y - texCoordMin.y) * texInv.y + 0.5f, 65535.0f);
+            }
+        });
+    }
+
+    //---- colors: 0 to 255 per channel
+    if(mesh.getNumColors() == numVerts){
+
+        //ofFloatColor is 4 floats back to back
+        const float* src = &mesh.getColors()[0].r;
+        colors.resize(numVerts * 4);
+
+        scheduler.parallelFor(0, numVerts, 8192, [&](size_t begin, size_t end){
+            for(size_t j = begin * 4; j < end * 4; j++){
+                colors[j] = (uint8_t)(ofClamp(src[j], 0, 1) * 255 + 0.5f);
+            }
+        });
+    }
+
+    lastEncodeTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+void QuantizedMesh::decodeVertices(size_t begin, size_t end, ofVec3f* out) const{
+
+    //plain floats in and out (ofVec3f is 3 floats back to back) and the
+    //constants in locals, so the compiler can see it's safe to vectorize
+    const uint16_t* p = &positions[begin * 3];
+    float* o = out->getPtr();
+    size_t count = end - begin;
+    float minX = positionMin.x, minY = positionMin.y, minZ = positionMin.z;
+    float stepX = positionStep.x, stepY = positionStep.y, stepZ = positionStep.z;
+
+    for(size_t i = 0; i < count; i++){
+        o[i * 3 + 0] = minX + p[i * 3 + 0] * stepX;
+        o[i * 3 + 1] = minY + p[i * 3 + 1] * stepY;
+        o[i * 3 + 2] = minZ + p[i * 3 + 2] * stepZ;
+    }
+}
+
+//--------------------------------------------------------------
+void QuantizedMesh::decode(ofMesh& mesh) const{
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    TaskScheduler& scheduler = TaskScheduler::get();
+
+    mesh.getVertices().resize(numVerts);
+    if(numVerts == 0) return;
+
+    ofVec3f* outVerts = &mesh.getVertices()[0];
+    scheduler.parallelFor(0, numVerts, 8192, [&](size_t begin, size_t end){
+        decodeVertices(begin, end, outVerts + begin);
+    });
+
+    if(hasNormals()){
+        mesh.getNormals().resize(numVerts);
+        ofVec3f* outNormals = &mesh.getNormals()[0];
+        scheduler.parallelFor(0, numVerts, 8192, [&](size_t begin, size_t end){
+            for(size_t i = begin; i < end; i++){
+                outNormals[i] = decodeOctahedral(&normals[i * 2]);
+            }
+        });
+    } else {
+        mesh.clearNormals();
+    }
+
+    if(hasTexCoords()){
+        mesh.getTexCoords().resize(numVerts);
+        ofVec2f* outTexCoords = &mesh.getTexCoords()[0];
+        scheduler.parallelFor(0, numVerts, 8192, [&](size_t begin, size_t end){
+            for(size_t i = begin; i < end; i++){
+                outTexCoords[i].set(texCoordMin.x + texCoords[i * 2 + 0] * texCoordStep.x,
+                                    texCoordMin.y + texCoords[i * 2 + 1] * texCoordStep.y);
+            }
+        });
+    } else {
+        mesh.clearTexCoords();
+    }
+
+    if(hasColors()){
+        mesh.getColors().resize(numVerts);
+        float* outColors = &mesh.getColors()[0].r;
+        scheduler.parallelFor(0, numVerts, 8192, [&](size_t begin, size_t end){
+            for(size_t j = begin * 4; j < end * 4; j++){
+                outColors[j] = colors[j] * (1 / 255.0f);
+            }
+        });
+    } else {
+        mesh.clearColors();
+    }
+
+    lastDecodeTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+ofVec3f QuantizedMesh::getVertex(size_t i) const{
+    ofVec3f v;
+    decodeVertices(i, i + 1, &v);
+    return v;
+}
+
+//--------------------------------------------------------------
+ofVec3f QuantizedMesh::getNormal(size_t i) const{
+    if(!hasNormals()) return ofVec3f(0, 0, 1);
+    return decodeOctahedral(&normals[i * 2]);
+}
+
+//--------------------------------------------------------------
+ofVec2f QuantizedMesh::getTexCoord(size_t i) const{
+    if(!hasTexCoords()) return ofVec2f();
+    return ofVec2f(texCoordMin.x + texCoords[i * 2 + 0] * texCoordStep.x,
+                   texCoordMin.y + texCoords[i * 2 + 1] * texCoordStep.y);
+}
+
+//--------------------------------------------------------------
+ofFloatColor QuantizedMesh::getColor(size_t i) const{
+    if(!hasColors()) return ofFloatColor::white;
+    return ofFloatColor(colors[i * 4 + 0] / 255.0f, colors[i * 4 + 1] / 255.0f,
+                        colors[i * 4 + 2] / 255.0f, colors[i * 4 + 3] / 255.0f);
+}
+
+//--------------------------------------------------------------
+size_t QuantizedMesh::getNumBytes() const{
+    return positions.size() * sizeof(uint16_t) + normals.size() * sizeof(int16_t) +
+           texCoords.size() * sizeof(uint16_t) + colors.size() * sizeof(uint8_t);
+}
+
+//--------------------------------------------------------------
+size_t QuantizedMesh::getNumBytes(const ofMesh& mesh){
+    return mesh.getNumVertices() * sizeof(ofVec3f) + mesh.getNumNormals() * sizeof(ofVec3f) +
+           mesh.getNumTexCoords() * sizeof(ofVec2f) + mesh.getNumColors() * sizeof(ofFloatColor);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * A compact copy of a mesh's vertex data. ofMesh keeps every attribute as floats:
+ * 12 bytes per position, 12 per normal, 8 per texcoord and 16 per color, 48 bytes
+ * a vertex. On big meshes just streaming that through memory every frame takes
+ * longer than the math done on it, so this stores:
+ *
+ *  - positions:  3 x 16 bits, as steps across the mesh's bounding box       6 bytes
+ *  - normals:    2 x 16 bits, octahedral encoding (the unit sphere is
+ *                folded out onto a square, so 2 numbers are enough)         4 bytes
+ *  - texcoords:  2 x 16 bits, as steps across their own range              4 bytes
+ *  - colors:     4 x 8 bits, like an image                                 4 bytes
+ *
+ * which is 18 bytes a vertex instead of 48. Values can be read back one at a time
+ * (getVertex() etc.) or all at once (decode()), and the largest error the
+ * rounding can cause is available for each attribute.
+ *
+ * The bulk encode and decode are split across the cores and written as straight
+ * loops over the arrays so the compiler turns them into SIMD code.
+ * Indices aren't stored, they're already small and never change here.
+ */
+
+class QuantizedMesh {
+
+	public:
+
+    QuantizedMesh();
+
+    //pack the vertex data of the mesh. Attributes the mesh doesn't have
+    //(or doesn't have one per vertex) are skipped
+    void encode(const ofMesh& mesh);
+
+    //unpack everything back into the mesh's vertices, normals, texcoords and colors.
+    //The mode and indices of the mesh are left alone
+    void decode(ofMesh& mesh) const;
+
+    //unpack just the positions [begin, end) into out[0] ... out[end - begin - 1].
+    //This is the one to use for reading rest positions every frame
+    void decodeVertices(size_t begin, size_t end, ofVec3f* out) const;
+
+    size_t getNumVertices() const { return numVerts; }
+    bool hasNormals() const { return !normals.empty(); }
+    bool hasTexCoords() const { return !texCoords.empty(); }
+    bool hasColors() const { return !colors.empty(); }
+
+    //read single values back (decoded on the spot)
+    ofVec3f getVertex(size_t i) const;
+    ofVec3f getNormal(size_t i) const;
+    ofVec2f getTexCoord(size_t i) const;
+    ofFloatColor getColor(size_t i) const;
+
+    //the most any decoded value can be off from the original.
+    //Positions and texcoords: half a step on each axis (plus float rounding).
+    //Normals: the largest angle (in degrees) measured while encoding
+    ofVec3f getVertexErrorBound() const { return positionError; }
+    ofVec2f getTexCoordErrorBound() const { return texCoordError; }
+    float getNormalErrorBound() const { return normalError; }
+    float getColorErrorBound() const { return 0.5 / 255.0; }
+
+    //memory used by the packed attributes, and by the same attributes as floats
+    size_t getNumBytes() const;
+    static size_t getNumBytes(const ofMesh& mesh);
+
+    float getLastEncodeTimeMs() const { return lastEncodeTimeMs; }
+    float getLastDecodeTimeMs() const { return lastDecodeTimeMs; }
+
+    private:
+
+    //entropy codes the packed arrays directly
+    friend class MeshCodec;
+
+    size_t numVerts;
+
+    //decoded = min + packed * step
+    ofVec3f positionMin, positionStep;
+    ofVec2f texCoordMin, texCoordStep;
+
+    //x, y, z / u, v / r, g, b, a per vertex
+    vector<uint16_t> positions;
+    vector<int16_t> normals;
+    vector<uint16_t> texCoords;
+    vector<uint8_t> colors;
+
+    ofVec3f positionError;
+    ofVec2f texCoordError;
+    float normalError;
+
+    float lastEncodeTimeMs;
+    mutable float lastDecodeTimeMs;
+};
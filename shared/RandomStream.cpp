@@ -0,0 +1,285 @@
+#include "RandomStream.h"
+#include "TaskScheduler.h"
+
+//x86 has SSE2 everywhere, AVX2 only when the compiler is told to use it (-mavx2)
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RANDOM_STREAM_SSE2
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RANDOM_STREAM_AVX2
+#endif
+
+//positions per piece of a fill, and per task
+static const size_t blockSize = 256;
+static const size_t grainSize = 4096;
+
+//--------------------------------------------------------------
+static inline float toUnit(uint32_t x){
+    //the top 24 bits, as many as a float holds: 0 up to (but not) 1
+    return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+//--------------------------------------------------------------
+static inline void philox(uint64_t counter, uint64_t stream, uint64_t seed, uint32_t* out){
+
+    //Philox 4x32 with 10 rounds. The counter is (position, stream), the key is the seed.
+    //Each round multiplies two of the four words, which spreads every bit of them
+    //over the whole 64 bit product, and mixes the halves with the other two words
+    //and the key. The key changes every round
+    uint32_t c0 = (uint32_t)counter;
+    uint32_t c1 = (uint32_t)(counter >> 32);
+    uint32_t c2 = (uint32_t)stream;
+    uint32_t c3 = (uint32_t)(stream >> 32);
+    uint32_t k0 = (uint32_t)seed;
+    uint32_t k1 = (uint32_t)(seed >> 32);
+
+    for(int round = 0; round < 10; round++){
+        uint64_t p0 = (uint64_t)0xD2511F53 * c0;
+        uint64_t p1 = (uint64_t)0xCD9E8D57 * c2;
+        c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t)p1;
+        c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t)p0;
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+#ifdef RANDOM_STREAM_SSE2
+//--------------------------------------------------------------
+//the high and low 32 bits of x * m for each of the 4 lanes. _mm_mul_epu32 gives
+//the whole 64 bit product of lanes 0 and 2, so the odd lanes get shifted down
+//for a second multiply and the halves are sorted back into lane order after
+static inline void mulHiLo(__m128i x, __m128i m, __m128i& hi, __m128i& lo){
+    __m128i even = _mm_mul_epu32(x, m);                             //lo0 hi0 lo2 hi2
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), m);          //lo1 hi1 lo3 hi3
+    even = _mm_shuffle_epi32(even, _MM_SHUFFLE(3, 1, 2, 0));        //lo0 lo2 hi0 hi2
+    odd = _mm_shuffle_epi32(odd, _MM_SHUFFLE(3, 1, 2, 0));          //lo1 lo3 hi1 hi3
+    lo = _mm_unpacklo_epi32(even, odd);
+    hi = _mm_unpackhi_epi32(even, odd);
+}
+
+//--------------------------------------------------------------
+//the same rounds as philox(), for the 4 positions first to first + 3 side by side.
+//Every register holds one of the 4 words of all 4 positions
+static inline void philox4(uint64_t first, uint64_t stream, uint64_t seed, uint32_t* out){
+
+    __m128i c0 = _mm_setr_epi32((uint32_t)first, (uint32_t)(first + 1), (uint32_t)(first + 2), (uint32_t)(first + 3));
+    __m128i c1 = _mm_setr_epi32((uint32_t)(first >> 32), (uint32_t)((first + 1) >> 32), (uint32_t)((first + 2) >> 32), (uint32_t)((first + 3) >> 32));
+    __m128i c2 = _mm_set1_epi32((uint32_t)stream);
+    __m128i c3 = _mm_set1_epi32((uint32_t)(stream >> 32));
+    uint32_t k0 = (uint32_t)seed;
+    uint32_t k1 = (uint32_t)(seed >> 32);
+
+    const __m128i m0 = _mm_set1_epi32(0xD2511F53);
+    const __m128i m1 = _mm_set1_epi32(0xCD9E8D57);
+
+    for(int round = 0; round < 10; round++){
+        __m128i hi0, lo0, hi1, lo1;
+        mulHiLo(c0, m0, hi0, lo0);
+        mulHiLo(c2, m1, hi1, lo1);
+        c0 = _mm_xor_si128(_mm_xor_si128(hi1, c1), _mm_set1_epi32(k0));
+        c1 = lo1;
+        c2 = _mm_xor_si128(_mm_xor_si128(hi0, c3), _mm_set1_epi32(k1));
+        c3 = lo0;
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+
+    //back to 4 words per position: a 4x4 transpose
+    __m128i t0 = _mm_unpacklo_epi32(c0, c1);     //p0.0 p0.1 p1.0 p1.1
+    __m128i t1 = _mm_unpacklo_epi32(c2, c3);     //p0.2 p0.3 p1.2 p1.3
+    __m128i t2 = _mm_unpackhi_epi32(c0, c1);     //p2.0 p2.1 p3.0 p3.1
+    __m128i t3 = _mm_unpackhi_epi32(c2, c3);     //p2.2 p2.3 p3.2 p3.3
+    _mm_storeu_si128((__m128i*)(out + 0), _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128((__m128i*)(out + 4), _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128((__m128i*)(out + 8), _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128((__m128i*)(out + 12), _mm_unpackhi_epi64(t2, t3));
+}
+#endif
+
+#ifdef RANDOM_STREAM_AVX2
+//--------------------------------------------------------------
+//mulHiLo() for 8 lanes
+static inline void mulHiLo(__m256i x, __m256i m, __m256i& hi, __m256i& lo){
+    __m256i even = _mm256_mul_epu32(x, m);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), m);
+    even = _mm256_shuffle_epi32(even, _MM_SHUFFLE(3, 1, 2, 0));
+    odd = _mm256_shuffle_epi32(odd, _MM_SHUFFLE(3, 1, 2, 0));
+    lo = _mm256_unpacklo_epi32(even, odd);
+    hi = _mm256_unpackhi_epi32(even, odd);
+}
+
+//--------------------------------------------------------------
+//philox4() for 8 positions. Lanes 0-3 are first to first + 3, lanes 4-7 the next 4
+//(AVX2 works on two 128 bit halves, so each half ends up like philox4()'s registers)
+static inline void philox8(uint64_t first, uint64_t stream, uint64_t seed, uint32_t* out){
+
+    uint32_t low[8], high[8];
+    for(int i = 0; i < 8; i++){
+        low[i] = (uint32_t)(first + i);
+        high[i] = (uint32_t)((first + i) >> 32);
+    }
+    __m256i c0 = _mm256_loadu_si256((const __m256i*)low);
+    __m256i c1 = _mm256_loadu_si256((const __m256i*)high);
+    __m256i c2 = _mm256_set1_epi32((uint32_t)stream);
+    __m256i c3 = _mm256_set1_epi32((uint32_t)(stream >> 32));
+    uint32_t k0 = (uint32_t)seed;
+    uint32_t k1 = (uint32_t)(seed >> 32);
+
+    const __m256i m0 = _mm256_set1_epi32(0xD2511F53);
+    const __m256i m1 = _mm256_set1_epi32(0xCD9E8D57);
+
+    for(int round = 0; round < 10; round++){
+        __m256i hi0, lo0, hi1, lo1;
+        mulHiLo(c0, m0, hi0, lo0);
+        mulHiLo(c2, m1, hi1, lo1);
+        c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32(k0));
+        c1 = lo1;
+        c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32(k1));
+        c3 = lo0;
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+
+    //the same transpose as philox4(), in both halves at once
+    __m256i t0 = _mm256_unpacklo_epi32(c0, c1);
+    __m256i t1 = _mm256_unpacklo_epi32(c2, c3);
+    __m256i t2 = _mm256_unpackhi_epi32(c0, c1);
+    __m256i t3 = _mm256_unpackhi_epi32(c2, c3);
+    __m256i r0 = _mm256_unpacklo_epi64(t0, t1);      //p0 | p4
+    __m256i r1 = _mm256_unpackhi_epi64(t0, t1);      //p1 | p5
+    __m256i r2 = _mm256_unpacklo_epi64(t2, t3);      //p2 | p6
+    __m256i r3 = _mm256_unpackhi_epi64(t2, t3);      //p3 | p7
+    _mm256_storeu_si256((__m256i*)(out + 0), _mm256_permute2x128_si256(r0, r1, 0x20));     //p0 p1
+    _mm256_storeu_si256((__m256i*)(out + 8), _mm256_permute2x128_si256(r2, r3, 0x20));     //p2 p3
+    _mm256_storeu_si256((__m256i*)(out + 16), _mm256_permute2x128_si256(r0, r1, 0x31));    //p4 p5
+    _mm256_storeu_si256((__m256i*)(out + 24), _mm256_permute2x128_si256(r2, r3, 0x31));    //p6 p7
+}
+#endif
+
+//--------------------------------------------------------------
+RandomStream::RandomStream(uint64_t seed, uint64_t stream){
+    setSeed(seed, stream);
+}
+
+//--------------------------------------------------------------
+void RandomStream::setSeed(uint64_t seed, uint64_t stream){
+    this->seed = seed;
+    this->stream = stream;
+    position = 0;
+}
+
+//--------------------------------------------------------------
+void RandomStream::generate(uint64_t first, size_t count, uint32_t* out) const{
+
+    //the positions don't depend on each other, so they're scrambled 8 or 4 at
+    //a time with SIMD where there is some, and one by one for what's left over
+    size_t i = 0;
+#ifdef RANDOM_STREAM_AVX2
+    for(; i + 8 <= count; i += 8){
+        philox8(first + i, stream, seed, out + i * 4);
+    }
+#endif
+#ifdef RANDOM_STREAM_SSE2
+    for(; i + 4 <= count; i += 4){
+        philox4(first + i, stream, seed, out + i * 4);
+    }
+#endif
+    for(; i < count; i++){
+        philox(first + i, stream, seed, out + i * 4);
+    }
+}
+
+//--------------------------------------------------------------
+void RandomStream::fillBlocks(size_t count, const std::function<void(size_t, size_t, const uint32_t*)>& fill){
+
+    //every element gets the numbers at its own position, so it doesn't matter
+    //which thread does which part, or how many threads there are
+    uint64_t first = position;
+    TaskScheduler::get().parallelFor(0, count, grainSize, [&](size_t begin, size_t end){
+        uint32_t numbers[blockSize * 4];
+        for(size_t b = begin; b < end; b += blockSize){
+            size_t n = min(blockSize, end - b);
+            generate(first + b, n, numbers);
+            fill(b, b + n, numbers);
+        }
+    });
+    position += count;
+}
+
+//--------------------------------------------------------------
+float RandomStream::uniform(float min, float max){
+    uint32_t numbers[4];
+    generate(position++, 1, numbers);
+    return min + (max - min) * toUnit(numbers[0]);
+}
+
+//--------------------------------------------------------------
+ofVec3f RandomStream::inBox(const ofVec3f& low, const ofVec3f& high){
+    ofVec3f point;
+    fillBox(&point, 1, low, high);
+    return point;
+}
+
+//--------------------------------------------------------------
+ofColor RandomStream::hsb(const ofVec3f& hsbLow, const ofVec3f& hsbHigh){
+    ofColor color;
+    fillHsb(&color, 1, hsbLow, hsbHigh);
+    return color;
+}
+
+//--------------------------------------------------------------
+void RandomStream::fillUniform(float* values, size_t count, float min, float max){
+
+    //4 values per position
+    float range = max - min;
+    fillBlocks((count + 3) / 4, [&](size_t begin, size_t end, const uint32_t* numbers){
+        for(size_t i = begin * 4; i < std::min(end * 4, count); i++){
+            values[i] = min + range * toUnit(numbers[i - begin * 4]);
+        }
+    });
+}
+
+//--------------------------------------------------------------
+void RandomStream::fillBox(ofVec3f* points, size_t count, const ofVec3f& low, const ofVec3f& high){
+
+    ofVec3f size = high - low;
+    fillBlocks(count, [&](size_t begin, size_t end, const uint32_t* numbers){
+        for(size_t i = begin; i < end; i++){
+            const uint32_t* n = numbers + (i - begin) * 4;
+            points[i].set(low.x + size.x * toUnit(n[0]), low.y + size.y * toUnit(n[1]), low.z + size.z * toUnit(n[2]));
+        }
+    });
+}
+
+//--------------------------------------------------------------
+void RandomStream::fillHsb(ofColor* colors, size_t count, const ofVec3f& hsbLow, const ofVec3f& hsbHigh, float alphaLow, float alphaHigh){
+    fillColors(colors, count, hsbLow, hsbHigh, alphaLow, alphaHigh);
+}
+
+//--------------------------------------------------------------
+void RandomStream::fillHsb(ofFloatColor* colors, size_t count, const ofVec3f& hsbLow, const ofVec3f& hsbHigh, float alphaLow, float alphaHigh){
+    fillColors(colors, count, hsbLow, hsbHigh, alphaLow, alphaHigh);
+}
+
+//--------------------------------------------------------------
+template<typename ColorType>
+void RandomStream::fillColors(ColorType* colors, size_t count, const ofVec3f& hsbLow, const ofVec3f& hsbHigh, float alphaLow, float alphaHigh){
+
+    ofVec3f size = hsbHigh - hsbLow;
+    float alphaSize = alphaHigh - alphaLow;
+    fillBlocks(count, [&](size_t begin, size_t end, const uint32_t* numbers){
+        for(size_t i = begin; i < end; i++){
+            const uint32_t* n = numbers + (i - begin) * 4;
+            colors[i].setHsb(hsbLow.x + size.x * toUnit(n[0]), hsbLow.y + size.y * toUnit(n[1]), hsbLow.z + size.z * toUnit(n[2]), alphaLow + alphaSize * toUnit(n[3]));
+        }
+    });
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Random numbers that come out the same every time for the same seed, and fast
+ * enough to fill whole meshes with (points, colors, scatter offsets).
+ *
+ * ofRandom() is one global generator: every call depends on all the calls before
+ * it, so it can't be split up between threads, and nobody can get the same run
+ * twice. This one is "counter based" (Philox 4x32, from the Random123 library):
+ * the numbers at position i are a scrambled version of (seed, i), worked out from
+ * scratch without looking at any other position. So:
+ *
+ *  - the same seed always gives the same numbers
+ *  - a fill can be cut up between any number of threads and still come out the
+ *    same, since every element knows its own position, so the fills run on all
+ *    the cores, and every core works on 4 positions at once with SSE2 (8 with
+ *    AVX2, when the project is built with -mavx2)
+ *
+ * Every position gives 4 random numbers. The fills use one position per element
+ * (a vec3 or a color) or per 4 floats, and move the stream on by that many, so
+ * one fill after another is the same as one big fill.
+ *
+ * Different streams of the same seed are completely separate sequences, handy
+ * when one sketch needs random numbers for different things.
+ */
+
+class RandomStream {
+
+	public:
+
+    RandomStream(uint64_t seed = 0, uint64_t stream = 0);
+
+    //start over at position 0
+    void setSeed(uint64_t seed, uint64_t stream = 0);
+    uint64_t getSeed() const { return seed; }
+
+    //how far the stream has got. Setting it back repeats the numbers from there
+    uint64_t getPosition() const { return position; }
+    void setPosition(uint64_t position) { this->position = position; }
+
+    //one at a time, like ofRandom (each call uses a position)
+    float uniform(float min, float max);
+    ofVec3f inBox(const ofVec3f& low, const ofVec3f& high);
+    ofColor hsb(const ofVec3f& hsbLow, const ofVec3f& hsbHigh);
+
+    //count floats from min to max
+    void fillUniform(float* values, size_t count, float min, float max);
+
+    //count points spread evenly over the box from low to high
+    void fillBox(ofVec3f* points, size_t count, const ofVec3f& low, const ofVec3f& high);
+
+    //count colors with hue, saturation and brightness each somewhere between
+    //hsbLow and hsbHigh, and the alpha between alphaLow and alphaHigh.
+    //0 - 255 for ofColor, 0 - 1 for ofFloatColor (what meshes use), like setHsb()
+    void fillHsb(ofColor* colors, size_t count, const ofVec3f& hsbLow, const ofVec3f& hsbHigh, float alphaLow = 255, float alphaHigh = 255);
+    void fillHsb(ofFloatColor* colors, size_t count, const ofVec3f& hsbLow, const ofVec3f& hsbHigh, float alphaLow = 1, float alphaHigh = 1);
+
+    //the 4 numbers for each of the positions [first, first + count), 4 per position.
+    //Doesn't move the stream
+    void generate(uint64_t first, size_t count, uint32_t* out) const;
+
+    private:
+
+    //calls fill(begin, end, numbers) for blocks of elements on all the cores,
+    //with numbers holding the 4 random numbers of each element
+    void fillBlocks(size_t count, const std::function<void(size_t, size_t, const uint32_t*)>& fill);
+
+    template<typename ColorType>
+    void fillColors(ColorType* colors, size_t count, const ofVec3f& hsbLow, const ofVec3f& hsbHigh, float alphaLow, float alphaHigh);
+
+    uint64_t seed;
+    uint64_t stream;
+    uint64_t position;
+};
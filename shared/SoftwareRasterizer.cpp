@@ -0,0 +1,522 @@
+#include "SoftwareRasterizer.h"
+#include "MeshUtils.h"
+
+#include "TaskScheduler.h"
+
+//--------------------------------------------------------------
+//keep huge values (from vertices very close to the camera) from overflowing an int
+static int toPixel(float v, int limit){
+    return (int)floor(ofClamp(v, -1, limit));
+}
+
+//--------------------------------------------------------------
+SoftwareRasterizer::SoftwareRasterizer(){
+    width = 0;
+    height = 0;
+    tileSize = 32;
+    numTilesX = 0;
+    numTilesY = 0;
+
+    drawColor = ofColor(255);
+    texture = nullptr;
+    bNormalizedTexCoords = false;
+
+    bLighting = false;
+    pointSize = 1;
+
+    lastDrawTimeMs = 0;
+    numPrimitivesDrawn = 0;
+}
+
+//--------------------------------------------------------------
+void SoftwareRasterizer::allocate(int w, int h, int tile){
+
+    width = w;
+    height = h;
+    tileSize = max(8, tile);
+
+    numTilesX = (width + tileSize - 1) / tileSize;
+    numTilesY = (height + tileSize - 1) / tileSize;
+    tileBins.assign(numTilesX * numTilesY, vector<unsigned>());
+
+    pixels.allocate(width, height, 3);
+    depth.assign(width * height, 1);
+}
+
+//--------------------------------------------------------------
+void SoftwareRasterizer::clear(const ofColor& color){
+
+    unsigned char* data = pixels.getData();
+    for(int i = 0; i < width * height; i++){
+        data[i * 3 + 0] = color.r;
+        data[i * 3 + 1] = color.g;
+        data[i * 3 + 2] = color.b;
+    }
+
+    std::fill(depth.begin(), depth.end(), 1);
+}
+
+//--------------------------------------------------------------
+void SoftwareRasterizer::setCamera(const ofCamera& cam){
+    modelViewProjection = cam.getModelViewProjectionMatrix(ofRectangle(0, 0, width, height));
+}
+
+//--------------------------------------------------------------
+void SoftwareRasterizer::enableLighting(const ofVec3f& position, const ofFloatColor& diffuse, const ofFloatColor& ambient){
+    bLighting = true;
+    lightPosition = position;
+    lightDiffuse = diffuse;
+    lightAmbient = ambient;
+}
+
+//--------------------------------------------------------------
+bool SoftwareRasterizer::save(const string& path) const{
+    return ofSaveImage(pixels, path);
+}
+
+//--------------------------------------------------------------
+void SoftwareRasterizer::draw(const ofMesh& mesh, DrawMode mode){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    if(width == 0 || height == 0){
+        ofLogWarning("SoftwareRasterizer") << "draw(): call allocate() first";
+        return;
+    }
+
+    const vector<ofVec3f>& verts = mesh.getVertices();
+    size_t numVerts = verts.size();
+
+    //---- project every vertex, a few thousand per task
+    //OF multiplies points as rows (p * M) so clip coordinate j comes from column j
+    const ofMatrix4x4& m = modelViewProjection;
+    screenVerts.resize(numVerts);
+
+    TaskScheduler::get().parallelFor(0, numVerts, 4096, [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++){
+            const ofVec3f& p = verts[i];
+            float cx = p.x * m(0, 0) + p.y * m(1, 0) + p.z * m(2, 0) + m(3, 0);
+            float cy = p.x * m(0, 1) + p.y * m(1, 1) + p.z * m(2, 1) + m(3, 1);
+            float cz = p.x * m(0, 2) + p.y * m(1, 2) + p.z * m(2, 2) + m(3, 2);
+            float cw = p.x * m(0, 3) + p.y * m(1, 3) + p.z * m(2, 3) + m(3, 3);
+
+            ScreenVertex& sv = screenVerts[i];
+            sv.visible = cw > 1e-6 && cz >= -cw;
+            sv.invW = sv.visible ? 1.0 / cw : 0;
+
+            //same as ofCamera::worldToScreen(): y goes down the image
+            sv.x = (cx * sv.invW + 1) * 0.5 * width;
+            sv.y = (1 - cy * sv.invW) * 0.5 * height;
+            sv.z = (cz * sv.invW + 1) * 0.5;
+        }
+    });
+
+    //---- turn the mesh into triangles, lines or points
+    primitives.clear();
+
+    vector<ofIndexType> triangles;
+    ofPrimitiveMode meshMode = mesh.getMode();
+    bool bLineMesh = meshMode == OF_PRIMITIVE_LINES || meshMode == OF_PRIMITIVE_LINE_STRIP || meshMode == OF_PRIMITIVE_LINE_LOOP;
+
+    if(mode == POINTS || meshMode == OF_PRIMITIVE_POINTS){
+        for(size_t i = 0; i < numVerts; i++){
+            ofIndexType v = i;
+            addPrimitive(&v, 1, mesh);
+        }
+    } else if(bLineMesh){
+        vector<ofIndexType> order;
+        if(mesh.hasIndices()){
+            order = mesh.getIndices();
+        } else {
+            for(size_t i = 0; i < numVerts; i++) order.push_back(i);
+        }
+
+        size_t step = meshMode == OF_PRIMITIVE_LINES ? 2 : 1;
+        for(size_t i = 0; i + 1 < order.size(); i += step){
+            addPrimitive(&order[i], 2, mesh);
+        }
+        if(meshMode == OF_PRIMITIVE_LINE_LOOP && order.size() > 2){
+            ofIndexType closing[2] = { order.back(), order.front() };
+            addPrimitive(closing, 2, mesh);
+        }
+    } else if(MeshUtils::getTriangleIndices(mesh, triangles)){
+        for(size_t t = 0; t < triangles.size(); t += 3){
+            if(mode == FILL){
+                addPrimitive(&triangles[t], 3, mesh);
+            } else {
+                for(int k = 0; k < 3; k++){
+                    ofIndexType edge[2] = { triangles[t + k], triangles[t + (k + 1) % 3] };
+                    addPrimitive(edge, 2, mesh);
+                }
+            }
+        }
+    }
+
+    //---- binning: every tile gets the list of primitives that might touch it.
+    //They're added in order so overlapping triangles always resolve the same way
+    for(auto& bin : tileBins){
+        bin.clear();
+    }
+
+    for(size_t i = 0; i < primitives.size(); i++){
+        const Primitive& prim = primitives[i];
+        for(int ty = prim.minY / tileSize; ty <= prim.maxY / tileSize; ty++){
+            for(int tx = prim.minX / tileSize; tx <= prim.maxX / tileSize; tx++){
+                tileBins[ty * numTilesX + tx].push_back(i);
+            }
+        }
+    }
+
+    //---- fill in the tiles, all at once. One tile per task: the tiles in the
+    //middle of the screen are usually much busier and idle threads can steal the rest
+    DrawState state;
+    state.mesh = &mesh;
+    state.bColors = mesh.hasColors() && mesh.usingColors() && mesh.getNumColors() == numVerts;
+    state.bTexture = texture != nullptr && texture->isAllocated() && mesh.hasTexCoords() && mesh.getNumTexCoords() == numVerts;
+    state.bNormals = mesh.hasNormals() && mesh.getNumNormals() == numVerts;
+    state.color = drawColor;
+
+    TaskScheduler::get().parallelFor(0, tileBins.size(), 1, [&](size_t begin, size_t end){
+        for(size_t tile = begin; tile < end; tile++){
+            rasterizeTile(tile, state);
+        }
+    });
+
+    numPrimitivesDrawn = primitives.size();
+    lastDrawTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+void SoftwareRasterizer::addPrimitive(const ofIndexType* v, int numVertices, const ofMesh& mesh){
+
+    Primitive prim;
+    prim.numVertices = numVertices;
+
+    float minX = std::numeric_limits<float>::max();
+    float minY = minX;
+    float maxX = -minX;
+    float maxY = -minX;
+
+    for(int k = 0; k < 3; k++){
+        prim.v[k] = v[min(k, numVertices - 1)];
+
+        //skip anything with a corner behind the camera
+        const ScreenVertex& sv = screenVerts[prim.v[k]];
+        if(!sv.visible) return;
+
+        minX = min(minX, sv.x);
+        minY = min(minY, sv.y);
+        maxX = max(maxX, sv.x);
+        maxY = max(maxY, sv.y);
+    }
+
+    //points and lines spill over their exact bounds a little
+    float pad = numVertices == 1 ? pointSize * 0.5 + 1 : (numVertices == 2 ? 1 : 0);
+
+    prim.minX = max(0, toPixel(minX - pad, width));
+    prim.minY = max(0, toPixel(minY - pad, height));
+    prim.maxX = min(width - 1, toPixel(maxX + pad, width));
+    prim.maxY = min(height - 1, toPixel(maxY + pad, height));
+
+    //completely off screen
+    if(prim.minX > prim.maxX || prim.minY > prim.maxY) return;
+
+    if(numVertices == 3){
+        const ofVec3f& a = mesh.getVertices()[prim.v[0]];
+        const ofVec3f& b = mesh.getVertices()[prim.v[1]];
+        const ofVec3f& c = mesh.getVertices()[prim.v[2]];
+        prim.faceNormal = (b - a).getCrossed(c - a).getNormalized();
+    }
+
+    primitives.push_back(prim);
+}
+
+//--------------------------------------------------------------
+void SoftwareRasterizer::rasterizeTile(int tileIndex, const DrawState& state){
+
+    int x0 = (tileIndex % numTilesX) * tileSize;
+    int y0 = (tileIndex / numTilesX) * tileSize;
+    int x1 = min(width, x0 + tileSize);
+    int y1 = min(height, y0 + tileSize);
+
+    for(unsigned id : tileBins[tileIndex]){
+        const Primitive& prim = primitives[id];
+
+        if(prim.numVertices == 3){
+            fillTriangle(prim, state, x0, y0, x1, y1);
+        } else if(prim.numVertices == 2){
+            drawLine(prim, state, x0, y0, x1, y1);
+        } else {
+            drawPoint(prim, state, x0, y0, x1, y1);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void SoftwareRasterizer::fillTriangle(const Primitive& prim, const DrawState& state, int x0, int y0, int x1, int y1){
+
+    const ScreenVertex& a = screenVerts[prim.v[0]];
+    const ScreenVertex& b = screenVerts[prim.v[1]];
+    const ScreenVertex& c = screenVerts[prim.v[2]];
+
+    //twice the signed area. Dividing by it makes the weights come out
+    //positive inside no matter which way the triangle is wound
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if(fabs(area) < 1e-8) return;
+    float invArea = 1.0 / area;
+
+    int startX = max(x0, prim.minX);
+    int endX = min(x1 - 1, prim.maxX);
+    int startY = max(y0, prim.minY);
+    int endY = min(y1 - 1, prim.maxY);
+
+    //the weight of each corner is the edge function of the opposite edge:
+    //w(x, y) = w at the first pixel + stepX * dx + stepY * dy
+    const ScreenVertex* corners[3] = { &a, &b, &c };
+    float rowStart[3], stepX[3], stepY[3];
+
+    for(int k = 0; k < 3; k++){
+        const ScreenVertex& p = *corners[(k + 1) % 3];
+        const ScreenVertex& q = *corners[(k + 2) % 3];
+        float px = startX + 0.5;
+        float py = startY + 0.5;
+
+        rowStart[k] = ((q.x - p.x) * (py - p.y) - (q.y - p.y) * (px - p.x)) * invArea;
+        stepX[k] = -(q.y - p.y) * invArea;
+        stepY[k] = (q.x - p.x) * invArea;
+    }
+
+    for(int y = startY; y <= endY; y++){
+
+        float w0 = rowStart[0];
+        float w1 = rowStart[1];
+        float w2 = rowStart[2];
+
+        for(int x = startX; x <= endX; x += 4){
+
+            //4 pixels side by side. Plain fixed size loops with no branches,
+            //which is what the compiler's auto-vectorizer is looking for
+            float e0[4], e1[4], e2[4];
+            bool inside[4];
+            bool any = false;
+
+            for(int k = 0; k < 4; k++){
+                e0[k] = w0 + stepX[0] * k;
+                e1[k] = w1 + stepX[1] * k;
+                e2[k] = w2 + stepX[2] * k;
+                inside[k] = (e0[k] >= 0) & (e1[k] >= 0) & (e2[k] >= 0) & (x + k <= endX);
+                any |= inside[k];
+            }
+
+            w0 += stepX[0] * 4;
+            w1 += stepX[1] * 4;
+            w2 += stepX[2] * 4;
+
+            if(!any) continue;
+
+            for(int k = 0; k < 4; k++){
+                if(!inside[k]) continue;
+
+                //depth is linear on screen, everything else needs the 1/w correction
+                float z = e0[k] * a.z + e1[k] * b.z + e2[k] * c.z;
+                int index = y * width + x + k;
+                if(z < 0 || z > 1 || z >= depth[index]) continue;
+
+                float weights[3] = { e0[k] * a.invW, e1[k] * b.invW, e2[k] * c.invW };
+                float sum = weights[0] + weights[1] + weights[2];
+                for(int i = 0; i < 3; i++){
+                    weights[i] /= sum;
+                }
+
+                writePixel(x + k, y, z, shade(state, prim, weights));
+            }
+        }
+
+        for(int k = 0; k < 3; k++){
+            rowStart[k] += stepY[k];
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void SoftwareRasterizer::drawLine(const Primitive& prim, const DrawState& state, int x0, int y0, int x1, int y1){
+
+    const ScreenVertex& a = screenVerts[prim.v[0]];
+    const ScreenVertex& b = screenVerts[prim.v[1]];
+
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    int steps = max(1, (int)ceil(max(fabs(dx), fabs(dy))));
+
+    //only walk the part of the line that's inside this tile
+    float tMin = 0;
+    float tMax = 1;
+    float lo[2] = { x0 - 1.0f, y0 - 1.0f };
+    float hi[2] = { x1 + 1.0f, y1 + 1.0f };
+    float from[2] = { a.x, a.y };
+    float delta[2] = { dx, dy };
+
+    for(int i = 0; i < 2; i++){
+        if(fabs(delta[i]) < 1e-6){
+            if(from[i] < lo[i] || from[i] > hi[i]) return;
+            continue;
+        }
+        float t0 = (lo[i] - from[i]) / delta[i];
+        float t1 = (hi[i] - from[i]) / delta[i];
+        if(t0 > t1) std::swap(t0, t1);
+        tMin = max(tMin, t0);
+        tMax = min(tMax, t1);
+    }
+    if(tMin > tMax) return;
+
+    for(int i = (int)floor(tMin * steps); i <= (int)ceil(tMax * steps); i++){
+
+        float t = ofClamp(i / (float)steps, 0, 1);
+        int x = (int)floor(a.x + dx * t);
+        int y = (int)floor(a.y + dy * t);
+        if(x < x0 || x >= x1 || y < y0 || y >= y1) continue;
+
+        float z = a.z + (b.z - a.z) * t;
+        int index = y * width + x;
+        if(z < 0 || z > 1 || z >= depth[index]) continue;
+
+        float weights[3] = { (1 - t) * a.invW, t * b.invW, 0 };
+        float sum = weights[0] + weights[1];
+        weights[0] /= sum;
+        weights[1] /= sum;
+
+        writePixel(x, y, z, shade(state, prim, weights));
+    }
+}
+
+//--------------------------------------------------------------
+void SoftwareRasterizer::drawPoint(const Primitive& prim, const DrawState& state, int x0, int y0, int x1, int y1){
+
+    const ScreenVertex& p = screenVerts[prim.v[0]];
+
+    //a square, like GL_POINTS without smoothing
+    //(the square's own corners first, then cut down to the tile. A point
+    //hanging over the tile's edge still ends where the point ends)
+    float half = pointSize * 0.5;
+    int size = max(1, (int)pointSize);
+    int pointX = floor(p.x - half + 0.5);
+    int pointY = floor(p.y - half + 0.5);
+    int startX = max(x0, pointX);
+    int startY = max(y0, pointY);
+    int endX = min(x1, pointX + size);
+    int endY = min(y1, pointY + size);
+
+    float weights[3] = { 1, 0, 0 };
+    ofFloatColor color = shade(state, prim, weights);
+
+    for(int y = startY; y < endY; y++){
+        for(int x = startX; x < endX; x++){
+            int index = y * width + x;
+            if(p.z < 0 || p.z > 1 || p.z >= depth[index]) continue;
+            writePixel(x, y, p.z, color);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+ofFloatColor SoftwareRasterizer::shade(const DrawState& state, const Primitive& prim, const float* weights) const{
+
+    const ofMesh& mesh = *state.mesh;
+    ofFloatColor color = state.color;
+
+    if(state.bColors){
+        ofFloatColor vc(0, 0, 0, 0);
+        for(int k = 0; k < prim.numVertices; k++){
+            vc = vc + mesh.getColors()[prim.v[k]] * weights[k];
+        }
+        color.r *= vc.r;
+        color.g *= vc.g;
+        color.b *= vc.b;
+    }
+
+    if(state.bTexture){
+        ofVec2f uv;
+        for(int k = 0; k < prim.numVertices; k++){
+            uv += mesh.getTexCoords()[prim.v[k]] * weights[k];
+        }
+        ofFloatColor tc = sampleTexture(uv.x, uv.y);
+        color.r *= tc.r;
+        color.g *= tc.g;
+        color.b *= tc.b;
+    }
+
+    //diffuse lighting per pixel. Lines and points without normals stay unlit
+    if(bLighting && (state.bNormals || prim.numVertices == 3)){
+        ofVec3f normal = prim.faceNormal;
+        ofVec3f position;
+
+        if(state.bNormals){
+            normal.set(0, 0, 0);
+            for(int k = 0; k < prim.numVertices; k++){
+                normal += mesh.getNormals()[prim.v[k]] * weights[k];
+            }
+            normal.normalize();
+        }
+        for(int k = 0; k < prim.numVertices; k++){
+            position += mesh.getVertices()[prim.v[k]] * weights[k];
+        }
+
+        float diffuse = max(0.0f, normal.dot((lightPosition - position).getNormalized()));
+        color.r *= lightAmbient.r + lightDiffuse.r * diffuse;
+        color.g *= lightAmbient.g + lightDiffuse.g * diffuse;
+        color.b *= lightAmbient.b + lightDiffuse.b * diffuse;
+    }
+
+    return color;
+}
+
+//--------------------------------------------------------------
+ofFloatColor SoftwareRasterizer::sampleTexture(float u, float v) const{
+
+    int w = texture->getWidth();
+    int h = texture->getHeight();
+    int channels = texture->getNumChannels();
+    const unsigned char* data = texture->getData();
+
+    if(bNormalizedTexCoords){
+        u *= w;
+        v *= h;
+    }
+
+    //bilinear: blend the 4 texels around the sample point (clamped at the edges)
+    float fx = ofClamp(u - 0.5, 0, w - 1);
+    float fy = ofClamp(v - 0.5, 0, h - 1);
+    int ix = min((int)fx, w - 2 < 0 ? 0 : w - 2);
+    int iy = min((int)fy, h - 2 < 0 ? 0 : h - 2);
+    int ix1 = min(ix + 1, w - 1);
+    int iy1 = min(iy + 1, h - 1);
+    float tx = fx - ix;
+    float ty = fy - iy;
+
+    ofFloatColor result(0, 0, 0, 1);
+    for(int c = 0; c < min(channels, 3); c++){
+        float top = data[(iy * w + ix) * channels + c] * (1 - tx) + data[(iy * w + ix1) * channels + c] * tx;
+        float bottom = data[(iy1 * w + ix) * channels + c] * (1 - tx) + data[(iy1 * w + ix1) * channels + c] * tx;
+        result[c] = (top * (1 - ty) + bottom * ty) / 255.0;
+    }
+
+    //grayscale images go into all three channels
+    if(channels == 1){
+        result.g = result.b = result.r;
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------
+void SoftwareRasterizer::writePixel(int x, int y, float z, const ofFloatColor& color){
+
+    int index = y * width + x;
+    depth[index] = z;
+
+    //round instead of truncating so 0.99999 still comes out as 255
+    unsigned char* p = pixels.getData() + index * 3;
+    p[0] = ofClamp(color.r, 0, 1) * 255 + 0.5;
+    p[1] = ofClamp(color.g, 0, 1) * 255 + 0.5;
+    p[2] = ofClamp(color.b, 0, 1) * 255 + 0.5;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Draws an ofMesh into an ofPixels image on the CPU, no OpenGL needed.
+ * Handy for rendering frames on machines without a GPU (or without a window)
+ * and for saving out image sequences.
+ *
+ * How it works:
+ *  - every vertex is projected through the camera, just like the GPU would
+ *  - the screen is cut into square tiles and every triangle/line/point gets
+ *    added to the list of each tile its bounding box touches ("binning")
+ *  - the tiles are then filled in on several threads at once. Each tile only
+ *    writes its own pixels so the threads never get in each other's way
+ *  - inside a tile the triangles are filled using "edge functions": a pixel is
+ *    inside a triangle if it's on the inner side of all three edges. They're
+ *    tested 4 pixels at a time (written as plain loops over 4 values so the
+ *    compiler can turn them into SIMD instructions on any platform)
+ *
+ * It covers what the sketches use: vertex colors, textures (from ofPixels),
+ * a single point light, and filled / wireframe / point drawing. There's a
+ * depth buffer but no blending, and triangles that poke through the camera's
+ * near plane are skipped rather than clipped.
+ */
+
+class SoftwareRasterizer {
+
+	public:
+
+    enum DrawMode {
+        FILL,
+        WIREFRAME,
+        POINTS
+    };
+
+    SoftwareRasterizer();
+
+    void allocate(int width, int height, int tileSize = 32);
+
+    //fill the image with a color and reset the depth buffer
+    void clear(const ofColor& color);
+
+    //everything drawn after this is seen through this camera.
+    //The camera's viewport is the whole image
+    void setCamera(const ofCamera& cam);
+
+    //multiplied with everything that's drawn, like ofSetColor()
+    void setColor(const ofColor& color) { drawColor = color; }
+
+    //pixels to use as the texture, or nullptr for none. Like OF's default
+    //(ARB) textures the texcoords are in pixels unless setNormalizedTexCoords(true)
+    void setTexture(const ofPixels* pixels) { texture = pixels; }
+    void setNormalizedTexCoords(bool normalized) { bNormalizedTexCoords = normalized; }
+
+    //a point light with a diffuse and an ambient color, similar to ofLight
+    void enableLighting(const ofVec3f& position, const ofFloatColor& diffuse, const ofFloatColor& ambient);
+    void disableLighting() { bLighting = false; }
+
+    void setPointSize(float size) { pointSize = size; }
+
+    //vertex colors are only used if the mesh has them and they're enabled
+    void draw(const ofMesh& mesh, DrawMode mode = FILL);
+
+    const ofPixels& getPixels() const { return pixels; }
+    bool save(const string& path) const;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    //stats from the last draw()
+    float getLastDrawTimeMs() const { return lastDrawTimeMs; }
+    size_t getNumPrimitivesDrawn() const { return numPrimitivesDrawn; }
+
+    private:
+
+    //a vertex after projection: pixel position, depth (0 near to 1 far) and 1/w
+    //for perspective correct interpolation. Not visible if it's behind the camera
+    struct ScreenVertex {
+        float x, y, z;
+        float invW;
+        bool visible;
+    };
+
+    //a triangle, line or point (1, 2 or 3 vertices) and the pixels it might cover
+    struct Primitive {
+        ofIndexType v[3];
+        unsigned char numVertices;
+        int minX, minY, maxX, maxY;
+        ofVec3f faceNormal;
+    };
+
+    //everything the pixel shading needs for one draw() call
+    struct DrawState {
+        const ofMesh* mesh;
+        bool bColors;
+        bool bTexture;
+        bool bNormals;
+        ofFloatColor color;
+    };
+
+    void addPrimitive(const ofIndexType* v, int numVertices, const ofMesh& mesh);
+    void rasterizeTile(int tileIndex, const DrawState& state);
+
+    //each of these only touches the pixels inside [x0, x1) x [y0, y1) (one tile)
+    void fillTriangle(const Primitive& prim, const DrawState& state, int x0, int y0, int x1, int y1);
+    void drawLine(const Primitive& prim, const DrawState& state, int x0, int y0, int x1, int y1);
+    void drawPoint(const Primitive& prim, const DrawState& state, int x0, int y0, int x1, int y1);
+
+    //color of one pixel from the corners and their (perspective corrected) weights
+    ofFloatColor shade(const DrawState& state, const Primitive& prim, const float* weights) const;
+    ofFloatColor sampleTexture(float u, float v) const;
+
+    void writePixel(int x, int y, float z, const ofFloatColor& color);
+
+    int width, height;
+    int tileSize;
+    int numTilesX, numTilesY;
+
+    ofPixels pixels;
+    vector<float> depth;
+
+    ofMatrix4x4 modelViewProjection;
+
+    vector<ScreenVertex> screenVerts;
+    vector<Primitive> primitives;
+    vector<vector<unsigned> > tileBins;
+
+    ofColor drawColor;
+    const ofPixels* texture;
+    bool bNormalizedTexCoords;
+
+    bool bLighting;
+    ofVec3f lightPosition;
+    ofFloatColor lightDiffuse;
+    ofFloatColor lightAmbient;
+
+    float pointSize;
+
+    float lastDrawTimeMs;
+    size_t numPrimitivesDrawn;
+};
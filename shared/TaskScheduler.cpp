@@ -0,0 +1,230 @@
+#include "TaskScheduler.h"
+
+//which scheduler and which queue the current thread belongs to.
+//Threads that aren't workers (like the app's main thread) all use queue 0
+static thread_local const TaskScheduler* currentScheduler = nullptr;
+static thread_local unsigned currentIndex = 0;
+
+//--------------------------------------------------------------
+TaskScheduler& TaskScheduler::get(){
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+//--------------------------------------------------------------
+TaskScheduler::TaskScheduler(unsigned numThreads){
+
+    if(numThreads == 0){
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    numQueued = 0;
+    bStop = false;
+    resetStats();
+
+    for(unsigned i = 0; i < numThreads; i++){
+        queues.push_back(unique_ptr<Queue>(new Queue()));
+    }
+
+    //queue 0 belongs to whoever calls wait(), the workers get the rest
+    for(unsigned i = 1; i < numThreads; i++){
+        workers.push_back(std::thread(&TaskScheduler::workerThread, this, i));
+    }
+}
+
+//--------------------------------------------------------------
+TaskScheduler::~TaskScheduler(){
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        bStop = true;
+    }
+    wakeUp.notify_all();
+
+    for(auto& t : workers){
+        t.join();
+    }
+}
+
+//--------------------------------------------------------------
+unsigned TaskScheduler::getThreadIndex() const{
+    return currentScheduler == this ? currentIndex : 0;
+}
+
+//--------------------------------------------------------------
+void TaskScheduler::run(TaskGroup& group, const std::function<void()>& task){
+
+    group.pending++;
+
+    Queue& queue = *queues[getThreadIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(Task{task, &group});
+    }
+
+    //count it before waking anybody up so a worker that is just about to
+    //go to sleep sees it (it checks the count while holding sleepMutex)
+    numQueued++;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeUp.notify_one();
+}
+
+//--------------------------------------------------------------
+bool TaskScheduler::runOne(unsigned index){
+
+    Task task;
+    bool found = false;
+
+    //newest task from our own queue first
+    {
+        Queue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if(!own.tasks.empty()){
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+
+    //otherwise the oldest task from the next queue that has one
+    for(size_t i = 1; i < queues.size() && !found; i++){
+        Queue& victim = *queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if(!victim.tasks.empty()){
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            found = true;
+            steals++;
+        }
+    }
+
+    if(!found) return false;
+
+    numQueued--;
+
+    //an exception goes to whoever waits on the group. Letting it out here would
+    //leave the group pending forever (and take the worker thread down with it)
+    try {
+        task.function();
+    } catch(...) {
+        storeException(*task.group);
+    }
+    tasksRun++;
+
+    //only now can anybody waiting on the group move on
+    task.group->pending--;
+
+    return true;
+}
+
+//--------------------------------------------------------------
+void TaskScheduler::workerThread(unsigned index){
+
+    currentScheduler = this;
+    currentIndex = index;
+
+    while(!bStop){
+
+        if(runOne(index)) continue;
+
+        //nothing anywhere, sleep until run() adds something
+        uint64_t start = ofGetElapsedTimeMicros();
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wakeUp.wait(lock, [this](){ return numQueued > 0 || bStop; });
+        }
+        idleMicros += ofGetElapsedTimeMicros() - start;
+    }
+}
+
+//--------------------------------------------------------------
+void TaskScheduler::wait(TaskGroup& group){
+
+    //help out instead of sitting around. This may run tasks from other
+    //groups too, which is fine: they'd have to run sooner or later anyway
+    unsigned index = getThreadIndex();
+    while(group.pending > 0){
+        if(!runOne(index)){
+            std::this_thread::yield();
+        }
+    }
+
+    //hand on what went wrong (once: the group can be used again afterwards)
+    std::exception_ptr exception;
+    {
+        std::lock_guard<std::mutex> lock(group.exceptionMutex);
+        std::swap(exception, group.exception);
+    }
+    if(exception){
+        std::rethrow_exception(exception);
+    }
+}
+
+//--------------------------------------------------------------
+void TaskScheduler::storeException(TaskGroup& group){
+    std::lock_guard<std::mutex> lock(group.exceptionMutex);
+    if(!group.exception){
+        group.exception = std::current_exception();
+    }
+}
+
+//--------------------------------------------------------------
+void TaskScheduler::parallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& body){
+
+    if(end <= begin) return;
+
+    size_t count = end - begin;
+    if(grainSize == 0){
+        grainSize = std::max<size_t>(1, count / (getNumThreads() * 4));
+    }
+
+    //not worth handing out
+    if(count <= grainSize || getNumThreads() == 1){
+        body(begin, end);
+        return;
+    }
+
+    //the tasks already handed out point at the group (and the body) on this
+    //stack, so even when our own piece throws they have to finish before we leave
+    TaskGroup group;
+    try {
+        splitRange(group, begin, end, grainSize, body);
+    } catch(...) {
+        storeException(group);
+    }
+    wait(group);
+}
+
+//--------------------------------------------------------------
+void TaskScheduler::splitRange(TaskGroup& group, size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& body){
+
+    //offer the top half to whoever wants it and keep halving the bottom half.
+    //A thread that steals a half splits it further the same way
+    while(end - begin > grainSize){
+        size_t mid = begin + (end - begin) / 2;
+        run(group, [this, &group, &body, mid, end, grainSize](){
+            splitRange(group, mid, end, grainSize, body);
+        });
+        end = mid;
+    }
+
+    body(begin, end);
+}
+
+//--------------------------------------------------------------
+TaskScheduler::Stats TaskScheduler::getStats() const{
+    Stats stats;
+    stats.tasksRun = tasksRun;
+    stats.steals = steals;
+    stats.idleMicros = idleMicros;
+    return stats;
+}
+
+//--------------------------------------------------------------
+void TaskScheduler::resetStats(){
+    tasksRun = 0;
+    steals = 0;
+    idleMicros = 0;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "ofMain.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+/*
+ * One pool of worker threads shared by all the mesh code, so the sketches don't
+ * start (and throw away) their own threads every time something runs in parallel.
+ *
+ * Every thread has its own queue of tasks. A thread adds new tasks to the back of
+ * its own queue and takes work from the back too (the newest, smallest pieces,
+ * which are likely still in the cache). When its queue is empty it "steals" from
+ * the front of somebody else's queue, where the biggest, oldest pieces are.
+ * That keeps everybody busy without one central queue everybody fights over.
+ *
+ * parallelFor() cuts a range in half, puts one half up for grabs and keeps cutting
+ * the other half until the pieces are down to the grain size, so idle threads
+ * steal big chunks and the splitting happens wherever the work ends up.
+ *
+ * The thread calling wait() (usually the app's update()) doesn't just sleep: it
+ * runs tasks too until the group is done. That's also why a task can start its
+ * own parallelFor() without getting stuck.
+ *
+ * If a task throws, the rest of its group still runs (and still counts as done),
+ * and wait() throws the first exception again on the thread that waits, the same
+ * as if the task had run there. parallelFor() does that too.
+ */
+
+class TaskScheduler {
+
+	public:
+
+    //a set of tasks you can wait on as a whole
+    class TaskGroup {
+        public:
+        TaskGroup() : pending(0) {}
+        bool isDone() const { return pending == 0; }
+
+        private:
+        friend class TaskScheduler;
+        std::atomic<int> pending;
+
+        //the first exception one of the tasks threw, for wait() to throw again
+        std::mutex exceptionMutex;
+        std::exception_ptr exception;
+    };
+
+    struct Stats {
+        uint64_t tasksRun;
+        uint64_t steals;        //tasks taken from another thread's queue
+        uint64_t idleMicros;    //time worker threads spent waiting for work (all of them together)
+    };
+
+    //the scheduler everybody shares. Uses every core: the calling thread plus one
+    //worker per extra core
+    static TaskScheduler& get();
+
+    //numThreads counts the calling thread too, 0 means one per core
+    TaskScheduler(unsigned numThreads = 0);
+    ~TaskScheduler();
+
+    //queue a task. It may run on any thread, including the one calling wait()
+    void run(TaskGroup& group, const std::function<void()>& task);
+
+    //run tasks until everything in the group is finished. Throws the first
+    //exception one of them threw, if any
+    void wait(TaskGroup& group);
+
+    //call body(begin, end) on pieces of [begin, end) no bigger than grainSize,
+    //spread over all the threads, and wait for all of them to finish.
+    //A grainSize of 0 picks one that gives every thread a few pieces
+    void parallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+
+    unsigned getNumThreads() const { return queues.size(); }
+
+    Stats getStats() const;
+    void resetStats();
+
+    private:
+
+    struct Task {
+        std::function<void()> function;
+        TaskGroup* group;
+    };
+
+    //one per thread. The owner uses the back, thieves use the front
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerThread(unsigned index);
+    void splitRange(TaskGroup& group, size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+
+    //keep the exception being handled in the group, unless it already has one
+    void storeException(TaskGroup& group);
+
+    //run one task from our own queue or a stolen one. False if there was nothing to do
+    bool runOne(unsigned index);
+    unsigned getThreadIndex() const;
+
+    vector<unique_ptr<Queue> > queues;
+    vector<std::thread> workers;
+
+    //sleeping workers wait here until new tasks come in
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::atomic<int> numQueued;
+    std::atomic<bool> bStop;
+
+    std::atomic<uint64_t> tasksRun;
+    std::atomic<uint64_t> steals;
+    std::atomic<uint64_t> idleMicros;
+};
@@ -0,0 +1,260 @@
+#include "VertexStreams.h"
+#include "TaskScheduler.h"
+
+//how many 64 byte cache lines an array of this many bytes covers
+//--------------------------------------------------------------
+static size_t cacheLines(size_t bytes){
+    return (bytes + 63) / 64;
+}
+
+//--------------------------------------------------------------
+VertexStreams::VertexStreams(){
+    numVerts = 0;
+    numIndices = 0;
+    indexBytesThisFrame = 0;
+    mode = OF_PRIMITIVE_TRIANGLES;
+    bUseColors = true;
+    lastUpdateTimeMs = 0;
+}
+
+//--------------------------------------------------------------
+VertexStreams::Layout VertexStreams::makeLayout(const ofMesh& mesh, int attributes) const{
+
+    Layout layout;
+    layout.attributes = 0;
+    layout.stride = 0;
+    layout.positionOffset = -1;
+    layout.normalOffset = -1;
+    layout.texCoordOffset = -1;
+    layout.colorOffset = -1;
+
+    //only attributes the mesh has one of per vertex
+    if((attributes & POSITION) && mesh.getNumVertices() == numVerts){
+        layout.positionOffset = layout.stride;
+        layout.stride += sizeof(ofVec3f);
+        layout.attributes |= POSITION;
+    }
+    if((attributes & NORMAL) && mesh.getNumNormals() == numVerts){
+        layout.normalOffset = layout.stride;
+        layout.stride += sizeof(ofVec3f);
+        layout.attributes |= NORMAL;
+    }
+    if((attributes & TEXCOORD) && mesh.getNumTexCoords() == numVerts){
+        layout.texCoordOffset = layout.stride;
+        layout.stride += sizeof(ofVec2f);
+        layout.attributes |= TEXCOORD;
+    }
+    if((attributes & COLOR) && bUseColors && mesh.getNumColors() == numVerts){
+        layout.colorOffset = layout.stride;
+        layout.stride += sizeof(ofFloatColor);
+        layout.attributes |= COLOR;
+    }
+
+    return layout;
+}
+
+//--------------------------------------------------------------
+void VertexStreams::setup(const ofMesh& mesh, int dynamicAttributes, bool useColors){
+
+    numVerts = mesh.getNumVertices();
+    mode = mesh.getMode();
+    bUseColors = useColors;
+
+    int all = POSITION | NORMAL | TEXCOORD | COLOR;
+    staticLayout = makeLayout(mesh, all & ~dynamicAttributes);
+    dynamicLayout = makeLayout(mesh, dynamicAttributes);
+
+    //a fresh vbo so nothing from an older layout is left switched on
+    vbo.clear();
+
+    //the static stream is packed and uploaded once
+    staticData.resize(numVerts * staticLayout.stride / sizeof(float));
+    pack(mesh, staticLayout, staticData, 0, numVerts);
+    if(staticLayout.stride > 0){
+        staticBuffer.allocate(staticData.size() * sizeof(float), staticData.data(), GL_STATIC_DRAW);
+        bindLayout(staticBuffer, staticLayout);
+    }
+
+    //the dynamic one gets room for a frame's worth and is refilled every frame.
+    //Positions on their own are laid out exactly like the mesh's vertex array,
+    //so those get uploaded straight from the mesh without packing them first
+    dynamicData.clear();
+    if(dynamicLayout.attributes == POSITION && numVerts > 0){
+        dynamicBuffer.allocate(numVerts * sizeof(ofVec3f), &mesh.getVertices()[0], GL_STREAM_DRAW);
+        bindLayout(dynamicBuffer, dynamicLayout);
+    } else if(dynamicLayout.stride > 0){
+        dynamicData.resize(numVerts * dynamicLayout.stride / sizeof(float));
+        pack(mesh, dynamicLayout, dynamicData, 0, numVerts);
+        dynamicBuffer.allocate(dynamicData.size() * sizeof(float), dynamicData.data(), GL_STREAM_DRAW);
+        bindLayout(dynamicBuffer, dynamicLayout);
+    }
+
+    //attributes the mesh doesn't have stay switched off
+    int used = staticLayout.attributes | dynamicLayout.attributes;
+    if(!(used & NORMAL)) vbo.disableNormals();
+    if(!(used & TEXCOORD)) vbo.disableTexCoords();
+    if(!(used & COLOR)) vbo.disableColors();
+
+    updateIndices(mesh);
+}
+
+//--------------------------------------------------------------
+void VertexStreams::bindLayout(ofBufferObject& buffer, const Layout& layout){
+    if(layout.positionOffset >= 0) vbo.setVertexBuffer(buffer, 3, layout.stride, layout.positionOffset);
+    if(layout.normalOffset >= 0) vbo.setNormalBuffer(buffer, layout.stride, layout.normalOffset);
+    if(layout.texCoordOffset >= 0) vbo.setTexCoordBuffer(buffer, layout.stride, layout.texCoordOffset);
+    if(layout.colorOffset >= 0) vbo.setColorBuffer(buffer, layout.stride, layout.colorOffset);
+}
+
+//--------------------------------------------------------------
+void VertexStreams::pack(const ofMesh& mesh, const Layout& layout, vector<float>& data, size_t begin, size_t end) const{
+
+    if(layout.stride == 0 || data.empty()) return;
+
+    //everything in the layout is floats, so offsets and the stride
+    //can be counted in floats instead of bytes
+    size_t stride = layout.stride / sizeof(float);
+
+    if(layout.positionOffset >= 0){
+        const vector<ofVec3f>& src = mesh.getVertices();
+        float* out = &data[layout.positionOffset / sizeof(float)];
+        for(size_t i = begin; i < end; i++){
+            out[i * stride + 0] = src[i].x;
+            out[i * stride + 1] = src[i].y;
+            out[i * stride + 2] = src[i].z;
+        }
+    }
+
+    if(layout.normalOffset >= 0){
+        const vector<ofVec3f>& src = mesh.getNormals();
+        float* out = &data[layout.normalOffset / sizeof(float)];
+        for(size_t i = begin; i < end; i++){
+            out[i * stride + 0] = src[i].x;
+            out[i * stride + 1] = src[i].y;
+            out[i * stride + 2] = src[i].z;
+        }
+    }
+
+    if(layout.texCoordOffset >= 0){
+        const vector<ofVec2f>& src = mesh.getTexCoords();
+        float* out = &data[layout.texCoordOffset / sizeof(float)];
+        for(size_t i = begin; i < end; i++){
+            out[i * stride + 0] = src[i].x;
+            out[i * stride + 1] = src[i].y;
+        }
+    }
+
+    if(layout.colorOffset >= 0){
+        const vector<ofFloatColor>& src = mesh.getColors();
+        float* out = &data[layout.colorOffset / sizeof(float)];
+        for(size_t i = begin; i < end; i++){
+            out[i * stride + 0] = src[i].r;
+            out[i * stride + 1] = src[i].g;
+            out[i * stride + 2] = src[i].b;
+            out[i * stride + 3] = src[i].a;
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void VertexStreams::updateDynamic(const ofMesh& mesh){
+
+    uint64_t start = ofGetElapsedTimeMicros();
+    indexBytesThisFrame = 0;
+
+    if(mesh.getNumVertices() != numVerts){
+        ofLogWarning("VertexStreams") << "updateDynamic(): the mesh doesn't match the one from setup()";
+        return;
+    }
+    if(dynamicLayout.stride == 0 || numVerts == 0) return;
+
+    if(dynamicData.empty()){
+        dynamicBuffer.updateData(0, numVerts * sizeof(ofVec3f), &mesh.getVertices()[0]);
+    } else {
+
+        //every chunk of vertices lands in its own part of the stream
+        TaskScheduler::get().parallelFor(0, numVerts, 8192, [&](size_t begin, size_t end){
+            pack(mesh, dynamicLayout, dynamicData, begin, end);
+        });
+
+        dynamicBuffer.updateData(0, dynamicData.size() * sizeof(float), dynamicData.data());
+    }
+
+    lastUpdateTimeMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+void VertexStreams::updateIndices(const ofMesh& mesh){
+
+    //culling can switch a strip over to separate triangles
+    mode = mesh.getMode();
+    numIndices = mesh.getNumIndices();
+    if(numIndices > 0){
+        vbo.setIndexData(&mesh.getIndices()[0], numIndices, GL_STREAM_DRAW);
+        vbo.enableIndices();
+    } else {
+        vbo.disableIndices();
+    }
+
+    indexBytesThisFrame = numIndices * sizeof(ofIndexType);
+}
+
+//--------------------------------------------------------------
+void VertexStreams::draw(ofPolyRenderMode renderMode){
+
+    if(numVerts == 0) return;
+
+    //same as ofMesh::drawWireframe(): draw the triangles as outlines
+#ifndef TARGET_OPENGLES
+    if(renderMode == OF_MESH_WIREFRAME) glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    if(renderMode == OF_MESH_POINTS) glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+#endif
+
+    if(numIndices > 0){
+        vbo.drawElements(ofGetGLPrimitiveMode(mode), numIndices);
+    } else {
+        vbo.draw(ofGetGLPrimitiveMode(mode), 0, numVerts);
+    }
+
+#ifndef TARGET_OPENGLES
+    if(renderMode != OF_MESH_FILL) glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+#endif
+}
+
+//--------------------------------------------------------------
+size_t VertexStreams::getBytesPerFrame() const{
+    return numVerts * dynamicLayout.stride + indexBytesThisFrame;
+}
+
+//--------------------------------------------------------------
+size_t VertexStreams::getCacheLinesPerFrame() const{
+
+    //read the dynamic attributes out of the mesh's arrays...
+    size_t lines = 0;
+    if(dynamicLayout.attributes & POSITION) lines += cacheLines(numVerts * sizeof(ofVec3f));
+    if(dynamicLayout.attributes & NORMAL) lines += cacheLines(numVerts * sizeof(ofVec3f));
+    if(dynamicLayout.attributes & TEXCOORD) lines += cacheLines(numVerts * sizeof(ofVec2f));
+    if(dynamicLayout.attributes & COLOR) lines += cacheLines(numVerts * sizeof(ofFloatColor));
+
+    //...write them into the stream, which is then read for the upload
+    //(positions on their own go straight from the mesh)
+    lines += 2 * cacheLines(dynamicData.size() * sizeof(float));
+
+    return lines + cacheLines(indexBytesThisFrame);
+}
+
+//--------------------------------------------------------------
+size_t VertexStreams::getSeparateBytesPerFrame(const ofMesh& mesh, bool useColors){
+    return mesh.getNumVertices() * sizeof(ofVec3f) + mesh.getNumNormals() * sizeof(ofVec3f) +
+           mesh.getNumTexCoords() * sizeof(ofVec2f) + (useColors ? mesh.getNumColors() * sizeof(ofFloatColor) : 0) +
+           mesh.getNumIndices() * sizeof(ofIndexType);
+}
+
+//--------------------------------------------------------------
+size_t VertexStreams::getSeparateCacheLinesPerFrame(const ofMesh& mesh, bool useColors){
+
+    //every array is read once for its upload
+    return cacheLines(mesh.getNumVertices() * sizeof(ofVec3f)) + cacheLines(mesh.getNumNormals() * sizeof(ofVec3f)) +
+           cacheLines(mesh.getNumTexCoords() * sizeof(ofVec2f)) + (useColors ? cacheLines(mesh.getNumColors() * sizeof(ofFloatColor)) : 0) +
+           cacheLines(mesh.getNumIndices() * sizeof(ofIndexType));
+}
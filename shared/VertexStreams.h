@@ -0,0 +1,105 @@
+#pragma once
+
+#include "ofMain.h"
+
+/*
+ * Draws a mesh from interleaved vertex buffers instead of ofMesh's separate arrays.
+ *
+ * ofMesh keeps positions, normals, texcoords and colors in separate vectors and
+ * drawing it sends all of them to the GPU again every frame, even when only the
+ * positions moved. Here the attributes are split into two "streams":
+ *
+ *  - static:  everything that never changes (say normals + texcoords), packed
+ *             together vertex by vertex and uploaded once
+ *  - dynamic: what gets rewritten every frame (usually just the positions),
+ *             packed the same way and re-uploaded with updateDynamic()
+ *
+ * Each stream is one block of memory with a fixed layout, for example with
+ * normals and texcoords in the static stream:
+ *
+ *     static:  | nx ny nz u v | nx ny nz u v | ...     stride 20 bytes
+ *     dynamic: | x y z | x y z | ...                   stride 12 bytes
+ *
+ * so a frame only touches (and uploads) the bytes that actually changed, in
+ * one straight run. The numbers for both ways are available to compare.
+ */
+
+class VertexStreams {
+
+	public:
+
+    enum Attribute {
+        POSITION = 1,
+        NORMAL = 2,
+        TEXCOORD = 4,
+        COLOR = 8
+    };
+
+    //where each attribute sits inside a vertex of one stream, in bytes
+    //(-1 if it isn't in this stream)
+    struct Layout {
+        int attributes;
+        int stride;
+        int positionOffset;
+        int normalOffset;
+        int texCoordOffset;
+        int colorOffset;
+    };
+
+    VertexStreams();
+
+    //pack and upload both streams. Attributes in dynamicAttributes go in the
+    //dynamic stream, every other one the mesh has goes in the static stream.
+    //Leave colors out of both with useColors = false (e.g. to use a texture)
+    void setup(const ofMesh& mesh, int dynamicAttributes = POSITION, bool useColors = true);
+
+    //repack the dynamic attributes from the mesh and upload them
+    void updateDynamic(const ofMesh& mesh);
+
+    //upload new indices (e.g. after culling swapped them).
+    //They count towards the frame started by the last updateDynamic()
+    void updateIndices(const ofMesh& mesh);
+
+    void draw(ofPolyRenderMode renderMode = OF_MESH_FILL);
+
+    const Layout& getStaticLayout() const { return staticLayout; }
+    const Layout& getDynamicLayout() const { return dynamicLayout; }
+
+    //what a frame costs: bytes uploaded, and 64 byte cache lines
+    //the CPU reads and writes to get them ready
+    size_t getBytesPerFrame() const;
+    size_t getCacheLinesPerFrame() const;
+
+    //the same for drawing the mesh the usual way (every array, every frame)
+    static size_t getSeparateBytesPerFrame(const ofMesh& mesh, bool useColors = true);
+    static size_t getSeparateCacheLinesPerFrame(const ofMesh& mesh, bool useColors = true);
+
+    float getLastUpdateTimeMs() const { return lastUpdateTimeMs; }
+
+    private:
+
+    Layout makeLayout(const ofMesh& mesh, int attributes) const;
+
+    //copy the layout's attributes for vertices [begin, end) into data
+    void pack(const ofMesh& mesh, const Layout& layout, vector<float>& data, size_t begin, size_t end) const;
+
+    //point the vbo at the attributes inside one of the buffers
+    void bindLayout(ofBufferObject& buffer, const Layout& layout);
+
+    ofVbo vbo;
+    ofBufferObject staticBuffer;
+    ofBufferObject dynamicBuffer;
+
+    Layout staticLayout;
+    Layout dynamicLayout;
+    vector<float> staticData;
+    vector<float> dynamicData;
+
+    size_t numVerts;
+    size_t numIndices;
+    size_t indexBytesThisFrame;
+    ofPrimitiveMode mode;
+    bool bUseColors;
+
+    float lastUpdateTimeMs;
+};